@@ -0,0 +1,78 @@
+#include "Hash.h"
+
+#include <string.h>
+
+namespace SG
+{
+
+	static inline uint64_t util_rotate_left(uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	static inline uint64_t util_final_mix(uint64_t k)
+	{
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdull;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ull;
+		k ^= k >> 33;
+		return k;
+	}
+
+	Hash128 hash_128(const void* pData, size_t size, uint64_t seed)
+	{
+		const uint64_t c1 = 0x87c37b91114253d5ull;
+		const uint64_t c2 = 0x4cf5ad432745937full;
+
+		const uint8_t* pBytes = (const uint8_t*)pData;
+		const size_t blockCount = size / 16;
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		for (size_t i = 0; i < blockCount; ++i)
+		{
+			uint64_t k1, k2;
+			memcpy(&k1, pBytes + i * 16, sizeof(k1));
+			memcpy(&k2, pBytes + i * 16 + 8, sizeof(k2));
+
+			k1 *= c1; k1 = util_rotate_left(k1, 31); k1 *= c2; h1 ^= k1;
+			h1 = util_rotate_left(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+			k2 *= c2; k2 = util_rotate_left(k2, 33); k2 *= c1; h2 ^= k2;
+			h2 = util_rotate_left(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+		}
+
+		// the last 1 to 15 bytes, little endian
+		const uint8_t* pTail = pBytes + blockCount * 16;
+		const size_t tailSize = size & 15;
+		uint64_t k1 = 0;
+		uint64_t k2 = 0;
+		for (size_t i = 8; i < tailSize; ++i)
+			k2 ^= (uint64_t)pTail[i] << ((i - 8) * 8);
+		for (size_t i = 0; i < tailSize && i < 8; ++i)
+			k1 ^= (uint64_t)pTail[i] << (i * 8);
+
+		if (tailSize > 8)
+		{
+			k2 *= c2; k2 = util_rotate_left(k2, 33); k2 *= c1; h2 ^= k2;
+		}
+		if (tailSize > 0)
+		{
+			k1 *= c1; k1 = util_rotate_left(k1, 31); k1 *= c2; h1 ^= k1;
+		}
+
+		h1 ^= (uint64_t)size;
+		h2 ^= (uint64_t)size;
+		h1 += h2;
+		h2 += h1;
+		h1 = util_final_mix(h1);
+		h2 = util_final_mix(h2);
+		h1 += h2;
+		h2 += h1;
+
+		Hash128 hash = { { h1, h2 } };
+		return hash;
+	}
+
+}
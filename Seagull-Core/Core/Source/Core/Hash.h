@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+#include <stddef.h>
+
+namespace SG
+{
+
+	// 128 bit MurmurHash3 (the x64 variant), for cache keys where a collision must never go unnoticed in practice.
+	// It is not a cryptographic hash.
+
+	typedef struct Hash128
+	{
+		uint64_t value[2];
+	} Hash128;
+
+	inline bool operator==(const Hash128& lhs, const Hash128& rhs) { return lhs.value[0] == rhs.value[0] && lhs.value[1] == rhs.value[1]; }
+	inline bool operator!=(const Hash128& lhs, const Hash128& rhs) { return !(lhs == rhs); }
+
+	Hash128 hash_128(const void* pData, size_t size, uint64_t seed = 0);
+
+}
@@ -0,0 +1,988 @@
+#include "MeshOptimization.h"
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include <include/EASTL/vector.h>
+#include <include/EASTL/sort.h>
+
+#include "Interface/ILog.h"
+
+namespace SG
+{
+
+	/// Entries of the LRU cache the vertex cache optimization scores against, larger than the hardware cache on purpose
+	#define SG_FORSYTH_CACHE_SIZE 32
+	/// Entries of the FIFO cache used to find the clusters of the overdraw optimization
+	#define SG_OVERDRAW_CACHE_SIZE 16
+
+	typedef struct IndexRange
+	{
+		uint32_t first;
+		uint32_t count;
+	} IndexRange;
+
+	/// The range of vertices a part of an index buffer references, so per draw scratch memory does not scale with the whole mesh
+	static IndexRange util_get_index_range(const uint32_t* pIndices, uint32_t indexCount)
+	{
+		uint32_t minIndex = UINT32_MAX;
+		uint32_t maxIndex = 0;
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			minIndex = pIndices[i] < minIndex ? pIndices[i] : minIndex;
+			maxIndex = pIndices[i] > maxIndex ? pIndices[i] : maxIndex;
+		}
+		return indexCount ? IndexRange{ minIndex, maxIndex - minIndex + 1 } : IndexRange{ 0, 0 };
+	}
+
+	static inline const float* util_get_position(const float* pPositions, uint32_t positionStride, uint32_t vertex)
+	{
+		return (const float*)((const uint8_t*)pPositions + (size_t)vertex * positionStride);
+	}
+
+#pragma region (Vertex Deduplication)
+
+	static inline uint32_t util_hash_vertex(const uint8_t* pVertex, uint32_t vertexSize)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (uint32_t i = 0; i < vertexSize; ++i)
+		{
+			hash ^= pVertex[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	uint32_t generate_vertex_remap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, const void* pVertices, uint32_t vertexCount, uint32_t vertexSize)
+	{
+		const uint8_t* pVertexData = (const uint8_t*)pVertices;
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			pRemap[v] = pIndices ? UINT32_MAX : 0;
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			ASSERT(pIndices[i] < vertexCount);
+			pRemap[pIndices[i]] = 0; // referenced
+		}
+
+		uint32_t bucketCount = 16;
+		while (bucketCount < vertexCount * 2)
+			bucketCount *= 2;
+		eastl::vector<uint32_t> buckets(bucketCount, UINT32_MAX);
+
+		uint32_t uniqueCount = 0;
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (UINT32_MAX == pRemap[v])
+				continue;
+
+			const uint8_t* pVertex = pVertexData + (size_t)v * vertexSize;
+			uint32_t bucket = util_hash_vertex(pVertex, vertexSize) & (bucketCount - 1);
+			// linear probing, the table is at most half full
+			while (UINT32_MAX != buckets[bucket] && memcmp(pVertexData + (size_t)buckets[bucket] * vertexSize, pVertex, vertexSize) != 0)
+				bucket = (bucket + 1) & (bucketCount - 1);
+
+			if (UINT32_MAX == buckets[bucket])
+			{
+				buckets[bucket] = v;
+				pRemap[v] = uniqueCount++;
+			}
+			else
+			{
+				pRemap[v] = pRemap[buckets[bucket]];
+			}
+		}
+		return uniqueCount;
+	}
+
+	void remap_index_buffer(uint32_t* pIndices, uint32_t indexCount, const uint32_t* pRemap)
+	{
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			ASSERT(UINT32_MAX != pRemap[pIndices[i]]);
+			pIndices[i] = pRemap[pIndices[i]];
+		}
+	}
+
+#pragma endregion (Vertex Deduplication)
+
+#pragma region (Vertex Cache)
+
+	/// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	static float util_forsyth_vertex_score(int32_t cachePosition, uint32_t remainingValence)
+	{
+		if (0 == remainingValence)
+			return -1.0f; // no triangle needs this vertex anymore
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// used by the last triangle, fixed score so that the next triangle does not just reuse one edge
+				score = 0.75f;
+			}
+			else
+			{
+				const float scaler = 1.0f / (SG_FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, 1.5f);
+			}
+		}
+
+		// boost vertices with few triangles left, so that lone triangles are not left behind
+		return score + 2.0f / sqrtf((float)remainingValence);
+	}
+
+	void optimize_vertex_cache(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		ASSERT(indexCount % 3 == 0);
+		const uint32_t triangleCount = indexCount / 3;
+		if (!triangleCount)
+			return;
+
+		const IndexRange range = util_get_index_range(pIndices, indexCount);
+		ASSERT(range.first + range.count <= vertexCount);
+
+		eastl::vector<uint32_t> indices(indexCount);
+		for (uint32_t i = 0; i < indexCount; ++i)
+			indices[i] = pIndices[i] - range.first;
+
+		// triangle adjacency of every vertex
+		eastl::vector<uint32_t> valence(range.count, 0);
+		for (uint32_t i = 0; i < indexCount; ++i)
+			++valence[indices[i]];
+
+		eastl::vector<uint32_t> adjacencyOffsets(range.count + 1, 0);
+		for (uint32_t v = 0; v < range.count; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+
+		eastl::vector<uint32_t> adjacency(indexCount);
+		{
+			eastl::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t i = 0; i < indexCount; ++i)
+				adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		eastl::vector<int32_t> cachePositions(range.count, -1);
+		eastl::vector<float> vertexScores(range.count);
+		for (uint32_t v = 0; v < range.count; ++v)
+			vertexScores[v] = util_forsyth_vertex_score(-1, valence[v]);
+
+		eastl::vector<float> triangleScores(triangleCount);
+		eastl::vector<bool> emitted(triangleCount, false);
+		int32_t bestTriangle = 0;
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t* tri = &indices[t * 3];
+			triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+			if (triangleScores[t] > triangleScores[bestTriangle])
+				bestTriangle = (int32_t)t;
+		}
+
+		uint32_t cache[SG_FORSYTH_CACHE_SIZE + 3];
+		uint32_t cacheCount = 0;
+		uint32_t nextCandidate = 0;
+
+		eastl::vector<uint32_t> output(indexCount);
+		for (uint32_t out = 0; out < triangleCount; ++out)
+		{
+			if (bestTriangle < 0)
+			{
+				// nothing in the cache has triangles left, continue with the next triangle in the input order
+				while (emitted[nextCandidate])
+					++nextCandidate;
+				bestTriangle = (int32_t)nextCandidate;
+			}
+
+			const uint32_t* tri = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = true;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				output[out * 3 + k] = tri[k] + range.first;
+				--valence[tri[k]];
+			}
+
+			// the triangle's vertices move to the front of the LRU cache
+			uint32_t newCache[SG_FORSYTH_CACHE_SIZE + 3];
+			uint32_t newCacheCount = 0;
+			for (uint32_t k = 0; k < 3; ++k)
+				newCache[newCacheCount++] = tri[k];
+			for (uint32_t c = 0; c < cacheCount; ++c)
+			{
+				const uint32_t v = cache[c];
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+					newCache[newCacheCount++] = v;
+			}
+
+			for (uint32_t c = 0; c < newCacheCount; ++c)
+			{
+				const uint32_t v = newCache[c];
+				cachePositions[v] = c < SG_FORSYTH_CACHE_SIZE ? (int32_t)c : -1;
+				vertexScores[v] = util_forsyth_vertex_score(cachePositions[v], valence[v]);
+			}
+
+			// only the triangles around the touched vertices changed their score
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (uint32_t c = 0; c < newCacheCount; ++c)
+			{
+				const uint32_t v = newCache[c];
+				for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+				{
+					const uint32_t t = adjacency[a];
+					if (emitted[t])
+						continue;
+
+					const uint32_t* adjacentTri = &indices[t * 3];
+					triangleScores[t] = vertexScores[adjacentTri[0]] + vertexScores[adjacentTri[1]] + vertexScores[adjacentTri[2]];
+					if (triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = (int32_t)t;
+					}
+				}
+			}
+
+			cacheCount = newCacheCount < SG_FORSYTH_CACHE_SIZE ? newCacheCount : SG_FORSYTH_CACHE_SIZE;
+			memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+		}
+
+		memcpy(pDst, output.data(), indexCount * sizeof(uint32_t));
+	}
+
+#pragma endregion (Vertex Cache)
+
+#pragma region (Overdraw)
+
+	/// FIFO cache simulation over local vertex ids, advancing the time by more than the cache size flushes it
+	typedef struct FifoCache
+	{
+		eastl::vector<uint32_t> timestamps;
+		uint32_t                time;
+		uint32_t                size;
+	} FifoCache;
+
+	static void util_init_fifo_cache(FifoCache* pCache, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		pCache->timestamps.assign(vertexCount, 0);
+		pCache->size = cacheSize;
+		pCache->time = cacheSize + 1;
+	}
+
+	static inline void util_flush_fifo_cache(FifoCache* pCache)
+	{
+		pCache->time += pCache->size + 1;
+	}
+
+	static inline uint32_t util_fifo_cache_triangle_misses(FifoCache* pCache, const uint32_t* tri)
+	{
+		uint32_t misses = 0;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			if (pCache->time - pCache->timestamps[tri[k]] > pCache->size)
+			{
+				pCache->timestamps[tri[k]] = pCache->time++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+
+	typedef struct OverdrawCluster
+	{
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+		float    sortKey;
+	} OverdrawCluster;
+
+	/// Pedro V. Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	void optimize_overdraw(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold)
+	{
+		ASSERT(indexCount % 3 == 0);
+		const uint32_t triangleCount = indexCount / 3;
+		if (!triangleCount)
+			return;
+
+		const IndexRange range = util_get_index_range(pIndices, indexCount);
+		ASSERT(range.first + range.count <= vertexCount);
+
+		eastl::vector<uint32_t> indices(indexCount);
+		for (uint32_t i = 0; i < indexCount; ++i)
+			indices[i] = pIndices[i] - range.first;
+
+		// hard boundaries: a triangle which misses the cache with every vertex starts a new strip anyway
+		FifoCache cache;
+		util_init_fifo_cache(&cache, range.count, SG_OVERDRAW_CACHE_SIZE);
+		eastl::vector<uint32_t> hardBoundaries;
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			if (3 == util_fifo_cache_triangle_misses(&cache, &indices[t * 3]) || 0 == t)
+				hardBoundaries.push_back(t);
+		}
+		hardBoundaries.push_back(triangleCount);
+
+		// soft boundaries: split the hard clusters as soon as the cache efficiency of the part is close enough to the whole cluster
+		eastl::vector<OverdrawCluster> clusters;
+		for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+		{
+			const uint32_t first = hardBoundaries[h];
+			const uint32_t end = hardBoundaries[h + 1];
+
+			util_flush_fifo_cache(&cache);
+			uint32_t clusterMisses = 0;
+			for (uint32_t t = first; t < end; ++t)
+				clusterMisses += util_fifo_cache_triangle_misses(&cache, &indices[t * 3]);
+			const float clusterAcmr = (float)clusterMisses / (float)(end - first);
+
+			util_flush_fifo_cache(&cache);
+			uint32_t start = first;
+			uint32_t misses = 0;
+			for (uint32_t t = first; t < end; ++t)
+			{
+				misses += util_fifo_cache_triangle_misses(&cache, &indices[t * 3]);
+				const float acmr = (float)misses / (float)(t - start + 1);
+				if (t + 1 < end && acmr <= clusterAcmr * threshold)
+				{
+					clusters.push_back({ start, t + 1 - start, 0.0f });
+					start = t + 1;
+					misses = 0;
+					util_flush_fifo_cache(&cache);
+				}
+			}
+			clusters.push_back({ start, end - start, 0.0f });
+		}
+
+		// sort key: how far the cluster faces away from the mesh center, outward facing clusters occlude the rest
+		eastl::vector<float> clusterData(clusters.size() * 7, 0.0f); // centroid * area, area, normal * area
+		float meshCentroid[3] = {};
+		float meshArea = 0.0f;
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			float* pData = &clusterData[c * 7];
+			for (uint32_t t = clusters[c].firstTriangle; t < clusters[c].firstTriangle + clusters[c].triangleCount; ++t)
+			{
+				const float* p0 = util_get_position(pPositions, positionStride, indices[t * 3 + 0] + range.first);
+				const float* p1 = util_get_position(pPositions, positionStride, indices[t * 3 + 1] + range.first);
+				const float* p2 = util_get_position(pPositions, positionStride, indices[t * 3 + 2] + range.first);
+
+				const float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				const float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+				const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const float centroid = (p0[k] + p1[k] + p2[k]) / 3.0f;
+					pData[k] += centroid * area;
+					pData[4 + k] += n[k];
+					meshCentroid[k] += centroid * area;
+				}
+				pData[3] += area;
+				meshArea += area;
+			}
+		}
+
+		if (meshArea > 0.0f)
+		{
+			for (uint32_t k = 0; k < 3; ++k)
+				meshCentroid[k] /= meshArea;
+		}
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			const float* pData = &clusterData[c * 7];
+			const float normalLength = sqrtf(pData[4] * pData[4] + pData[5] * pData[5] + pData[6] * pData[6]);
+			if (pData[3] <= 0.0f || normalLength <= 0.0f)
+				continue;
+
+			float key = 0.0f;
+			for (uint32_t k = 0; k < 3; ++k)
+				key += (pData[k] / pData[3] - meshCentroid[k]) * (pData[4 + k] / normalLength);
+			clusters[c].sortKey = key;
+		}
+
+		eastl::sort(clusters.begin(), clusters.end(), [](const OverdrawCluster& lhs, const OverdrawCluster& rhs)
+		{
+			return lhs.sortKey > rhs.sortKey || (lhs.sortKey == rhs.sortKey && lhs.firstTriangle < rhs.firstTriangle);
+		});
+
+		uint32_t out = 0;
+		for (const OverdrawCluster& cluster : clusters)
+		{
+			for (uint32_t i = cluster.firstTriangle * 3; i < (cluster.firstTriangle + cluster.triangleCount) * 3; ++i)
+				pDst[out++] = indices[i] + range.first;
+		}
+		ASSERT(out == indexCount);
+	}
+
+#pragma endregion (Overdraw)
+
+#pragma region (Vertex Fetch)
+
+	uint32_t optimize_vertex_fetch_remap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			pRemap[v] = UINT32_MAX;
+
+		uint32_t nextVertex = 0;
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			ASSERT(pIndices[i] < vertexCount);
+			if (UINT32_MAX == pRemap[pIndices[i]])
+				pRemap[pIndices[i]] = nextVertex++;
+		}
+		return nextVertex;
+	}
+
+#pragma endregion (Vertex Fetch)
+
+#pragma region (Simplification)
+
+	/// Symmetric plane quadric (A, b, c) with the total weight of its planes, evaluates to the weighted mean squared distance
+	typedef struct Quadric
+	{
+		float a00, a11, a22, a01, a02, a12;
+		float b0, b1, b2;
+		float c;
+		float w;
+	} Quadric;
+
+	static void util_quadric_from_triangle(Quadric* pQ, const float* p0, const float* p1, const float* p2)
+	{
+		const float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+		const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		memset(pQ, 0, sizeof(Quadric));
+		if (length == 0.0f)
+			return;
+
+		n[0] /= length;
+		n[1] /= length;
+		n[2] /= length;
+		const float d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+		// weight by area, so large triangles dominate the error of the vertices they share with slivers
+		const float w = length * 0.5f;
+		pQ->a00 = w * n[0] * n[0];
+		pQ->a11 = w * n[1] * n[1];
+		pQ->a22 = w * n[2] * n[2];
+		pQ->a01 = w * n[0] * n[1];
+		pQ->a02 = w * n[0] * n[2];
+		pQ->a12 = w * n[1] * n[2];
+		pQ->b0 = w * n[0] * d;
+		pQ->b1 = w * n[1] * d;
+		pQ->b2 = w * n[2] * d;
+		pQ->c = w * d * d;
+		pQ->w = w;
+	}
+
+	static inline void util_quadric_add(Quadric* pDst, const Quadric* pSrc)
+	{
+		pDst->a00 += pSrc->a00; pDst->a11 += pSrc->a11; pDst->a22 += pSrc->a22;
+		pDst->a01 += pSrc->a01; pDst->a02 += pSrc->a02; pDst->a12 += pSrc->a12;
+		pDst->b0 += pSrc->b0; pDst->b1 += pSrc->b1; pDst->b2 += pSrc->b2;
+		pDst->c += pSrc->c;
+		pDst->w += pSrc->w;
+	}
+
+	static inline float util_quadric_error(const Quadric* pQ0, const Quadric* pQ1, const float* p)
+	{
+		const float a00 = pQ0->a00 + pQ1->a00, a11 = pQ0->a11 + pQ1->a11, a22 = pQ0->a22 + pQ1->a22;
+		const float a01 = pQ0->a01 + pQ1->a01, a02 = pQ0->a02 + pQ1->a02, a12 = pQ0->a12 + pQ1->a12;
+		const float b0 = pQ0->b0 + pQ1->b0, b1 = pQ0->b1 + pQ1->b1, b2 = pQ0->b2 + pQ1->b2;
+		const float w = pQ0->w + pQ1->w;
+
+		const float rx = a00 * p[0] + a01 * p[1] + a02 * p[2];
+		const float ry = a01 * p[0] + a11 * p[1] + a12 * p[2];
+		const float rz = a02 * p[0] + a12 * p[1] + a22 * p[2];
+		const float error = p[0] * rx + p[1] * ry + p[2] * rz + 2.0f * (b0 * p[0] + b1 * p[1] + b2 * p[2]) + pQ0->c + pQ1->c;
+		return w > 0.0f && error > 0.0f ? error / w : 0.0f;
+	}
+
+	typedef struct EdgeCollapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float    error;
+	} EdgeCollapse;
+
+	/// Would moving vertex from onto the position of vertex to turn one of the remaining triangles around from over
+	static bool util_collapse_flips_triangle(const uint32_t* pIndices, const uint32_t* pTriangles, uint32_t triangleCount,
+		const uint32_t* pPositionIds, const float* pPositions, uint32_t from, uint32_t to)
+	{
+		const float* target = pPositions + (size_t)to * 3;
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t* tri = pIndices + (size_t)pTriangles[t] * 3;
+			// the triangles with both ends of the edge disappear
+			if (pPositionIds[tri[0]] == pPositionIds[to] || pPositionIds[tri[1]] == pPositionIds[to] || pPositionIds[tri[2]] == pPositionIds[to])
+				continue;
+
+			const uint32_t k = tri[0] == from ? 0 : (tri[1] == from ? 1 : 2);
+			ASSERT(tri[k] == from);
+			const float* p0 = pPositions + (size_t)tri[k] * 3;
+			const float* p1 = pPositions + (size_t)tri[(k + 1) % 3] * 3;
+			const float* p2 = pPositions + (size_t)tri[(k + 2) % 3] * 3;
+
+			const float e1[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+			const float e0[3] = { p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2] };
+			const float e0n[3] = { target[0] - p1[0], target[1] - p1[1], target[2] - p1[2] };
+			const float n[3] = { e1[1] * e0[2] - e1[2] * e0[1], e1[2] * e0[0] - e1[0] * e0[2], e1[0] * e0[1] - e1[1] * e0[0] };
+			const float nn[3] = { e1[1] * e0n[2] - e1[2] * e0n[1], e1[2] * e0n[0] - e1[0] * e0n[2], e1[0] * e0n[1] - e1[1] * e0n[0] };
+			if (n[0] * nn[0] + n[1] * nn[1] + n[2] * nn[2] <= 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	uint32_t simplify_mesh(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride,
+		uint32_t vertexCount, uint32_t targetIndexCount, float targetError, float* pResultError)
+	{
+		if (pResultError)
+			*pResultError = 0.0f;
+
+		const IndexRange range = util_get_index_range(pIndices, indexCount);
+		ASSERT(range.first + range.count <= vertexCount);
+
+		eastl::vector<uint32_t> indices(indexCount);
+		for (uint32_t i = 0; i < indexCount; ++i)
+			indices[i] = pIndices[i] - range.first;
+
+		// normalize the positions, so the error bound is independent of the mesh size
+		eastl::vector<float> positions((size_t)range.count * 3, 0.0f);
+		float minPosition[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxPosition[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			const float* p = util_get_position(pPositions, positionStride, pIndices[i]);
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				minPosition[axis] = p[axis] < minPosition[axis] ? p[axis] : minPosition[axis];
+				maxPosition[axis] = p[axis] > maxPosition[axis] ? p[axis] : maxPosition[axis];
+			}
+		}
+		float extent = 0.0f;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			extent = maxPosition[axis] - minPosition[axis] > extent ? maxPosition[axis] - minPosition[axis] : extent;
+		const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+		for (uint32_t v = 0; v < range.count && indexCount; ++v)
+		{
+			const float* p = util_get_position(pPositions, positionStride, range.first + v);
+			for (uint32_t axis = 0; axis < 3; ++axis)
+				positions[(size_t)v * 3 + axis] = (p[axis] - minPosition[axis]) * scale;
+		}
+
+		// vertices which only differ in other attributes share a position id, the topology is built on the position ids
+		eastl::vector<uint32_t> positionIds(range.count);
+		const uint32_t positionCount = generate_vertex_remap(positionIds.data(), indices.data(), indexCount, positions.data(), range.count, sizeof(float[3]));
+
+		eastl::vector<uint32_t> wedgeCounts(positionCount, 0);
+		for (uint32_t v = 0; v < range.count; ++v)
+		{
+			if (UINT32_MAX != positionIds[v])
+				++wedgeCounts[positionIds[v]];
+		}
+
+		// an edge without its opposite edge lies on the border, its vertices stay to keep the outline (and the seams between draws) closed
+		const uint32_t triangleCount = indexCount / 3;
+		eastl::vector<uint32_t> edgeOffsets(positionCount + 1, 0);
+		for (uint32_t i = 0; i < triangleCount * 3; ++i)
+			++edgeOffsets[positionIds[indices[i]] + 1];
+		for (uint32_t p = 0; p < positionCount; ++p)
+			edgeOffsets[p + 1] += edgeOffsets[p];
+		eastl::vector<uint32_t> edgeTargets(triangleCount * 3);
+		{
+			eastl::vector<uint32_t> fill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const uint32_t p0 = positionIds[indices[t * 3 + k]];
+					const uint32_t p1 = positionIds[indices[t * 3 + (k + 1) % 3]];
+					edgeTargets[fill[p0]++] = p1;
+				}
+			}
+		}
+
+		eastl::vector<bool> lockedPositions(positionCount, false);
+		for (uint32_t p = 0; p < positionCount; ++p)
+		{
+			if (wedgeCounts[p] > 1)
+				lockedPositions[p] = true;
+
+			for (uint32_t e = edgeOffsets[p]; e < edgeOffsets[p + 1]; ++e)
+			{
+				const uint32_t q = edgeTargets[e];
+				bool opposite = false;
+				for (uint32_t r = edgeOffsets[q]; r < edgeOffsets[q + 1] && !opposite; ++r)
+					opposite = edgeTargets[r] == p;
+				if (!opposite)
+				{
+					lockedPositions[p] = true;
+					lockedPositions[q] = true;
+				}
+			}
+		}
+
+		eastl::vector<Quadric> quadrics(positionCount);
+		memset(quadrics.data(), 0, positionCount * sizeof(Quadric));
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t* tri = &indices[t * 3];
+			Quadric q;
+			util_quadric_from_triangle(&q, &positions[(size_t)tri[0] * 3], &positions[(size_t)tri[1] * 3], &positions[(size_t)tri[2] * 3]);
+			for (uint32_t k = 0; k < 3; ++k)
+				util_quadric_add(&quadrics[positionIds[tri[k]]], &q);
+		}
+
+		const float maxError = targetError * targetError;
+		float resultError = 0.0f;
+		uint32_t currentIndexCount = triangleCount * 3;
+
+		eastl::vector<EdgeCollapse> collapses;
+		eastl::vector<uint32_t> collapseTargets(range.count);
+		eastl::vector<bool> touched(positionCount);
+		eastl::vector<uint32_t> triangleOffsets(range.count + 1);
+		eastl::vector<uint32_t> vertexTriangles;
+
+		// every pass collapses a set of independent edges in the order of their error, then rebuilds the index buffer
+		while (currentIndexCount > targetIndexCount)
+		{
+			const uint32_t currentTriangleCount = currentIndexCount / 3;
+
+			collapses.clear();
+			for (uint32_t t = 0; t < currentTriangleCount; ++t)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const uint32_t v0 = indices[t * 3 + k];
+					const uint32_t v1 = indices[t * 3 + (k + 1) % 3];
+					if (!lockedPositions[positionIds[v0]])
+						collapses.push_back({ v0, v1, util_quadric_error(&quadrics[positionIds[v0]], &quadrics[positionIds[v1]], &positions[(size_t)v1 * 3]) });
+					if (!lockedPositions[positionIds[v1]])
+						collapses.push_back({ v1, v0, util_quadric_error(&quadrics[positionIds[v1]], &quadrics[positionIds[v0]], &positions[(size_t)v0 * 3]) });
+				}
+			}
+			eastl::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& lhs, const EdgeCollapse& rhs) { return lhs.error < rhs.error; });
+
+			eastl::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+			for (uint32_t i = 0; i < currentIndexCount; ++i)
+				++triangleOffsets[indices[i] + 1];
+			for (uint32_t v = 0; v < range.count; ++v)
+				triangleOffsets[v + 1] += triangleOffsets[v];
+			vertexTriangles.resize(currentIndexCount);
+			{
+				eastl::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+				for (uint32_t i = 0; i < currentIndexCount; ++i)
+					vertexTriangles[fill[indices[i]]++] = i / 3;
+			}
+
+			for (uint32_t v = 0; v < range.count; ++v)
+				collapseTargets[v] = v;
+			eastl::fill(touched.begin(), touched.end(), false);
+
+			// a collapse removes about two triangles
+			const uint32_t targetCollapses = (currentIndexCount - targetIndexCount) / 6 + 1;
+			uint32_t collapseCount = 0;
+			for (const EdgeCollapse& collapse : collapses)
+			{
+				if (collapse.error > maxError || collapseCount >= targetCollapses)
+					break;
+
+				const uint32_t from = positionIds[collapse.from];
+				const uint32_t to = positionIds[collapse.to];
+				if (touched[from] || touched[to] || from == to)
+					continue;
+
+				const uint32_t* pTriangles = &vertexTriangles[triangleOffsets[collapse.from]];
+				const uint32_t fanCount = triangleOffsets[collapse.from + 1] - triangleOffsets[collapse.from];
+				if (util_collapse_flips_triangle(indices.data(), pTriangles, fanCount, positionIds.data(), positions.data(), collapse.from, collapse.to))
+					continue;
+
+				// the one-ring of the collapsed vertex moves with it, so it sits out the rest of the pass to keep the flip test valid
+				for (uint32_t t = 0; t < fanCount; ++t)
+				{
+					for (uint32_t k = 0; k < 3; ++k)
+						touched[positionIds[indices[(size_t)pTriangles[t] * 3 + k]]] = true;
+				}
+
+				collapseTargets[collapse.from] = collapse.to;
+				util_quadric_add(&quadrics[to], &quadrics[from]);
+				resultError = collapse.error > resultError ? collapse.error : resultError;
+				++collapseCount;
+			}
+
+			if (!collapseCount)
+				break;
+
+			uint32_t writeIndexCount = 0;
+			for (uint32_t t = 0; t < currentTriangleCount; ++t)
+			{
+				const uint32_t v0 = collapseTargets[indices[t * 3]];
+				const uint32_t v1 = collapseTargets[indices[t * 3 + 1]];
+				const uint32_t v2 = collapseTargets[indices[t * 3 + 2]];
+				const uint32_t p0 = positionIds[v0], p1 = positionIds[v1], p2 = positionIds[v2];
+				if (p0 == p1 || p1 == p2 || p0 == p2)
+					continue;
+
+				indices[writeIndexCount++] = v0;
+				indices[writeIndexCount++] = v1;
+				indices[writeIndexCount++] = v2;
+			}
+			currentIndexCount = writeIndexCount;
+		}
+
+		for (uint32_t i = 0; i < currentIndexCount; ++i)
+			pDst[i] = indices[i] + range.first;
+
+		if (pResultError)
+			*pResultError = sqrtf(resultError) * extent;
+		return currentIndexCount;
+	}
+
+#pragma endregion (Simplification)
+
+#pragma region (Meshlets)
+
+	uint32_t get_meshlet_bound(uint32_t indexCount, uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		ASSERT(maxVertices >= 3 && maxVertices <= 256);
+		ASSERT(maxTriangles >= 1);
+		// every meshlet but the last one is flushed with more than maxVertices - 3 vertices or with maxTriangles triangles,
+		// and the meshlet vertices never exceed the index count
+		const uint32_t vertexLimited = (indexCount + maxVertices - 3) / (maxVertices - 2);
+		const uint32_t triangleLimited = (indexCount / 3 + maxTriangles - 1) / maxTriangles;
+		return vertexLimited + triangleLimited + 1;
+	}
+
+	uint32_t build_meshlets(Meshlet* pMeshlets, uint32_t* pMeshletVertices, uint8_t* pMeshletTriangles,
+		const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		ASSERT(maxVertices >= 3 && maxVertices <= 256);
+		ASSERT(maxTriangles >= 1);
+		const uint32_t triangleCount = indexCount / 3;
+		if (!triangleCount)
+			return 0;
+
+		const IndexRange range = util_get_index_range(pIndices, indexCount);
+		ASSERT(range.first + range.count <= vertexCount);
+
+		// meshlet local index of every vertex of the range, 0xff while it is not in the current meshlet
+		eastl::vector<uint8_t> localIndex(range.count, 0xff);
+
+		uint32_t meshletCount = 0;
+		Meshlet meshlet = {};
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t tri[3] = { pIndices[t * 3] - range.first, pIndices[t * 3 + 1] - range.first, pIndices[t * 3 + 2] - range.first };
+			const uint32_t newVertices = (localIndex[tri[0]] == 0xff) + (localIndex[tri[1]] == 0xff) + (localIndex[tri[2]] == 0xff);
+
+			if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount >= maxTriangles)
+			{
+				for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+					localIndex[pMeshletVertices[meshlet.vertexOffset + v] - range.first] = 0xff;
+
+				pMeshlets[meshletCount++] = meshlet;
+				meshlet.vertexOffset += meshlet.vertexCount;
+				meshlet.triangleOffset += meshlet.triangleCount;
+				meshlet.vertexCount = 0;
+				meshlet.triangleCount = 0;
+			}
+
+			uint8_t* pTriangle = pMeshletTriangles + (size_t)(meshlet.triangleOffset + meshlet.triangleCount) * 3;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				if (localIndex[tri[k]] == 0xff)
+				{
+					localIndex[tri[k]] = (uint8_t)meshlet.vertexCount;
+					pMeshletVertices[meshlet.vertexOffset + meshlet.vertexCount++] = tri[k] + range.first;
+				}
+				pTriangle[k] = localIndex[tri[k]];
+			}
+			++meshlet.triangleCount;
+		}
+
+		if (meshlet.triangleCount)
+			pMeshlets[meshletCount++] = meshlet;
+
+		ASSERT(meshletCount <= get_meshlet_bound(indexCount, maxVertices, maxTriangles));
+		return meshletCount;
+	}
+
+	MeshletBounds compute_meshlet_bounds(const Meshlet* pMeshlet, const uint32_t* pMeshletVertices, const uint8_t* pMeshletTriangles,
+		const float* pPositions, uint32_t positionStride)
+	{
+		MeshletBounds bounds = {};
+		bounds.coneCutoff = 1.0f;
+		if (!pMeshlet->vertexCount)
+			return bounds;
+
+		const uint32_t* pVertices = pMeshletVertices + pMeshlet->vertexOffset;
+		const uint8_t* pTriangles = pMeshletTriangles + (size_t)pMeshlet->triangleOffset * 3;
+
+		// Ritter's bounding sphere: start from the two vertices farthest apart along the axis with the largest extent
+		uint32_t minVertex[3] = { 0, 0, 0 };
+		uint32_t maxVertex[3] = { 0, 0, 0 };
+		for (uint32_t v = 0; v < pMeshlet->vertexCount; ++v)
+		{
+			const float* p = util_get_position(pPositions, positionStride, pVertices[v]);
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				if (p[axis] < util_get_position(pPositions, positionStride, pVertices[minVertex[axis]])[axis])
+					minVertex[axis] = v;
+				if (p[axis] > util_get_position(pPositions, positionStride, pVertices[maxVertex[axis]])[axis])
+					maxVertex[axis] = v;
+			}
+		}
+
+		float maxSpan = -1.0f;
+		uint32_t spanAxis = 0;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const float* p0 = util_get_position(pPositions, positionStride, pVertices[minVertex[axis]]);
+			const float* p1 = util_get_position(pPositions, positionStride, pVertices[maxVertex[axis]]);
+			const float span = (p1[0] - p0[0]) * (p1[0] - p0[0]) + (p1[1] - p0[1]) * (p1[1] - p0[1]) + (p1[2] - p0[2]) * (p1[2] - p0[2]);
+			if (span > maxSpan)
+			{
+				maxSpan = span;
+				spanAxis = axis;
+			}
+		}
+
+		const float* p0 = util_get_position(pPositions, positionStride, pVertices[minVertex[spanAxis]]);
+		const float* p1 = util_get_position(pPositions, positionStride, pVertices[maxVertex[spanAxis]]);
+		float center[3] = { (p0[0] + p1[0]) * 0.5f, (p0[1] + p1[1]) * 0.5f, (p0[2] + p1[2]) * 0.5f };
+		float radius = sqrtf(maxSpan) * 0.5f;
+
+		for (uint32_t v = 0; v < pMeshlet->vertexCount; ++v)
+		{
+			const float* p = util_get_position(pPositions, positionStride, pVertices[v]);
+			const float d[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+			const float distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			if (distance > radius)
+			{
+				// grow the sphere just enough to touch p on the far side
+				const float shift = (distance - radius) * 0.5f / distance;
+				center[0] += d[0] * shift;
+				center[1] += d[1] * shift;
+				center[2] += d[2] * shift;
+				radius = (radius + distance) * 0.5f;
+			}
+		}
+
+		memcpy(bounds.center, center, sizeof(center));
+		bounds.radius = radius;
+		memcpy(bounds.coneApex, center, sizeof(center));
+
+		// normal cone: the axis is the average triangle normal, the cone has to contain every normal
+		eastl::vector<float> normals((size_t)pMeshlet->triangleCount * 3);
+		float axis[3] = { 0.0f, 0.0f, 0.0f };
+		uint32_t normalCount = 0;
+		for (uint32_t t = 0; t < pMeshlet->triangleCount; ++t)
+		{
+			const float* a = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3]]);
+			const float* b = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3 + 1]]);
+			const float* c = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3 + 2]]);
+			const float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+			const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			// degenerate triangles are never visible, they do not widen the cone
+			if (length == 0.0f)
+				continue;
+
+			float* pNormal = &normals[(size_t)normalCount++ * 3];
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				pNormal[k] = n[k] / length;
+				axis[k] += pNormal[k];
+			}
+		}
+
+		const float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (!normalCount || axisLength == 0.0f)
+			return bounds;
+		axis[0] /= axisLength;
+		axis[1] /= axisLength;
+		axis[2] /= axisLength;
+
+		float minDot = 1.0f;
+		for (uint32_t t = 0; t < normalCount; ++t)
+		{
+			const float* n = &normals[(size_t)t * 3];
+			const float dp = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+			minDot = dp < minDot ? dp : minDot;
+		}
+
+		// the normals span a half space or more, no view direction sees only back faces
+		if (minDot <= 0.0f)
+			return bounds;
+
+		// move the apex back along the axis until every triangle plane lies in front of it,
+		// then the cone test is conservative for cameras close to the meshlet as well
+		float maxT = 0.0f;
+		uint32_t normalIndex = 0;
+		for (uint32_t t = 0; t < pMeshlet->triangleCount; ++t)
+		{
+			const float* a = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3]]);
+			const float* b = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3 + 1]]);
+			const float* c = util_get_position(pPositions, positionStride, pVertices[pTriangles[t * 3 + 2]]);
+			const float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const float cross[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+			if (cross[0] == 0.0f && cross[1] == 0.0f && cross[2] == 0.0f)
+				continue;
+
+			const float* n = &normals[(size_t)normalIndex++ * 3];
+			const float dc = (center[0] - a[0]) * n[0] + (center[1] - a[1]) * n[1] + (center[2] - a[2]) * n[2];
+			const float dn = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+			const float offset = dc / dn;
+			maxT = offset > maxT ? offset : maxT;
+		}
+
+		bounds.coneApex[0] = center[0] - axis[0] * maxT;
+		bounds.coneApex[1] = center[1] - axis[1] * maxT;
+		bounds.coneApex[2] = center[2] - axis[2] * maxT;
+		memcpy(bounds.coneAxis, axis, sizeof(axis));
+		bounds.coneCutoff = sqrtf(1.0f - minDot * minDot);
+		return bounds;
+	}
+
+#pragma endregion (Meshlets)
+
+	VertexCacheStatistics analyze_vertex_cache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStatistics stats = {};
+		const uint32_t triangleCount = indexCount / 3;
+		if (!triangleCount)
+			return stats;
+
+		const IndexRange range = util_get_index_range(pIndices, indexCount);
+		ASSERT(range.first + range.count <= vertexCount);
+
+		FifoCache cache;
+		util_init_fifo_cache(&cache, range.count, cacheSize);
+		eastl::vector<bool> referenced(range.count, false);
+		uint32_t uniqueCount = 0;
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t tri[3] = { pIndices[t * 3] - range.first, pIndices[t * 3 + 1] - range.first, pIndices[t * 3 + 2] - range.first };
+			stats.verticesTransformed += util_fifo_cache_triangle_misses(&cache, tri);
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				if (!referenced[tri[k]])
+				{
+					referenced[tri[k]] = true;
+					++uniqueCount;
+				}
+			}
+		}
+
+		stats.acmr = (float)stats.verticesTransformed / (float)triangleCount;
+		stats.atvr = (float)stats.verticesTransformed / (float)uniqueCount;
+		return stats;
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+namespace SG
+{
+
+	// Index buffer and vertex order optimizations run by the geometry loader.
+	// All of them work on 32 bit triangle lists, vertexCount is an upper bound of the referenced vertices.
+	// The reorderings only permute triangles, so a range of the index buffer (e.g. one draw) can be optimized on its own.
+
+	typedef struct VertexCacheStatistics
+	{
+		/// Number of vertex shader invocations with the simulated cache
+		uint32_t verticesTransformed;
+		/// Average cache miss ratio, transformed vertices per triangle (0.5 is the best case for a regular grid, 3 the worst)
+		float    acmr;
+		/// Average transformed vertex ratio, transformed vertices per referenced vertex (1 is optimal)
+		float    atvr;
+	} VertexCacheStatistics;
+
+	/// Build a table mapping every vertex to the first vertex with the same vertexSize bytes of data, unreferenced vertices map to UINT32_MAX.
+	/// The unique vertices keep their relative order, returns the number of unique vertices
+	uint32_t generate_vertex_remap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, const void* pVertices, uint32_t vertexCount, uint32_t vertexSize);
+	/// Replace every index by pRemap[index]
+	void remap_index_buffer(uint32_t* pIndices, uint32_t indexCount, const uint32_t* pRemap);
+
+	/// Reorder the triangles for the post-transform vertex cache (Forsyth, tuned for a 32 entry LRU cache). pDst may equal pIndices
+	void optimize_vertex_cache(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+	/// Reorder clusters of an already cache optimized index buffer to draw the outward facing ones first, which reduces overdraw.
+	/// threshold is the allowed ACMR loss, 1.05 keeps the cache efficiency within 5%. pDst may equal pIndices
+	void optimize_overdraw(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold);
+	/// Build a remap table which orders the vertices by their first use in the index buffer, unreferenced vertices map to UINT32_MAX.
+	/// Returns the number of referenced vertices
+	uint32_t optimize_vertex_fetch_remap(uint32_t* pRemap, const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+
+	/// Simulate a FIFO post-transform cache of cacheSize entries
+	VertexCacheStatistics analyze_vertex_cache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize);
+
+	/// Reduce the triangle count of a triangle list by quadric error edge collapses until at most targetIndexCount indices are left
+	/// or the next collapse would move the surface by more than targetError, relative to the extent of the mesh (0.01 is 1%).
+	/// Border vertices and vertices on attribute seams (several vertices with the same position) are kept in place.
+	/// The result references a subset of the input vertices, so it can share the vertex buffer. pDst needs room for indexCount indices.
+	/// Returns the index count of the simplified mesh, pResultError (optional) receives the error in position units
+	uint32_t simplify_mesh(uint32_t* pDst, const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride,
+		uint32_t vertexCount, uint32_t targetIndexCount, float targetError, float* pResultError);
+
+	/// Meshlet limits the geometry loader builds with, they fit the usual mesh shader output limits
+	#define SG_MESHLET_MAX_VERTICES 64
+	#define SG_MESHLET_MAX_TRIANGLES 124
+
+	/// A cluster of triangles which is culled as a whole
+	typedef struct Meshlet
+	{
+		/// First entry of the meshlet in the meshlet vertex array (one vertex index each)
+		uint32_t vertexOffset;
+		/// First entry of the meshlet in the meshlet triangle array (three meshlet local vertices each)
+		uint32_t triangleOffset;
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+	} Meshlet;
+
+	/// Bounding sphere and normal cone of a meshlet.
+	/// The whole meshlet faces away from a camera at position p if dot(normalize(coneApex - p), coneAxis) >= coneCutoff,
+	/// meshlets whose triangles face too many directions get a zero axis and a cutoff of 1 so they are never rejected
+	typedef struct MeshletBounds
+	{
+		float center[3];
+		float radius;
+		float coneApex[3];
+		float coneCutoff;
+		float coneAxis[3];
+		float pad;
+	} MeshletBounds;
+
+	/// Upper bound of the meshlets build_meshlets creates for a triangle list
+	uint32_t get_meshlet_bound(uint32_t indexCount, uint32_t maxVertices, uint32_t maxTriangles);
+	/// Split a triangle list into meshlets in index order, so a cache optimized index buffer gives denser meshlets.
+	/// pMeshletVertices needs room for indexCount entries and pMeshletTriangles for indexCount bytes in the worst case.
+	/// Returns the number of meshlets
+	uint32_t build_meshlets(Meshlet* pMeshlets, uint32_t* pMeshletVertices, uint8_t* pMeshletTriangles,
+		const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles);
+	MeshletBounds compute_meshlet_bounds(const Meshlet* pMeshlet, const uint32_t* pMeshletVertices, const uint8_t* pMeshletTriangles,
+		const float* pPositions, uint32_t positionStride);
+
+}
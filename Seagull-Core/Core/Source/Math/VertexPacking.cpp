@@ -0,0 +1,654 @@
+#include "VertexPacking.h"
+
+#include <string.h>
+#include <math.h>
+
+#include <include/EASTL/algorithm.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define SG_VERTEX_PACKING_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+	#define SG_VERTEX_PACKING_NEON
+	#include <arm_neon.h>
+#endif
+
+// gcc and clang only emit the instructions of a function for its own target
+#if defined(SG_VERTEX_PACKING_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define SG_TARGET_SSE41 __attribute__((target("sse4.1")))
+	#define SG_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+	#define SG_TARGET_SSE41
+	#define SG_TARGET_AVX2
+#endif
+
+/// Elements converted per block, blocks of strided attributes are gathered into a small stack buffer first
+#define SG_PACKING_BLOCK_SIZE 256U
+
+namespace SG
+{
+
+	// The kernels work on flat arrays of floats and return one code per float,
+	// the drivers below gather strided sources and narrow the codes into the strided destination.
+	typedef void (*HalfCodeKernel)(const float* pSrc, int32_t* pDst, uint32_t n);
+	typedef void (*NormCodeKernel)(const float* pSrc, int32_t* pDst, uint32_t n, float minValue, float scale);
+	typedef void (*OctCodeKernel)(const float* pX, const float* pY, const float* pZ, uint32_t* pDst, uint32_t n);
+
+	typedef struct VertexPackingKernels
+	{
+		HalfCodeKernel halfCodes;
+		NormCodeKernel normCodes;
+		OctCodeKernel  octCodes;
+	} VertexPackingKernels;
+
+#pragma region (Scalar Reference)
+
+	static inline int32_t util_half_code(float value)
+	{
+		uint32_t f32 = 0;
+		memcpy(&f32, &value, sizeof(f32));
+
+		int32_t sign = (f32 >> 16) & 0x8000;
+		int32_t exponent = ((f32 >> 23) & 0xff) - 127;
+		int32_t mantissa = f32 & 0x007fffff;
+		if (exponent == 128) // Infinity or NaN
+			return sign | 0x7C00 | (mantissa & 0x3ff);
+		if (exponent > 15)   // Overflow - flush to Infinity
+			return sign | 0x7C00;
+		if (exponent > -15)  // Representable value
+			return sign | ((exponent + 15) << 10) | (mantissa >> 13);
+		return sign;
+	}
+
+	static inline int32_t util_norm_code(float value, float minValue, float scale)
+	{
+		// NaN compares false and ends up at minValue, same as the max instructions of the SIMD kernels
+		value = value > minValue ? value : minValue;
+		value = value < 1.0f ? value : 1.0f;
+		return (int32_t)roundf(value * scale);
+	}
+
+	static inline uint32_t util_oct_code(float x, float y, float z)
+	{
+		float absLength = fabsf(x) + fabsf(y) + fabsf(z);
+		if (absLength == 0.0f)
+			return 0;
+
+		float encX = x / absLength;
+		float encY = y / absLength;
+		float encZ = z / absLength;
+		if (encZ < 0.0f)
+		{
+			float oldX = encX;
+			encX = (1.0f - fabsf(encY)) * (encX >= 0.0f ? 1.0f : -1.0f);
+			encY = (1.0f - fabsf(oldX)) * (encY >= 0.0f ? 1.0f : -1.0f);
+		}
+		encX = encX * 0.5f + 0.5f;
+		encY = encY * 0.5f + 0.5f;
+		return (uint32_t)util_norm_code(encX, 0.0f, 65535.0f) | ((uint32_t)util_norm_code(encY, 0.0f, 65535.0f) << 16);
+	}
+
+	static void half_codes_scalar(const float* pSrc, int32_t* pDst, uint32_t n)
+	{
+		for (uint32_t i = 0; i < n; ++i)
+			pDst[i] = util_half_code(pSrc[i]);
+	}
+
+	static void norm_codes_scalar(const float* pSrc, int32_t* pDst, uint32_t n, float minValue, float scale)
+	{
+		for (uint32_t i = 0; i < n; ++i)
+			pDst[i] = util_norm_code(pSrc[i], minValue, scale);
+	}
+
+	static void oct_codes_scalar(const float* pX, const float* pY, const float* pZ, uint32_t* pDst, uint32_t n)
+	{
+		for (uint32_t i = 0; i < n; ++i)
+			pDst[i] = util_oct_code(pX[i], pY[i], pZ[i]);
+	}
+
+#pragma endregion (Scalar Reference)
+
+#if defined(SG_VERTEX_PACKING_X86)
+#pragma region (SSE4.1)
+
+	SG_TARGET_SSE41 static inline __m128i util_half_code_sse41(__m128 value)
+	{
+		const __m128i bits = _mm_castps_si128(value);
+		const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+		const __m128i exponent = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127));
+		const __m128i mantissa = _mm_and_si128(bits, _mm_set1_epi32(0x007fffff));
+
+		const __m128i normal = _mm_or_si128(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(15)), 10), _mm_srli_epi32(mantissa, 13));
+		const __m128i infinity = _mm_set1_epi32(0x7C00);
+		const __m128i nan = _mm_or_si128(infinity, _mm_and_si128(mantissa, _mm_set1_epi32(0x3ff)));
+
+		__m128i code = _mm_and_si128(normal, _mm_cmpgt_epi32(exponent, _mm_set1_epi32(-15)));
+		code = _mm_blendv_epi8(code, infinity, _mm_cmpgt_epi32(exponent, _mm_set1_epi32(15)));
+		code = _mm_blendv_epi8(code, nan, _mm_cmpeq_epi32(exponent, _mm_set1_epi32(128)));
+		return _mm_or_si128(code, sign);
+	}
+
+	/// roundf() for the clamped and scaled values, which are far below 2^23 so the fraction is exact
+	SG_TARGET_SSE41 static inline __m128i util_round_half_away_sse41(__m128 value)
+	{
+		const __m128i truncated = _mm_cvttps_epi32(value);
+		const __m128 fraction = _mm_sub_ps(value, _mm_cvtepi32_ps(truncated));
+		// compare masks are -1, subtracting the "up" mask and adding the "down" mask moves away from zero
+		__m128i code = _mm_sub_epi32(truncated, _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))));
+		return _mm_add_epi32(code, _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f))));
+	}
+
+	SG_TARGET_SSE41 static inline __m128i util_norm_code_sse41(__m128 value, __m128 minValue, __m128 scale)
+	{
+		value = _mm_min_ps(_mm_max_ps(value, minValue), _mm_set1_ps(1.0f));
+		return util_round_half_away_sse41(_mm_mul_ps(value, scale));
+	}
+
+	SG_TARGET_SSE41 static void half_codes_sse41(const float* pSrc, int32_t* pDst, uint32_t n)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_si128((__m128i*)(pDst + i), util_half_code_sse41(_mm_loadu_ps(pSrc + i)));
+		for (; i < n; ++i)
+			pDst[i] = util_half_code(pSrc[i]);
+	}
+
+	SG_TARGET_SSE41 static void norm_codes_sse41(const float* pSrc, int32_t* pDst, uint32_t n, float minValue, float scale)
+	{
+		const __m128 minValues = _mm_set1_ps(minValue);
+		const __m128 scales = _mm_set1_ps(scale);
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_si128((__m128i*)(pDst + i), util_norm_code_sse41(_mm_loadu_ps(pSrc + i), minValues, scales));
+		for (; i < n; ++i)
+			pDst[i] = util_norm_code(pSrc[i], minValue, scale);
+	}
+
+	SG_TARGET_SSE41 static void oct_codes_sse41(const float* pX, const float* pY, const float* pZ, uint32_t* pDst, uint32_t n)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 scale = _mm_set1_ps(65535.0f);
+
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(pX + i);
+			__m128 y = _mm_loadu_ps(pY + i);
+			__m128 z = _mm_loadu_ps(pZ + i);
+
+			__m128 absLength = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+			__m128 valid = _mm_cmpneq_ps(absLength, zero);
+			// keep the division of the zero lanes finite, they are masked out at the end
+			absLength = _mm_blendv_ps(one, absLength, valid);
+
+			__m128 encX = _mm_div_ps(x, absLength);
+			__m128 encY = _mm_div_ps(y, absLength);
+			__m128 encZ = _mm_div_ps(z, absLength);
+
+			__m128 signX = _mm_blendv_ps(_mm_set1_ps(-1.0f), one, _mm_cmpge_ps(encX, zero));
+			__m128 signY = _mm_blendv_ps(_mm_set1_ps(-1.0f), one, _mm_cmpge_ps(encY, zero));
+			__m128 wrapX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, encY)), signX);
+			__m128 wrapY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, encX)), signY);
+			__m128 lowerHemisphere = _mm_cmplt_ps(encZ, zero);
+			encX = _mm_blendv_ps(encX, wrapX, lowerHemisphere);
+			encY = _mm_blendv_ps(encY, wrapY, lowerHemisphere);
+
+			encX = _mm_add_ps(_mm_mul_ps(encX, half), half);
+			encY = _mm_add_ps(_mm_mul_ps(encY, half), half);
+
+			__m128i codeX = util_norm_code_sse41(encX, zero, scale);
+			__m128i codeY = util_norm_code_sse41(encY, zero, scale);
+			__m128i code = _mm_or_si128(codeX, _mm_slli_epi32(codeY, 16));
+			_mm_storeu_si128((__m128i*)(pDst + i), _mm_and_si128(code, _mm_castps_si128(valid)));
+		}
+		for (; i < n; ++i)
+			pDst[i] = util_oct_code(pX[i], pY[i], pZ[i]);
+	}
+
+#pragma endregion (SSE4.1)
+
+#pragma region (AVX2)
+
+	SG_TARGET_AVX2 static inline __m256i util_half_code_avx2(__m256 value)
+	{
+		const __m256i bits = _mm256_castps_si256(value);
+		const __m256i sign = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x8000));
+		const __m256i exponent = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127));
+		const __m256i mantissa = _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff));
+
+		const __m256i normal = _mm256_or_si256(_mm256_slli_epi32(_mm256_add_epi32(exponent, _mm256_set1_epi32(15)), 10), _mm256_srli_epi32(mantissa, 13));
+		const __m256i infinity = _mm256_set1_epi32(0x7C00);
+		const __m256i nan = _mm256_or_si256(infinity, _mm256_and_si256(mantissa, _mm256_set1_epi32(0x3ff)));
+
+		__m256i code = _mm256_and_si256(normal, _mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(-15)));
+		code = _mm256_blendv_epi8(code, infinity, _mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(15)));
+		code = _mm256_blendv_epi8(code, nan, _mm256_cmpeq_epi32(exponent, _mm256_set1_epi32(128)));
+		return _mm256_or_si256(code, sign);
+	}
+
+	SG_TARGET_AVX2 static inline __m256i util_round_half_away_avx2(__m256 value)
+	{
+		const __m256i truncated = _mm256_cvttps_epi32(value);
+		const __m256 fraction = _mm256_sub_ps(value, _mm256_cvtepi32_ps(truncated));
+		__m256i code = _mm256_sub_epi32(truncated, _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+		return _mm256_add_epi32(code, _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(-0.5f), _CMP_LE_OQ)));
+	}
+
+	SG_TARGET_AVX2 static inline __m256i util_norm_code_avx2(__m256 value, __m256 minValue, __m256 scale)
+	{
+		value = _mm256_min_ps(_mm256_max_ps(value, minValue), _mm256_set1_ps(1.0f));
+		return util_round_half_away_avx2(_mm256_mul_ps(value, scale));
+	}
+
+	SG_TARGET_AVX2 static void half_codes_avx2(const float* pSrc, int32_t* pDst, uint32_t n)
+	{
+		uint32_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_si256((__m256i*)(pDst + i), util_half_code_avx2(_mm256_loadu_ps(pSrc + i)));
+		for (; i < n; ++i)
+			pDst[i] = util_half_code(pSrc[i]);
+	}
+
+	SG_TARGET_AVX2 static void norm_codes_avx2(const float* pSrc, int32_t* pDst, uint32_t n, float minValue, float scale)
+	{
+		const __m256 minValues = _mm256_set1_ps(minValue);
+		const __m256 scales = _mm256_set1_ps(scale);
+		uint32_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_si256((__m256i*)(pDst + i), util_norm_code_avx2(_mm256_loadu_ps(pSrc + i), minValues, scales));
+		for (; i < n; ++i)
+			pDst[i] = util_norm_code(pSrc[i], minValue, scale);
+	}
+
+	SG_TARGET_AVX2 static void oct_codes_avx2(const float* pX, const float* pY, const float* pZ, uint32_t* pDst, uint32_t n)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 scale = _mm256_set1_ps(65535.0f);
+
+		uint32_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(pX + i);
+			__m256 y = _mm256_loadu_ps(pY + i);
+			__m256 z = _mm256_loadu_ps(pZ + i);
+
+			__m256 absLength = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(signMask, x), _mm256_andnot_ps(signMask, y)), _mm256_andnot_ps(signMask, z));
+			__m256 valid = _mm256_cmp_ps(absLength, zero, _CMP_NEQ_UQ);
+			absLength = _mm256_blendv_ps(one, absLength, valid);
+
+			__m256 encX = _mm256_div_ps(x, absLength);
+			__m256 encY = _mm256_div_ps(y, absLength);
+			__m256 encZ = _mm256_div_ps(z, absLength);
+
+			__m256 signX = _mm256_blendv_ps(_mm256_set1_ps(-1.0f), one, _mm256_cmp_ps(encX, zero, _CMP_GE_OQ));
+			__m256 signY = _mm256_blendv_ps(_mm256_set1_ps(-1.0f), one, _mm256_cmp_ps(encY, zero, _CMP_GE_OQ));
+			__m256 wrapX = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, encY)), signX);
+			__m256 wrapY = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, encX)), signY);
+			__m256 lowerHemisphere = _mm256_cmp_ps(encZ, zero, _CMP_LT_OQ);
+			encX = _mm256_blendv_ps(encX, wrapX, lowerHemisphere);
+			encY = _mm256_blendv_ps(encY, wrapY, lowerHemisphere);
+
+			encX = _mm256_add_ps(_mm256_mul_ps(encX, half), half);
+			encY = _mm256_add_ps(_mm256_mul_ps(encY, half), half);
+
+			__m256i codeX = util_norm_code_avx2(encX, zero, scale);
+			__m256i codeY = util_norm_code_avx2(encY, zero, scale);
+			__m256i code = _mm256_or_si256(codeX, _mm256_slli_epi32(codeY, 16));
+			_mm256_storeu_si256((__m256i*)(pDst + i), _mm256_and_si256(code, _mm256_castps_si256(valid)));
+		}
+		for (; i < n; ++i)
+			pDst[i] = util_oct_code(pX[i], pY[i], pZ[i]);
+	}
+
+#pragma endregion (AVX2)
+
+	static void util_cpuid(uint32_t leaf, uint32_t subLeaf, uint32_t* pRegs)
+	{
+	#if defined(_MSC_VER)
+		__cpuidex((int*)pRegs, (int)leaf, (int)subLeaf);
+	#else
+		__cpuid_count(leaf, subLeaf, pRegs[0], pRegs[1], pRegs[2], pRegs[3]);
+	#endif
+	}
+
+	static bool util_cpu_supports(VertexPackingISA isa)
+	{
+		uint32_t regs[4] = {};
+		util_cpuid(0, 0, regs);
+		const uint32_t maxLeaf = regs[0];
+
+		util_cpuid(1, 0, regs);
+		const bool sse41 = (regs[2] >> 19) & 1;
+		if (SG_VERTEX_PACKING_ISA_SSE41 == isa)
+			return sse41;
+
+		if (SG_VERTEX_PACKING_ISA_AVX2 == isa)
+		{
+			// the OS has to save the ymm registers too
+			const bool osxsave = (regs[2] >> 27) & 1;
+			const bool avx = (regs[2] >> 28) & 1;
+			if (!sse41 || !osxsave || !avx || maxLeaf < 7)
+				return false;
+	#if defined(_MSC_VER)
+			const uint64_t xcr0 = _xgetbv(0);
+	#else
+			uint32_t xcr0Low = 0, xcr0High = 0;
+			__asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+			const uint64_t xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+	#endif
+			if ((xcr0 & 0x6) != 0x6)
+				return false;
+
+			util_cpuid(7, 0, regs);
+			return (regs[1] >> 5) & 1;
+		}
+
+		return SG_VERTEX_PACKING_ISA_SCALAR == isa;
+	}
+#endif
+
+#if defined(SG_VERTEX_PACKING_NEON)
+#pragma region (NEON)
+
+	static inline int32x4_t util_half_code_neon(float32x4_t value)
+	{
+		const int32x4_t bits = vreinterpretq_s32_f32(value);
+		const int32x4_t sign = vandq_s32(vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(bits), 16)), vdupq_n_s32(0x8000));
+		const int32x4_t exponent = vsubq_s32(vandq_s32(vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(bits), 23)), vdupq_n_s32(0xff)), vdupq_n_s32(127));
+		const int32x4_t mantissa = vandq_s32(bits, vdupq_n_s32(0x007fffff));
+
+		const int32x4_t normal = vorrq_s32(vshlq_n_s32(vaddq_s32(exponent, vdupq_n_s32(15)), 10), vshrq_n_s32(mantissa, 13));
+		const int32x4_t infinity = vdupq_n_s32(0x7C00);
+		const int32x4_t nan = vorrq_s32(infinity, vandq_s32(mantissa, vdupq_n_s32(0x3ff)));
+
+		int32x4_t code = vandq_s32(normal, vreinterpretq_s32_u32(vcgtq_s32(exponent, vdupq_n_s32(-15))));
+		code = vbslq_s32(vcgtq_s32(exponent, vdupq_n_s32(15)), infinity, code);
+		code = vbslq_s32(vceqq_s32(exponent, vdupq_n_s32(128)), nan, code);
+		return vorrq_s32(code, sign);
+	}
+
+	static inline int32x4_t util_round_half_away_neon(float32x4_t value)
+	{
+		const int32x4_t truncated = vcvtq_s32_f32(value);
+		const float32x4_t fraction = vsubq_f32(value, vcvtq_f32_s32(truncated));
+		int32x4_t code = vsubq_s32(truncated, vreinterpretq_s32_u32(vcgeq_f32(fraction, vdupq_n_f32(0.5f))));
+		return vaddq_s32(code, vreinterpretq_s32_u32(vcleq_f32(fraction, vdupq_n_f32(-0.5f))));
+	}
+
+	static inline int32x4_t util_norm_code_neon(float32x4_t value, float32x4_t minValue, float32x4_t scale)
+	{
+		value = vminq_f32(vmaxnmq_f32(value, minValue), vdupq_n_f32(1.0f));
+		return util_round_half_away_neon(vmulq_f32(value, scale));
+	}
+
+	static void half_codes_neon(const float* pSrc, int32_t* pDst, uint32_t n)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(pDst + i, util_half_code_neon(vld1q_f32(pSrc + i)));
+		for (; i < n; ++i)
+			pDst[i] = util_half_code(pSrc[i]);
+	}
+
+	static void norm_codes_neon(const float* pSrc, int32_t* pDst, uint32_t n, float minValue, float scale)
+	{
+		const float32x4_t minValues = vdupq_n_f32(minValue);
+		const float32x4_t scales = vdupq_n_f32(scale);
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(pDst + i, util_norm_code_neon(vld1q_f32(pSrc + i), minValues, scales));
+		for (; i < n; ++i)
+			pDst[i] = util_norm_code(pSrc[i], minValue, scale);
+	}
+
+	static void oct_codes_neon(const float* pX, const float* pY, const float* pZ, uint32_t* pDst, uint32_t n)
+	{
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		const float32x4_t half = vdupq_n_f32(0.5f);
+		const float32x4_t scale = vdupq_n_f32(65535.0f);
+
+		uint32_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			float32x4_t x = vld1q_f32(pX + i);
+			float32x4_t y = vld1q_f32(pY + i);
+			float32x4_t z = vld1q_f32(pZ + i);
+
+			float32x4_t absLength = vaddq_f32(vaddq_f32(vabsq_f32(x), vabsq_f32(y)), vabsq_f32(z));
+			uint32x4_t valid = vmvnq_u32(vceqq_f32(absLength, zero));
+			absLength = vbslq_f32(valid, absLength, one);
+
+			// vdivq_f32 is correctly rounded like the scalar division, a reciprocal estimate would not be bit-exact
+			float32x4_t encX = vdivq_f32(x, absLength);
+			float32x4_t encY = vdivq_f32(y, absLength);
+			float32x4_t encZ = vdivq_f32(z, absLength);
+
+			float32x4_t signX = vbslq_f32(vcgeq_f32(encX, zero), one, vdupq_n_f32(-1.0f));
+			float32x4_t signY = vbslq_f32(vcgeq_f32(encY, zero), one, vdupq_n_f32(-1.0f));
+			float32x4_t wrapX = vmulq_f32(vsubq_f32(one, vabsq_f32(encY)), signX);
+			float32x4_t wrapY = vmulq_f32(vsubq_f32(one, vabsq_f32(encX)), signY);
+			uint32x4_t lowerHemisphere = vcltq_f32(encZ, zero);
+			encX = vbslq_f32(lowerHemisphere, wrapX, encX);
+			encY = vbslq_f32(lowerHemisphere, wrapY, encY);
+
+			encX = vaddq_f32(vmulq_f32(encX, half), half);
+			encY = vaddq_f32(vmulq_f32(encY, half), half);
+
+			int32x4_t codeX = util_norm_code_neon(encX, zero, scale);
+			int32x4_t codeY = util_norm_code_neon(encY, zero, scale);
+			uint32x4_t code = vorrq_u32(vreinterpretq_u32_s32(codeX), vshlq_n_u32(vreinterpretq_u32_s32(codeY), 16));
+			vst1q_u32(pDst + i, vandq_u32(code, valid));
+		}
+		for (; i < n; ++i)
+			pDst[i] = util_oct_code(pX[i], pY[i], pZ[i]);
+	}
+
+#pragma endregion (NEON)
+#endif
+
+	static const VertexPackingKernels gVertexPackingKernels[SG_VERTEX_PACKING_ISA_COUNT] =
+	{
+		{ half_codes_scalar, norm_codes_scalar, oct_codes_scalar },
+#if defined(SG_VERTEX_PACKING_X86)
+		{ half_codes_sse41, norm_codes_sse41, oct_codes_sse41 },
+		{ half_codes_avx2, norm_codes_avx2, oct_codes_avx2 },
+#else
+		{ nullptr, nullptr, nullptr },
+		{ nullptr, nullptr, nullptr },
+#endif
+#if defined(SG_VERTEX_PACKING_NEON)
+		{ half_codes_neon, norm_codes_neon, oct_codes_neon },
+#else
+		{ nullptr, nullptr, nullptr },
+#endif
+	};
+
+	static bool util_is_vertex_packing_isa_supported(VertexPackingISA isa)
+	{
+		if (isa >= SG_VERTEX_PACKING_ISA_COUNT || !gVertexPackingKernels[isa].halfCodes)
+			return false;
+#if defined(SG_VERTEX_PACKING_X86)
+		return util_cpu_supports(isa);
+#else
+		return true;
+#endif
+	}
+
+	static VertexPackingISA util_select_vertex_packing_isa()
+	{
+		const VertexPackingISA preferred[] = { SG_VERTEX_PACKING_ISA_AVX2, SG_VERTEX_PACKING_ISA_NEON, SG_VERTEX_PACKING_ISA_SSE41 };
+		for (VertexPackingISA isa : preferred)
+		{
+			if (util_is_vertex_packing_isa_supported(isa))
+				return isa;
+		}
+		return SG_VERTEX_PACKING_ISA_SCALAR;
+	}
+
+	static VertexPackingISA gVertexPackingISA = util_select_vertex_packing_isa();
+
+	VertexPackingISA get_vertex_packing_isa()
+	{
+		return gVertexPackingISA;
+	}
+
+	const char* get_vertex_packing_isa_name(VertexPackingISA isa)
+	{
+		static const char* names[] = { "Scalar", "SSE4.1", "AVX2", "NEON" };
+		SG_COMPILE_ASSERT(sizeof(names) / sizeof(names[0]) == SG_VERTEX_PACKING_ISA_COUNT);
+		return isa < SG_VERTEX_PACKING_ISA_COUNT ? names[isa] : "Unknown";
+	}
+
+	bool set_vertex_packing_isa(VertexPackingISA isa)
+	{
+		if (!util_is_vertex_packing_isa_supported(isa))
+			return false;
+		gVertexPackingISA = isa;
+		return true;
+	}
+
+	/// Point at a block of floats: tightly packed sources are used in place, strided ones are gathered into pScratch
+	static inline const float* util_gather_float_block(const uint8_t* src, uint32_t srcStride, uint32_t components, uint32_t count, float* pScratch)
+	{
+		const uint32_t elementSize = components * sizeof(float);
+		if (srcStride == elementSize)
+			return (const float*)src;
+
+		for (uint32_t e = 0; e < count; ++e)
+			memcpy(pScratch + e * components, src + e * srcStride, elementSize);
+		return pScratch;
+	}
+
+	template <typename CodeType, typename ConvertFunc>
+	static void util_pack_float_codes(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst, ConvertFunc convert)
+	{
+		ASSERT(components && components <= 4);
+		float scratch[SG_PACKING_BLOCK_SIZE * 4];
+		int32_t codes[SG_PACKING_BLOCK_SIZE * 4];
+
+		for (uint32_t first = 0; first < count; first += SG_PACKING_BLOCK_SIZE)
+		{
+			const uint32_t blockCount = eastl::min(SG_PACKING_BLOCK_SIZE, count - first);
+			const float* pBlock = util_gather_float_block(src + (size_t)first * srcStride, srcStride, components, blockCount, scratch);
+			convert(pBlock, codes, blockCount * components);
+
+			uint8_t* pDst = dst + (size_t)first * dstStride;
+			for (uint32_t e = 0; e < blockCount; ++e)
+			{
+				CodeType* pElement = (CodeType*)(pDst + e * dstStride);
+				for (uint32_t c = 0; c < components; ++c)
+					pElement[c] = (CodeType)codes[e * components + c];
+			}
+		}
+	}
+
+	void pack_float_to_half(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		HalfCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].halfCodes;
+		util_pack_float_codes<uint16_t>(count, components, srcStride, dstStride, src, dst,
+			[kernel](const float* pSrc, int32_t* pDst, uint32_t n) { kernel(pSrc, pDst, n); });
+	}
+
+	void pack_float_to_unorm16(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		NormCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].normCodes;
+		util_pack_float_codes<uint16_t>(count, components, srcStride, dstStride, src, dst,
+			[kernel](const float* pSrc, int32_t* pDst, uint32_t n) { kernel(pSrc, pDst, n, 0.0f, 65535.0f); });
+	}
+
+	void pack_float_to_snorm16(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		NormCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].normCodes;
+		util_pack_float_codes<int16_t>(count, components, srcStride, dstStride, src, dst,
+			[kernel](const float* pSrc, int32_t* pDst, uint32_t n) { kernel(pSrc, pDst, n, -1.0f, 32767.0f); });
+	}
+
+	void pack_float_to_unorm8(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		NormCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].normCodes;
+		util_pack_float_codes<uint8_t>(count, components, srcStride, dstStride, src, dst,
+			[kernel](const float* pSrc, int32_t* pDst, uint32_t n) { kernel(pSrc, pDst, n, 0.0f, 255.0f); });
+	}
+
+	void pack_float_to_snorm8(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		NormCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].normCodes;
+		util_pack_float_codes<int8_t>(count, components, srcStride, dstStride, src, dst,
+			[kernel](const float* pSrc, int32_t* pDst, uint32_t n) { kernel(pSrc, pDst, n, -1.0f, 127.0f); });
+	}
+
+	void pack_float3_direction_to_oct16(uint32_t count, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		OctCodeKernel kernel = gVertexPackingKernels[gVertexPackingISA].octCodes;
+		float x[SG_PACKING_BLOCK_SIZE];
+		float y[SG_PACKING_BLOCK_SIZE];
+		float z[SG_PACKING_BLOCK_SIZE];
+		uint32_t codes[SG_PACKING_BLOCK_SIZE];
+
+		for (uint32_t first = 0; first < count; first += SG_PACKING_BLOCK_SIZE)
+		{
+			const uint32_t blockCount = eastl::min(SG_PACKING_BLOCK_SIZE, count - first);
+			const uint8_t* pSrc = src + (size_t)first * srcStride;
+			// deinterleave, the kernels work on one component per register
+			for (uint32_t e = 0; e < blockCount; ++e)
+			{
+				const float* pElement = (const float*)(pSrc + e * srcStride);
+				x[e] = pElement[0];
+				y[e] = pElement[1];
+				z[e] = pElement[2];
+			}
+			kernel(x, y, z, codes, blockCount);
+
+			uint8_t* pDst = dst + (size_t)first * dstStride;
+			for (uint32_t e = 0; e < blockCount; ++e)
+				*(uint32_t*)(pDst + e * dstStride) = codes[e];
+		}
+	}
+
+	void interleave_vertex_attribute(uint32_t count, uint32_t elementSize, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+	{
+		if (srcStride == elementSize && dstStride == elementSize)
+		{
+			memcpy(dst, src, (size_t)count * elementSize);
+			return;
+		}
+
+		// constant sizes let the compiler turn the copies into plain loads and stores
+		switch (elementSize)
+		{
+		case 4:
+			for (uint32_t e = 0; e < count; ++e)
+				memcpy(dst + (size_t)e * dstStride, src + (size_t)e * srcStride, 4);
+			break;
+		case 8:
+			for (uint32_t e = 0; e < count; ++e)
+				memcpy(dst + (size_t)e * dstStride, src + (size_t)e * srcStride, 8);
+			break;
+		case 12:
+			for (uint32_t e = 0; e < count; ++e)
+				memcpy(dst + (size_t)e * dstStride, src + (size_t)e * srcStride, 12);
+			break;
+		case 16:
+			for (uint32_t e = 0; e < count; ++e)
+				memcpy(dst + (size_t)e * dstStride, src + (size_t)e * srcStride, 16);
+			break;
+		default:
+			for (uint32_t e = 0; e < count; ++e)
+				memcpy(dst + (size_t)e * dstStride, src + (size_t)e * srcStride, elementSize);
+			break;
+		}
+	}
+
+}
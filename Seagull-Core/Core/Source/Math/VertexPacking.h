@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+namespace SG
+{
+
+	/// Instruction set used by the vertex packing kernels, the best one the CPU supports is picked on first use
+	typedef enum VertexPackingISA
+	{
+		SG_VERTEX_PACKING_ISA_SCALAR = 0,
+		SG_VERTEX_PACKING_ISA_SSE41,
+		SG_VERTEX_PACKING_ISA_AVX2,
+		SG_VERTEX_PACKING_ISA_NEON,
+		SG_VERTEX_PACKING_ISA_COUNT,
+	} VertexPackingISA;
+
+	VertexPackingISA get_vertex_packing_isa();
+	const char* get_vertex_packing_isa_name(VertexPackingISA isa);
+	/// Force the kernels of an instruction set, e.g. SG_VERTEX_PACKING_ISA_SCALAR to compare against the reference.
+	/// Returns false (and keeps the current kernels) if the CPU does not support it
+	bool set_vertex_packing_isa(VertexPackingISA isa);
+
+	// Every kernel converts count elements read srcStride bytes apart and writes them dstStride bytes apart,
+	// so the same kernel packs a tightly packed stream or one attribute of an interleaved vertex.
+	// The SIMD kernels are bit-exact with the scalar reference.
+
+	/// float -> half, the mantissa is truncated and values too small for a normal half flush to zero
+	void pack_float_to_half(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	/// float -> unorm/snorm, clamped to [0, 1] / [-1, 1] and rounded half away from zero
+	void pack_float_to_unorm16(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	void pack_float_to_snorm16(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	void pack_float_to_unorm8(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	void pack_float_to_snorm8(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	/// float3 direction (normal, tangent) -> octahedral encoding stored as unorm2x16
+	void pack_float3_direction_to_oct16(uint32_t count, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+	/// Copy elementSize bytes per element, interleaves an attribute into a vertex buffer without conversion
+	void interleave_vertex_attribute(uint32_t count, uint32_t elementSize, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+
+}
@@ -0,0 +1,306 @@
+#include "RangeAllocator.h"
+
+#include <string.h>
+
+#include <include/EASTL/vector.h>
+
+#include "Interface/ILog.h"
+#include "Interface/IMemory.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace SG
+{
+
+	#define SG_RANGE_ALLOCATOR_SUBCLASS_LOG2 3
+	#define SG_RANGE_ALLOCATOR_CLASS_COUNT 64
+	#define SG_RANGE_NODE_NONE UINT32_MAX
+
+	SG_COMPILE_ASSERT((1 << SG_RANGE_ALLOCATOR_SUBCLASS_LOG2) == SG_RANGE_ALLOCATOR_SUBCLASS_COUNT);
+
+	/// A free or allocated range, linked to the ranges next to it in the block and, while free, to the other free ranges of its size class.
+	/// Offsets and sizes are in units of the granularity
+	typedef struct RangeNode
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t prevPhysical;
+		uint32_t nextPhysical;
+		uint32_t prevFree;
+		uint32_t nextFree;
+		bool     free;
+	} RangeNode;
+
+	struct RangeAllocator
+	{
+		uint64_t                 granularity;
+		uint64_t                 freeSize;
+		/// Bit per size class with free ranges, and per class the bits of its subclasses with free ranges
+		uint64_t                 classBitmap;
+		uint32_t                 subclassBitmaps[SG_RANGE_ALLOCATOR_CLASS_COUNT];
+		uint32_t                 freeHeads[SG_RANGE_ALLOCATOR_CLASS_COUNT][SG_RANGE_ALLOCATOR_SUBCLASS_COUNT];
+		eastl::vector<RangeNode> nodes;
+		/// Entries of nodes which were merged into a neighbour and can be reused
+		eastl::vector<uint32_t>  unusedNodes;
+	};
+
+	static inline uint32_t util_find_last_set(uint64_t value)
+	{
+		ASSERT(value);
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return (uint32_t)index;
+	#else
+		return 63u - (uint32_t)__builtin_clzll(value);
+	#endif
+	}
+
+	static inline uint32_t util_find_first_set(uint64_t value)
+	{
+		ASSERT(value);
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return (uint32_t)index;
+	#else
+		return (uint32_t)__builtin_ctzll(value);
+	#endif
+	}
+
+	/// Sizes below the subclass count get a subclass each, larger ones are split by their highest bit and the bits below it
+	static void util_get_size_class(uint64_t size, uint32_t* pClass, uint32_t* pSubclass)
+	{
+		if (size < SG_RANGE_ALLOCATOR_SUBCLASS_COUNT)
+		{
+			*pClass = 0;
+			*pSubclass = (uint32_t)size;
+			return;
+		}
+		const uint32_t highestBit = util_find_last_set(size);
+		*pClass = highestBit - SG_RANGE_ALLOCATOR_SUBCLASS_LOG2 + 1;
+		*pSubclass = (uint32_t)(size >> (highestBit - SG_RANGE_ALLOCATOR_SUBCLASS_LOG2)) - SG_RANGE_ALLOCATOR_SUBCLASS_COUNT;
+	}
+
+	static uint32_t util_add_node(RangeAllocator* pAllocator, uint64_t offset, uint64_t size)
+	{
+		uint32_t node;
+		if (!pAllocator->unusedNodes.empty())
+		{
+			node = pAllocator->unusedNodes.back();
+			pAllocator->unusedNodes.pop_back();
+		}
+		else
+		{
+			node = (uint32_t)pAllocator->nodes.size();
+			pAllocator->nodes.push_back();
+		}
+		RangeNode& rangeNode = pAllocator->nodes[node];
+		rangeNode = {};
+		rangeNode.offset = offset;
+		rangeNode.size = size;
+		rangeNode.prevPhysical = SG_RANGE_NODE_NONE;
+		rangeNode.nextPhysical = SG_RANGE_NODE_NONE;
+		rangeNode.prevFree = SG_RANGE_NODE_NONE;
+		rangeNode.nextFree = SG_RANGE_NODE_NONE;
+		return node;
+	}
+
+	static void util_insert_free_node(RangeAllocator* pAllocator, uint32_t node)
+	{
+		RangeNode& rangeNode = pAllocator->nodes[node];
+		uint32_t sizeClass, subclass;
+		util_get_size_class(rangeNode.size, &sizeClass, &subclass);
+
+		const uint32_t head = pAllocator->freeHeads[sizeClass][subclass];
+		rangeNode.free = true;
+		rangeNode.prevFree = SG_RANGE_NODE_NONE;
+		rangeNode.nextFree = head;
+		if (head != SG_RANGE_NODE_NONE)
+			pAllocator->nodes[head].prevFree = node;
+		pAllocator->freeHeads[sizeClass][subclass] = node;
+		pAllocator->classBitmap |= 1ull << sizeClass;
+		pAllocator->subclassBitmaps[sizeClass] |= 1u << subclass;
+		pAllocator->freeSize += rangeNode.size;
+	}
+
+	static void util_remove_free_node(RangeAllocator* pAllocator, uint32_t node)
+	{
+		RangeNode& rangeNode = pAllocator->nodes[node];
+		ASSERT(rangeNode.free);
+		uint32_t sizeClass, subclass;
+		util_get_size_class(rangeNode.size, &sizeClass, &subclass);
+
+		if (rangeNode.prevFree != SG_RANGE_NODE_NONE)
+			pAllocator->nodes[rangeNode.prevFree].nextFree = rangeNode.nextFree;
+		else
+			pAllocator->freeHeads[sizeClass][subclass] = rangeNode.nextFree;
+		if (rangeNode.nextFree != SG_RANGE_NODE_NONE)
+			pAllocator->nodes[rangeNode.nextFree].prevFree = rangeNode.prevFree;
+
+		if (pAllocator->freeHeads[sizeClass][subclass] == SG_RANGE_NODE_NONE)
+		{
+			pAllocator->subclassBitmaps[sizeClass] &= ~(1u << subclass);
+			if (!pAllocator->subclassBitmaps[sizeClass])
+				pAllocator->classBitmap &= ~(1ull << sizeClass);
+		}
+		rangeNode.free = false;
+		rangeNode.prevFree = SG_RANGE_NODE_NONE;
+		rangeNode.nextFree = SG_RANGE_NODE_NONE;
+		pAllocator->freeSize -= rangeNode.size;
+	}
+
+	/// Fold the free node next into node, which comes right before it in the block
+	static void util_merge_nodes(RangeAllocator* pAllocator, uint32_t node, uint32_t next)
+	{
+		RangeNode& rangeNode = pAllocator->nodes[node];
+		RangeNode& nextNode = pAllocator->nodes[next];
+		ASSERT(rangeNode.nextPhysical == next && rangeNode.offset + rangeNode.size == nextNode.offset);
+		rangeNode.size += nextNode.size;
+		rangeNode.nextPhysical = nextNode.nextPhysical;
+		if (nextNode.nextPhysical != SG_RANGE_NODE_NONE)
+			pAllocator->nodes[nextNode.nextPhysical].prevPhysical = node;
+		pAllocator->unusedNodes.push_back(next);
+	}
+
+	void add_range_allocator(uint64_t size, uint64_t granularity, RangeAllocator** ppAllocator)
+	{
+		ASSERT(ppAllocator);
+		ASSERT(granularity && !(granularity & (granularity - 1)));
+
+		RangeAllocator* pAllocator = sg_new(RangeAllocator);
+		pAllocator->granularity = granularity;
+		pAllocator->freeSize = 0;
+		pAllocator->classBitmap = 0;
+		memset(pAllocator->subclassBitmaps, 0, sizeof(pAllocator->subclassBitmaps));
+		memset(pAllocator->freeHeads, 0xff, sizeof(pAllocator->freeHeads));
+
+		// the tail which is not a multiple of the granularity is never handed out
+		const uint64_t units = size / granularity;
+		if (units)
+			util_insert_free_node(pAllocator, util_add_node(pAllocator, 0, units));
+
+		*ppAllocator = pAllocator;
+	}
+
+	void remove_range_allocator(RangeAllocator* pAllocator)
+	{
+		ASSERT(pAllocator);
+		sg_delete(pAllocator);
+	}
+
+	bool allocate_range(RangeAllocator* pAllocator, uint64_t size, RangeAllocation* pOutAllocation)
+	{
+		ASSERT(pAllocator && pOutAllocation);
+		ASSERT(size);
+
+		const uint64_t units = (size + pAllocator->granularity - 1) / pAllocator->granularity;
+		// round up to the next subclass, so any free range of the class that is found fits
+		uint64_t searchSize = units;
+		if (searchSize >= SG_RANGE_ALLOCATOR_SUBCLASS_COUNT)
+			searchSize += (1ull << (util_find_last_set(searchSize) - SG_RANGE_ALLOCATOR_SUBCLASS_LOG2)) - 1;
+
+		uint32_t node = SG_RANGE_NODE_NONE;
+		uint32_t sizeClass, subclass;
+		util_get_size_class(searchSize, &sizeClass, &subclass);
+		if (sizeClass < SG_RANGE_ALLOCATOR_CLASS_COUNT)
+		{
+			uint32_t subclassMap = pAllocator->subclassBitmaps[sizeClass] & (~0u << subclass);
+			if (!subclassMap)
+			{
+				const uint64_t classMap = sizeClass + 1 < SG_RANGE_ALLOCATOR_CLASS_COUNT ? pAllocator->classBitmap & (~0ull << (sizeClass + 1)) : 0;
+				if (classMap)
+				{
+					sizeClass = util_find_first_set(classMap);
+					subclassMap = pAllocator->subclassBitmaps[sizeClass];
+				}
+			}
+			if (subclassMap)
+				node = pAllocator->freeHeads[sizeClass][util_find_first_set(subclassMap)];
+		}
+
+		// the rounding skips the subclass of the request, a range in it may still be large enough, e.g. one of exactly the requested size
+		if (node == SG_RANGE_NODE_NONE)
+		{
+			util_get_size_class(units, &sizeClass, &subclass);
+			if (sizeClass >= SG_RANGE_ALLOCATOR_CLASS_COUNT)
+				return false;
+			for (uint32_t candidate = pAllocator->freeHeads[sizeClass][subclass]; candidate != SG_RANGE_NODE_NONE; candidate = pAllocator->nodes[candidate].nextFree)
+			{
+				if (pAllocator->nodes[candidate].size >= units)
+				{
+					node = candidate;
+					break;
+				}
+			}
+			if (node == SG_RANGE_NODE_NONE)
+				return false;
+		}
+
+		ASSERT(pAllocator->nodes[node].size >= units);
+		util_remove_free_node(pAllocator, node);
+
+		// hand the rest of the range back as a free range of its own
+		if (pAllocator->nodes[node].size > units)
+		{
+			const uint32_t rest = util_add_node(pAllocator, pAllocator->nodes[node].offset + units, pAllocator->nodes[node].size - units);
+			RangeNode& rangeNode = pAllocator->nodes[node];
+			RangeNode& restNode = pAllocator->nodes[rest];
+			restNode.prevPhysical = node;
+			restNode.nextPhysical = rangeNode.nextPhysical;
+			if (rangeNode.nextPhysical != SG_RANGE_NODE_NONE)
+				pAllocator->nodes[rangeNode.nextPhysical].prevPhysical = rest;
+			rangeNode.nextPhysical = rest;
+			rangeNode.size = units;
+			util_insert_free_node(pAllocator, rest);
+		}
+
+		pOutAllocation->offset = pAllocator->nodes[node].offset * pAllocator->granularity;
+		pOutAllocation->size = units * pAllocator->granularity;
+		pOutAllocation->node = node;
+		return true;
+	}
+
+	void free_range(RangeAllocator* pAllocator, const RangeAllocation* pAllocation)
+	{
+		ASSERT(pAllocator && pAllocation);
+		uint32_t node = pAllocation->node;
+		ASSERT(node < pAllocator->nodes.size() && !pAllocator->nodes[node].free);
+
+		const uint32_t next = pAllocator->nodes[node].nextPhysical;
+		if (next != SG_RANGE_NODE_NONE && pAllocator->nodes[next].free)
+		{
+			util_remove_free_node(pAllocator, next);
+			util_merge_nodes(pAllocator, node, next);
+		}
+		const uint32_t prev = pAllocator->nodes[node].prevPhysical;
+		if (prev != SG_RANGE_NODE_NONE && pAllocator->nodes[prev].free)
+		{
+			util_remove_free_node(pAllocator, prev);
+			util_merge_nodes(pAllocator, prev, node);
+			node = prev;
+		}
+		util_insert_free_node(pAllocator, node);
+	}
+
+	uint64_t get_range_allocator_free_size(const RangeAllocator* pAllocator)
+	{
+		return pAllocator->freeSize * pAllocator->granularity;
+	}
+
+	uint64_t get_range_allocator_largest_free_range(const RangeAllocator* pAllocator)
+	{
+		if (!pAllocator->classBitmap)
+			return 0;
+		// the ranges of a subclass are not sorted, look at all of the largest non-empty one
+		const uint32_t sizeClass = util_find_last_set(pAllocator->classBitmap);
+		const uint32_t subclass = util_find_last_set(pAllocator->subclassBitmaps[sizeClass]);
+		uint64_t largest = 0;
+		for (uint32_t node = pAllocator->freeHeads[sizeClass][subclass]; node != SG_RANGE_NODE_NONE; node = pAllocator->nodes[node].nextFree)
+			largest = pAllocator->nodes[node].size > largest ? pAllocator->nodes[node].size : largest;
+		return largest * pAllocator->granularity;
+	}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+namespace SG
+{
+
+	// Two level segregated fit (TLSF) allocator of ranges inside a block of a fixed size, e.g. a large GPU buffer.
+	// It only hands out offsets and never touches the memory. The free ranges are kept in lists per size class (a power of two
+	// split into SG_RANGE_ALLOCATOR_SUBCLASS_COUNT linear steps), so allocating and freeing take constant time.
+	// Freed ranges merge with their free neighbours right away. The allocator is not thread safe.
+
+	#define SG_RANGE_ALLOCATOR_SUBCLASS_COUNT 8
+
+	typedef struct RangeAllocator RangeAllocator;
+
+	typedef struct RangeAllocation
+	{
+		/// Offset of the range in the block, a multiple of the granularity
+		uint64_t offset;
+		/// Size of the range, the requested size rounded up to the granularity
+		uint64_t size;
+		/// Handle of the range for free_range
+		uint32_t node;
+	} RangeAllocation;
+
+	/// size is the size of the block, granularity the alignment of every range (a power of two)
+	void add_range_allocator(uint64_t size, uint64_t granularity, RangeAllocator** ppAllocator);
+	void remove_range_allocator(RangeAllocator* pAllocator);
+
+	/// Returns false if no free range is large enough
+	bool allocate_range(RangeAllocator* pAllocator, uint64_t size, RangeAllocation* pOutAllocation);
+	void free_range(RangeAllocator* pAllocator, const RangeAllocation* pAllocation);
+
+	/// Bytes not covered by allocated ranges, they may be fragmented
+	uint64_t get_range_allocator_free_size(const RangeAllocator* pAllocator);
+	/// Size of the largest free range
+	uint64_t get_range_allocator_largest_free_range(const RangeAllocator* pAllocator);
+
+}
@@ -0,0 +1,470 @@
+#include "MipGenerator.h"
+
+#include <string.h>
+#include <math.h>
+
+#include <include/EASTL/vector.h>
+#include <include/EASTL/algorithm.h>
+
+#include "Interface/ILog.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define SG_MIP_GENERATOR_SSE2
+	#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+	#define SG_MIP_GENERATOR_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace SG
+{
+
+	/// Half width of the Kaiser filter in destination texels and the shape parameter of its window
+	#define SG_KAISER_FILTER_WIDTH 3.0f
+	#define SG_KAISER_FILTER_ALPHA 4.0f
+	/// Entries of the linear to sRGB table, fine enough to stay within one 8 bit step at the dark end
+	#define SG_SRGB_ENCODE_TABLE_SIZE 8192
+
+#pragma region (Texel Math)
+
+	// the filters work on four float channels per texel, missing channels are zero
+
+#if defined(SG_MIP_GENERATOR_SSE2)
+	typedef __m128 Texel;
+	static inline Texel util_texel_zero() { return _mm_setzero_ps(); }
+	static inline Texel util_texel_load(const float* pValues) { return _mm_loadu_ps(pValues); }
+	static inline void util_texel_store(float* pValues, Texel texel) { _mm_storeu_ps(pValues, texel); }
+	static inline Texel util_texel_madd(Texel acc, Texel texel, float weight) { return _mm_add_ps(acc, _mm_mul_ps(texel, _mm_set1_ps(weight))); }
+#elif defined(SG_MIP_GENERATOR_NEON)
+	typedef float32x4_t Texel;
+	static inline Texel util_texel_zero() { return vdupq_n_f32(0.0f); }
+	static inline Texel util_texel_load(const float* pValues) { return vld1q_f32(pValues); }
+	static inline void util_texel_store(float* pValues, Texel texel) { vst1q_f32(pValues, texel); }
+	static inline Texel util_texel_madd(Texel acc, Texel texel, float weight) { return vmlaq_n_f32(acc, texel, weight); }
+#else
+	typedef struct Texel
+	{
+		float values[4];
+	} Texel;
+	static inline Texel util_texel_zero() { return Texel{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	static inline Texel util_texel_load(const float* pValues) { return Texel{ { pValues[0], pValues[1], pValues[2], pValues[3] } }; }
+	static inline void util_texel_store(float* pValues, Texel texel) { memcpy(pValues, texel.values, sizeof(texel.values)); }
+	static inline Texel util_texel_madd(Texel acc, Texel texel, float weight)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			acc.values[c] += texel.values[c] * weight;
+		return acc;
+	}
+#endif
+
+	typedef struct SrgbTables
+	{
+		float   decode[256];
+		uint8_t encode[SG_SRGB_ENCODE_TABLE_SIZE];
+
+		SrgbTables()
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				const float value = (float)i / 255.0f;
+				decode[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (uint32_t i = 0; i < SG_SRGB_ENCODE_TABLE_SIZE; ++i)
+			{
+				const float value = (float)i / (float)(SG_SRGB_ENCODE_TABLE_SIZE - 1);
+				const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+				encode[i] = (uint8_t)(srgb * 255.0f + 0.5f);
+			}
+		}
+	} SrgbTables;
+
+	static const SrgbTables& util_get_srgb_tables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	typedef struct TexelCodec
+	{
+		uint32_t     channelCount;
+		/// The leading channels which are stored sRGB encoded
+		uint32_t     srgbChannels;
+		uint32_t     texelSize;
+		MipTexelType texelType;
+		bool         normalMap;
+	} TexelCodec;
+
+	static void util_decode_texels(const TexelCodec& codec, const uint8_t* pSrc, uint32_t count, float* pDst)
+	{
+		const uint32_t channelCount = codec.channelCount;
+		memset(pDst, 0, count * 4 * sizeof(float));
+		if (SG_MIP_TEXEL_FLOAT32 == codec.texelType)
+		{
+			const float* pValues = (const float*)pSrc;
+			for (uint32_t i = 0; i < count; ++i)
+				memcpy(pDst + i * 4, pValues + i * channelCount, channelCount * sizeof(float));
+			return;
+		}
+
+		const SrgbTables& tables = util_get_srgb_tables();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				const uint8_t value = pSrc[i * channelCount + c];
+				pDst[i * 4 + c] = c < codec.srgbChannels ? tables.decode[value] : (float)value * (1.0f / 255.0f);
+			}
+		}
+	}
+
+	static void util_encode_texels(const TexelCodec& codec, const float* pSrc, uint32_t count, uint8_t* pDst)
+	{
+		const uint32_t channelCount = codec.channelCount;
+		const bool unorm = SG_MIP_TEXEL_UNORM8 == codec.texelType;
+		const SrgbTables& tables = util_get_srgb_tables();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			float texel[4];
+			memcpy(texel, pSrc + i * 4, sizeof(texel));
+
+			if (codec.normalMap && channelCount >= 3)
+			{
+				float n[3];
+				for (uint32_t c = 0; c < 3; ++c)
+					n[c] = unorm ? texel[c] * 2.0f - 1.0f : texel[c];
+				const float lengthSquared = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+				if (lengthSquared > 1e-12f)
+				{
+					const float invLength = 1.0f / sqrtf(lengthSquared);
+					for (uint32_t c = 0; c < 3; ++c)
+						texel[c] = unorm ? n[c] * invLength * 0.5f + 0.5f : n[c] * invLength;
+				}
+			}
+
+			if (!unorm)
+			{
+				memcpy((float*)pDst + i * channelCount, texel, channelCount * sizeof(float));
+				continue;
+			}
+
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				const float value = texel[c] < 0.0f ? 0.0f : (texel[c] > 1.0f ? 1.0f : texel[c]);
+				pDst[i * channelCount + c] = c < codec.srgbChannels ?
+					tables.encode[(uint32_t)(value * (float)(SG_SRGB_ENCODE_TABLE_SIZE - 1) + 0.5f)] :
+					(uint8_t)(value * 255.0f + 0.5f);
+			}
+		}
+	}
+
+#pragma endregion (Texel Math)
+
+#pragma region (Downsampling)
+
+	/// Weights of the source texels which contribute to every destination texel along one axis
+	typedef struct FilterTaps
+	{
+		/// First source texel of every destination texel, outside of the image for the texels next to the border
+		eastl::vector<int32_t> first;
+		/// tapCount weights per destination texel, summing up to one
+		eastl::vector<float>   weights;
+		uint32_t               tapCount;
+	} FilterTaps;
+
+	static float util_bessel_i0(float x)
+	{
+		const float halfSquared = x * x * 0.25f;
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (uint32_t k = 1; k < 32 && term > sum * 1e-8f; ++k)
+		{
+			term *= halfSquared / (float)(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	/// x is the distance in destination texels
+	static float util_kaiser_sinc(float x)
+	{
+		const float t = x / SG_KAISER_FILTER_WIDTH;
+		if (t <= -1.0f || t >= 1.0f)
+			return 0.0f;
+
+		const float window = util_bessel_i0(SG_KAISER_FILTER_ALPHA * sqrtf(1.0f - t * t)) / util_bessel_i0(SG_KAISER_FILTER_ALPHA);
+		const float px = 3.14159265f * x;
+		return (fabsf(px) < 1e-4f ? 1.0f : sinf(px) / px) * window;
+	}
+
+	static void util_build_filter_taps(MipFilter filter, uint32_t srcSize, uint32_t dstSize, FilterTaps* pTaps)
+	{
+		const float scale = (float)srcSize / (float)dstSize;
+		const float support = SG_MIP_FILTER_KAISER == filter ? SG_KAISER_FILTER_WIDTH * scale : 0.5f * scale;
+		const uint32_t tapCount = (uint32_t)ceilf(2.0f * support) + 1;
+		pTaps->tapCount = tapCount;
+		pTaps->first.resize(dstSize);
+		pTaps->weights.resize(dstSize * tapCount);
+
+		for (uint32_t i = 0; i < dstSize; ++i)
+		{
+			const float center = ((float)i + 0.5f) * scale;
+			const int32_t first = (int32_t)floorf(center - support);
+			float* pWeights = &pTaps->weights[i * tapCount];
+			float sum = 0.0f;
+			for (uint32_t t = 0; t < tapCount; ++t)
+			{
+				const float j = (float)(first + (int32_t)t);
+				if (SG_MIP_FILTER_KAISER == filter)
+				{
+					pWeights[t] = util_kaiser_sinc((j + 0.5f - center) / scale);
+				}
+				else
+				{
+					// the part of the source texel [j, j + 1] inside the footprint of the destination texel
+					const float lo = eastl::max(j, (float)i * scale);
+					const float hi = eastl::min(j + 1.0f, (float)(i + 1) * scale);
+					pWeights[t] = eastl::max(0.0f, hi - lo);
+				}
+				sum += pWeights[t];
+			}
+
+			if (sum != 0.0f)
+			{
+				for (uint32_t t = 0; t < tapCount; ++t)
+					pWeights[t] /= sum;
+			}
+			pTaps->first[i] = first;
+		}
+	}
+
+	typedef struct DownsampleScratch
+	{
+		/// Decoded source row
+		eastl::vector<float>   sourceRow;
+		/// Ring of horizontally filtered source rows, a destination row needs at most yTaps.tapCount of them
+		eastl::vector<float>   filteredRows;
+		eastl::vector<int32_t> filteredRowTags;
+		eastl::vector<float>   destinationRow;
+	} DownsampleScratch;
+
+	static inline int32_t util_clamp_texel(int32_t index, uint32_t size)
+	{
+		return index < 0 ? 0 : (index >= (int32_t)size ? (int32_t)size - 1 : index);
+	}
+
+	static void util_downsample_level(const TexelCodec& codec, const FilterTaps& xTaps, const FilterTaps& yTaps,
+		const uint8_t* pSrc, uint32_t srcRowPitch, uint32_t srcWidth, uint32_t srcHeight,
+		uint8_t* pDst, uint32_t dstRowPitch, uint32_t dstWidth, uint32_t dstHeight, DownsampleScratch* pScratch)
+	{
+		const uint32_t ringSize = yTaps.tapCount;
+		pScratch->sourceRow.resize(srcWidth * 4);
+		pScratch->filteredRows.resize(ringSize * dstWidth * 4);
+		pScratch->filteredRowTags.assign(ringSize, -1);
+		pScratch->destinationRow.resize(dstWidth * 4);
+
+		for (uint32_t y = 0; y < dstHeight; ++y)
+		{
+			float* pDstRow = pScratch->destinationRow.data();
+			memset(pDstRow, 0, dstWidth * 4 * sizeof(float));
+
+			for (uint32_t ty = 0; ty < yTaps.tapCount; ++ty)
+			{
+				const float weightY = yTaps.weights[y * yTaps.tapCount + ty];
+				if (weightY == 0.0f)
+					continue;
+
+				// the rows of consecutive destination rows overlap, every source row is filtered horizontally once
+				const int32_t row = util_clamp_texel(yTaps.first[y] + (int32_t)ty, srcHeight);
+				float* pFiltered = &pScratch->filteredRows[(row % ringSize) * dstWidth * 4];
+				if (pScratch->filteredRowTags[row % ringSize] != row)
+				{
+					const float* pSrcRow = pScratch->sourceRow.data();
+					util_decode_texels(codec, pSrc + (size_t)row * srcRowPitch, srcWidth, pScratch->sourceRow.data());
+					for (uint32_t x = 0; x < dstWidth; ++x)
+					{
+						const float* pWeights = &xTaps.weights[x * xTaps.tapCount];
+						Texel acc = util_texel_zero();
+						for (uint32_t tx = 0; tx < xTaps.tapCount; ++tx)
+						{
+							if (pWeights[tx] != 0.0f)
+								acc = util_texel_madd(acc, util_texel_load(pSrcRow + util_clamp_texel(xTaps.first[x] + (int32_t)tx, srcWidth) * 4), pWeights[tx]);
+						}
+						util_texel_store(pFiltered + x * 4, acc);
+					}
+					pScratch->filteredRowTags[row % ringSize] = row;
+				}
+
+				for (uint32_t x = 0; x < dstWidth; ++x)
+					util_texel_store(pDstRow + x * 4, util_texel_madd(util_texel_load(pDstRow + x * 4), util_texel_load(pFiltered + x * 4), weightY));
+			}
+
+			util_encode_texels(codec, pDstRow, dstWidth, pDst + (size_t)y * dstRowPitch);
+		}
+	}
+
+#pragma endregion (Downsampling)
+
+#pragma region (Cubemap Edge Fixup)
+
+	/// u and v in [-1, 1] of a cube face to a direction whose major axis is one, the inverse of the cube map face selection of the graphics APIs
+	static void util_cube_face_to_direction(uint32_t face, float u, float v, float* pDir)
+	{
+		switch (face)
+		{
+		case 0: pDir[0] = 1.0f;  pDir[1] = -v;    pDir[2] = -u;    break;
+		case 1: pDir[0] = -1.0f; pDir[1] = -v;    pDir[2] = u;     break;
+		case 2: pDir[0] = u;     pDir[1] = 1.0f;  pDir[2] = v;     break;
+		case 3: pDir[0] = u;     pDir[1] = -1.0f; pDir[2] = -v;    break;
+		case 4: pDir[0] = u;     pDir[1] = -v;    pDir[2] = 1.0f;  break;
+		default: pDir[0] = -u;   pDir[1] = -v;    pDir[2] = -1.0f; break;
+		}
+	}
+
+	/// Returns false when the direction is not on the face
+	static bool util_direction_to_cube_face(const float* pDir, uint32_t face, float* pU, float* pV)
+	{
+		const float sign = (face & 1) ? -1.0f : 1.0f;
+		if (pDir[face >> 1] * sign != 1.0f)
+			return false;
+
+		switch (face)
+		{
+		case 0: *pU = -pDir[2]; *pV = -pDir[1]; break;
+		case 1: *pU = pDir[2];  *pV = -pDir[1]; break;
+		case 2: *pU = pDir[0];  *pV = pDir[2];  break;
+		case 3: *pU = pDir[0];  *pV = -pDir[2]; break;
+		case 4: *pU = pDir[0];  *pV = -pDir[1]; break;
+		default: *pU = -pDir[0]; *pV = -pDir[1]; break;
+		}
+		return true;
+	}
+
+	/// Average the texels of the six faces of one mip which meet at the same cube edge (two faces) or corner (three faces)
+	static void util_fixup_cube_edges(const TexelCodec& codec, uint8_t* const* ppFaces, const uint32_t* pRowPitches, uint32_t size)
+	{
+		float texels[6][4];
+		uint8_t* pTexels[6];
+
+		if (1 == size)
+		{
+			// every texel touches every face
+			float average[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (uint32_t f = 0; f < 6; ++f)
+			{
+				util_decode_texels(codec, ppFaces[f], 1, texels[f]);
+				for (uint32_t c = 0; c < 4; ++c)
+					average[c] += texels[f][c] / 6.0f;
+			}
+			for (uint32_t f = 0; f < 6; ++f)
+				util_encode_texels(codec, average, 1, ppFaces[f]);
+			return;
+		}
+
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			for (uint32_t y = 0; y < size; ++y)
+			{
+				const bool borderRow = 0 == y || size - 1 == y;
+				for (uint32_t x = 0; x < size; x += (borderRow || size - 1 == x) ? 1 : size - 1)
+				{
+					// move the texel center onto the edge and find the texels of the other faces at that point
+					const float u = 0 == x ? -1.0f : (size - 1 == x ? 1.0f : (2.0f * x + 1.0f) / size - 1.0f);
+					const float v = 0 == y ? -1.0f : (size - 1 == y ? 1.0f : (2.0f * y + 1.0f) / size - 1.0f);
+					float dir[3];
+					util_cube_face_to_direction(face, u, v, dir);
+
+					uint32_t count = 0;
+					float average[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					for (uint32_t g = 0; g < 6; ++g)
+					{
+						float gu, gv;
+						if (!util_direction_to_cube_face(dir, g, &gu, &gv))
+							continue;
+						const int32_t gx = util_clamp_texel((int32_t)floorf((gu + 1.0f) * 0.5f * size), size);
+						const int32_t gy = util_clamp_texel((int32_t)floorf((gv + 1.0f) * 0.5f * size), size);
+						pTexels[count] = ppFaces[g] + (size_t)gy * pRowPitches[g] + (size_t)gx * codec.texelSize;
+						util_decode_texels(codec, pTexels[count], 1, texels[count]);
+						for (uint32_t c = 0; c < 4; ++c)
+							average[c] += texels[count][c];
+						++count;
+					}
+
+					for (uint32_t c = 0; c < 4; ++c)
+						average[c] /= (float)count;
+					for (uint32_t i = 0; i < count; ++i)
+						util_encode_texels(codec, average, 1, pTexels[i]);
+				}
+			}
+		}
+	}
+
+#pragma endregion (Cubemap Edge Fixup)
+
+	uint32_t get_mip_level_count(uint32_t width, uint32_t height)
+	{
+		uint32_t levelCount = 1;
+		for (uint32_t size = eastl::max(width, height); size > 1; size >>= 1)
+			++levelCount;
+		return levelCount;
+	}
+
+	bool generate_mip_chain(const MipChainDesc* pDesc)
+	{
+		if (!pDesc->ppLevels || !pDesc->pRowPitches || !pDesc->width || !pDesc->height || !pDesc->levelCount ||
+			pDesc->channelCount < 1 || pDesc->channelCount > 4 || SG_MIP_FILTER_NONE == pDesc->filter ||
+			(pDesc->cubemap && (pDesc->layerCount % 6 || pDesc->width != pDesc->height)))
+		{
+			SG_LOG_ERROR("Invalid mip chain description (%ux%u, %u levels, %u layers, %u channels)",
+				pDesc->width, pDesc->height, pDesc->levelCount, pDesc->layerCount, pDesc->channelCount);
+			return false;
+		}
+
+		TexelCodec codec = {};
+		codec.channelCount = pDesc->channelCount;
+		codec.texelType = pDesc->texelType;
+		codec.texelSize = pDesc->channelCount * (SG_MIP_TEXEL_FLOAT32 == pDesc->texelType ? 4 : 1);
+		codec.normalMap = (pDesc->flags & SG_MIP_GENERATION_FLAG_NORMAL_MAP) != 0;
+		if ((pDesc->flags & SG_MIP_GENERATION_FLAG_SRGB) && SG_MIP_TEXEL_UNORM8 == pDesc->texelType)
+			codec.srgbChannels = 4 == pDesc->channelCount ? 3 : pDesc->channelCount;
+
+		const uint32_t levelCount = pDesc->levelCount;
+		FilterTaps xTaps;
+		FilterTaps yTaps;
+		DownsampleScratch scratch;
+		for (uint32_t level = 1; level < levelCount; ++level)
+		{
+			const uint32_t srcWidth = eastl::max(1U, pDesc->width >> (level - 1));
+			const uint32_t srcHeight = eastl::max(1U, pDesc->height >> (level - 1));
+			const uint32_t dstWidth = eastl::max(1U, pDesc->width >> level);
+			const uint32_t dstHeight = eastl::max(1U, pDesc->height >> level);
+			util_build_filter_taps(pDesc->filter, srcWidth, dstWidth, &xTaps);
+			util_build_filter_taps(pDesc->filter, srcHeight, dstHeight, &yTaps);
+
+			for (uint32_t layer = 0; layer < pDesc->layerCount; ++layer)
+			{
+				const uint32_t src = layer * levelCount + level - 1;
+				util_downsample_level(codec, xTaps, yTaps,
+					pDesc->ppLevels[src], pDesc->pRowPitches[src], srcWidth, srcHeight,
+					pDesc->ppLevels[src + 1], pDesc->pRowPitches[src + 1], dstWidth, dstHeight, &scratch);
+			}
+
+			if (!pDesc->cubemap)
+				continue;
+
+			for (uint32_t cube = 0; cube < pDesc->layerCount / 6; ++cube)
+			{
+				uint8_t* pFaces[6];
+				uint32_t rowPitches[6];
+				for (uint32_t face = 0; face < 6; ++face)
+				{
+					pFaces[face] = pDesc->ppLevels[(cube * 6 + face) * levelCount + level];
+					rowPitches[face] = pDesc->pRowPitches[(cube * 6 + face) * levelCount + level];
+				}
+				util_fixup_cube_edges(codec, pFaces, rowPitches, dstWidth);
+			}
+		}
+
+		return true;
+	}
+
+}
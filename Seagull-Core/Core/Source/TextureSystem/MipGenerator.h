@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+namespace SG
+{
+
+	// CPU mip chain generation for textures whose files only store the first mip.
+	// Every level is filtered from the level above it, separably and with clamped borders, on the calling thread.
+
+	typedef enum MipFilter
+	{
+		/// Keep the single mip
+		SG_MIP_FILTER_NONE = 0,
+		/// Area average of the texels a destination texel covers, also correct for odd sizes
+		SG_MIP_FILTER_BOX,
+		/// Kaiser windowed sinc, keeps the mips sharper with less aliasing than the box filter
+		SG_MIP_FILTER_KAISER,
+	} MipFilter;
+
+	typedef enum MipGenerationFlags
+	{
+		SG_MIP_GENERATION_FLAG_NONE = 0,
+		/// The color channels are sRGB encoded and get filtered in linear space, alpha stays linear
+		SG_MIP_GENERATION_FLAG_SRGB = 0x1,
+		/// The first three channels hold a unit vector (packed to [0, 1] for 8 bit texels) which is renormalized on every mip
+		SG_MIP_GENERATION_FLAG_NORMAL_MAP = 0x2,
+	} MipGenerationFlags;
+
+	typedef enum MipTexelType
+	{
+		/// 8 bit unsigned normalized channels
+		SG_MIP_TEXEL_UNORM8 = 0,
+		/// 32 bit float channels
+		SG_MIP_TEXEL_FLOAT32,
+	} MipTexelType;
+
+	typedef struct MipChainDesc
+	{
+		/// Every level of every layer, ppLevels[layer * levelCount + mip]. The first mip of each layer is the source, the others are written
+		uint8_t**          ppLevels;
+		/// Bytes between two rows of each level, indexed like ppLevels
+		const uint32_t*    pRowPitches;
+		/// Size of the first mip
+		uint32_t           width;
+		uint32_t           height;
+		uint32_t           levelCount;
+		uint32_t           layerCount;
+		/// 1 to 4 channels per texel, with four channels the last one is alpha (RGBA and BGRA)
+		uint32_t           channelCount;
+		MipTexelType       texelType;
+		MipFilter          filter;
+		MipGenerationFlags flags;
+		/// The layers are cube faces in groups of six (+X, -X, +Y, -Y, +Z, -Z). The texels along the edges the faces share get averaged
+		/// on every generated mip, so seamless cubemap filtering does not show seams
+		bool               cubemap;
+	} MipChainDesc;
+
+	/// Number of mips of a full chain down to 1x1
+	uint32_t get_mip_level_count(uint32_t width, uint32_t height);
+	/// Fill the mips 1 to levelCount - 1 of every layer from its first mip
+	bool generate_mip_chain(const MipChainDesc* pDesc);
+
+}
@@ -0,0 +1,783 @@
+#include "TextureCompressor.h"
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include <include/EASTL/algorithm.h>
+
+#include "ThreadSystem/ThreadSystem.h"
+#include "Interface/ILog.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define SG_TEXTURE_COMPRESSOR_SSE2
+	#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+	#define SG_TEXTURE_COMPRESSOR_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace SG
+{
+
+	/// Least squares refinements of the endpoints for every quality level
+	static const uint32_t gBlockRefineIterations[] = { 0, 1, 4 };
+
+#pragma region (Block Helpers)
+
+	/// Pixels of one 4x4 block with one row of 16 values per channel, so the index search works on four pixels at once
+	typedef struct BlockPixels
+	{
+		float channels[4][16];
+	} BlockPixels;
+
+	/// The colors a block can decode to, laid out like BlockPixels
+	typedef struct BlockPalette
+	{
+		float    channels[4][16];
+		uint32_t count;
+	} BlockPalette;
+
+	static inline float util_clamp_unorm8(float value)
+	{
+		return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+	}
+
+	static void util_load_block(const TextureCompressDesc* pDesc, uint32_t rowPitch, uint32_t blockX, uint32_t blockY, BlockPixels* pBlock)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint32_t py = eastl::min(blockY * 4 + y, pDesc->height - 1);
+			const uint8_t* pRow = pDesc->pRGBA + (size_t)py * rowPitch;
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint32_t px = eastl::min(blockX * 4 + x, pDesc->width - 1);
+				for (uint32_t c = 0; c < 4; ++c)
+					pBlock->channels[c][y * 4 + x] = (float)pRow[px * 4 + c];
+			}
+		}
+	}
+
+	/// Pick the closest palette entry for every pixel over the first channelCount channels, pErrors (optional) receives the squared distances.
+	/// Returns the squared error of the whole block
+	static float util_find_palette_indices(const BlockPixels* pBlock, const BlockPalette* pPalette, uint32_t channelCount, uint8_t* pIndices, float* pErrors)
+	{
+#if defined(SG_TEXTURE_COMPRESSOR_SSE2)
+		__m128 total = _mm_setzero_ps();
+		for (uint32_t i = 0; i < 16; i += 4)
+		{
+			__m128 pixels[4];
+			for (uint32_t c = 0; c < channelCount; ++c)
+				pixels[c] = _mm_loadu_ps(&pBlock->channels[c][i]);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (uint32_t p = 0; p < pPalette->count; ++p)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const __m128 delta = _mm_sub_ps(pixels[c], _mm_set1_ps(pPalette->channels[c][p]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(delta, delta));
+				}
+				const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((int)p)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			int32_t indices[4];
+			_mm_storeu_si128((__m128i*)indices, bestIndex);
+			for (uint32_t j = 0; j < 4; ++j)
+				pIndices[i + j] = (uint8_t)indices[j];
+			if (pErrors)
+				_mm_storeu_ps(pErrors + i, best);
+			total = _mm_add_ps(total, best);
+		}
+
+		float sums[4];
+		_mm_storeu_ps(sums, total);
+		return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#elif defined(SG_TEXTURE_COMPRESSOR_NEON)
+		float32x4_t total = vdupq_n_f32(0.0f);
+		for (uint32_t i = 0; i < 16; i += 4)
+		{
+			float32x4_t pixels[4];
+			for (uint32_t c = 0; c < channelCount; ++c)
+				pixels[c] = vld1q_f32(&pBlock->channels[c][i]);
+
+			float32x4_t best = vdupq_n_f32(FLT_MAX);
+			uint32x4_t bestIndex = vdupq_n_u32(0);
+			for (uint32_t p = 0; p < pPalette->count; ++p)
+			{
+				float32x4_t distance = vdupq_n_f32(0.0f);
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const float32x4_t delta = vsubq_f32(pixels[c], vdupq_n_f32(pPalette->channels[c][p]));
+					distance = vmlaq_f32(distance, delta, delta);
+				}
+				const uint32x4_t closer = vcltq_f32(distance, best);
+				best = vminq_f32(distance, best);
+				bestIndex = vbslq_u32(closer, vdupq_n_u32(p), bestIndex);
+			}
+
+			uint32_t indices[4];
+			vst1q_u32(indices, bestIndex);
+			for (uint32_t j = 0; j < 4; ++j)
+				pIndices[i + j] = (uint8_t)indices[j];
+			if (pErrors)
+				vst1q_f32(pErrors + i, best);
+			total = vaddq_f32(total, best);
+		}
+
+		float sums[4];
+		vst1q_f32(sums, total);
+		return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+		float total = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			float best = FLT_MAX;
+			uint32_t bestIndex = 0;
+			for (uint32_t p = 0; p < pPalette->count; ++p)
+			{
+				float distance = 0.0f;
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const float delta = pBlock->channels[c][i] - pPalette->channels[c][p];
+					distance += delta * delta;
+				}
+				if (distance < best)
+				{
+					best = distance;
+					bestIndex = p;
+				}
+			}
+			pIndices[i] = (uint8_t)bestIndex;
+			if (pErrors)
+				pErrors[i] = best;
+			total += best;
+		}
+		return total;
+#endif
+	}
+
+	/// Endpoints on the principal axis of the first channelCount channels which span the pixels with pMask[i] set (all of them if null)
+	static void util_compute_axis_endpoints(const BlockPixels* pBlock, const bool* pMask, uint32_t channelCount, float* pEndpoint0, float* pEndpoint1)
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			if (pMask && !pMask[i])
+				continue;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				mean[c] += pBlock->channels[c][i];
+			++count;
+		}
+		ASSERT(count);
+		for (uint32_t c = 0; c < channelCount; ++c)
+			mean[c] /= (float)count;
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			if (pMask && !pMask[i])
+				continue;
+			for (uint32_t a = 0; a < channelCount; ++a)
+			{
+				const float da = pBlock->channels[a][i] - mean[a];
+				for (uint32_t b = a; b < channelCount; ++b)
+					covariance[a][b] += da * (pBlock->channels[b][i] - mean[b]);
+			}
+		}
+
+		// power iteration, starting with the column of the largest variance which is never orthogonal to the principal axis
+		uint32_t largest = 0;
+		for (uint32_t c = 1; c < channelCount; ++c)
+			largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+
+		float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axis[c] = c <= largest ? covariance[c][largest] : covariance[largest][c];
+
+		for (uint32_t iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float maxComponent = 0.0f;
+			for (uint32_t a = 0; a < channelCount; ++a)
+			{
+				for (uint32_t b = 0; b < channelCount; ++b)
+					next[a] += (a <= b ? covariance[a][b] : covariance[b][a]) * axis[b];
+				maxComponent = eastl::max(maxComponent, fabsf(next[a]));
+			}
+			if (maxComponent < 1e-12f)
+				break;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				axis[c] = next[c] / maxComponent;
+		}
+
+		float length = 0.0f;
+		for (uint32_t c = 0; c < channelCount; ++c)
+			length += axis[c] * axis[c];
+		if (length < 1e-12f)
+		{
+			// all the pixels are the same
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				pEndpoint0[c] = mean[c];
+				pEndpoint1[c] = mean[c];
+			}
+			return;
+		}
+		length = 1.0f / sqrtf(length);
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axis[c] *= length;
+
+		float minT = FLT_MAX;
+		float maxT = -FLT_MAX;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			if (pMask && !pMask[i])
+				continue;
+			float t = 0.0f;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				t += (pBlock->channels[c][i] - mean[c]) * axis[c];
+			minT = eastl::min(minT, t);
+			maxT = eastl::max(maxT, t);
+		}
+
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			pEndpoint0[c] = util_clamp_unorm8(mean[c] + axis[c] * maxT);
+			pEndpoint1[c] = util_clamp_unorm8(mean[c] + axis[c] * minT);
+		}
+	}
+
+	/// Least squares fit of the two endpoints to the chosen indices, pWeights holds the weight of endpoint 0 for every index
+	/// and is negative for the entries which do not depend on the endpoints. Returns false when the indices leave the fit undetermined
+	static bool util_fit_endpoints(const BlockPixels* pBlock, const uint8_t* pIndices, const float* pWeights, uint32_t channelCount, float* pEndpoint0, float* pEndpoint1)
+	{
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const float a = pWeights[pIndices[i]];
+			if (a < 0.0f)
+				continue;
+			const float b = 1.0f - a;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				ax[c] += a * pBlock->channels[c][i];
+				bx[c] += b * pBlock->channels[c][i];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		const float invDeterminant = 1.0f / determinant;
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			pEndpoint0[c] = util_clamp_unorm8((ax[c] * bb - bx[c] * ab) * invDeterminant);
+			pEndpoint1[c] = util_clamp_unorm8((bx[c] * aa - ax[c] * ab) * invDeterminant);
+		}
+		return true;
+	}
+
+	/// Write bitCount bits of value at *pOffset, least significant bit first. pDst has to be zeroed
+	static inline void util_write_bits(uint8_t* pDst, uint32_t* pOffset, uint32_t value, uint32_t bitCount)
+	{
+		for (uint32_t i = 0; i < bitCount; ++i, ++(*pOffset))
+			pDst[*pOffset >> 3] |= (uint8_t)(((value >> i) & 1) << (*pOffset & 7));
+	}
+
+#pragma endregion (Block Helpers)
+
+#pragma region (BC1)
+
+	typedef struct BC1Block
+	{
+		uint16_t color0;
+		uint16_t color1;
+		uint8_t  indices[16];
+		float    error;
+	} BC1Block;
+
+	static const float gBC1FourColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	static const float gBC1ThreeColorWeights[4] = { 1.0f, 0.0f, 0.5f, -1.0f };
+
+	static inline uint16_t util_pack_rgb565(const float* pColor)
+	{
+		const uint32_t r = (uint32_t)(util_clamp_unorm8(pColor[0]) * (31.0f / 255.0f) + 0.5f);
+		const uint32_t g = (uint32_t)(util_clamp_unorm8(pColor[1]) * (63.0f / 255.0f) + 0.5f);
+		const uint32_t b = (uint32_t)(util_clamp_unorm8(pColor[2]) * (31.0f / 255.0f) + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static inline void util_unpack_rgb565(uint16_t color, float* pColor)
+	{
+		const uint32_t r = (color >> 11) & 31;
+		const uint32_t g = (color >> 5) & 63;
+		const uint32_t b = color & 31;
+		pColor[0] = (float)((r << 3) | (r >> 2));
+		pColor[1] = (float)((g << 2) | (g >> 4));
+		pColor[2] = (float)((b << 3) | (b >> 2));
+	}
+
+	/// Quantize the endpoints, order them for the mode and pick the indices. The four color mode needs color0 > color1,
+	/// the three color mode (with transparent black as the last entry) color0 <= color1. Transparent pixels do not count to the error
+	static void util_evaluate_bc1(const BlockPixels* pBlock, const bool* pTransparent, const float* pEndpoint0, const float* pEndpoint1, bool threeColor, BC1Block* pOut)
+	{
+		uint16_t color0 = util_pack_rgb565(pEndpoint0);
+		uint16_t color1 = util_pack_rgb565(pEndpoint1);
+		if (threeColor ? color0 > color1 : color0 < color1)
+			eastl::swap(color0, color1);
+
+		float e0[3], e1[3];
+		util_unpack_rgb565(color0, e0);
+		util_unpack_rgb565(color1, e1);
+
+		BlockPalette palette;
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette.channels[c][0] = e0[c];
+			palette.channels[c][1] = e1[c];
+			palette.channels[c][2] = threeColor ? (e0[c] + e1[c]) * 0.5f : (2.0f * e0[c] + e1[c]) * (1.0f / 3.0f);
+			palette.channels[c][3] = (e0[c] + 2.0f * e1[c]) * (1.0f / 3.0f);
+		}
+		// equal endpoints decode to a single color in both modes, the three color mode keeps the transparent entry to itself
+		palette.count = color0 == color1 ? 1 : (threeColor ? 3 : 4);
+
+		float errors[16];
+		util_find_palette_indices(pBlock, &palette, 3, pOut->indices, errors);
+
+		pOut->color0 = color0;
+		pOut->color1 = color1;
+		pOut->error = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			if (pTransparent && pTransparent[i])
+				pOut->indices[i] = 3;
+			else
+				pOut->error += errors[i];
+		}
+	}
+
+	static void util_refine_bc1(const BlockPixels* pBlock, const bool* pTransparent, bool threeColor, uint32_t iterations, BC1Block* pBest)
+	{
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			float e0[4], e1[4];
+			if (!util_fit_endpoints(pBlock, pBest->indices, threeColor ? gBC1ThreeColorWeights : gBC1FourColorWeights, 3, e0, e1))
+				break;
+
+			BC1Block candidate;
+			util_evaluate_bc1(pBlock, pTransparent, e0, e1, threeColor, &candidate);
+			if (candidate.error >= pBest->error)
+				break;
+			*pBest = candidate;
+		}
+	}
+
+	/// allowTransparency is false for the color block of BC3, which always decodes in the four color mode
+	static void util_encode_bc1(const BlockPixels* pBlock, BlockCompressionQuality quality, bool allowTransparency, uint8_t* pDst)
+	{
+		bool transparent[16];
+		bool opaque[16];
+		uint32_t transparentCount = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			transparent[i] = allowTransparency && pBlock->channels[3][i] < 128.0f;
+			opaque[i] = !transparent[i];
+			transparentCount += transparent[i] ? 1 : 0;
+		}
+
+		BC1Block best = {};
+		if (transparentCount == 16)
+		{
+			memset(best.indices, 3, sizeof(best.indices));
+		}
+		else
+		{
+			const bool threeColor = transparentCount > 0;
+			const bool* pTransparent = threeColor ? transparent : nullptr;
+			const uint32_t iterations = gBlockRefineIterations[quality];
+
+			float e0[4], e1[4];
+			util_compute_axis_endpoints(pBlock, opaque, 3, e0, e1);
+			util_evaluate_bc1(pBlock, pTransparent, e0, e1, threeColor, &best);
+			util_refine_bc1(pBlock, pTransparent, threeColor, iterations, &best);
+
+			// the midpoint of the three color mode sometimes fits opaque blocks better than the thirds
+			if (quality == SG_BLOCK_COMPRESSION_QUALITY_HIGH && allowTransparency && !threeColor)
+			{
+				BC1Block candidate;
+				util_evaluate_bc1(pBlock, nullptr, e0, e1, true, &candidate);
+				util_refine_bc1(pBlock, nullptr, true, iterations, &candidate);
+				if (candidate.error < best.error)
+					best = candidate;
+			}
+		}
+
+		uint32_t indexBits = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+			indexBits |= (uint32_t)best.indices[i] << (2 * i);
+
+		pDst[0] = (uint8_t)(best.color0 & 0xff);
+		pDst[1] = (uint8_t)(best.color0 >> 8);
+		pDst[2] = (uint8_t)(best.color1 & 0xff);
+		pDst[3] = (uint8_t)(best.color1 >> 8);
+		for (uint32_t i = 0; i < 4; ++i)
+			pDst[4 + i] = (uint8_t)(indexBits >> (8 * i));
+	}
+
+#pragma endregion (BC1)
+
+#pragma region (BC4)
+
+	typedef struct BC4Block
+	{
+		uint8_t endpoint0;
+		uint8_t endpoint1;
+		uint8_t indices[16];
+		float   error;
+	} BC4Block;
+
+	static const float gBC4EightValueWeights[8] = { 1.0f, 0.0f, 6.0f / 7.0f, 5.0f / 7.0f, 4.0f / 7.0f, 3.0f / 7.0f, 2.0f / 7.0f, 1.0f / 7.0f };
+	static const float gBC4SixValueWeights[8] = { 1.0f, 0.0f, 4.0f / 5.0f, 3.0f / 5.0f, 2.0f / 5.0f, 1.0f / 5.0f, -1.0f, -1.0f };
+
+	/// The eight value mode needs endpoint0 > endpoint1, the six value mode (with exact 0 and 255 entries) endpoint0 <= endpoint1.
+	/// Works on the first channel of the block
+	static void util_evaluate_bc4(const BlockPixels* pBlock, float endpoint0, float endpoint1, bool sixValues, BC4Block* pOut)
+	{
+		uint32_t e0 = (uint32_t)(util_clamp_unorm8(endpoint0) + 0.5f);
+		uint32_t e1 = (uint32_t)(util_clamp_unorm8(endpoint1) + 0.5f);
+		if (sixValues ? e0 > e1 : e0 < e1)
+			eastl::swap(e0, e1);
+
+		BlockPalette palette;
+		palette.count = 8;
+		palette.channels[0][0] = (float)e0;
+		palette.channels[0][1] = (float)e1;
+		if (e0 > e1)
+		{
+			for (uint32_t i = 2; i < 8; ++i)
+				palette.channels[0][i] = (float)((8 - i) * e0 + (i - 1) * e1) * (1.0f / 7.0f);
+		}
+		else
+		{
+			for (uint32_t i = 2; i < 6; ++i)
+				palette.channels[0][i] = (float)((6 - i) * e0 + (i - 1) * e1) * (1.0f / 5.0f);
+			palette.channels[0][6] = 0.0f;
+			palette.channels[0][7] = 255.0f;
+		}
+
+		pOut->endpoint0 = (uint8_t)e0;
+		pOut->endpoint1 = (uint8_t)e1;
+		pOut->error = util_find_palette_indices(pBlock, &palette, 1, pOut->indices, nullptr);
+	}
+
+	static void util_refine_bc4(const BlockPixels* pBlock, uint32_t iterations, BC4Block* pBest)
+	{
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			const bool sixValues = pBest->endpoint0 <= pBest->endpoint1;
+			float e0[4], e1[4];
+			if (!util_fit_endpoints(pBlock, pBest->indices, sixValues ? gBC4SixValueWeights : gBC4EightValueWeights, 1, e0, e1))
+				break;
+
+			BC4Block candidate;
+			util_evaluate_bc4(pBlock, e0[0], e1[0], sixValues, &candidate);
+			if (candidate.error >= pBest->error)
+				break;
+			*pBest = candidate;
+		}
+	}
+
+	/// Encode one channel of the block, the alpha of BC3 and the channels of BC4 and BC5
+	static void util_encode_bc4(const BlockPixels* pBlock, uint32_t channel, BlockCompressionQuality quality, uint8_t* pDst)
+	{
+		BlockPixels values;
+		memcpy(values.channels[0], pBlock->channels[channel], sizeof(values.channels[0]));
+
+		float minValue = 255.0f, maxValue = 0.0f;
+		float innerMin = 255.0f, innerMax = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const float value = values.channels[0][i];
+			minValue = eastl::min(minValue, value);
+			maxValue = eastl::max(maxValue, value);
+			if (value > 0.0f && value < 255.0f)
+			{
+				innerMin = eastl::min(innerMin, value);
+				innerMax = eastl::max(innerMax, value);
+			}
+		}
+
+		const uint32_t iterations = gBlockRefineIterations[quality];
+		BC4Block best;
+		util_evaluate_bc4(&values, maxValue, minValue, false, &best);
+		util_refine_bc4(&values, iterations, &best);
+
+		// the six value mode only needs to span the values between the exact 0 and 255 entries
+		if (quality == SG_BLOCK_COMPRESSION_QUALITY_HIGH && innerMin <= innerMax && best.error > 0.0f)
+		{
+			BC4Block candidate;
+			util_evaluate_bc4(&values, innerMin, innerMax, true, &candidate);
+			util_refine_bc4(&values, iterations, &candidate);
+			if (candidate.error < best.error)
+				best = candidate;
+		}
+
+		uint64_t indexBits = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+			indexBits |= (uint64_t)best.indices[i] << (3 * i);
+
+		pDst[0] = best.endpoint0;
+		pDst[1] = best.endpoint1;
+		for (uint32_t i = 0; i < 6; ++i)
+			pDst[2 + i] = (uint8_t)(indexBits >> (8 * i));
+	}
+
+#pragma endregion (BC4)
+
+#pragma region (BC7)
+
+	/// Mode 6 block, one subset with RGBA endpoints of 7 bits plus a p-bit each and 4 bit indices
+	typedef struct BC7Block
+	{
+		uint8_t endpoints[2][4];
+		uint8_t pbits[2];
+		uint8_t indices[16];
+		float   error;
+	} BC7Block;
+
+	static const uint32_t gBC7IndexWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	static const float gBC7FitWeights[16] =
+	{
+		64.0f / 64.0f, 60.0f / 64.0f, 55.0f / 64.0f, 51.0f / 64.0f, 47.0f / 64.0f, 43.0f / 64.0f, 38.0f / 64.0f, 34.0f / 64.0f,
+		30.0f / 64.0f, 26.0f / 64.0f, 21.0f / 64.0f, 17.0f / 64.0f, 13.0f / 64.0f, 9.0f / 64.0f, 4.0f / 64.0f, 0.0f / 64.0f,
+	};
+
+	static inline float util_quantize_bc7_endpoint(const float* pEndpoint, uint32_t pbit, uint8_t* pQuantized)
+	{
+		float error = 0.0f;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const int32_t q = (int32_t)floorf((util_clamp_unorm8(pEndpoint[c]) - (float)pbit) * 0.5f + 0.5f);
+			pQuantized[c] = (uint8_t)eastl::clamp(q, 0, 127);
+			const float delta = pEndpoint[c] - (float)((pQuantized[c] << 1) | pbit);
+			error += delta * delta;
+		}
+		return error;
+	}
+
+	/// A negative p-bit picks the one which quantizes the endpoint best
+	static void util_evaluate_bc7(const BlockPixels* pBlock, const float* pEndpoint0, const float* pEndpoint1, int32_t pbit0, int32_t pbit1, BC7Block* pOut)
+	{
+		const float* pEndpoints[2] = { pEndpoint0, pEndpoint1 };
+		const int32_t pbits[2] = { pbit0, pbit1 };
+		for (uint32_t e = 0; e < 2; ++e)
+		{
+			if (pbits[e] >= 0)
+			{
+				pOut->pbits[e] = (uint8_t)pbits[e];
+				util_quantize_bc7_endpoint(pEndpoints[e], pbits[e], pOut->endpoints[e]);
+				continue;
+			}
+
+			uint8_t quantized[4];
+			const float error0 = util_quantize_bc7_endpoint(pEndpoints[e], 0, pOut->endpoints[e]);
+			const float error1 = util_quantize_bc7_endpoint(pEndpoints[e], 1, quantized);
+			pOut->pbits[e] = error1 < error0 ? 1 : 0;
+			if (error1 < error0)
+				memcpy(pOut->endpoints[e], quantized, sizeof(quantized));
+		}
+
+		BlockPalette palette;
+		palette.count = 16;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const uint32_t a = (pOut->endpoints[0][c] << 1) | pOut->pbits[0];
+			const uint32_t b = (pOut->endpoints[1][c] << 1) | pOut->pbits[1];
+			for (uint32_t i = 0; i < 16; ++i)
+				palette.channels[c][i] = (float)(((64 - gBC7IndexWeights[i]) * a + gBC7IndexWeights[i] * b + 32) >> 6);
+		}
+		pOut->error = util_find_palette_indices(pBlock, &palette, 4, pOut->indices, nullptr);
+
+		// the index of the first pixel is stored without its top bit, swap the endpoints when it needs the upper half
+		if (pOut->indices[0] >= 8)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+				eastl::swap(pOut->endpoints[0][c], pOut->endpoints[1][c]);
+			eastl::swap(pOut->pbits[0], pOut->pbits[1]);
+			for (uint32_t i = 0; i < 16; ++i)
+				pOut->indices[i] = 15 - pOut->indices[i];
+		}
+	}
+
+	static void util_refine_bc7(const BlockPixels* pBlock, uint32_t iterations, bool fixedPbits, BC7Block* pBest)
+	{
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			float e0[4], e1[4];
+			if (!util_fit_endpoints(pBlock, pBest->indices, gBC7FitWeights, 4, e0, e1))
+				break;
+
+			BC7Block candidate;
+			util_evaluate_bc7(pBlock, e0, e1, fixedPbits ? pBest->pbits[0] : -1, fixedPbits ? pBest->pbits[1] : -1, &candidate);
+			if (candidate.error >= pBest->error)
+				break;
+			*pBest = candidate;
+		}
+	}
+
+	static void util_encode_bc7(const BlockPixels* pBlock, BlockCompressionQuality quality, uint8_t* pDst)
+	{
+		const uint32_t iterations = gBlockRefineIterations[quality];
+
+		float e0[4], e1[4];
+		util_compute_axis_endpoints(pBlock, nullptr, 4, e0, e1);
+
+		BC7Block best;
+		util_evaluate_bc7(pBlock, e0, e1, -1, -1, &best);
+		util_refine_bc7(pBlock, iterations, false, &best);
+
+		if (quality == SG_BLOCK_COMPRESSION_QUALITY_HIGH)
+		{
+			for (int32_t pbits = 0; pbits < 4 && best.error > 0.0f; ++pbits)
+			{
+				BC7Block candidate;
+				util_evaluate_bc7(pBlock, e0, e1, pbits & 1, pbits >> 1, &candidate);
+				util_refine_bc7(pBlock, iterations, true, &candidate);
+				if (candidate.error < best.error)
+					best = candidate;
+			}
+		}
+
+		memset(pDst, 0, 16);
+		uint32_t offset = 0;
+		util_write_bits(pDst, &offset, 1 << 6, 7);
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			util_write_bits(pDst, &offset, best.endpoints[0][c], 7);
+			util_write_bits(pDst, &offset, best.endpoints[1][c], 7);
+		}
+		util_write_bits(pDst, &offset, best.pbits[0], 1);
+		util_write_bits(pDst, &offset, best.pbits[1], 1);
+		util_write_bits(pDst, &offset, best.indices[0], 3);
+		for (uint32_t i = 1; i < 16; ++i)
+			util_write_bits(pDst, &offset, best.indices[i], 4);
+		ASSERT(offset == 128);
+	}
+
+#pragma endregion (BC7)
+
+	static inline uint32_t util_get_block_size(BlockCompressionFormat format)
+	{
+		return (format == SG_BLOCK_COMPRESSION_BC1 || format == SG_BLOCK_COMPRESSION_BC4) ? 8 : 16;
+	}
+
+	typedef struct TextureCompressTask
+	{
+		const TextureCompressDesc* pDesc;
+		uint8_t*                   pDst;
+		uint32_t                   rowPitch;
+		uint32_t                   blocksX;
+		uint32_t                   blockSize;
+	} TextureCompressTask;
+
+	static void util_compress_block_row(uintptr_t blockY, void* pUserData)
+	{
+		const TextureCompressTask* pTask = (const TextureCompressTask*)pUserData;
+		const TextureCompressDesc* pDesc = pTask->pDesc;
+		uint8_t* pDst = pTask->pDst + (size_t)blockY * pTask->blocksX * pTask->blockSize;
+
+		for (uint32_t blockX = 0; blockX < pTask->blocksX; ++blockX, pDst += pTask->blockSize)
+		{
+			BlockPixels block;
+			util_load_block(pDesc, pTask->rowPitch, blockX, (uint32_t)blockY, &block);
+
+			switch (pDesc->format)
+			{
+			case SG_BLOCK_COMPRESSION_BC1:
+				util_encode_bc1(&block, pDesc->quality, true, pDst);
+				break;
+			case SG_BLOCK_COMPRESSION_BC3:
+				util_encode_bc4(&block, 3, pDesc->quality, pDst);
+				util_encode_bc1(&block, pDesc->quality, false, pDst + 8);
+				break;
+			case SG_BLOCK_COMPRESSION_BC4:
+				util_encode_bc4(&block, 0, pDesc->quality, pDst);
+				break;
+			case SG_BLOCK_COMPRESSION_BC5:
+				util_encode_bc4(&block, 0, pDesc->quality, pDst);
+				util_encode_bc4(&block, 1, pDesc->quality, pDst + 8);
+				break;
+			case SG_BLOCK_COMPRESSION_BC7:
+				util_encode_bc7(&block, pDesc->quality, pDst);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	TinyImageFormat get_block_compression_texture_format(BlockCompressionFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case SG_BLOCK_COMPRESSION_BC1: return srgb ? TinyImageFormat_DXBC1_RGBA_SRGB : TinyImageFormat_DXBC1_RGBA_UNORM;
+		case SG_BLOCK_COMPRESSION_BC3: return srgb ? TinyImageFormat_DXBC3_SRGB : TinyImageFormat_DXBC3_UNORM;
+		case SG_BLOCK_COMPRESSION_BC4: return TinyImageFormat_DXBC4_UNORM;
+		case SG_BLOCK_COMPRESSION_BC5: return TinyImageFormat_DXBC5_UNORM;
+		case SG_BLOCK_COMPRESSION_BC7: return srgb ? TinyImageFormat_DXBC7_SRGB : TinyImageFormat_DXBC7_UNORM;
+		default: return TinyImageFormat_UNDEFINED;
+		}
+	}
+
+	uint32_t get_block_compressed_size(BlockCompressionFormat format, uint32_t width, uint32_t height)
+	{
+		return ((width + 3) / 4) * ((height + 3) / 4) * util_get_block_size(format);
+	}
+
+	bool compress_texture_blocks(const TextureCompressDesc* pDesc, void* pDst)
+	{
+		if (!pDesc->pRGBA || !pDst || !pDesc->width || !pDesc->height || pDesc->format >= SG_BLOCK_COMPRESSION_COUNT ||
+			pDesc->quality > SG_BLOCK_COMPRESSION_QUALITY_HIGH)
+		{
+			SG_LOG_ERROR("Invalid texture compression description (%ux%u, format %d, quality %d)",
+				pDesc->width, pDesc->height, (int)pDesc->format, (int)pDesc->quality);
+			return false;
+		}
+
+		TextureCompressTask task = {};
+		task.pDesc = pDesc;
+		task.pDst = (uint8_t*)pDst;
+		task.rowPitch = pDesc->rowPitch ? pDesc->rowPitch : pDesc->width * 4;
+		task.blocksX = (pDesc->width + 3) / 4;
+		task.blockSize = util_get_block_size(pDesc->format);
+
+		const uint32_t blocksY = (pDesc->height + 3) / 4;
+		if (pDesc->pThreadSystem && blocksY > 1)
+		{
+			// every row of blocks is a task, this thread takes rows too until the queue is empty
+			add_thread_system_range_task(pDesc->pThreadSystem, util_compress_block_row, &task, blocksY);
+			while (assist_thread_system(pDesc->pThreadSystem))
+				;
+			wait_thread_system_idle(pDesc->pThreadSystem);
+		}
+		else
+		{
+			for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+				util_compress_block_row(blockY, &task);
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Core/CompilerConfig.h"
+
+#include "../../Third-party/Include/tinyImageFormat/include/tinyimageformat_base.h"
+
+namespace SG
+{
+
+	struct ThreadSystem;
+
+	// CPU block compression of RGBA8 images, used by the texture cooker and for textures generated at runtime.
+	// Every 4x4 block is encoded on its own, blocks on the right and bottom border replicate the edge pixels.
+
+	typedef enum BlockCompressionFormat
+	{
+		/// RGB with 1 bit alpha, blocks with an alpha below 128 use the punch through mode (pass opaque alpha for color only textures)
+		SG_BLOCK_COMPRESSION_BC1 = 0,
+		/// BC1 color with a BC4 alpha block
+		SG_BLOCK_COMPRESSION_BC3,
+		/// Red channel only
+		SG_BLOCK_COMPRESSION_BC4,
+		/// Red and green channels, e.g. tangent space normal maps
+		SG_BLOCK_COMPRESSION_BC5,
+		/// RGBA, encoded in mode 6 (one subset, 7 bit endpoints with a p-bit and 4 bit indices)
+		SG_BLOCK_COMPRESSION_BC7,
+		SG_BLOCK_COMPRESSION_COUNT,
+	} BlockCompressionFormat;
+
+	typedef enum BlockCompressionQuality
+	{
+		/// Principal axis endpoints only
+		SG_BLOCK_COMPRESSION_QUALITY_FAST = 0,
+		/// One least squares refinement of the endpoints
+		SG_BLOCK_COMPRESSION_QUALITY_NORMAL,
+		/// Several refinements, alternative BC1/BC4 modes and all BC7 p-bit combinations
+		SG_BLOCK_COMPRESSION_QUALITY_HIGH,
+	} BlockCompressionQuality;
+
+	typedef struct TextureCompressDesc
+	{
+		/// Source image, four bytes per pixel in RGBA order
+		const uint8_t*          pRGBA;
+		uint32_t                width;
+		uint32_t                height;
+		/// Bytes between two rows of pRGBA, 0 for tightly packed rows
+		uint32_t                rowPitch;
+		BlockCompressionFormat  format;
+		BlockCompressionQuality quality;
+		/// Optional, the rows of blocks are spread over its threads and the calling thread helps until all of them are done.
+		/// Leave it null when calling from a task of the same thread system, waiting for it to be idle would never return
+		ThreadSystem*           pThreadSystem;
+	} TextureCompressDesc;
+
+	/// The texture format of the compressed data, srgb only changes the format for BC1, BC3 and BC7
+	TinyImageFormat get_block_compression_texture_format(BlockCompressionFormat format, bool srgb);
+	/// Bytes compress_texture_blocks writes for a width x height image, rows of blocks are tightly packed
+	uint32_t get_block_compressed_size(BlockCompressionFormat format, uint32_t width, uint32_t height);
+	/// Compress pDesc->pRGBA into pDst, which needs room for get_block_compressed_size() bytes
+	bool compress_texture_blocks(const TextureCompressDesc* pDesc, void* pDst);
+
+}
@@ -12,7 +12,13 @@
 #include <include/tinyimageformat_apis.h>
 
 #include <tinyktx.h>
-//#include "../../ThirdParty/OpenSource/basis_universal/transcoder/basisu_transcoder.h"
+// Basis Universal (and the zstd decoder it ships with) is an optional dependency,
+// generate the projects with --basisu=<path to basis_universal> to define SG_ENABLE_BASIS_UNIVERSAL and build the transcoder,
+// without it only KTX2 files which are neither supercompressed nor Basis encoded can be loaded
+#if defined(SG_ENABLE_BASIS_UNIVERSAL)
+#include <transcoder/basisu_transcoder.h>
+#include <zstd/zstd.h>
+#endif
 
 #include "Interface/IMemory.h"
 
@@ -693,6 +699,52 @@ if (!(exp))                   \
 		return true;
 	}
 
+	/// Write a texture in the layout load_dds_texture reads back (every array slice with all of its mips) as a DDS with the DX10 header
+	static bool save_dds_texture(FileStream* pStream, const TextureCreateDesc* pDesc, const void* pData, uint32_t dataSize)
+	{
+		const TinyImageFormat_DXGI_FORMAT dxgiFormat = TinyImageFormat_ToDXGI_FORMAT(pDesc->format);
+		if (!pStream || !pData || dxgiFormat == TIF_DXGI_FORMAT_UNKNOWN)
+			return false;
+
+		const bool cube = (pDesc->descriptors & SG_DESCRIPTOR_TYPE_TEXTURE_CUBE) != 0;
+		const bool volume = pDesc->depth > 1;
+		const uint32_t mipLevels = eastl::max(1U, pDesc->mipLevels);
+
+		uint32_t numBytes = 0;
+		uint32_t rowBytes = 0;
+		if (!util_get_surface_info(pDesc->width, pDesc->height, pDesc->format, &numBytes, &rowBytes, nullptr))
+			return false;
+
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		// DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT, with DDSD_LINEARSIZE or DDSD_PITCH
+		header.flags = 0x1 | DDS_HEIGHT | 0x4 | 0x1000 | (TinyImageFormat_IsCompressed(pDesc->format) ? 0x80000 : 0x8);
+		header.flags |= (mipLevels > 1 ? 0x20000 /* DDSD_MIPMAPCOUNT */ : 0) | (volume ? DDS_HEADER_FLAGS_VOLUME : 0);
+		header.height = pDesc->height;
+		header.width = pDesc->width;
+		header.pitchOrLinearSize = TinyImageFormat_IsCompressed(pDesc->format) ? numBytes : rowBytes;
+		header.depth = volume ? pDesc->depth : 0;
+		header.mipMapCount = mipLevels;
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		// DDSCAPS_TEXTURE, DDSCAPS_COMPLEX and DDSCAPS_MIPMAP
+		header.caps = 0x1000 | (mipLevels > 1 || cube || volume ? 0x8 : 0) | (mipLevels > 1 ? 0x400000 : 0);
+		header.caps2 = cube ? DDS_CUBEMAP_ALLFACES : (volume ? 0x200000 /* DDSCAPS2_VOLUME */ : 0);
+
+		DDS_HEADER_DXT10 headerDx10 = {};
+		headerDx10.dxgiFormat = dxgiFormat;
+		headerDx10.resourceDimension = volume ? 4 /* D3D12_RESOURCE_DIMENSION_TEXTURE3D */ : 3 /* D3D12_RESOURCE_DIMENSION_TEXTURE2D */;
+		headerDx10.miscFlag = cube ? 0x4 /* RESOURCE_MISC_TEXTURECUBE */ : 0;
+		headerDx10.arraySize = eastl::max(1U, cube ? pDesc->arraySize / 6 : pDesc->arraySize);
+
+		const uint32_t magic = DDS_MAGIC;
+		return sgfs_write_to_stream(pStream, &magic, sizeof(magic)) == sizeof(magic) &&
+			sgfs_write_to_stream(pStream, &header, sizeof(header)) == sizeof(header) &&
+			sgfs_write_to_stream(pStream, &headerDx10, sizeof(headerDx10)) == sizeof(headerDx10) &&
+			sgfs_write_to_stream(pStream, pData, dataSize) == dataSize;
+	}
+
 	//KTX Loading
 	static bool load_ktx_texture(FileStream* pStream, TextureCreateDesc* pOutDesc)
 	{
@@ -905,6 +957,387 @@ if (!(exp))                   \
 //		return true;
 //	}
 
+#if defined(SG_ENABLE_BASIS_UNIVERSAL)
+	static void util_init_basis_transcoder()
+	{
+		// thread safe, the transcoder tables are built once by whichever worker gets here first
+		static const bool initialized = (basist::basisu_transcoder_init(), true);
+		UNREF_PARAM(initialized);
+	}
+
+	/// Pick the block format to transcode a Basis Universal texture to, the first one in order of quality the GPU can sample.
+	/// Two channel textures (normal maps) prefer BC5 / EAC RG11, uncompressed RGBA8 is the last resort
+	static void util_select_basis_target_format(const GPUCapBits* pCapBits, bool hasAlpha, bool twoChannel, bool srgb,
+		TinyImageFormat* pOutFormat, basist::transcoder_texture_format* pOutTarget)
+	{
+		typedef struct BasisTarget
+		{
+			TinyImageFormat                   format;
+			TinyImageFormat                   srgbFormat;
+			basist::transcoder_texture_format target;
+			bool                              alpha;
+			bool                              twoChannel;
+		} BasisTarget;
+
+		static const BasisTarget targets[] =
+		{
+			{ TinyImageFormat_DXBC5_UNORM,           TinyImageFormat_UNDEFINED,          basist::transcoder_texture_format::cTFBC5_RG,        false, true },
+			{ TinyImageFormat_ETC2_EAC_R11G11_UNORM, TinyImageFormat_UNDEFINED,          basist::transcoder_texture_format::cTFETC2_EAC_RG11, false, true },
+			{ TinyImageFormat_DXBC7_UNORM,           TinyImageFormat_DXBC7_SRGB,         basist::transcoder_texture_format::cTFBC7_RGBA,      true,  false },
+			{ TinyImageFormat_DXBC1_RGB_UNORM,       TinyImageFormat_DXBC1_RGB_SRGB,     basist::transcoder_texture_format::cTFBC1_RGB,       false, false },
+			{ TinyImageFormat_DXBC3_UNORM,           TinyImageFormat_DXBC3_SRGB,         basist::transcoder_texture_format::cTFBC3_RGBA,      true,  false },
+			{ TinyImageFormat_ASTC_4x4_UNORM,        TinyImageFormat_ASTC_4x4_SRGB,      basist::transcoder_texture_format::cTFASTC_4x4_RGBA, true,  false },
+			{ TinyImageFormat_ETC2_R8G8B8_UNORM,     TinyImageFormat_ETC2_R8G8B8_SRGB,   basist::transcoder_texture_format::cTFETC1_RGB,      false, false },
+			{ TinyImageFormat_ETC2_R8G8B8A8_UNORM,   TinyImageFormat_ETC2_R8G8B8A8_SRGB, basist::transcoder_texture_format::cTFETC2_RGBA,     true,  false },
+		};
+
+		for (const BasisTarget& target : targets)
+		{
+			// the color formats are fine for two channel data as well, the two channel ones only carry red and green
+			if ((target.twoChannel && (!twoChannel || srgb)) || (hasAlpha && !target.alpha && !twoChannel))
+				continue;
+
+			const TinyImageFormat format = srgb ? target.srgbFormat : target.format;
+			if (!pCapBits || pCapBits->canShaderReadFrom[format])
+			{
+				*pOutFormat = format;
+				*pOutTarget = target.target;
+				return;
+			}
+		}
+
+		*pOutFormat = srgb ? TinyImageFormat_R8G8B8A8_SRGB : TinyImageFormat_R8G8B8A8_UNORM;
+		*pOutTarget = basist::transcoder_texture_format::cTFRGBA32;
+	}
+
+	/// Transcode one image level, block formats are written as a tight grid of blocks and RGBA32 as tight rows of pixels
+	static inline uint32_t util_get_basis_output_size(basist::transcoder_texture_format target, uint32_t width, uint32_t height,
+		uint32_t blocksX, uint32_t blocksY, uint32_t* pOutBlocksOrPixels)
+	{
+		*pOutBlocksOrPixels = basist::basis_transcoder_format_is_uncompressed(target) ? width * height : blocksX * blocksY;
+		return *pOutBlocksOrPixels * basist::basis_get_bytes_per_block_or_pixel(target);
+	}
+#endif
+
+	// BASIS Loading
+	/// The images are transcoded into *ppOutData in the DDS order (every slice with all of its mips)
+	static bool load_basis_texture(FileStream* pStream, TextureCreateDesc* pOutDesc, const GPUCapBits* pCapBits, void** ppOutData, uint32_t* pOutDataSize)
+	{
+#if defined(SG_ENABLE_BASIS_UNIVERSAL)
+		if (!pStream || sgfs_get_stream_file_size(pStream) <= 0)
+			return false;
+
+		util_init_basis_transcoder();
+
+		const uint32_t fileSize = (uint32_t)sgfs_get_stream_file_size(pStream);
+		void* basisData = sg_malloc(fileSize);
+		sgfs_read_from_stream(pStream, basisData, fileSize);
+
+		basist::basisu_transcoder decoder;
+		basist::basisu_file_info fileInfo;
+		basist::basisu_image_info imageInfo;
+		if (!decoder.validate_header(basisData, fileSize) || !decoder.get_file_info(basisData, fileSize, fileInfo) ||
+			!decoder.get_image_info(basisData, fileSize, imageInfo, 0))
+		{
+			SG_LOG_ERROR("Failed retrieving Basis file information!");
+			sg_free(basisData);
+			return false;
+		}
+
+		TextureCreateDesc& textureDesc = *pOutDesc;
+		textureDesc.width = imageInfo.m_width;
+		textureDesc.height = imageInfo.m_height;
+		textureDesc.depth = 1;
+		textureDesc.mipLevels = fileInfo.m_image_mipmap_levels[0];
+		textureDesc.arraySize = fileInfo.m_total_images;
+		textureDesc.sampleCount = SG_SAMPLE_COUNT_1;
+		textureDesc.descriptors = SG_DESCRIPTOR_TYPE_TEXTURE;
+		if (basist::cBASISTexTypeCubemapArray == fileInfo.m_tex_type)
+			textureDesc.descriptors |= SG_DESCRIPTOR_TYPE_TEXTURE_CUBE;
+
+		// the basisu tool stores 1 in userdata0 for normal maps
+		const bool isNormalMap = fileInfo.m_userdata0 == 1;
+		basist::transcoder_texture_format target = basist::transcoder_texture_format::cTFRGBA32;
+		util_select_basis_target_format(pCapBits, imageInfo.m_alpha_flag, isNormalMap, false, &textureDesc.format, &target);
+
+		const uint32_t requiredSize = util_get_surface_size(textureDesc.format, textureDesc.width, textureDesc.height, 1, 1, 1,
+			0, textureDesc.mipLevels, 0, textureDesc.arraySize);
+		uint8_t* data = (uint8_t*)sg_malloc(requiredSize);
+		uint8_t* dst = data;
+
+		bool transcoded = decoder.start_transcoding(basisData, fileSize);
+		for (uint32_t s = 0; s < fileInfo.m_total_images && transcoded; ++s)
+		{
+			for (uint32_t m = 0; m < textureDesc.mipLevels && transcoded; ++m)
+			{
+				basist::basisu_image_level_info levelInfo;
+				transcoded = decoder.get_image_level_info(basisData, fileSize, levelInfo, s, m);
+				if (!transcoded)
+					break;
+
+				uint32_t blocksOrPixels = 0;
+				const uint32_t levelSize = util_get_basis_output_size(target, levelInfo.m_orig_width, levelInfo.m_orig_height,
+					levelInfo.m_num_blocks_x, levelInfo.m_num_blocks_y, &blocksOrPixels);
+				transcoded = decoder.transcode_image_level(basisData, fileSize, s, m, dst, blocksOrPixels, target);
+				dst += levelSize;
+			}
+		}
+		sg_free(basisData);
+
+		if (!transcoded || dst != data + requiredSize)
+		{
+			SG_LOG_ERROR("Failed transcoding Basis texture to %s", TinyImageFormat_Name(textureDesc.format));
+			sg_free(data);
+			return false;
+		}
+
+		*ppOutData = data;
+		*pOutDataSize = requiredSize;
+		return true;
+#else
+		UNREF_PARAM(pStream);
+		UNREF_PARAM(pOutDesc);
+		UNREF_PARAM(pCapBits);
+		UNREF_PARAM(ppOutData);
+		UNREF_PARAM(pOutDataSize);
+		SG_LOG_ERROR("Basis textures need the projects generated with --basisu");
+		return false;
+#endif
+	}
+
+	// KTX2 Loading
+	// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+#define KTX2_SUPERCOMPRESSION_NONE    0
+#define KTX2_SUPERCOMPRESSION_BASISLZ 1
+#define KTX2_SUPERCOMPRESSION_ZSTD    2
+#define KTX2_DF_MODEL_UASTC           166
+#define KTX2_DF_TRANSFER_SRGB         2
+
+	struct KTX2_HEADER
+	{
+		uint8_t  identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+
+	struct KTX2_LEVEL
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	static const uint8_t gKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	/// Basis encoded KTX2 (ETC1S in BasisLZ or UASTC, optionally zstd supercompressed): transcode every level to the best format the GPU supports
+	static bool util_transcode_ktx2_basis(const uint8_t* pFileData, uint32_t fileSize, TextureCreateDesc* pOutDesc, const GPUCapBits* pCapBits,
+		void** ppOutData, uint32_t* pOutDataSize)
+	{
+#if defined(SG_ENABLE_BASIS_UNIVERSAL)
+		util_init_basis_transcoder();
+
+		basist::ktx2_transcoder transcoder;
+		if (!transcoder.init(pFileData, fileSize) || !transcoder.start_transcoding())
+		{
+			SG_LOG_ERROR("Failed to start transcoding the Basis data of a KTX2 texture");
+			return false;
+		}
+
+		const bool srgb = KTX2_DF_TRANSFER_SRGB == transcoder.get_dfd_transfer_func();
+		const bool twoChannel = transcoder.is_uastc() ?
+			basist::KTX2_DF_CHANNEL_UASTC_RG == transcoder.get_dfd_channel_id0() :
+			(basist::KTX2_DF_CHANNEL_ETC1S_RRR == transcoder.get_dfd_channel_id0() && basist::KTX2_DF_CHANNEL_ETC1S_GGG == transcoder.get_dfd_channel_id1());
+
+		TextureCreateDesc& textureDesc = *pOutDesc;
+		basist::transcoder_texture_format target = basist::transcoder_texture_format::cTFRGBA32;
+		util_select_basis_target_format(pCapBits, transcoder.get_has_alpha(), twoChannel, srgb, &textureDesc.format, &target);
+
+		const uint32_t layerCount = eastl::max(1U, transcoder.get_layers());
+		const uint32_t faceCount = transcoder.get_faces();
+		const uint32_t requiredSize = util_get_surface_size(textureDesc.format, textureDesc.width, textureDesc.height, 1, 1, 1,
+			0, textureDesc.mipLevels, 0, textureDesc.arraySize);
+		uint8_t* data = (uint8_t*)sg_malloc(requiredSize);
+		uint8_t* dst = data;
+
+		bool transcoded = true;
+		for (uint32_t level = 0; level < textureDesc.mipLevels && transcoded; ++level)
+		{
+			for (uint32_t layer = 0; layer < layerCount && transcoded; ++layer)
+			{
+				for (uint32_t face = 0; face < faceCount && transcoded; ++face)
+				{
+					basist::ktx2_image_level_info levelInfo;
+					transcoded = transcoder.get_image_level_info(levelInfo, level, layer, face);
+					if (!transcoded)
+						break;
+
+					uint32_t blocksOrPixels = 0;
+					const uint32_t levelSize = util_get_basis_output_size(target, levelInfo.m_orig_width, levelInfo.m_orig_height,
+						levelInfo.m_num_blocks_x, levelInfo.m_num_blocks_y, &blocksOrPixels);
+					transcoded = transcoder.transcode_image_level(level, layer, face, dst, blocksOrPixels, target);
+					dst += levelSize;
+				}
+			}
+		}
+
+		if (!transcoded || dst != data + requiredSize)
+		{
+			SG_LOG_ERROR("Failed transcoding KTX2 texture to %s", TinyImageFormat_Name(textureDesc.format));
+			sg_free(data);
+			return false;
+		}
+
+		*ppOutData = data;
+		*pOutDataSize = requiredSize;
+		return true;
+#else
+		UNREF_PARAM(pFileData);
+		UNREF_PARAM(fileSize);
+		UNREF_PARAM(pOutDesc);
+		UNREF_PARAM(pCapBits);
+		UNREF_PARAM(ppOutData);
+		UNREF_PARAM(pOutDataSize);
+		SG_LOG_ERROR("Basis encoded KTX2 textures need the projects generated with --basisu");
+		return false;
+#endif
+	}
+
+	/// Read a KTX2 texture into *ppOutData with the mips after the slices (every mip with all of its layers and faces), the order KTX2 uses.
+	/// Supercompressed levels are inflated and Basis encoded textures are transcoded to a block format pCapBits says the GPU can sample
+	static bool load_ktx2_texture(FileStream* pStream, TextureCreateDesc* pOutDesc, const GPUCapBits* pCapBits, void** ppOutData, uint32_t* pOutDataSize)
+	{
+#define RETURN_IF_FAILED(exp) \
+		if (!(exp))                   \
+		{                             \
+			return false;             \
+		}
+		RETURN_IF_FAILED(pStream);
+
+		const ssize_t fileSize = sgfs_get_stream_file_size(pStream);
+		RETURN_IF_FAILED(fileSize > (ssize_t)sizeof(KTX2_HEADER) && fileSize <= UINT32_MAX);
+
+		uint8_t* fileData = (uint8_t*)sg_malloc(fileSize);
+		if (sgfs_read_from_stream(pStream, fileData, fileSize) != fileSize)
+		{
+			sg_free(fileData);
+			return false;
+		}
+
+		KTX2_HEADER header = {};
+		memcpy(&header, fileData, sizeof(header));
+		const uint32_t levelCount = eastl::max(1U, header.levelCount);
+		const KTX2_LEVEL* levels = (const KTX2_LEVEL*)(fileData + sizeof(KTX2_HEADER));
+		if (memcmp(header.identifier, gKtx2Identifier, sizeof(gKtx2Identifier)) != 0 ||
+			sizeof(KTX2_HEADER) + levelCount * sizeof(KTX2_LEVEL) > (size_t)fileSize ||
+			(header.faceCount != 1 && header.faceCount != 6))
+		{
+			SG_LOG_ERROR("Invalid KTX2 header");
+			sg_free(fileData);
+			return false;
+		}
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			if (levels[level].byteOffset + levels[level].byteLength > (uint64_t)fileSize)
+			{
+				SG_LOG_ERROR("KTX2 level %u is out of the file", level);
+				sg_free(fileData);
+				return false;
+			}
+		}
+
+		TextureCreateDesc& textureDesc = *pOutDesc;
+		textureDesc.width = header.pixelWidth;
+		textureDesc.height = eastl::max(1U, header.pixelHeight);
+		textureDesc.depth = eastl::max(1U, header.pixelDepth);
+		textureDesc.arraySize = eastl::max(1U, header.layerCount) * header.faceCount;
+		textureDesc.mipLevels = levelCount;
+		textureDesc.sampleCount = SG_SAMPLE_COUNT_1;
+		textureDesc.descriptors = SG_DESCRIPTOR_TYPE_TEXTURE;
+		if (6 == header.faceCount)
+			textureDesc.descriptors |= SG_DESCRIPTOR_TYPE_TEXTURE_CUBE;
+
+		// VK_FORMAT_UNDEFINED marks Basis Universal data, the color model of the data format descriptor tells ETC1S and UASTC apart
+		const uint8_t colorModel = header.dfdByteLength >= 16 && header.dfdByteOffset + 16 <= (uint64_t)fileSize ? fileData[header.dfdByteOffset + 12] : 0;
+		if (0 == header.vkFormat && (KTX2_SUPERCOMPRESSION_BASISLZ == header.supercompressionScheme || KTX2_DF_MODEL_UASTC == colorModel))
+		{
+			const bool transcoded = util_transcode_ktx2_basis(fileData, (uint32_t)fileSize, &textureDesc, pCapBits, ppOutData, pOutDataSize);
+			sg_free(fileData);
+			return transcoded;
+		}
+
+		textureDesc.format = TinyImageFormat_FromVkFormat((TinyImageFormat_VkFormat)header.vkFormat);
+		if (TinyImageFormat_UNDEFINED == textureDesc.format ||
+			(KTX2_SUPERCOMPRESSION_NONE != header.supercompressionScheme && KTX2_SUPERCOMPRESSION_ZSTD != header.supercompressionScheme))
+		{
+			SG_LOG_ERROR("Unsupported KTX2 texture: vkFormat %u, supercompression %u", header.vkFormat, header.supercompressionScheme);
+			sg_free(fileData);
+			return false;
+		}
+
+		const uint32_t requiredSize = util_get_surface_size(textureDesc.format, textureDesc.width, textureDesc.height, textureDesc.depth, 1, 1,
+			0, textureDesc.mipLevels, 0, textureDesc.arraySize);
+		uint8_t* data = (uint8_t*)sg_malloc(requiredSize);
+
+		// KTX2 stores the smallest level first, the level index puts them back in order
+		uint32_t offset = 0;
+		bool read = true;
+		for (uint32_t level = 0; level < levelCount && read; ++level)
+		{
+			uint32_t levelSize = 0;
+			util_get_surface_info(eastl::max(1U, textureDesc.width >> level), eastl::max(1U, textureDesc.height >> level), textureDesc.format, &levelSize, NULL, NULL);
+			levelSize *= eastl::max(1U, textureDesc.depth >> level) * textureDesc.arraySize;
+			if (offset + levelSize > requiredSize)
+			{
+				read = false;
+				break;
+			}
+
+			const KTX2_LEVEL& levelIndex = levels[level];
+			if (KTX2_SUPERCOMPRESSION_ZSTD == header.supercompressionScheme)
+			{
+#if defined(SG_ENABLE_BASIS_UNIVERSAL)
+				const size_t inflated = ZSTD_decompress(data + offset, levelSize, fileData + levelIndex.byteOffset, (size_t)levelIndex.byteLength);
+				read = !ZSTD_isError(inflated) && inflated == levelSize;
+#else
+				SG_LOG_ERROR("zstd supercompressed KTX2 textures need the projects generated with --basisu");
+				read = false;
+#endif
+			}
+			else
+			{
+				read = levelIndex.byteLength == levelSize;
+				if (read)
+					memcpy(data + offset, fileData + levelIndex.byteOffset, levelSize);
+			}
+			offset += levelSize;
+		}
+		sg_free(fileData);
+
+		if (!read || offset != requiredSize)
+		{
+			SG_LOG_ERROR("KTX2 levels do not match a %ux%u %s texture", textureDesc.width, textureDesc.height, TinyImageFormat_Name(textureDesc.format));
+			sg_free(data);
+			return false;
+		}
+
+		*ppOutData = data;
+		*pOutDataSize = requiredSize;
+		return true;
+	}
+
 	// SVT Loading
 	struct SVT_HEADER
 	{
@@ -25,7 +25,8 @@ namespace SG
 
 			if (ts->begin != ts->end)
 			{
-				ThreadTask& resourceTask = ts->tasks[ts->end];
+				// copy the task out, the slot may be advanced or reused as soon as we release the lock
+				ThreadTask resourceTask = ts->tasks[ts->end];
 				if (resourceTask.start + 1 == resourceTask.end)
 				{
 					++(ts->end);
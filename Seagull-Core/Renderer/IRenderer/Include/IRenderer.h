@@ -940,6 +940,8 @@ namespace SG
 		VkSemaphore          pVkSemaphore;
 		uint32_t             currentNodeIndex : 5;
 		uint32_t             signaled : 1;
+		/// Created by add_timeline_semaphore, submissions signal and wait for values instead of toggling signaled
+		uint32_t             timeline : 1;
 		uint32_t             padA;
 		uint64_t             padB;
 		uint64_t             padC;
@@ -1197,6 +1199,10 @@ namespace SG
 		Semaphore** ppWaitSemaphores;
 		uint32_t    signalSemaphoreCount;
 		Semaphore** ppSignalSemaphores;
+		/// Value to wait for / signal of every semaphore in ppWaitSemaphores / ppSignalSemaphores.
+		/// Only read for timeline semaphores, can stay null if there are none
+		uint64_t*   pWaitValues;
+		uint64_t*   pSignalValues;
 		bool        submitDone;
 	} QueueSubmitDesc;
 
@@ -1227,6 +1233,9 @@ namespace SG
 		SG_BUFFER_CREATION_FLAG_ESRAM = 0x08,
 		/// Flag to specify not to allocate descriptors for the resource
 		SG_BUFFER_CREATION_FLAG_NO_DESCRIPTOR_VIEW_CREATION = 0x10,
+		/// Place a GPU only buffer in device local memory the CPU can write (resizable BAR or unified memory) and keep it mapped.
+		/// Without such memory, or once its heap is out of budget, the buffer gets regular device local memory and no pCpuMappedAddress
+		SG_BUFFER_CREATION_FLAG_HOST_VISIBLE_DEVICE_LOCAL = 0x20,
 	} BufferCreationFlags;
 	SG_MAKE_ENUM_FLAG(uint32_t, BufferCreationFlags);
 
@@ -1301,8 +1310,9 @@ namespace SG
 		/// Buffer view
 		VkBufferView                     pVkStorageTexelView;
 		VkBufferView                     pVkUniformTexelView;
-		/// Contains resource allocation info such as parent heap, offset in heap
+		/// Contains resource allocation info such as parent heap, offset in heap (null for pooled buffers)
 		VmaAllocation				     vkAllocation;
+		/// Start of the first element of structured buffer views, or of the range of a pooled buffer in the shared pVkBuffer (only then added to binds and copies)
 		uint64_t                         offset;
 #endif
 #if defined(SG_GRAPHIC_API_GLES)
@@ -1314,6 +1324,8 @@ namespace SG
 		uint64_t                         descriptors : 20;
 		uint64_t                         memoryUsage : 3;
 		uint64_t                         nodeIndex : 4;
+		/// Sub-allocated from a BufferPool, pVkBuffer and its memory are shared with the other buffers of the pool
+		uint64_t                         pooled : 1;
 	} Buffer;
 	// check for the alignment
 	SG_COMPILE_ASSERT(sizeof(Buffer) == 8 * sizeof(uint64_t));
@@ -1579,6 +1591,9 @@ namespace SG
 		void* pByteCode;
 		uint32_t byteCodeSize;
 		const char* pEntryPoint; // for glsl is commonly "main"
+		/// Reflection of the byte code from serialize_shader_reflection, the byte code is reflected when there is none
+		const void* pReflection;
+		uint32_t reflectionSize;
 #if defined(SG_GRAPHIC_API_GLES)
 		GLuint		    shader;
 #endif
@@ -2061,7 +2076,11 @@ namespace SG
 		// in DX12 this information is stored in ID3D12StateObject.
 		// but for Vulkan we need to store it manually
 		const char** ppShaderStageNames;
-		uint64_t                    padB[4];
+		/// Entry of the pipeline in the pipeline state cache, null if the pipeline is not shared
+		struct PipelineStateCacheEntry* pCacheEntry;
+		/// Next handle of add_pipeline_async waiting for the same entry, every caller binds its own fallback
+		struct Pipeline*            pNextShell;
+		uint64_t                    padB[2];
 #endif
 #if defined(SG_GRAPHIC_API_D3D11)
 		ID3D11VertexShader* pDxVertexShader;
@@ -2099,6 +2118,28 @@ namespace SG
 	SG_COMPILE_ASSERT(sizeof(Pipeline) == 8 * sizeof(uint64_t));
 #endif
 
+	typedef struct PipelineStateCacheStats
+	{
+		/// add_pipeline calls that got a pipeline created before with the same description
+		uint32_t hitCount;
+		/// add_pipeline calls that created the pipeline on the calling thread
+		uint32_t missCount;
+		/// add_pipeline_async calls that handed the creation to a worker
+		uint32_t asyncMissCount;
+		/// Async pipelines that still bind their fallback
+		uint32_t pendingCount;
+		/// Pipelines the cache can hand out
+		uint32_t pipelineCount;
+		/// Seconds the calling threads spent creating pipelines on a miss
+		float    missTime;
+		/// The slowest pipeline created on a calling thread, the likeliest cause of a hitch
+		float    slowestMissTime;
+		char     slowestMissName[64];
+	} PipelineStateCacheStats;
+
+	/// Called for every pipeline the pipeline state cache creates, on the thread calling add_pipeline or add_pipeline_async
+	typedef void (*PipelineCreatedFunc)(const PipelineCreateDesc* pDesc, void* pUserData);
+
 #pragma endregion (Pipeline)
 
 #pragma region (Renderer)
@@ -2197,9 +2238,20 @@ namespace SG
 		uint32_t**						pAvailableQueueCount;
 		uint32_t**						pUsedQueueCount;
 		struct DescriptorPool*			pDescriptorPool;
+		struct PipelineStateCache*		pPipelineStateCache;
 		//struct VmaAllocator_T*	    pVmaAllocator;
 		VmaAllocator					vmaAllocator;
 		uint32_t                        raytracingExtension : 1;
+		/// Timeline semaphores (Vulkan 1.2) are available for add_timeline_semaphore
+		uint32_t                        timelineSemaphoreSupport : 1;
+		/// A coherent device local memory type the CPU can write, on a heap larger than the 256MB BAR window
+		/// (resizable BAR or unified memory), used by SG_BUFFER_CREATION_FLAG_HOST_VISIBLE_DEVICE_LOCAL
+		uint32_t                        hostVisibleDeviceMemory : 1;
+		/// Buffers and textures other than render targets are shared between the graphics and the transfer family (VK_SHARING_MODE_CONCURRENT).
+		/// Set by the resource loader when it uploads on a dedicated transfer family without ownership transfers,
+		/// resources created before init_resource_loader_interface stay exclusive to the family that first uses them
+		uint32_t                        concurrentTransferSharing : 1;
+		uint32_t                        hostVisibleDeviceMemoryType;
 		union
 		{
 			struct
@@ -2252,6 +2304,11 @@ namespace SG
 
 	SG_RENDER_API void SG_CALLCONV add_semaphore(Renderer* pRenderer, Semaphore** pSemaphore);
 	SG_RENDER_API void SG_CALLCONV remove_semaphore(Renderer* pRenderer, Semaphore* pSemaphore);
+	/// Semaphore with a monotonically increasing value, only if pRenderer->timelineSemaphoreSupport is set
+	SG_RENDER_API void SG_CALLCONV add_timeline_semaphore(Renderer* pRenderer, uint64_t initialValue, Semaphore** ppSemaphore);
+	SG_RENDER_API uint64_t SG_CALLCONV get_semaphore_value(Renderer* pRenderer, Semaphore* pSemaphore);
+	/// Block the calling thread until the timeline semaphore reached value
+	SG_RENDER_API void SG_CALLCONV wait_for_semaphore_value(Renderer* pRenderer, Semaphore* pSemaphore, uint64_t value);
 
 	SG_RENDER_API void SG_CALLCONV add_queue(Renderer* pRenderer, QueueCreateDesc* pQueueDesc, Queue** pQueue);
 	SG_RENDER_API void SG_CALLCONV remove_queue(Renderer* pRenderer, Queue* pQueue);
@@ -2302,8 +2359,20 @@ namespace SG
 	SG_RENDER_API void SG_CALLCONV remove_root_signature(Renderer* pRenderer, RootSignature* pRootSignature);
 
 	// pipeline functions
+	/// Graphics and compute pipelines are shared: a description equal to the one of a pipeline alive returns that pipeline,
+	/// every add_pipeline needs its remove_pipeline. The name of the first description is kept
 	SG_RENDER_API void SG_CALLCONV add_pipeline(Renderer* pRenderer, const PipelineCreateDesc* pPipelineSettings, Pipeline** pPipeline);
+	/// add_pipeline that creates the pipeline on a worker thread when it is not in the cache. Until it is ready, binding the
+	/// pipeline binds pFallback, which has to be of the same type, compatible with the same render targets and stay alive until then.
+	/// Callers joining a creation in flight get a handle of their own, bound to their own fallback.
+	/// pFallback may be null for a pipeline that is not bound before it is ready, like when warming up the cache
+	SG_RENDER_API void SG_CALLCONV add_pipeline_async(Renderer* pRenderer, const PipelineCreateDesc* pPipelineSettings, Pipeline* pFallback, Pipeline** pPipeline);
+	/// False while an async pipeline binds its fallback
+	SG_RENDER_API bool SG_CALLCONV is_pipeline_ready(Pipeline* pPipeline);
 	SG_RENDER_API void SG_CALLCONV remove_pipeline(Renderer* pRenderer, Pipeline* pPipeline);
+	SG_RENDER_API void SG_CALLCONV get_pipeline_state_cache_stats(Renderer* pRenderer, PipelineStateCacheStats* pStats);
+	/// The callback has to be thread safe, pass null to remove it
+	SG_RENDER_API void SG_CALLCONV set_pipeline_created_callback(Renderer* pRenderer, PipelineCreatedFunc pFunc, void* pUserData);
 	SG_RENDER_API void SG_CALLCONV add_pipeline_cache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache);
 	SG_RENDER_API void SG_CALLCONV get_pipeline_cache_data(Renderer* pRenderer, PipelineCache* pPipelineCache, size_t* pSize, void* pData);
 	SG_RENDER_API void SG_CALLCONV remove_pipeline_cache(Renderer* pRenderer, PipelineCache* pPipelineCache);
@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 
+#include "../../../Core/Source/TextureSystem/TextureCompressor.h"
+#include "../../../Core/Source/TextureSystem/MipGenerator.h"
+
 //#include "IRenderer.h"
 //#include "../../../Core/Source/Core/Atomic.h"
 //#include "../../../Core/Source/Math/MathTypes.h"
@@ -35,8 +38,40 @@ namespace SG
 		SG_TEXTURE_CONTAINER_BASIS,
 		/// .svt
 		SG_TEXTURE_CONTAINER_SVT,
+		/// .ktx2, plain, zstd supercompressed or Basis Universal (ETC1S / UASTC) encoded.
+		/// Basis data is transcoded on the loader workers to the best block format the GPU can sample.
+		/// zstd and Basis need the project generated with --basisu=<path to basis_universal>, otherwise only plain KTX2 loads
+		SG_TEXTURE_CONTAINER_KTX2,
 	} TextureContainerType;
 
+	typedef enum LoadPriority
+	{
+		/// Needed right away, processed in the next batch of the loader
+		/// Buffer/texture updates and barriers always use this priority
+		SG_LOAD_PRIORITY_IMMEDIATE = 0,
+		/// Visible on screen, may arrive a few frames late
+		SG_LOAD_PRIORITY_VISIBLE,
+		/// Speculative streaming, only processed when nothing more urgent is waiting
+		SG_LOAD_PRIORITY_PREFETCH,
+		SG_LOAD_PRIORITY_COUNT,
+	} LoadPriority;
+
+	typedef struct BufferPool BufferPool;
+
+	typedef struct BufferPoolDesc
+	{
+		/// Size of the shared buffers the pool sub-allocates from, another one is added whenever they are full
+		uint64_t            blockSize;
+		/// Usage class of the pool, its buffers may use any subset of these descriptors
+		DescriptorType      descriptors;
+		ResourceMemoryUsage memoryUsage;
+		/// Creation flags of the shared buffers, the ones of CPU visible pools are always persistently mapped
+		BufferCreationFlags flags;
+		uint32_t            nodeIndex;
+		/// Debug name of the shared buffers
+		const char*         name;
+	} BufferPoolDesc;
+
 	typedef struct BufferLoadDesc
 	{
 		Buffer** ppBuffer;
@@ -44,6 +79,9 @@ namespace SG
 		BufferCreateDesc  desc;
 		/// Force Reset buffer to NULL
 		bool        forceReset;
+		/// Sub-allocate the buffer from a shared buffer of this pool instead of giving it a VkBuffer of its own.
+		/// desc.memoryUsage and desc.nodeIndex have to match the pool and desc.descriptors has to be part of its usage class
+		BufferPool* pPool;
 	} BufferLoadDesc;
 
 	typedef struct TextureLoadDesc
@@ -59,8 +97,25 @@ namespace SG
 		TextureCreationFlags creationFlag;
 		/// The texture file format (dds/ktx/...)
 		TextureContainerType container;
+		/// How urgently the loader should process this load
+		LoadPriority         priority;
+		/// Stream the mip chain instead of loading it up front (dds/ktx only).
+		/// Only this many of the smallest mips are loaded by add_resource and they always stay resident,
+		/// the larger mips follow through update_texture_streaming. 0 loads the whole chain.
+		uint32_t             minResidentMips;
+		/// Build the mip chain of files which only store the first mip, on the loader threads while the texels are decoded.
+		/// Works for uncompressed 8 bit unorm / sRGB and 32 bit float formats which are not streamed, cubemaps get their edges fixed up
+		MipFilter            mipFilter;
+		MipGenerationFlags   mipFlags;
 	} TextureLoadDesc;
 
+	/// Max levels of detail of a geometry, including the full detail one
+	#define SG_MAX_GEOMETRY_LODS 8
+
+	// Math/MeshOptimization.h
+	struct Meshlet;
+	struct MeshletBounds;
+
 	typedef struct Geometry
 	{
 		struct Hair
@@ -75,19 +130,40 @@ namespace SG
 			void* pAttributes[SG_MAX_VERTEX_ATTRIBS];
 		};
 
+		struct MeshletData
+		{
+			Meshlet*       pMeshlets;
+			/// Bounding sphere and normal cone of every meshlet, for cluster culling
+			MeshletBounds* pBounds;
+			/// Geometry vertex index of every meshlet vertex
+			uint32_t*      pVertices;
+			/// Three meshlet local vertex indices per triangle
+			uint8_t*       pTriangles;
+			/// The meshlets of draw i are [pDrawMeshletOffsets[i], pDrawMeshletOffsets[i + 1])
+			uint32_t*      pDrawMeshletOffsets;
+			uint32_t       meshletCount;
+			uint32_t       vertexCount;
+			uint32_t       triangleCount;
+		};
+
 		/// Index buffer to bind when drawing this geometry
 		Buffer* pIndexBuffer;
 		/// The array of vertex buffers to bind when drawing this geometry
 		Buffer* pVertexBuffers[SG_MAX_VERTEX_BINDINGS];
-		/// The array of traditional draw arguments to draw each subset in this geometry
+		/// The array of traditional draw arguments to draw each subset in this geometry.
+		/// Holds drawArgCount draws for every LOD, the draws of LOD l start at pDrawArgs + l * drawArgCount
 		IndirectDrawIndexArguments* pDrawArgs;
 		/// Shadow copy of the geometry vertex and index data if requested through the load flags
 		ShadowData* pShadow;
+		/// Meshlets of every draw if requested through the load flags
+		MeshletData* pMeshlets;
 
 		/// The array of joint inverse bind-pose matrices ( object-space )
 		Matrix4* pInverseBindPoses;
 		/// The array of data to remap skin batch local joint ids to global joint ids
 		uint32_t* pJointRemaps;
+		/// Simplification error of every LOD in object space units, 0 for LOD 0
+		float* pLodErrors;
 		/// The array of vertex buffer strides to bind when drawing this geometry
 		uint32_t vertexStrides[SG_MAX_VERTEX_BINDINGS];
 		/// Hair data
@@ -99,9 +175,11 @@ namespace SG
 		uint32_t indexType : 2;
 		/// Number of joints in the skinned geometry
 		uint32_t jointCount : 16;
-		/// Number of draw args in the geometry
+		/// Number of levels of detail, they share the vertex buffers and index into the same index buffer
+		uint32_t lodCount : 4;
+		/// Number of draw args of every LOD in the geometry
 		uint32_t drawArgCount;
-		/// Number of indices in the geometry
+		/// Number of indices in the geometry, all the LODs together
 		uint32_t indexCount;
 		/// Number of vertices in the geometry
 		uint32_t vertexCount;
@@ -115,6 +193,20 @@ namespace SG
 		SG_GEOMETRY_LOAD_FLAG_SHADOWED = 0x1,
 		/// Use structured buffers instead of raw buffers
 		SG_GEOMETRY_LOAD_FLAG_STRUCTURED_BUFFERS = 0x2,
+		/// Merge vertices with identical attributes
+		SG_GEOMETRY_LOAD_FLAG_DEDUPLICATE_VERTICES = 0x4,
+		/// Reorder the triangles of every draw for the post-transform vertex cache
+		SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_CACHE = 0x8,
+		/// Reorder clusters of triangles to draw the outward facing ones first, the vertex cache efficiency stays within 5%
+		SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_OVERDRAW = 0x10,
+		/// Reorder the vertices by their first use in the index buffer
+		SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_FETCH = 0x20,
+		/// Log the ACMR (average cache miss ratio) and vertex count before and after the optimizations
+		SG_GEOMETRY_LOAD_FLAG_OPTIMIZATION_REPORT = 0x40,
+		/// Split every draw into meshlets of up to 64 vertices and 124 triangles with per meshlet culling bounds
+		SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS = 0x80,
+		SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_ALL = SG_GEOMETRY_LOAD_FLAG_DEDUPLICATE_VERTICES | SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_CACHE |
+			SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_OVERDRAW | SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_FETCH,
 	} GeometryLoadFlags;
 	SG_MAKE_ENUM_FLAG(uint32_t, GeometryLoadFlags);
 
@@ -130,6 +222,13 @@ namespace SG
 		uint32_t          nodeIndex;
 		/// Specifies how to arrange the vertex data loaded from the file into GPU memory
 		VertexLayout* pVertexLayout;
+		/// How urgently the loader should process this load
+		LoadPriority      priority;
+		/// Levels of detail to generate by simplifying the geometry, every one targets half the triangles of the previous one.
+		/// 0 or 1 only loads the full detail geometry, the chain ends early once a level stops paying off
+		uint32_t          lodCount;
+		/// Max simplification error of a LOD relative to the extent of the mesh, 0 uses the loader default (2%)
+		float             lodTargetError;
 	} GeometryLoadDesc;
 
 	typedef struct VirtualTexturePageInfo
@@ -229,6 +328,50 @@ namespace SG
 		ShaderTarget        target;
 	} ShaderLoadDesc;
 
+	typedef struct ShaderCompileStats
+	{
+		/// Stages whose binary was up to date
+		uint32_t cachedStageCount;
+		/// Stages compiled from source, their binaries were written to the shader binary directory
+		uint32_t compiledStageCount;
+		/// Stages another shader of the batch loaded with the same file and macros
+		uint32_t sharedStageCount;
+		uint32_t failedStageCount;
+		/// Shaders with at least one stage that failed
+		uint32_t failedShaderCount;
+		/// Seconds the whole batch took
+		float    batchTime;
+		/// Seconds spent compiling, added up over all the stages compiled in parallel
+		float    compileTime;
+		/// Bytecode of the compiled stages as the compiler produced it and as it was saved. Release builds optimize
+		/// the SPIR-V and strip its debug information in between
+		uint64_t compiledByteCodeSize;
+		uint64_t compiledInstructionCount;
+		uint64_t savedByteCodeSize;
+		uint64_t savedInstructionCount;
+	} ShaderCompileStats;
+
+	typedef struct ShaderReloadDesc
+	{
+		/// Seconds between two looks at the modification times of the shader files, 0 looks on every update
+		float    pollInterval;
+		/// Number of frames the GPU may still be working on, a replaced object is freed that many updates after the swap
+		uint32_t framesInFlight;
+	} ShaderReloadDesc;
+
+	typedef struct ShaderReloadStatus
+	{
+		/// Number of shaders the update swapped in
+		uint32_t    reloadedShaderCount;
+		/// The update swapped in new root signatures, the descriptor sets made from the old ones have to be created again
+		bool        rootSignaturesChanged;
+		/// Changed shaders are compiling in the background
+		bool        reloading;
+		/// Compile errors of the watched shaders that failed to reload, empty once all of them compile again.
+		/// Valid until the next update_shader_reload
+		const char* pErrors;
+	} ShaderReloadStatus;
+
 	typedef struct PipelineCacheLoadDesc
 	{
 		const char*		   fileName;
@@ -240,16 +383,94 @@ namespace SG
 		const char* fileName;
 	} PipelineCacheSaveDesc;
 
+	typedef struct PipelineManifestStats
+	{
+		/// Pipelines in the manifest, the ones read at init_pipeline_manifest and the ones recorded since
+		uint32_t recordCount;
+		/// Pipelines the replay created or found in the pipeline state cache
+		uint32_t replayedCount;
+		/// Pipelines left for a later replay because their shader or root signature is not registered
+		uint32_t skippedCount;
+		/// Seconds the replay took
+		float    replayTime;
+	} PipelineManifestStats;
+
 	typedef uint64_t SyncToken;
 
+	/// Loads that complete as a whole, e.g. all the assets of a level
+	typedef struct SyncTokenGroup
+	{
+		/// token completing with every load of the group
+		SyncToken token;
+		/// number of loads added to the group
+		uint32_t  count;
+	} SyncTokenGroup;
+
+	typedef void (*LoadCompletedFunc)(void* pUserData);
+
+	typedef enum LoadCallbackDispatch
+	{
+		/// Queued until dispatch_resource_load_callbacks is called, usually from the main thread once per frame
+		SG_LOAD_CALLBACK_DISPATCH_MAIN_THREAD = 0,
+		/// Run on worker threads of the loader as soon as the load completes. The callback may wait on other loads,
+		/// the decoding workers never run it.
+		/// Falls back to SG_LOAD_CALLBACK_DISPATCH_MAIN_THREAD when the loader is single threaded
+		SG_LOAD_CALLBACK_DISPATCH_WORKER,
+	} LoadCallbackDispatch;
+
 	typedef struct ResourceLoaderDesc
 	{
 		uint64_t bufferSize;
 		uint32_t bufferCount;
 		bool     singleThreaded;
+		/// Number of worker threads decoding textures and geometry for the loader thread, 0 uses one per core
+		uint32_t decodeThreadCount;
+		/// Share the textures and geometries loaded from files: add_resource with a file and load parameters that were already added
+		/// hands out the same resource (or joins its load that is still in flight) instead of loading the file again.
+		/// The resource is freed once remove_resource was called for every add_resource that returned it
+		bool     enableResourceCache;
+		/// On a dedicated transfer family, upload into exclusive resources and release them to the graphics family.
+		/// Every graphics submission then has to record cmd_acquire_loaded_resources before it uses a loaded resource.
+		/// Off by default: the renderer creates the resources shared by both families and no acquire is needed
+		bool     queueOwnershipTransfer;
 	} ResourceLoaderDesc;
 
 	extern ResourceLoaderDesc gDefaultResourceLoaderDesc;
+
+	typedef struct ResourceLoaderStats
+	{
+		/// Number of requests waiting in the queue of each priority
+		uint32_t queueDepth[SG_LOAD_PRIORITY_COUNT];
+		/// Highest queue depth the loader has seen for each priority
+		uint32_t peakQueueDepth[SG_LOAD_PRIORITY_COUNT];
+		/// Number of requests dropped through cancel_resource_load
+		uint64_t cancelledCount;
+		/// Number of textures loaded with TextureLoadDesc::minResidentMips
+		uint32_t streamedTextureCount;
+		/// GPU memory used by the resident mips of the streamed textures
+		uint64_t streamedTextureMemory;
+		/// Number of textures and geometries in the resource cache, including the loads still in flight
+		uint32_t cachedResourceCount;
+		/// Number of add_resource calls the resource cache answered without loading the file again
+		uint64_t resourceCacheHits;
+		/// Bytes of geometry written straight into host visible device local memory (resizable BAR or unified memory),
+		/// without staging memory or a copy
+		uint64_t directUploadBytes;
+	} ResourceLoaderStats;
+
+	typedef struct TextureStreamingUpdateDesc
+	{
+		/// GPU memory the resident mips of all streamed textures may use, 0 for no limit
+		uint64_t  memoryBudget;
+		/// Maximum number of mip loads started by one update
+		uint32_t  maxLoadCount;
+		/// Receives the textures whose resident mip chain changed, descriptors pointing to them have to be updated.
+		/// Uploaded chains wait for a later update when the array is full.
+		Texture** ppChangedTextures;
+		uint32_t  changedTextureCapacity;
+		/// Filled by update_texture_streaming
+		uint32_t  changedTextureCount;
+	} TextureStreamingUpdateDesc;
 	
 	// MARK: - Resource Loader Functions
 	void init_resource_loader_interface(Renderer* pRenderer, ResourceLoaderDesc* pDesc = nullptr);
@@ -272,6 +493,49 @@ namespace SG
 	void end_update_resource(BufferUpdateDesc* pBuffer, SyncToken* token);
 	void end_update_resource(TextureUpdateDesc* pTexture, SyncToken* token);
 
+	// MARK: Cooked Geometry
+
+	/// Cook the gltf pDesc->fileName into a .sgmesh holding the final index and vertex streams for pDesc->pVertexLayout
+	/// (after the optimizations pDesc->flags asks for) plus the draw arguments and joint data, written to cookedFileName
+	/// or next to the gltf if cookedFileName is nullptr.
+	/// add_resource(GeometryLoadDesc) reads the cooked file straight into staging memory whenever it is newer than the gltf and
+	/// was cooked with the same vertex layout and optimization flags, and falls back to the gltf otherwise.
+	/// A .sgmesh can also be loaded directly. Geometries which are loaded shadowed have to be cooked with SG_GEOMETRY_LOAD_FLAG_SHADOWED.
+	bool cook_geometry(const GeometryLoadDesc* pDesc, const char* cookedFileName);
+
+	// MARK: Geometry LOD
+
+	/// Pick the coarsest LOD of pGeom whose simplification error projects to at most maxPixelError pixels on screen.
+	/// pixelsPerUnit is the projected size of one object space unit at the distance of the geometry,
+	/// viewportHeight / (2 * tan(fovY / 2) * distance) for a perspective projection. Draw it with pGeom->pDrawArgs + lod * pGeom->drawArgCount
+	uint32_t select_geometry_lod(const Geometry* pGeom, float pixelsPerUnit, float maxPixelError);
+
+	// MARK: Texture Compression
+
+	typedef struct TextureCookDesc
+	{
+		/// Uncompressed RGBA8 or BGRA8 DDS in the texture directory, with or without the extension
+		const char*             fileName;
+		BlockCompressionFormat  format;
+		BlockCompressionQuality quality;
+		/// Use the sRGB variant of BC1, BC3 and BC7, sRGB sources always do
+		bool                    srgb;
+	} TextureCookDesc;
+
+	/// Block compress every array slice and mip of pDesc->fileName into a DDS of the compressed format, written to cookedFileName
+	/// (<fileName>_<format>.dds next to the source when null) so add_resource(TextureLoadDesc) picks it up like any other DDS.
+	/// The blocks are compressed on the resource loader threads, so this must not be called from a load callback running on them
+	bool cook_texture(const TextureCookDesc* pDesc, const char* cookedFileName);
+
+	// MARK: Buffer Pools
+
+	/// Small buffers of one usage class (per frame uniform buffers, vertex and index buffers of many meshes) share a few large buffers.
+	/// Each buffer is a range of one of them found by a TLSF allocator: creating it needs no driver call and no memory allocation,
+	/// and buffers of the same pool can be bound with the same VkBuffer. The buffers are returned to their pool by remove_resource
+	void add_buffer_pool(const BufferPoolDesc* pDesc, BufferPool** ppPool);
+	/// All buffers of the pool have to be removed first
+	void remove_buffer_pool(BufferPool* pPool);
+
 	// MARK: removeResource
 
 	void remove_resource(Buffer* pBuffer);
@@ -292,15 +556,116 @@ namespace SG
 	/// A SyncToken is an array of monotonically(أޱ仯) increasing integers.
 	/// getLastTokenCompleted() returns the last value for which
 	/// isTokenCompleted(token) is guaranteed to return true.
+	/// Requests of a higher priority complete before older ones, so a token above it may already be completed as well.
+	/// A token passed to several calls completes once all of their requests did
 	SyncToken get_last_token_completed();
 	bool is_token_completed(const SyncToken* token);
+	/// The copies of a submitted token are queued on the GPU. Before they complete, only a graphics submission which
+	/// waits on the semaphore of cmd_acquire_loaded_resources may use the resources
+	SyncToken get_last_token_submitted();
+	bool is_token_submitted(const SyncToken* token);
+	/// Get the timeline semaphore and value the submission of pCmd has to wait for, so the GPU orders it after every copy
+	/// the loader submitted so far (null without timeline semaphores, the tokens have to complete then).
+	/// With ResourceLoaderDesc::queueOwnershipTransfer it also records the queue family acquires of everything uploaded
+	/// since the last call, it has to be called for every graphics submission then
+	void cmd_acquire_loaded_resources(Cmd* pCmd, Semaphore** ppWaitSemaphore, uint64_t* pWaitValue);
+	/// Sleeps until this token is completed, the loader only wakes the waiters whose token it reached
 	void wait_for_token(const SyncToken* token);
 
+	/// Add the token of an add_resource/end_update_resource call to a group
+	void add_sync_token_to_group(SyncTokenGroup* pGroup, const SyncToken* token);
+	bool is_token_group_completed(const SyncTokenGroup* pGroup);
+	void wait_for_token_group(const SyncTokenGroup* pGroup);
+
+	/// Call pFunc once the token is completed, right away (on the dispatch target) if it already is
+	void add_resource_load_callback(const SyncToken* token, LoadCompletedFunc pFunc, void* pUserData, LoadCallbackDispatch dispatch);
+	void add_token_group_callback(const SyncTokenGroup* pGroup, LoadCompletedFunc pFunc, void* pUserData, LoadCallbackDispatch dispatch);
+	/// Run the SG_LOAD_CALLBACK_DISPATCH_MAIN_THREAD callbacks of the completed loads on the calling thread, returns how many ran
+	uint32_t dispatch_resource_load_callbacks();
+
+	// MARK: Scheduling
+
+	/// Requests of a higher priority are processed first, every batch takes all the immediate requests
+	/// and only a few visible or prefetch ones, so urgent loads never wait behind a long streaming queue.
+	/// The functions below identify a request by the token of its own add_resource/end_update_resource call
+	/// (pass a token initialized to 0 to that call). They return false if the loader has already picked up the request.
+
+	/// Move a queued request to another priority class
+	bool set_resource_load_priority(const SyncToken* token, LoadPriority priority);
+	/// Drop a queued request and release the staging memory it holds, the token completes as if the request had run.
+	/// A load shared through the resource cache is dropped for every add_resource that joined it
+	bool cancel_resource_load(const SyncToken* token);
+	void get_resource_loader_stats(ResourceLoaderStats* pOutStats);
+
+	// MARK: Texture Streaming
+
+	/// Streamed textures (TextureLoadDesc::minResidentMips) start with their smallest mips only.
+	/// The renderer reports how large every visible texture is on screen, update_texture_streaming (once per frame,
+	/// from the thread rendering) loads the mips that size needs, most magnified textures first, and drops mips
+	/// of the least important textures to stay inside the memory budget.
+	/// A new mip chain is swapped into the same Texture object once it is uploaded and the old one is released
+	/// a few updates later, so the Texture pointer stays valid and sampling always sees fully loaded mips.
+
+	/// Longest edge in pixels the texture covers on screen this frame, 0 if it is not visible
+	void set_texture_screen_size(Texture* pTexture, float screenSize);
+	void update_texture_streaming(TextureStreamingUpdateDesc* pDesc);
+	/// First mip of the file that is resident in the texture, 0 for textures that are not streamed
+	uint32_t get_texture_resident_mip(Texture* pTexture);
+
 	/// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
 	void add_shader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** pShader);
+	/// add_shader for a batch of shaders, e.g. all the variants a pass needs. The stages of all the shaders are loaded and compiled
+	/// at the same time on the workers of the resource loader, with shaderc in process when the Vulkan SDK provides it,
+	/// and every source file the batch includes is read once. A shader with a stage that fails to load is left untouched in ppShaders
+	void add_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders);
+	/// Bring the binaries of a batch of shaders up to date without creating the shaders, so tools can compile every variant offline.
+	/// The binaries hold the reflection of the bytecode as well, taken before release builds strip the names from the bytecode
+	/// Returns false if a shader failed to compile
+	bool compile_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, ShaderCompileStats* pStats);
+
+	// MARK: Shader Hot Reload
+
+	/// Watched shaders are polled for changes of their source files and of everything they include. Changed shaders are recompiled
+	/// on a background thread, together with the watched root signatures and pipelines made from them, and update_shader_reload
+	/// swaps the new objects into the pointers the app registered. The replaced objects are freed once the GPU is done with them.
+	/// A shader that fails to compile keeps its last working version, its errors are reported in the status.
+	/// Watch a shader before the root signatures and pipelines made from it, the descs are copied. Raytracing pipelines are not watched.
+	/// Without init_shader_reload all the functions below do nothing, so the app can watch its objects in every build
+	void init_shader_reload(Renderer* pRenderer, const ShaderReloadDesc* pDesc);
+	/// Frees the replaced objects right away, the GPU has to be idle. The objects in the watched pointers belong to the app
+	void exit_shader_reload();
+	void watch_shader(const ShaderLoadDesc* pDesc, Shader** ppShader);
+	void watch_root_signature(const RootSignatureCreateDesc* pDesc, RootSignature** ppRootSignature);
+	void watch_pipeline(const PipelineCreateDesc* pDesc, Pipeline** ppPipeline);
+	/// Stop watching before removing the object in the pointer, a reload in flight is finished first
+	void unwatch_shader(Shader** ppShader);
+	void unwatch_root_signature(RootSignature** ppRootSignature);
+	void unwatch_pipeline(Pipeline** ppPipeline);
+	/// Once per frame on the rendering thread, before recording anything that uses the watched objects
+	void update_shader_reload(ShaderReloadStatus* pStatus);
 
 	/// Save/Load pipeline cache from disk
 	void add_pipeline_cache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache);
 	void save_pipeline_cache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc);
 
+	// MARK: Pipeline Manifest
+
+	/// The pipeline cache above only keeps the driver blob, the app still creates every pipeline on first use.
+	/// The manifest records the description of every pipeline the pipeline state cache creates, with its shader and root signature
+	/// identified by the name the app registered them with, and saves it at exit. At the next launch replay_pipeline_manifest creates
+	/// the recorded pipelines up front, so add_pipeline finds them in the pipeline state cache.
+	/// Pipelines of shaders or root signatures that are not registered are not recorded. The manifest is only valid for the build
+	/// that wrote it, a manifest of another layout is dropped
+	void init_pipeline_manifest(Renderer* pRenderer, const char* fileName);
+	/// Saves the manifest and releases the replayed pipelines, call it before the registered objects are removed
+	void exit_pipeline_manifest();
+	/// The names have to stay the same between launches. Register the new object under the same name when an object is recreated,
+	/// or pass null to forget the name before the object is removed. Objects swapped in by the shader hot reload keep their name
+	void register_pipeline_manifest_shader(const char* name, Shader* pShader);
+	void register_pipeline_manifest_root_signature(const char* name, RootSignature* pRootSignature);
+	/// Create the recorded pipelines whose shader and root signature are registered, through add_pipeline_async on the workers of the
+	/// pipeline state cache with the calling thread helping out. It only waits for its own pipelines. Call it while loading, once per set of registered objects, e.g. after the shaders of a level are loaded.
+	/// The pipelines stay alive until exit_pipeline_manifest. pCache is the driver cache the pipelines are created with, it may be null
+	void replay_pipeline_manifest(PipelineCache* pCache, PipelineManifestStats* pStats);
+
 }
\ No newline at end of file
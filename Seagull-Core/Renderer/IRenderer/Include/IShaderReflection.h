@@ -119,7 +119,13 @@ namespace SG
 	void create_pipeline_reflection(ShaderReflection* pReflection, uint32_t stageCount, PipelineReflection* pOutReflection);
 	void destroy_pipeline_reflection(PipelineReflection* pReflection);
 
-	//void serialize_reflection(File* pInFile, Reflection* pReflection);
-	//void deserialize_reflection(File* pOutFile, Reflection* pReflection);
+	/// Size of the blob serialize_shader_reflection writes for the reflection
+	uint32_t get_shader_reflection_blob_size(const ShaderReflection* pReflection);
+	/// Writes the reflection with its names to pOutBlob, which holds get_shader_reflection_blob_size bytes.
+	/// The blob has no pointers, it is stored next to the bytecode so loading a shader binary does not reflect it again
+	void serialize_shader_reflection(const ShaderReflection* pReflection, void* pOutBlob);
+	/// Rebuilds a reflection serialized by serialize_shader_reflection, free it with destroy_shader_reflection.
+	/// Returns false if the blob is not a valid reflection
+	bool deserialize_shader_reflection(const void* pBlob, uint32_t blobSize, ShaderReflection* pOutReflection);
 
 }
\ No newline at end of file
@@ -59,6 +59,265 @@ namespace SG
 		sg_free(pReflection->pVariables);
 	}
 
+	// A serialized reflection is the header, the vertex inputs, the resources and the variables, followed by the name pool.
+	// Names are offsets into the name pool instead of pointers.
+	#define SG_SHADER_REFLECTION_NO_NAME UINT32_MAX
+
+	typedef struct ShaderReflectionBlobHeader
+	{
+		uint32_t shaderStage;
+		uint32_t namePoolSize;
+		uint32_t vertexInputsCount;
+		uint32_t shaderResourceCount;
+		uint32_t variableCount;
+		uint32_t numThreadsPerGroup[3];
+		uint32_t numControlPoint;
+		uint32_t entryPointOffset;
+	} ShaderReflectionBlobHeader;
+
+	typedef struct VertexInputBlob
+	{
+		uint32_t size;
+		uint32_t nameOffset;
+		uint32_t nameSize;
+	} VertexInputBlob;
+
+	typedef struct ShaderResourceBlob
+	{
+		uint32_t type;
+		uint32_t set;
+		uint32_t reg;
+		uint32_t size;
+		uint32_t usedStages;
+		uint32_t nameOffset;
+		uint32_t nameSize;
+		uint32_t dim;
+	} ShaderResourceBlob;
+
+	typedef struct ShaderVariableBlob
+	{
+		uint32_t parentIndex;
+		uint32_t offset;
+		uint32_t size;
+		uint32_t nameOffset;
+		uint32_t nameSize;
+#if defined(SG_GRAPHIC_API_GLES)
+		uint32_t type;
+#endif
+	} ShaderVariableBlob;
+
+	static uint32_t util_get_name_offset(const ShaderReflection* pReflection, const char* name)
+	{
+		if (name == nullptr)
+			return SG_SHADER_REFLECTION_NO_NAME;
+
+		ASSERT(name >= pReflection->pNamePool && name < pReflection->pNamePool + pReflection->namePoolSize);
+		return (uint32_t)(name - pReflection->pNamePool);
+	}
+
+	// the names in the pool are null terminated, a name running up to the end of the pool is broken
+	static char* util_get_pool_name(const ShaderReflection* pReflection, uint32_t nameOffset, uint32_t nameSize, bool* pValid)
+	{
+		if (nameOffset == SG_SHADER_REFLECTION_NO_NAME)
+			return nullptr;
+
+		if ((uint64_t)nameOffset + nameSize >= pReflection->namePoolSize)
+		{
+			*pValid = false;
+			return nullptr;
+		}
+		return pReflection->pNamePool + nameOffset;
+	}
+
+	uint32_t get_shader_reflection_blob_size(const ShaderReflection* pReflection)
+	{
+		return (uint32_t)(sizeof(ShaderReflectionBlobHeader) +
+			pReflection->vertexInputsCount * sizeof(VertexInputBlob) +
+			pReflection->shaderResourceCount * sizeof(ShaderResourceBlob) +
+			pReflection->variableCount * sizeof(ShaderVariableBlob) +
+			pReflection->namePoolSize);
+	}
+
+	void serialize_shader_reflection(const ShaderReflection* pReflection, void* pOutBlob)
+	{
+		ASSERT(pReflection);
+		ASSERT(pOutBlob);
+
+		uint8_t* pDst = (uint8_t*)pOutBlob;
+
+		ShaderReflectionBlobHeader header = {};
+		header.shaderStage = (uint32_t)pReflection->shaderStage;
+		header.namePoolSize = pReflection->namePoolSize;
+		header.vertexInputsCount = pReflection->vertexInputsCount;
+		header.shaderResourceCount = pReflection->shaderResourceCount;
+		header.variableCount = pReflection->variableCount;
+		for (uint32_t i = 0; i < 3; ++i)
+			header.numThreadsPerGroup[i] = pReflection->numThreadsPerGroup[i];
+		header.numControlPoint = pReflection->numControlPoint;
+#if defined(SG_GRAPHIC_API_VULKAN)
+		header.entryPointOffset = util_get_name_offset(pReflection, pReflection->pEntryPoint);
+#else
+		header.entryPointOffset = SG_SHADER_REFLECTION_NO_NAME;
+#endif
+		memcpy(pDst, &header, sizeof(header));
+		pDst += sizeof(header);
+
+		for (uint32_t i = 0; i < pReflection->vertexInputsCount; ++i)
+		{
+			const VertexInput& input = pReflection->pVertexInputs[i];
+			VertexInputBlob blob = { input.size, util_get_name_offset(pReflection, input.name), input.nameSize };
+			memcpy(pDst, &blob, sizeof(blob));
+			pDst += sizeof(blob);
+		}
+
+		for (uint32_t i = 0; i < pReflection->shaderResourceCount; ++i)
+		{
+			const ShaderResource& resource = pReflection->pShaderResources[i];
+			ShaderResourceBlob blob = {};
+			blob.type = (uint32_t)resource.type;
+			blob.set = resource.set;
+			blob.reg = resource.reg;
+			blob.size = resource.size;
+			blob.usedStages = (uint32_t)resource.usedStages;
+			blob.nameOffset = util_get_name_offset(pReflection, resource.name);
+			blob.nameSize = resource.nameSize;
+			blob.dim = (uint32_t)resource.dim;
+			memcpy(pDst, &blob, sizeof(blob));
+			pDst += sizeof(blob);
+		}
+
+		for (uint32_t i = 0; i < pReflection->variableCount; ++i)
+		{
+			const ShaderVariable& variable = pReflection->pVariables[i];
+			ShaderVariableBlob blob = {};
+			blob.parentIndex = variable.parentIndex;
+			blob.offset = variable.offset;
+			blob.size = variable.size;
+			blob.nameOffset = util_get_name_offset(pReflection, variable.name);
+			blob.nameSize = variable.nameSize;
+#if defined(SG_GRAPHIC_API_GLES)
+			blob.type = (uint32_t)variable.type;
+#endif
+			memcpy(pDst, &blob, sizeof(blob));
+			pDst += sizeof(blob);
+		}
+
+		if (pReflection->namePoolSize)
+			memcpy(pDst, pReflection->pNamePool, pReflection->namePoolSize);
+	}
+
+	bool deserialize_shader_reflection(const void* pBlob, uint32_t blobSize, ShaderReflection* pOutReflection)
+	{
+		ASSERT(pOutReflection);
+
+		ShaderReflectionBlobHeader header = {};
+		if (pBlob == nullptr || blobSize < sizeof(header))
+			return false;
+		memcpy(&header, pBlob, sizeof(header));
+
+		const uint64_t expectedSize = sizeof(header) +
+			(uint64_t)header.vertexInputsCount * sizeof(VertexInputBlob) +
+			(uint64_t)header.shaderResourceCount * sizeof(ShaderResourceBlob) +
+			(uint64_t)header.variableCount * sizeof(ShaderVariableBlob) +
+			header.namePoolSize;
+		if (expectedSize != blobSize)
+			return false;
+
+		const uint8_t* pSrc = (const uint8_t*)pBlob + sizeof(header);
+		const uint8_t* pNames = (const uint8_t*)pBlob + blobSize - header.namePoolSize;
+
+		ShaderReflection reflection = {};
+		reflection.shaderStage = (ShaderStage)header.shaderStage;
+		reflection.namePoolSize = header.namePoolSize;
+		reflection.vertexInputsCount = header.vertexInputsCount;
+		reflection.shaderResourceCount = header.shaderResourceCount;
+		reflection.variableCount = header.variableCount;
+		for (uint32_t i = 0; i < 3; ++i)
+			reflection.numThreadsPerGroup[i] = header.numThreadsPerGroup[i];
+		reflection.numControlPoint = header.numControlPoint;
+
+		if (reflection.namePoolSize)
+		{
+			reflection.pNamePool = (char*)sg_malloc(reflection.namePoolSize);
+			memcpy(reflection.pNamePool, pNames, reflection.namePoolSize);
+		}
+
+		bool valid = true;
+#if defined(SG_GRAPHIC_API_VULKAN)
+		reflection.pEntryPoint = util_get_pool_name(&reflection, header.entryPointOffset, 0, &valid);
+#endif
+
+		if (reflection.vertexInputsCount)
+		{
+			reflection.pVertexInputs = (VertexInput*)sg_malloc(sizeof(VertexInput) * reflection.vertexInputsCount);
+			for (uint32_t i = 0; i < reflection.vertexInputsCount; ++i)
+			{
+				VertexInputBlob blob;
+				memcpy(&blob, pSrc, sizeof(blob));
+				pSrc += sizeof(blob);
+
+				VertexInput& input = reflection.pVertexInputs[i];
+				input.size = blob.size;
+				input.name = util_get_pool_name(&reflection, blob.nameOffset, blob.nameSize, &valid);
+				input.nameSize = blob.nameSize;
+			}
+		}
+
+		if (reflection.shaderResourceCount)
+		{
+			reflection.pShaderResources = (ShaderResource*)sg_malloc(sizeof(ShaderResource) * reflection.shaderResourceCount);
+			for (uint32_t i = 0; i < reflection.shaderResourceCount; ++i)
+			{
+				ShaderResourceBlob blob;
+				memcpy(&blob, pSrc, sizeof(blob));
+				pSrc += sizeof(blob);
+
+				ShaderResource& resource = reflection.pShaderResources[i];
+				resource.type = (DescriptorType)blob.type;
+				resource.set = blob.set;
+				resource.reg = blob.reg;
+				resource.size = blob.size;
+				resource.usedStages = (ShaderStage)blob.usedStages;
+				resource.name = util_get_pool_name(&reflection, blob.nameOffset, blob.nameSize, &valid);
+				resource.nameSize = blob.nameSize;
+				resource.dim = (TextureDimension)blob.dim;
+			}
+		}
+
+		if (reflection.variableCount)
+		{
+			reflection.pVariables = (ShaderVariable*)sg_malloc(sizeof(ShaderVariable) * reflection.variableCount);
+			for (uint32_t i = 0; i < reflection.variableCount; ++i)
+			{
+				ShaderVariableBlob blob;
+				memcpy(&blob, pSrc, sizeof(blob));
+				pSrc += sizeof(blob);
+
+				ShaderVariable& variable = reflection.pVariables[i];
+				variable.parentIndex = blob.parentIndex;
+				variable.offset = blob.offset;
+				variable.size = blob.size;
+				variable.name = util_get_pool_name(&reflection, blob.nameOffset, blob.nameSize, &valid);
+				variable.nameSize = blob.nameSize;
+#if defined(SG_GRAPHIC_API_GLES)
+				variable.type = (GLenum)blob.type;
+#endif
+				// the variables of a resource the stage does not use are filtered out, the parent is always there
+				valid = valid && variable.parentIndex < reflection.shaderResourceCount;
+			}
+		}
+
+		if (!valid)
+		{
+			SG_LOG_ERROR("Serialized shader reflection is corrupt.");
+			destroy_shader_reflection(&reflection);
+			return false;
+		}
+
+		*pOutReflection = reflection;
+		return true;
+	}
+
 	void create_pipeline_reflection(ShaderReflection* pReflection, uint32_t stageCount, PipelineReflection* pOutReflection)
 	{
 		// parameter checks
@@ -104,12 +363,19 @@ namespace SG
 		ShaderVariable* pVariables = nullptr;
 		uint32_t        variableCount = 0;
 
-		// should we be using dynamic arrays for these? Perhaps we can add std::vector
-		// like functionality?
-		ShaderResource* uniqueResources[512];
-		ShaderStage shaderUsage[512];
-		ShaderVariable* uniqueVariable[512];
-		ShaderResource* uniqueVariableParent[512];
+		// there can not be more unique resources and variables than all the stages have together
+		uint32_t maxResourceCount = 0;
+		uint32_t maxVariableCount = 0;
+		for (uint32_t i = 0; i < stageCount; ++i)
+		{
+			maxResourceCount += pReflection[i].shaderResourceCount;
+			maxVariableCount += pReflection[i].variableCount;
+		}
+
+		ShaderResource** uniqueResources = (ShaderResource**)sg_malloc(sizeof(ShaderResource*) * (maxResourceCount + 1));
+		ShaderStage* shaderUsage = (ShaderStage*)sg_malloc(sizeof(ShaderStage) * (maxResourceCount + 1));
+		ShaderVariable** uniqueVariable = (ShaderVariable**)sg_malloc(sizeof(ShaderVariable*) * (maxVariableCount + 1));
+		ShaderResource** uniqueVariableParent = (ShaderResource**)sg_malloc(sizeof(ShaderResource*) * (maxVariableCount + 1));
 		for (uint32_t i = 0; i < stageCount; ++i)
 		{
 			ShaderReflection* pSrcRef = pReflection + i;
@@ -226,6 +492,11 @@ namespace SG
 			}
 		}
 
+		sg_free(uniqueResources);
+		sg_free(shaderUsage);
+		sg_free(uniqueVariable);
+		sg_free(uniqueVariableParent);
+
 		// all refection structs should be built now
 		pOutReflection->shaderStages = combinedShaderStages;
 
@@ -12,6 +12,8 @@
 
 #include "Interface/ILog.h"
 #include "Interface/IThread.h"
+#include "Interface/ITime.h"
+#include "ThreadSystem/ThreadSystem.h"
 
 #if defined(SG_PLATFORM_WINDOWS)
 // pull in minimal Windows headers
@@ -36,6 +38,9 @@
 #include <include/EASTL/vector.h>
 #include <include/EASTL/string_hash_map.h>
 #include <include/EASTL/sort.h>
+#include <include/EASTL/unordered_map.h>
+
+#include "Core/Hash.h"
 
 // GPUConfig.h still have some issues on <regex>
 #include "Core/GPUConfig.h"
@@ -115,6 +120,14 @@ namespace SG
 
 #pragma endregion (Extern Functions)
 
+	static void util_forget_cached_pipelines(Renderer* pRenderer, const Shader* pShaderProgram, const RootSignature* pRootSignature);
+
+	/// Start of the range of a pooled buffer in the VkBuffer it shares, for other buffers the offset is the first element of their views
+	static inline uint64_t util_get_pool_offset(const Buffer* pBuffer)
+	{
+		return pBuffer->pooled ? pBuffer->offset : 0;
+	}
+
 #pragma region (Predefined Global Variable)
 
 	VkBlendOp gVkBlendOpTranslator[BlendMode::SG_MAX_BLEND_MODES] =
@@ -843,7 +856,9 @@ namespace SG
 				queueIndex = 0;
 				break;
 			}
-			if ((queueFlags & requiredFlags) && ((queueFlags & ~requiredFlags) == 0) &&
+			// sparse binding and protected memory do not make a family less dedicated (the transfer only families usually do sparse binding)
+			const VkQueueFlags otherFlags = queueFlags & ~requiredFlags & ~(VK_QUEUE_SPARSE_BINDING_BIT | VK_QUEUE_PROTECTED_BIT);
+			if ((queueFlags & requiredFlags) && otherFlags == 0 &&
 				pRenderer->pUsedQueueCount[nodeIndex][queueFlags] < pRenderer->pAvailableQueueCount[nodeIndex][queueFlags])
 			{
 				found = true;
@@ -1916,6 +1931,16 @@ namespace SG
 		}
 #endif
 
+#if defined(VK_VERSION_1_2) && !defined(ANDROID)
+		// core in Vulkan 1.2, queried (and so enabled) only on devices which report it
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES };
+		if (pRenderer->pVkActiveGPUProperties->properties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			timelineSemaphoreFeatures.pNext = gpuFeatures2.pNext;
+			gpuFeatures2.pNext = &timelineSemaphoreFeatures;
+		}
+#endif
+
 #ifndef NX64
 		vkGetPhysicalDeviceFeatures2(pRenderer->pVkActiveGPU, &gpuFeatures2);
 #else
@@ -2062,6 +2087,14 @@ namespace SG
 			SG_LOG_INFO("Successfully loaded Nvidia Ray Tracing extension");
 		}
 
+#if defined(VK_VERSION_1_2) && !defined(ANDROID)
+		pRenderer->timelineSemaphoreSupport = timelineSemaphoreFeatures.timelineSemaphore ? 1 : 0;
+		if (pRenderer->timelineSemaphoreSupport)
+		{
+			SG_LOG_INFO("Successfully enabled Timeline Semaphores");
+		}
+#endif
+
 #ifdef USE_DEBUG_UTILS_EXTENSION
 		gDebugMarkerSupport = (&vkCmdBeginDebugUtilsLabelEXT) && (&vkCmdEndDebugUtilsLabelEXT) && (&vkCmdInsertDebugUtilsLabelEXT) && (&vkSetDebugUtilsObjectNameEXT);
 #endif
@@ -2939,11 +2972,12 @@ namespace SG
 				{
 					VALIDATE_DESCRIPTOR(pParam->ppBuffers[arr], "NULL Buffer (%s [%u] )", pDesc->name, arr);
 
+					// a pooled buffer may not see the rest of the VkBuffer it shares
 					pUpdateData[pDesc->handleIndex + arr].bufferInfo =
 					{
 						pParam->ppBuffers[arr]->pVkBuffer,
 						pParam->ppBuffers[arr]->offset,
-						VK_WHOLE_SIZE
+						pParam->ppBuffers[arr]->pooled ? (VkDeviceSize)pParam->ppBuffers[arr]->size : VK_WHOLE_SIZE
 					};
 					if (pParam->offsets)
 					{
@@ -2954,7 +2988,7 @@ namespace SG
 							pParam->sizes[arr],
 							pRenderer->pVkActiveGPUProperties->properties.limits.maxUniformBufferRange);
 
-						pUpdateData[pDesc->handleIndex + arr].bufferInfo.offset = pParam->offsets[arr];
+						pUpdateData[pDesc->handleIndex + arr].bufferInfo.offset = util_get_pool_offset(pParam->ppBuffers[arr]) + pParam->offsets[arr];
 						pUpdateData[pDesc->handleIndex + arr].bufferInfo.range = pParam->sizes[arr];
 					}
 
@@ -3038,6 +3072,18 @@ namespace SG
 
 #pragma region (Buffer Function)
 
+	/// Leave a tenth of the heap of the host visible device memory to the driver and the other allocations of the process
+	static bool util_has_host_visible_device_budget(Renderer* pRenderer, uint64_t size)
+	{
+		const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+		vmaGetMemoryProperties(pRenderer->vmaAllocator, &pMemoryProperties);
+		const uint32_t heapIndex = pMemoryProperties->memoryTypes[pRenderer->hostVisibleDeviceMemoryType].heapIndex;
+
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+		vmaGetBudget(pRenderer->vmaAllocator, budgets);
+		return budgets[heapIndex].usage + size <= budgets[heapIndex].budget - budgets[heapIndex].budget / 10;
+	}
+
 	void add_buffer(Renderer* pRenderer, const BufferCreateDesc* pDesc, Buffer** ppBuffer)
 	{
 		ASSERT(pRenderer);
@@ -3066,6 +3112,15 @@ namespace SG
 		addInfo.queueFamilyIndexCount = 0;
 		addInfo.pQueueFamilyIndices = nullptr;
 
+		// the resource loader writes the buffer on the transfer queue and the graphics queue reads it without an ownership transfer
+		const uint32_t sharedFamilyIndices[] = { pRenderer->graphicsQueueFamilyIndex, pRenderer->transferQueueFamilyIndex };
+		if (pRenderer->concurrentTransferSharing)
+		{
+			addInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			addInfo.queueFamilyIndexCount = 2;
+			addInfo.pQueueFamilyIndices = sharedFamilyIndices;
+		}
+
 		// buffer can be used as dst in a transfer command (Uploading data to a storage buffer, readback query data)
 		if (pDesc->memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY || pDesc->memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_TO_CPU)
 			addInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
@@ -3083,8 +3138,24 @@ namespace SG
 			vmaMemReqs.flags |= VMA_ALLOCATION_CREATE_DONT_BIND_BIT;
 
 		VmaAllocationInfo allocInfo = {};
-		SG_CHECK_VKRESULT(vmaCreateBuffer(pRenderer->vmaAllocator, &addInfo, &vmaMemReqs,
-			&pBuffer->pVkBuffer, &pBuffer->vkAllocation, &allocInfo));
+		VkResult directResult = VK_ERROR_FEATURE_NOT_PRESENT;
+		if ((pDesc->flags & SG_BUFFER_CREATION_FLAG_HOST_VISIBLE_DEVICE_LOCAL) && pRenderer->hostVisibleDeviceMemory &&
+			pDesc->memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY && !linkedMultiGpu && util_has_host_visible_device_budget(pRenderer, allocationSize))
+		{
+			VmaAllocationCreateInfo directMemReqs = vmaMemReqs;
+			directMemReqs.usage = VMA_MEMORY_USAGE_UNKNOWN;
+			directMemReqs.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			directMemReqs.memoryTypeBits = 1u << pRenderer->hostVisibleDeviceMemoryType;
+			directMemReqs.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+			directResult = vmaCreateBuffer(pRenderer->vmaAllocator, &addInfo, &directMemReqs,
+				&pBuffer->pVkBuffer, &pBuffer->vkAllocation, &allocInfo);
+		}
+		// fall back to the memory the usage asks for
+		if (VK_SUCCESS != directResult)
+		{
+			SG_CHECK_VKRESULT(vmaCreateBuffer(pRenderer->vmaAllocator, &addInfo, &vmaMemReqs,
+				&pBuffer->pVkBuffer, &pBuffer->vkAllocation, &allocInfo));
+		}
 
 		pBuffer->pCpuMappedAddress = allocInfo.pMappedData;
 
@@ -3179,6 +3250,7 @@ namespace SG
 		ASSERT(pBuffer);
 		ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 		ASSERT(VK_NULL_HANDLE != pBuffer->pVkBuffer);
+		ASSERT(!pBuffer->pooled && "Pooled buffers are returned to their BufferPool");
 
 		if (pBuffer->pVkUniformTexelView)
 		{
@@ -3311,6 +3383,17 @@ namespace SG
 			createInfo.pQueueFamilyIndices = nullptr;
 			createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
+			// textures the resource loader uploads on the transfer queue, render targets never go through it
+			// and stay exclusive so the driver can keep them compressed
+			const uint32_t sharedFamilyIndices[] = { pRenderer->graphicsQueueFamilyIndex, pRenderer->transferQueueFamilyIndex };
+			if (pRenderer->concurrentTransferSharing &&
+				!(additionalFlags & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)))
+			{
+				createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+				createInfo.queueFamilyIndexCount = 2;
+				createInfo.pQueueFamilyIndices = sharedFamilyIndices;
+			}
+
 			if (cubemapRequired)
 				createInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 			if (arrayRequired)
@@ -3608,6 +3691,20 @@ namespace SG
 
 #pragma region (Shader)
 
+	// the reflection loaded with the byte code saves running spirv-cross over it
+	static void util_create_shader_reflection(const BinaryShaderStageDesc* pStageDesc, ShaderStage stage, ShaderReflection* pOutReflection)
+	{
+		if (pStageDesc->pReflection && deserialize_shader_reflection(pStageDesc->pReflection, pStageDesc->reflectionSize, pOutReflection))
+		{
+			if (pOutReflection->shaderStage == stage)
+				return;
+			destroy_shader_reflection(pOutReflection);
+		}
+
+		*pOutReflection = {};
+		vk_create_shader_reflection((const uint8_t*)pStageDesc->pByteCode, (uint32_t)pStageDesc->byteCodeSize, stage, pOutReflection);
+	}
+
 	void add_shader_binary(Renderer* pRenderer, const BinaryShaderCreateDesc* pDesc, Shader** ppShaderProgram)
 	{
 		ASSERT(pRenderer);
@@ -3668,8 +3765,7 @@ namespace SG
 				{
 				case SG_SHADER_STAGE_VERT:
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->vert.pByteCode, (uint32_t)pDesc->vert.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->vert, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->vert.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->vert.pByteCode;
@@ -3679,8 +3775,7 @@ namespace SG
 				break;
 				case SG_SHADER_STAGE_TESC:
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->hull.pByteCode, (uint32_t)pDesc->hull.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->hull, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->hull.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->hull.pByteCode;
@@ -3690,8 +3785,7 @@ namespace SG
 				break;
 				case SG_SHADER_STAGE_TESE:
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->domain.pByteCode, (uint32_t)pDesc->domain.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->domain, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->domain.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->domain.pByteCode;
@@ -3701,8 +3795,7 @@ namespace SG
 				break;
 				case SG_SHADER_STAGE_GEOM:
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->geom.pByteCode, (uint32_t)pDesc->geom.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->geom, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->geom.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->geom.pByteCode;
@@ -3712,8 +3805,7 @@ namespace SG
 				break;
 				case SG_SHADER_STAGE_FRAG:
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->frag.pByteCode, (uint32_t)pDesc->frag.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->frag, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->frag.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->frag.pByteCode;
@@ -3726,8 +3818,7 @@ namespace SG
 				case SG_SHADER_STAGE_RAYTRACING:
 #endif
 				{
-					vk_create_shader_reflection((const uint8_t*)pDesc->comp.pByteCode, (uint32_t)pDesc->comp.byteCodeSize, stageMask,
-						&stageReflections[counter]);
+					util_create_shader_reflection(&pDesc->comp, stageMask, &stageReflections[counter]);
 
 					createInfo.codeSize = pDesc->comp.byteCodeSize;
 					createInfo.pCode = (const uint32_t*)pDesc->comp.pByteCode;
@@ -3756,6 +3847,9 @@ namespace SG
 
 		ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 
+		// a shader created later at the same address must not hit the pipelines of this one
+		util_forget_cached_pipelines(pRenderer, pShaderProgram, nullptr);
+
 		if (pShaderProgram->stages & SG_SHADER_STAGE_VERT)
 		{
 			vkDestroyShaderModule(pRenderer->pVkDevice, pShaderProgram->pShaderModules[pShaderProgram->pReflection->vertexStageIndex], nullptr);
@@ -4242,7 +4336,9 @@ void cmd_bind_pipeline(Cmd* pCmd, Pipeline* pPipeline)
 	ASSERT(pCmd->pVkCmdBuf != VK_NULL_HANDLE);
 
 	VkPipelineBindPoint pipelineBindPoint = gPipelineBindPoint[pPipeline->type];
-	vkCmdBindPipeline(pCmd->pVkCmdBuf, pipelineBindPoint, pPipeline->pVkPipeline);
+	// a worker swaps the fallback of an async pipeline for the real one
+	VkPipeline pVkPipeline = (VkPipeline)sg_atomic64_load_acquire((sg_atomic64_t*)&pPipeline->pVkPipeline);
+	vkCmdBindPipeline(pCmd->pVkCmdBuf, pipelineBindPoint, pVkPipeline);
 }
 
 void cmd_bind_index_buffer(Cmd* pCmd, Buffer* pBuffer, uint32_t indexType, uint64_t offset)
@@ -4252,7 +4348,7 @@ void cmd_bind_index_buffer(Cmd* pCmd, Buffer* pBuffer, uint32_t indexType, uint6
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
 
 	VkIndexType vkIndexType = (SG_INDEX_TYPE_UINT16 == indexType) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
-	vkCmdBindIndexBuffer(pCmd->pVkCmdBuf, pBuffer->pVkBuffer, offset, vkIndexType);
+	vkCmdBindIndexBuffer(pCmd->pVkCmdBuf, pBuffer->pVkBuffer, util_get_pool_offset(pBuffer) + offset, vkIndexType);
 }
 
 void cmd_bind_vertex_buffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, const uint32_t* pStrides, const uint64_t* pOffsets)
@@ -4277,7 +4373,7 @@ void cmd_bind_vertex_buffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers,
 	for (uint32_t i = 0; i < cappedBufferCount; ++i)
 	{
 		buffers[i] = ppBuffers[i]->pVkBuffer;
-		offsets[i] = (pOffsets ? pOffsets[i] : 0);
+		offsets[i] = util_get_pool_offset(ppBuffers[i]) + (pOffsets ? pOffsets[i] : 0);
 	}
 
 	vkCmdBindVertexBuffers(pCmd->pVkCmdBuf, 0, cappedBufferCount, buffers, offsets);
@@ -4331,13 +4427,14 @@ void cmd_update_buffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* p
 	ASSERT(pSrcBuffer->pVkBuffer);
 	ASSERT(pBuffer);
 	ASSERT(pBuffer->pVkBuffer);
-	ASSERT(srcOffset + size <= pSrcBuffer->size);
-	ASSERT(dstOffset + size <= pBuffer->size);
 
 	SG_DECLARE_ZERO(VkBufferCopy, region);
-	region.srcOffset = srcOffset;
-	region.dstOffset = dstOffset;
+	region.srcOffset = util_get_pool_offset(pSrcBuffer) + srcOffset;
+	region.dstOffset = util_get_pool_offset(pBuffer) + dstOffset;
 	region.size = (VkDeviceSize)size;
+	// a pooled buffer shares its VkBuffer, the copy must stay inside its own range of it
+	ASSERT(region.srcOffset + size <= util_get_pool_offset(pSrcBuffer) + pSrcBuffer->size);
+	ASSERT(region.dstOffset + size <= util_get_pool_offset(pBuffer) + pBuffer->size);
 	vkCmdCopyBuffer(pCmd->pVkCmdBuf, pSrcBuffer->pVkBuffer, pBuffer->pVkBuffer, 1, &region);
 }
 
@@ -4587,13 +4684,26 @@ void queue_submit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 
 	auto* waitSemaphores = waitSemaphoreCount ? (VkSemaphore*)alloca(waitSemaphoreCount * sizeof(VkSemaphore)) : nullptr;
 	auto* waitMasks = (VkPipelineStageFlags*)alloca(waitSemaphoreCount * sizeof(VkPipelineStageFlags));
+	auto* waitValues = (uint64_t*)alloca(waitSemaphoreCount * sizeof(uint64_t));
 	uint32_t waitCount = 0;
+	bool timeline = false;
 	for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
 	{
-		if (ppWaitSemaphores[i]->signaled)
+		// timeline semaphores are always waited on, the value tells what for
+		if (ppWaitSemaphores[i]->timeline)
 		{
+			ASSERT(pDesc->pWaitValues);
 			waitSemaphores[waitCount] = ppWaitSemaphores[i]->pVkSemaphore;
 			waitMasks[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			waitValues[waitCount] = pDesc->pWaitValues[i];
+			++waitCount;
+			timeline = true;
+		}
+		else if (ppWaitSemaphores[i]->signaled)
+		{
+			waitSemaphores[waitCount] = ppWaitSemaphores[i]->pVkSemaphore;
+			waitMasks[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			waitValues[waitCount] = 0;
 			++waitCount;
 
 			ppWaitSemaphores[i]->signaled = false;
@@ -4601,12 +4711,23 @@ void queue_submit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 	}
 
 	VkSemaphore* signalSemaphores = signalSemaphoreCount ? (VkSemaphore*)alloca(signalSemaphoreCount * sizeof(VkSemaphore)) : nullptr;
+	auto* signalValues = (uint64_t*)alloca(signalSemaphoreCount * sizeof(uint64_t));
 	uint32_t signalCount = 0;
 	for (uint32_t i = 0; i < signalSemaphoreCount; ++i)
 	{
-		if (!ppSignalSemaphores[i]->signaled)
+		if (ppSignalSemaphores[i]->timeline)
 		{
+			ASSERT(pDesc->pSignalValues);
 			signalSemaphores[signalCount] = ppSignalSemaphores[i]->pVkSemaphore;
+			signalValues[signalCount] = pDesc->pSignalValues[i];
+			ppSignalSemaphores[i]->currentNodeIndex = pQueue->nodeIndex;
+			++signalCount;
+			timeline = true;
+		}
+		else if (!ppSignalSemaphores[i]->signaled)
+		{
+			signalSemaphores[signalCount] = ppSignalSemaphores[i]->pVkSemaphore;
+			signalValues[signalCount] = 0;
 			ppSignalSemaphores[i]->currentNodeIndex = pQueue->nodeIndex;
 			ppSignalSemaphores[signalCount]->signaled = true;
 			++signalCount;
@@ -4627,6 +4748,21 @@ void queue_submit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 	submitInfo.signalSemaphoreCount = signalCount;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
+#if defined(VK_VERSION_1_2)
+	// binary semaphores in the same submission take a dummy value
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO, nullptr };
+	if (timeline)
+	{
+		timelineSubmitInfo.waitSemaphoreValueCount = waitCount;
+		timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+		timelineSubmitInfo.signalSemaphoreValueCount = signalCount;
+		timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+		submitInfo.pNext = &timelineSubmitInfo;
+	}
+#else
+	ASSERT(!timeline);
+#endif
+
 	VkDeviceGroupSubmitInfo deviceGroupSubmitInfo = { VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO_KHR, nullptr };
 	if (pQueue->gpuMode == SG_GPU_MODE_LINKED)
 	{
@@ -4634,7 +4770,7 @@ void queue_submit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 		uint32_t* pSignalIndices = nullptr;
 		uint32_t* pWaitIndices = nullptr;
 
-		deviceGroupSubmitInfo.pNext = nullptr;
+		deviceGroupSubmitInfo.pNext = submitInfo.pNext;
 		deviceGroupSubmitInfo.commandBufferCount = submitInfo.commandBufferCount;
 		deviceGroupSubmitInfo.signalSemaphoreCount = submitInfo.signalSemaphoreCount;
 		deviceGroupSubmitInfo.waitSemaphoreCount = submitInfo.waitSemaphoreCount;
@@ -4880,6 +5016,67 @@ void remove_semaphore(Renderer* pRenderer, Semaphore* pSemaphore)
 	SG_SAFE_FREE(pSemaphore);
 }
 
+void add_timeline_semaphore(Renderer* pRenderer, uint64_t initialValue, Semaphore** ppSemaphore)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppSemaphore);
+	ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
+	ASSERT(pRenderer->timelineSemaphoreSupport);
+
+	auto* pSemaphore = (Semaphore*)sg_calloc(1, sizeof(Semaphore));
+	ASSERT(pSemaphore);
+
+#if defined(VK_VERSION_1_2)
+	SG_DECLARE_ZERO(VkSemaphoreTypeCreateInfo, typeCreateInfo);
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeCreateInfo.pNext = nullptr;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeCreateInfo.initialValue = initialValue;
+
+	SG_DECLARE_ZERO(VkSemaphoreCreateInfo, createInfo);
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	createInfo.pNext = &typeCreateInfo;
+	createInfo.flags = 0;
+	SG_CHECK_VKRESULT(vkCreateSemaphore(pRenderer->pVkDevice, &createInfo, nullptr, &(pSemaphore->pVkSemaphore)));
+#else
+	UNREF_PARAM(initialValue);
+#endif
+	pSemaphore->timeline = true;
+
+	*ppSemaphore = pSemaphore;
+}
+
+uint64_t get_semaphore_value(Renderer* pRenderer, Semaphore* pSemaphore)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSemaphore && pSemaphore->timeline);
+
+	uint64_t value = 0;
+#if defined(VK_VERSION_1_2)
+	SG_CHECK_VKRESULT(vkGetSemaphoreCounterValue(pRenderer->pVkDevice, pSemaphore->pVkSemaphore, &value));
+#endif
+	return value;
+}
+
+void wait_for_semaphore_value(Renderer* pRenderer, Semaphore* pSemaphore, uint64_t value)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSemaphore && pSemaphore->timeline);
+
+#if defined(VK_VERSION_1_2)
+	SG_DECLARE_ZERO(VkSemaphoreWaitInfo, waitInfo);
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &pSemaphore->pVkSemaphore;
+	waitInfo.pValues = &value;
+	SG_CHECK_VKRESULT(vkWaitSemaphores(pRenderer->pVkDevice, &waitInfo, UINT64_MAX));
+#else
+	UNREF_PARAM(value);
+#endif
+}
+
 #pragma endregion (Semaphore)
 
 #pragma region (Render Target)
@@ -5550,8 +5747,8 @@ void cmd_resource_barrier(Cmd* pCmd,
 		if (pBufferBarrier)
 		{
 			pBufferBarrier->buffer = pBuffer->pVkBuffer;
-			pBufferBarrier->size = VK_WHOLE_SIZE;
-			pBufferBarrier->offset = 0;
+			pBufferBarrier->size = pBuffer->pooled ? (VkDeviceSize)pBuffer->size : VK_WHOLE_SIZE;
+			pBufferBarrier->offset = util_get_pool_offset(pBuffer);
 
 			if (pTrans->acquire) // current queue to the dst queue
 			{
@@ -6383,6 +6580,8 @@ void cmd_resource_barrier(Cmd* pCmd,
 
 	void remove_root_signature(Renderer* pRenderer, RootSignature* pRootSignature)
 	{
+		util_forget_cached_pipelines(pRenderer, nullptr, pRootSignature);
+
 		for (uint32_t i = 0; i < SG_DESCRIPTOR_UPDATE_FREQ_COUNT; ++i)
 		{
 			vkDestroyDescriptorSetLayout(pRenderer->pVkDevice, pRootSignature->vkDescriptorSetLayouts[i], nullptr);
@@ -6705,7 +6904,7 @@ void cmd_resource_barrier(Cmd* pCmd,
 		*ppPipeline = pPipeline;
 	}
 
-	void add_pipeline(Renderer* pRenderer, const PipelineCreateDesc* pDesc, Pipeline** ppPipeline)
+	static void util_create_pipeline(Renderer* pRenderer, const PipelineCreateDesc* pDesc, Pipeline** ppPipeline)
 	{
 		switch (pDesc->type)
 		{
@@ -6742,7 +6941,7 @@ void cmd_resource_barrier(Cmd* pCmd,
 #endif
 	}
 
-	void remove_pipeline(Renderer* pRenderer, Pipeline* pPipeline)
+	static void util_destroy_pipeline(Renderer* pRenderer, Pipeline* pPipeline)
 	{
 		ASSERT(pRenderer);
 		ASSERT(pPipeline);
@@ -6757,6 +6956,588 @@ void cmd_resource_barrier(Cmd* pCmd,
 		SG_SAFE_FREE(pPipeline);
 	}
 
+	// pipeline state cache
+	// add_pipeline hands out the pipeline of an equal description instead of creating it again. The key is a hash of the
+	// description with every pointer replaced by what it points to, only the shader and the root signature are kept by address,
+	// remove_shader and remove_root_signature take the pipelines using them out of the map.
+
+	typedef struct PipelineStateCacheEntry
+	{
+		Hash128             key;
+		Renderer*           pRenderer;
+		/// The shared pipeline, null until an async creation is done (and after it if the creation failed)
+		Pipeline*           pPipeline;
+		/// Handles of the add_pipeline_async callers, linked through pNextShell. Each one binds the fallback of its caller
+		/// until the worker stores the pipeline in all of them, they never own a VkPipeline. Guarded by the cache mutex
+		Pipeline*           pShells;
+		/// add_pipeline calls minus remove_pipeline calls, guarded by the cache mutex
+		uint32_t            refCount;
+		/// Set until the worker stored the pipeline, cleared inside the cache mutex
+		sg_atomic32_t       pending;
+		/// False once a shader or root signature of the pipeline is removed, the entry is no longer in the map
+		bool                cached;
+		/// Copy of the description for the worker, the pointers of graphicsDesc point to the members below
+		PipelineCreateDesc  desc;
+		VertexLayout        vertexLayout;
+		BlendStateDesc      blendState;
+		DepthStateDesc      depthState;
+		RasterizerStateDesc rasterizerState;
+		TinyImageFormat     colorFormats[SG_MAX_RENDER_TARGET_ATTACHMENTS];
+		char                name[64];
+	} PipelineStateCacheEntry;
+
+	struct PipelineStateKeyHasher
+	{
+		size_t operator()(const Hash128& key) const { return (size_t)key.value[0]; }
+	};
+
+	typedef struct PipelineStateCache
+	{
+		eastl::unordered_map<Hash128, PipelineStateCacheEntry*, PipelineStateKeyHasher> entries;
+		Mutex                   mutex;
+		/// Workers of add_pipeline_async, started by the first async miss
+		ThreadSystem*           pThreadSystem;
+		/// Async pipelines not created yet
+		sg_atomic32_t           pendingCount;
+		PipelineStateCacheStats stats;
+		PipelineCreatedFunc     pCreatedFunc;
+		void*                   pCreatedUserData;
+	} PipelineStateCache;
+
+	/// Canonical words of a pipeline description: the fields the pipeline is made of, in a fixed order and without padding
+	typedef struct PipelineStateKeyWriter
+	{
+		uint64_t words[256];
+		uint32_t count;
+
+		void Add(uint64_t word)
+		{
+			ASSERT(count < sizeof(words) / sizeof(words[0]));
+			words[count++] = word;
+		}
+
+		void AddFloat(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			Add(bits);
+		}
+	} PipelineStateKeyWriter;
+
+	static bool util_is_pipeline_cacheable(const PipelineCreateDesc* pDesc)
+	{
+		return (SG_PIPELINE_TYPE_GRAPHICS == pDesc->type || SG_PIPELINE_TYPE_COMPUTE == pDesc->type) && 0 == pDesc->extensionCount;
+	}
+
+	/// pCache and name do not change the pipeline and are left out, a null state is hashed apart from any state since it means the default one
+	static Hash128 util_hash_pipeline_desc(const PipelineCreateDesc* pDesc)
+	{
+		PipelineStateKeyWriter writer;
+		writer.count = 0;
+		writer.Add(pDesc->type);
+
+		if (SG_PIPELINE_TYPE_COMPUTE == pDesc->type)
+		{
+			writer.Add((uint64_t)(uintptr_t)pDesc->computeDesc.pShaderProgram);
+			writer.Add((uint64_t)(uintptr_t)pDesc->computeDesc.pRootSignature);
+			return hash_128(writer.words, writer.count * sizeof(uint64_t));
+		}
+
+		const GraphicsPipelineDesc* pGraphics = &pDesc->graphicsDesc;
+		writer.Add((uint64_t)(uintptr_t)pGraphics->pShaderProgram);
+		writer.Add((uint64_t)(uintptr_t)pGraphics->pRootSignature);
+
+		// the semantic names only matter to the backends binding by name, vulkan binds by location
+		const VertexLayout* pVertexLayout = pGraphics->pVertexLayout;
+		writer.Add(pVertexLayout ? 1 + pVertexLayout->attribCount : 0);
+		for (uint32_t i = 0; pVertexLayout && i < pVertexLayout->attribCount && i < SG_MAX_VERTEX_ATTRIBS; ++i)
+		{
+			const VertexAttrib* pAttrib = &pVertexLayout->attribs[i];
+			writer.Add(pAttrib->format);
+			writer.Add(pAttrib->binding);
+			writer.Add(pAttrib->location);
+			writer.Add(pAttrib->offset);
+			writer.Add(pAttrib->rate);
+		}
+
+		const BlendStateDesc* pBlend = pGraphics->pBlendState;
+		writer.Add(pBlend != nullptr);
+		if (pBlend)
+		{
+			writer.Add(pBlend->renderTargetMask);
+			writer.Add(pBlend->alphaToCoverage);
+			writer.Add(pBlend->independentBlend);
+			// slot 0 is the blend function of every render target without independent blend
+			const uint32_t slotCount = pBlend->independentBlend ? SG_MAX_RENDER_TARGET_ATTACHMENTS : 1;
+			for (uint32_t i = 0; i < slotCount; ++i)
+			{
+				writer.Add(pBlend->srcFactors[i]);
+				writer.Add(pBlend->dstFactors[i]);
+				writer.Add(pBlend->srcAlphaFactors[i]);
+				writer.Add(pBlend->dstAlphaFactors[i]);
+				writer.Add(pBlend->blendModes[i]);
+				writer.Add(pBlend->blendAlphaModes[i]);
+				writer.Add(pBlend->masks[i]);
+			}
+		}
+
+		const DepthStateDesc* pDepth = pGraphics->pDepthState;
+		writer.Add(pDepth != nullptr);
+		if (pDepth)
+		{
+			writer.Add(pDepth->depthTest);
+			writer.Add(pDepth->depthWrite);
+			writer.Add(pDepth->depthFunc);
+			writer.Add(pDepth->stencilTest);
+			writer.Add(pDepth->stencilReadMask);
+			writer.Add(pDepth->stencilWriteMask);
+			writer.Add(pDepth->stencilFrontFunc);
+			writer.Add(pDepth->stencilFrontFail);
+			writer.Add(pDepth->depthFrontFail);
+			writer.Add(pDepth->stencilFrontPass);
+			writer.Add(pDepth->stencilBackFunc);
+			writer.Add(pDepth->stencilBackFail);
+			writer.Add(pDepth->depthBackFail);
+			writer.Add(pDepth->stencilBackPass);
+		}
+
+		const RasterizerStateDesc* pRasterizer = pGraphics->pRasterizerState;
+		writer.Add(pRasterizer != nullptr);
+		if (pRasterizer)
+		{
+			writer.Add(pRasterizer->cullMode);
+			writer.Add((uint32_t)pRasterizer->depthBias);
+			writer.AddFloat(pRasterizer->slopeScaledDepthBias);
+			writer.Add(pRasterizer->fillMode);
+			writer.Add(pRasterizer->multiSample);
+			writer.Add(pRasterizer->scissor);
+			writer.Add(pRasterizer->frontFace);
+			writer.Add(pRasterizer->depthClampEnable);
+		}
+
+		writer.Add(pGraphics->renderTargetCount);
+		for (uint32_t i = 0; i < pGraphics->renderTargetCount; ++i)
+			writer.Add(pGraphics->pColorFormats[i]);
+		writer.Add(pGraphics->sampleCount);
+		writer.Add(pGraphics->sampleQuality);
+		writer.Add(pGraphics->depthStencilFormat);
+		writer.Add(pGraphics->primitiveTopo);
+		writer.Add(pGraphics->supportIndirectCommandBuffer);
+
+		return hash_128(writer.words, writer.count * sizeof(uint64_t));
+	}
+
+	/// Copy the description and the states it points to into the entry
+	static void util_copy_pipeline_desc(const PipelineCreateDesc* pDesc, PipelineStateCacheEntry* pEntry)
+	{
+		pEntry->desc = *pDesc;
+		pEntry->desc.pPipelineExtensions = nullptr;
+		pEntry->desc.extensionCount = 0;
+		pEntry->desc.name = pEntry->name;
+
+		if (SG_PIPELINE_TYPE_GRAPHICS != pDesc->type)
+			return;
+
+		const GraphicsPipelineDesc* pSrc = &pDesc->graphicsDesc;
+		GraphicsPipelineDesc* pDst = &pEntry->desc.graphicsDesc;
+		if (pSrc->pVertexLayout)
+		{
+			pEntry->vertexLayout = *pSrc->pVertexLayout;
+			pDst->pVertexLayout = &pEntry->vertexLayout;
+		}
+		if (pSrc->pBlendState)
+		{
+			pEntry->blendState = *pSrc->pBlendState;
+			pDst->pBlendState = &pEntry->blendState;
+		}
+		if (pSrc->pDepthState)
+		{
+			pEntry->depthState = *pSrc->pDepthState;
+			pDst->pDepthState = &pEntry->depthState;
+		}
+		if (pSrc->pRasterizerState)
+		{
+			pEntry->rasterizerState = *pSrc->pRasterizerState;
+			pDst->pRasterizerState = &pEntry->rasterizerState;
+		}
+		ASSERT(pSrc->renderTargetCount <= SG_MAX_RENDER_TARGET_ATTACHMENTS);
+		if (pSrc->renderTargetCount)
+			memcpy(pEntry->colorFormats, pSrc->pColorFormats, pSrc->renderTargetCount * sizeof(TinyImageFormat));
+		pDst->pColorFormats = pEntry->colorFormats;
+	}
+
+	static PipelineStateCacheEntry* util_add_pipeline_state_entry(Renderer* pRenderer, const Hash128& key, const PipelineCreateDesc* pDesc)
+	{
+		PipelineStateCacheEntry* pEntry = (PipelineStateCacheEntry*)sg_calloc(1, sizeof(PipelineStateCacheEntry));
+		ASSERT(pEntry);
+		pEntry->key = key;
+		pEntry->pRenderer = pRenderer;
+		pEntry->refCount = 1;
+		pEntry->cached = true;
+		if (pDesc->name)
+			strncpy(pEntry->name, pDesc->name, sizeof(pEntry->name) - 1);
+		return pEntry;
+	}
+
+	/// Let the calling thread help the workers until the async creation of the entry is done
+	static void util_wait_pipeline_state_entry(PipelineStateCache* pCache, PipelineStateCacheEntry* pEntry)
+	{
+		while (sg_atomic32_load_acquire(&pEntry->pending))
+		{
+			if (!assist_thread_system(pCache->pThreadSystem))
+				Thread::sleep(0);
+		}
+	}
+
+	static void util_create_pipeline_task(uintptr_t index, void* pUserData)
+	{
+		UNREF_PARAM(index);
+		PipelineStateCacheEntry* pEntry = (PipelineStateCacheEntry*)pUserData;
+		PipelineStateCache* pCache = pEntry->pRenderer->pPipelineStateCache;
+
+		Pipeline* pCreated = nullptr;
+		util_create_pipeline(pEntry->pRenderer, &pEntry->desc, &pCreated);
+		if (pCreated && VK_NULL_HANDLE == pCreated->pVkPipeline)
+			SG_SAFE_FREE(pCreated);
+
+		{
+			// the shells keep binding their fallback if the creation failed
+			MutexLock lock(pCache->mutex);
+			pEntry->pPipeline = pCreated;
+			for (Pipeline* pShell = pEntry->pShells; pShell && pCreated; pShell = pShell->pNextShell)
+				sg_atomic64_store_release((sg_atomic64_t*)&pShell->pVkPipeline, (uint64_t)pCreated->pVkPipeline);
+			sg_atomic32_store_release(&pEntry->pending, 0);
+		}
+		sg_atomic32_add_relaxed(&pCache->pendingCount, -1);
+	}
+
+	static void util_release_pipeline_state_entry(PipelineStateCache* pCache, PipelineStateCacheEntry* pEntry)
+	{
+		util_wait_pipeline_state_entry(pCache, pEntry);
+
+		if (pEntry->pPipeline)
+			util_destroy_pipeline(pEntry->pRenderer, pEntry->pPipeline);
+		while (Pipeline* pShell = pEntry->pShells)
+		{
+			pEntry->pShells = pShell->pNextShell;
+			SG_SAFE_FREE(pShell);
+		}
+		SG_SAFE_FREE(pEntry);
+	}
+
+	/// Drop a reference of the entry and release it with the last one
+	static void util_unref_pipeline_state_entry(PipelineStateCache* pCache, PipelineStateCacheEntry* pEntry)
+	{
+		{
+			MutexLock lock(pCache->mutex);
+			ASSERT(pEntry->refCount > 0);
+			if (--pEntry->refCount > 0)
+				return;
+			if (pEntry->cached)
+				pCache->entries.erase(pEntry->key);
+		}
+		util_release_pipeline_state_entry(pCache, pEntry);
+	}
+
+	/// The shared pipeline of the entry once its creation is done, a failed async creation drops the reference of the caller
+	static Pipeline* util_get_shared_pipeline(PipelineStateCache* pCache, PipelineStateCacheEntry* pEntry)
+	{
+		util_wait_pipeline_state_entry(pCache, pEntry);
+		Pipeline* pPipeline = pEntry->pPipeline;
+		if (!pPipeline)
+			util_unref_pipeline_state_entry(pCache, pEntry);
+		return pPipeline;
+	}
+
+	static void add_pipeline_state_cache(PipelineStateCache** ppCache)
+	{
+		PipelineStateCache* pCache = sg_new(PipelineStateCache);
+		pCache->mutex.Init();
+		pCache->pThreadSystem = nullptr;
+		pCache->pendingCount = 0;
+		pCache->stats = {};
+		pCache->pCreatedFunc = nullptr;
+		pCache->pCreatedUserData = nullptr;
+		*ppCache = pCache;
+	}
+
+	static void remove_pipeline_state_cache(PipelineStateCache* pCache)
+	{
+		if (pCache->pThreadSystem)
+		{
+			wait_thread_system_idle(pCache->pThreadSystem);
+			exit_thread_system(pCache->pThreadSystem);
+		}
+
+		if (!pCache->entries.empty())
+			SG_LOG_WARNING("%u pipelines were not removed before the renderer", (uint32_t)pCache->entries.size());
+		for (auto& it : pCache->entries)
+			util_release_pipeline_state_entry(pCache, it.second);
+		pCache->entries.clear();
+
+		pCache->mutex.Destroy();
+		sg_delete(pCache);
+	}
+
+	static void util_forget_cached_pipelines(Renderer* pRenderer, const Shader* pShaderProgram, const RootSignature* pRootSignature)
+	{
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		if (!pCache)
+			return;
+
+		bool waitForWorkers = false;
+		{
+			MutexLock lock(pCache->mutex);
+			for (auto it = pCache->entries.begin(); it != pCache->entries.end();)
+			{
+				PipelineStateCacheEntry* pEntry = it->second;
+				const bool compute = SG_PIPELINE_TYPE_COMPUTE == pEntry->desc.type;
+				const Shader* pEntryShader = compute ? pEntry->desc.computeDesc.pShaderProgram : pEntry->desc.graphicsDesc.pShaderProgram;
+				const RootSignature* pEntryRootSignature = compute ? pEntry->desc.computeDesc.pRootSignature : pEntry->desc.graphicsDesc.pRootSignature;
+				if ((pShaderProgram && pEntryShader == pShaderProgram) || (pRootSignature && pEntryRootSignature == pRootSignature))
+				{
+					waitForWorkers |= sg_atomic32_load_acquire(&pEntry->pending) != 0;
+					pEntry->cached = false;
+					it = pCache->entries.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		// the workers may still be reading the shader or the root signature
+		if (waitForWorkers)
+			wait_thread_system_idle(pCache->pThreadSystem);
+	}
+
+	/// Return the entry of the description with one more reference, or insert a new one with pNewEntry when it is not null
+	static PipelineStateCacheEntry* util_find_pipeline_state_entry(PipelineStateCache* pCache, const Hash128& key, PipelineStateCacheEntry* pNewEntry)
+	{
+		MutexLock lock(pCache->mutex);
+		auto it = pCache->entries.find(key);
+		if (it != pCache->entries.end())
+		{
+			++it->second->refCount;
+			++pCache->stats.hitCount;
+			return it->second;
+		}
+		if (pNewEntry)
+			pCache->entries.insert(eastl::make_pair(key, pNewEntry));
+		return pNewEntry;
+	}
+
+	static void util_notify_pipeline_created(PipelineStateCache* pCache, const PipelineCreateDesc* pDesc)
+	{
+		PipelineCreatedFunc pFunc = nullptr;
+		void* pUserData = nullptr;
+		{
+			MutexLock lock(pCache->mutex);
+			pFunc = pCache->pCreatedFunc;
+			pUserData = pCache->pCreatedUserData;
+		}
+		if (pFunc)
+			pFunc(pDesc, pUserData);
+	}
+
+	void add_pipeline(Renderer* pRenderer, const PipelineCreateDesc* pDesc, Pipeline** ppPipeline)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(ppPipeline);
+
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		if (!util_is_pipeline_cacheable(pDesc))
+		{
+			util_create_pipeline(pRenderer, pDesc, ppPipeline);
+			return;
+		}
+
+		const Hash128 key = util_hash_pipeline_desc(pDesc);
+		PipelineStateCacheEntry* pEntry = util_find_pipeline_state_entry(pCache, key, nullptr);
+		if (pEntry)
+		{
+			// the caller needs a pipeline it can bind
+			*ppPipeline = util_get_shared_pipeline(pCache, pEntry);
+			return;
+		}
+
+		// create outside of the lock, other threads keep looking up and creating pipelines meanwhile
+		Timer timer;
+		timer.Reset();
+		Pipeline* pPipeline = nullptr;
+		util_create_pipeline(pRenderer, pDesc, &pPipeline);
+		timer.Tick();
+		if (!pPipeline)
+		{
+			*ppPipeline = nullptr;
+			return;
+		}
+
+		PipelineStateCacheEntry* pNewEntry = util_add_pipeline_state_entry(pRenderer, key, pDesc);
+		util_copy_pipeline_desc(pDesc, pNewEntry);
+		pNewEntry->pPipeline = pPipeline;
+		pPipeline->pCacheEntry = pNewEntry;
+
+		pEntry = util_find_pipeline_state_entry(pCache, key, pNewEntry);
+		if (pEntry != pNewEntry)
+		{
+			// another thread created the same pipeline first
+			util_release_pipeline_state_entry(pCache, pNewEntry);
+			*ppPipeline = util_get_shared_pipeline(pCache, pEntry);
+			return;
+		}
+
+		{
+			MutexLock lock(pCache->mutex);
+			PipelineStateCacheStats& stats = pCache->stats;
+			++stats.missCount;
+			stats.missTime += timer.GetTotalTime();
+			if (timer.GetTotalTime() > stats.slowestMissTime)
+			{
+				stats.slowestMissTime = timer.GetTotalTime();
+				strncpy(stats.slowestMissName, pNewEntry->name, sizeof(stats.slowestMissName) - 1);
+				stats.slowestMissName[sizeof(stats.slowestMissName) - 1] = '\0';
+			}
+		}
+		util_notify_pipeline_created(pCache, pDesc);
+		*ppPipeline = pPipeline;
+	}
+
+	void add_pipeline_async(Renderer* pRenderer, const PipelineCreateDesc* pDesc, Pipeline* pFallback, Pipeline** ppPipeline)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pDesc);
+		ASSERT(ppPipeline);
+		ASSERT(!pFallback || pFallback->type == pDesc->type);
+
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		if (!util_is_pipeline_cacheable(pDesc))
+		{
+			util_create_pipeline(pRenderer, pDesc, ppPipeline);
+			return;
+		}
+
+		const Hash128 key = util_hash_pipeline_desc(pDesc);
+		PipelineStateCacheEntry* pNewEntry = util_add_pipeline_state_entry(pRenderer, key, pDesc);
+		util_copy_pipeline_desc(pDesc, pNewEntry);
+		pNewEntry->pending = 1;
+
+		// the shell is what the caller binds, it binds the fallback of this caller until the worker is done
+		Pipeline* pShell = (Pipeline*)sg_calloc_memalign(1, alignof(Pipeline), sizeof(Pipeline));
+		ASSERT(pShell);
+		pShell->type = pDesc->type;
+		pShell->pVkPipeline = pFallback ? pFallback->pVkPipeline : VK_NULL_HANDLE;
+
+		PipelineStateCacheEntry* pEntry = nullptr;
+		Pipeline* pShared = nullptr;
+		{
+			MutexLock lock(pCache->mutex);
+			auto it = pCache->entries.find(key);
+			pEntry = it != pCache->entries.end() ? it->second : pNewEntry;
+			if (pEntry != pNewEntry)
+			{
+				++pEntry->refCount;
+				++pCache->stats.hitCount;
+				pShared = pEntry->pPipeline;
+			}
+			else
+			{
+				pCache->entries.insert(eastl::make_pair(key, pNewEntry));
+				++pCache->stats.asyncMissCount;
+				// the decode workers of the resource loader run next to these, so the pool takes half of the cores
+				if (!pCache->pThreadSystem)
+					init_thread_system(&pCache->pThreadSystem, eastl::max(1U, Thread::get_num_CPU_cores() / 2), 0, true, "PipelineCreate");
+			}
+
+			// a creation still in flight (or failed) hands out a shell of this caller, a finished one the shared pipeline
+			if (!pShared)
+			{
+				pShell->pCacheEntry = pEntry;
+				pShell->pNextShell = pEntry->pShells;
+				pEntry->pShells = pShell;
+			}
+		}
+
+		if (pEntry != pNewEntry)
+		{
+			SG_SAFE_FREE(pNewEntry);
+			if (pShared)
+				SG_SAFE_FREE(pShell);
+			*ppPipeline = pShared ? pShared : pShell;
+			return;
+		}
+
+		// the task queue of the thread system is bounded, help out rather than overflow it
+		while (sg_atomic32_load_acquire(&pCache->pendingCount) >= SG_MAX_THREAD_TASK / 2)
+		{
+			if (!assist_thread_system(pCache->pThreadSystem))
+				Thread::sleep(0);
+		}
+		sg_atomic32_add_relaxed(&pCache->pendingCount, 1);
+		add_thread_system_task(pCache->pThreadSystem, util_create_pipeline_task, pNewEntry);
+		util_notify_pipeline_created(pCache, pDesc);
+		*ppPipeline = pShell;
+	}
+
+	bool is_pipeline_ready(Pipeline* pPipeline)
+	{
+		ASSERT(pPipeline);
+		return !pPipeline->pCacheEntry || !sg_atomic32_load_acquire(&pPipeline->pCacheEntry->pending);
+	}
+
+	void remove_pipeline(Renderer* pRenderer, Pipeline* pPipeline)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pPipeline);
+
+		PipelineStateCacheEntry* pEntry = pPipeline->pCacheEntry;
+		if (!pEntry)
+		{
+			util_destroy_pipeline(pRenderer, pPipeline);
+			return;
+		}
+
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		{
+			// a shell of add_pipeline_async, the worker no longer writes to it once it is unlinked
+			MutexLock lock(pCache->mutex);
+			if (pPipeline != pEntry->pPipeline)
+			{
+				Pipeline** ppLink = &pEntry->pShells;
+				while (*ppLink && *ppLink != pPipeline)
+					ppLink = &(*ppLink)->pNextShell;
+				ASSERT(*ppLink);
+				*ppLink = pPipeline->pNextShell;
+				SG_SAFE_FREE(pPipeline);
+			}
+		}
+		util_unref_pipeline_state_entry(pCache, pEntry);
+	}
+
+	void get_pipeline_state_cache_stats(Renderer* pRenderer, PipelineStateCacheStats* pStats)
+	{
+		ASSERT(pRenderer);
+		ASSERT(pStats);
+
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		MutexLock lock(pCache->mutex);
+		*pStats = pCache->stats;
+		pStats->pendingCount = sg_atomic32_load_acquire(&pCache->pendingCount);
+		pStats->pipelineCount = (uint32_t)pCache->entries.size();
+	}
+
+	void set_pipeline_created_callback(Renderer* pRenderer, PipelineCreatedFunc pFunc, void* pUserData)
+	{
+		ASSERT(pRenderer);
+
+		PipelineStateCache* pCache = pRenderer->pPipelineStateCache;
+		MutexLock lock(pCache->mutex);
+		pCache->pCreatedFunc = pFunc;
+		pCache->pCreatedUserData = pUserData;
+	}
+
 	void add_pipeline_cache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache)
 	{
 		ASSERT(pRenderer);
@@ -6827,6 +7608,9 @@ void cmd_resource_barrier(Cmd* pCmd,
 		pQueue->flags = queueProps.queueFlags;
 		pQueue->pSubmitMutex = &pRenderer->pNullDescriptors->mSubmitMutex;
 
+		// the family the ownership transfer barriers (BufferBarrier::acquire / release) of this queue type refer to
+		pRenderer->queueFamilyIndices[pDesc->type] = queueFamilyIndex;
+
 		// Get queue handle
 		vkGetDeviceQueue(pRenderer->pVkDevice, pQueue->vkQueueFamilyIndex, pQueue->vkQueueIndex, &pQueue->pVkQueue);
 		ASSERT(VK_NULL_HANDLE != pQueue->pVkQueue);
@@ -6993,6 +7777,25 @@ void cmd_resource_barrier(Cmd* pCmd,
 			vmaCreateAllocator(&createInfo, &pRenderer->vmaAllocator);
 
 			SG_LOG_INFO("VmaAllocator initialized successfully!");
+
+			// Without resizable BAR a discrete GPU only exposes a 256MB window of its memory to the CPU, too small to put buffers in
+			const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+			vmaGetMemoryProperties(pRenderer->vmaAllocator, &pMemoryProperties);
+			const VkMemoryPropertyFlags hostVisibleDeviceFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			pRenderer->hostVisibleDeviceMemory = 0;
+			for (uint32_t i = 0; i < pMemoryProperties->memoryTypeCount; ++i)
+			{
+				const VkMemoryType& memoryType = pMemoryProperties->memoryTypes[i];
+				if ((memoryType.propertyFlags & hostVisibleDeviceFlags) == hostVisibleDeviceFlags &&
+					pMemoryProperties->memoryHeaps[memoryType.heapIndex].size > 256ull * 1024 * 1024)
+				{
+					pRenderer->hostVisibleDeviceMemory = 1;
+					pRenderer->hostVisibleDeviceMemoryType = i;
+					SG_LOG_INFO("Found host visible device local memory (heap of %llu MB), buffers can be written in place",
+						(unsigned long long)(pMemoryProperties->memoryHeaps[memoryType.heapIndex].size >> 20));
+					break;
+				}
+			}
 		}
 
 		VkDescriptorPoolSize descriptorPoolSizes[SG_DESCRIPTOR_TYPE_RANGE_SIZE] =
@@ -7019,6 +7822,8 @@ void cmd_resource_barrier(Cmd* pCmd,
 		add_descriptor_pool(pRenderer, 8192, (VkDescriptorPoolCreateFlags)0, descriptorPoolSizes,
 			gDescriptorTypeRangeSize, &(pRenderer->pDescriptorPool));
 
+		add_pipeline_state_cache(&pRenderer->pPipelineStateCache);
+
 		pRenderPassMutex = (Mutex*)sg_calloc(1, sizeof(Mutex));
 		pRenderPassMutex->Init();
 		gRenderPassMap = sg_placement_new<eastl::hash_map<ThreadID, RenderPassMap> >(sg_malloc(sizeof(*gRenderPassMap)));
@@ -7065,6 +7870,7 @@ void cmd_resource_barrier(Cmd* pCmd,
 
 		remove_default_resources(pRenderer);
 		remove_descriptor_pool(pRenderer, pRenderer->pDescriptorPool);
+		remove_pipeline_state_cache(pRenderer->pPipelineStateCache);
 
 		// Remove the render passes
 		for (eastl::hash_map<ThreadID, RenderPassMap>::value_type& t : *gRenderPassMap)
@@ -7199,7 +8005,7 @@ void cmd_resource_barrier(Cmd* pCmd,
 #else
 		flags |= VK_QUERY_RESULT_WAIT_BIT;
 #endif
-		vkCmdCopyQueryPoolResults(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount, pReadbackBuffer->pVkBuffer, 0, sizeof(uint64_t), flags);
+		vkCmdCopyQueryPoolResults(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount, pReadbackBuffer->pVkBuffer, util_get_pool_offset(pReadbackBuffer), sizeof(uint64_t), flags);
 	}
 
 #pragma endregion (GPU Query)
@@ -12,8 +12,11 @@
 
 #include "Interface/ILog.h"
 #include "Interface/IThread.h"
+#include "Interface/ITime.h"
+#include "ThreadSystem/ThreadSystem.h"
 
 #include <include/EASTL/algorithm.h>
+#include <include/EASTL/sort.h>
 #include <include/EASTL/unordered_map.h>
 
 //#if defined(__ANDROID__) && defined(SG_GRAPHIC_API_VULKAN)
@@ -25,15 +28,28 @@
 //#endif
 
 #include "Math/MathTypes.h"
+#include "Math/VertexPacking.h"
+#include "Math/MeshOptimization.h"
+#include "Memory/RangeAllocator.h"
 
 #include "IRenderer.h"
 #include "IResourceLoader.h"
 
 #include "Core/Atomic.h"
+#include "Core/Hash.h"
 #include "TextureSystem/TextureContainer.h"
 
 #include "Interface/IMemory.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define SG_RESOURCE_LOADER_SSE2
+	#include <emmintrin.h>
+#endif
+
+#if defined(SG_GRAPHIC_API_VULKAN) && !defined(SG_PLATFORM_WINDOWS) && !defined(__ANDROID__)
+	#include <dlfcn.h>
+#endif
+
 //#ifdef NX64
 //#include "../ThirdParty/OpenSource/murmurhash3/MurmurHash3_32.h"
 //#endif
@@ -59,11 +75,15 @@ namespace SG
 enum
 {
 	MAPPED_RANGE_FLAG_UNMAP_BUFFER = (1 << 0),
-	MAPPED_RANGE_FLAG_TEMP_BUFFER = (1 << 1),
+	/// range was handed out of the staging ring and is released once its copy is recorded
+	MAPPED_RANGE_FLAG_STAGING_RING = (1 << 1),
+	/// range is the persistent mapping of a buffer in host visible device memory, the data is written in place and never copied
+	MAPPED_RANGE_FLAG_DIRECT_WRITE = (1 << 2),
 };
 
 static inline uint32_t round_up(uint32_t value, uint32_t multiple) { return ((value + multiple - 1) / multiple) * multiple; }
 static inline uint32_t round_down(uint32_t value, uint32_t multiple) { return value - value % multiple; }
+static inline uint64_t round_up_64(uint64_t value, uint64_t multiple) { return ((value + multiple - 1) / multiple) * multiple; }
 
 namespace SG
 {
@@ -74,6 +94,12 @@ namespace SG
 	extern void add_texture(Renderer* pRenderer, const TextureCreateDesc* pDesc, Texture** ppTexture);
 	extern void remove_texture(Renderer* pRenderer, Texture* pTexture);
 
+#if defined(SG_GRAPHIC_API_VULKAN)
+	extern void util_find_queue_family_index(const Renderer* pRenderer, uint32_t nodeIndex, QueueType queueType,
+		VkQueueFamilyProperties* pOutProps, uint8_t* pOutFamilyIndex, uint8_t* pOutQueueIndex);
+	extern void vk_create_shader_reflection(const uint8_t* shaderCode, uint32_t shaderSize, ShaderStage shaderStage, ShaderReflection* pOutReflection);
+#endif
+
 	//extern void add_virtual_texture(Cmd* pCmd, const TextureCreateDesc* pDesc, Texture** ppTexture, void* pImageData);
 
 	extern void map_buffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
@@ -95,6 +121,16 @@ namespace SG
 #endif
 
 #define MAX_FRAMES 3U
+// visible and prefetch loads a batch takes for every decode worker
+#define SG_STREAMING_LOADS_PER_WORKER 2U
+// workers running the SG_LOAD_CALLBACK_DISPATCH_WORKER callbacks
+#define SG_LOAD_CALLBACK_THREAD_COUNT 2U
+// loader batches after which the staging ring gives back the chunks it did not need
+#define SG_STAGING_RING_SHRINK_INTERVAL 64U
+// staging ring size (relative to its initial size) above which every growth is reported
+#define SG_STAGING_RING_MAX_GROWTH 8U
+// milliseconds the idle loader thread sleeps between polls of the copies still in flight
+#define SG_COPY_ENGINE_POLL_INTERVAL 1U
 
 //struct VertexTemp
 //{
@@ -260,95 +296,6 @@ namespace SG
 	//	}
 	//}
 
-	#define F16_EXPONENT_BITS 0x1F
-	#define F16_EXPONENT_SHIFT 10
-	#define F16_EXPONENT_BIAS 15
-	#define F16_MANTISSA_BITS 0x3ff
-	#define F16_MANTISSA_SHIFT (23 - F16_EXPONENT_SHIFT)
-	#define F16_MAX_EXPONENT (F16_EXPONENT_BITS << F16_EXPONENT_SHIFT)
-
-	static inline uint16_t util_float_to_half(float val)
-	{
-		uint32_t f32 = (*(uint32_t*)&val);
-		uint16_t f16 = 0;
-		/* Decode IEEE 754 little-endian 32-bit floating-point value */
-		int sign = (f32 >> 16) & 0x8000;
-		/* Map exponent to the range [-127,128] */
-		int exponent = ((f32 >> 23) & 0xff) - 127;
-		int mantissa = f32 & 0x007fffff;
-		if (exponent == 128)
-		{ /* Infinity or NaN */
-			f16 = (uint16_t)(sign | F16_MAX_EXPONENT);
-			if (mantissa)
-				f16 |= (mantissa & F16_MANTISSA_BITS);
-		}
-		else if (exponent > 15)
-		{ /* Overflow - flush to Infinity */
-			f16 = (unsigned short)(sign | F16_MAX_EXPONENT);
-		}
-		else if (exponent > -15)
-		{ /* Representable value */
-			exponent += F16_EXPONENT_BIAS;
-			mantissa >>= F16_MANTISSA_SHIFT;
-			f16 = (unsigned short)(sign | exponent << F16_EXPONENT_SHIFT | mantissa);
-		}
-		else
-		{
-			f16 = (unsigned short)sign;
-		}
-		return f16;
-	}
-
-	static inline void util_pack_float2_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-	{
-		struct f2 { float x; float y; };
-		f2* f = (f2*)src;
-		for (uint32_t e = 0; e < count; ++e)
-		{
-			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = (
-				(util_float_to_half(f[e].x) & 0x0000FFFF) | ((util_float_to_half(f[e].y) << 16) & 0xFFFF0000));
-		}
-	}
-
-	static inline uint32_t util_float2_to_unorm2x16(const float* v)
-	{
-		uint32_t x = (uint32_t)round(eastl::clamp(v[0], 0.0f, 1.0f) * 65535.0f);
-		uint32_t y = (uint32_t)round(eastl::clamp(v[1], 0.0f, 1.0f) * 65535.0f);
-		return ((uint32_t)0x0000FFFF & x) | ((y << 16) & (uint32_t)0xFFFF0000);
-	}
-
-	#define OCT_WRAP(v, w) ((1.0f - abs((w))) * ((v) >= 0.0f ? 1.0f : -1.0f))
-
-	static inline void util_pack_float3_direction_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-	{
-		struct f3 { float x; float y; float z; };
-		for (uint32_t e = 0; e < count; ++e)
-		{
-			f3 f = *(f3*)(src + e * stride);
-			float absLength = (abs(f.x) + abs(f.y) + abs(f.z));
-			f3 enc = {};
-			if (absLength)
-			{
-				enc.x = f.x / absLength;
-				enc.y = f.y / absLength;
-				enc.z = f.z / absLength;
-				if (enc.z < 0)
-				{
-					float oldX = enc.x;
-					enc.x = OCT_WRAP(enc.x, enc.y);
-					enc.y = OCT_WRAP(enc.y, oldX);
-				}
-				enc.x = enc.x * 0.5f + 0.5f;
-				enc.y = enc.y * 0.5f + 0.5f;
-				*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = util_float2_to_unorm2x16(&enc.x);
-			}
-			else
-			{
-				*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = 0;
-			}
-		}
-	}
-
 	// Internal Structures
 	typedef void(*PreMipStepFunc)(FileStream* pStream, uint32_t mip);
 
@@ -363,6 +310,11 @@ namespace SG
 		uint32_t          layerCount;
 		PreMipStepFunc    preMipFunc;
 		bool              mipsAfterSlice;
+		/// largest mips of the file that are not part of the texture (streamed textures), they are skipped in the stream
+		uint32_t          skipMipLevels;
+		uint32_t          fileWidth;
+		uint32_t          fileHeight;
+		uint32_t          fileDepth;
 	} TextureUpdateDescInternal;
 
 	typedef struct CopyResourceSet
@@ -372,23 +324,71 @@ namespace SG
 	#endif
 		Cmd* pCmd;
 		CmdPool* pCmdPool;
-		Buffer* pBuffer;
-		uint64_t allocatedSpace;
-
-		/// Buffers created in case we ran out of space in the original staging buffer
-		/// Will be cleaned up after the fence for this set is complete
-		eastl::vector<Buffer*> tempBuffers;
+		/// value the last submission of this set signals on the timeline semaphore of its copy engine
+		uint64_t timelineValue;
+		/// staging ring batch recorded into this set
+		uint64_t batch;
+		/// the set was submitted and the copy queue may still be executing it
+		bool     submitted;
+		/// resources the batch of this set hands over to the graphics queue family, the release barriers are recorded
+		/// right before the batch is submitted and turn into the acquires the graphics queue has to record
+		eastl::vector<BufferBarrier>  bufferReleases;
+		eastl::vector<TextureBarrier> textureReleases;
 	} CopyResourceSet;
 
+	typedef struct StagingChunk
+	{
+		Buffer*  pBuffer;
+		/// linear allocation offset into the chunk
+		uint64_t allocatedSpace;
+		/// last loader batch recording copies out of this chunk, the chunk can be reused once that batch retired
+		uint64_t lastBatch;
+		/// ranges handed out by begin_update_resource whose copies are not recorded yet
+		uint32_t pendingCount;
+	} StagingChunk;
+
+	/// Ring of persistently mapped staging chunks.
+	/// Allocations move linearly through the current chunk and wrap around to the next retired chunk when it is full.
+	/// The ring grows when every chunk is still in flight and every SG_STAGING_RING_SHRINK_INTERVAL batches
+	/// gives back the idle chunks above the high-water mark of that interval.
+	typedef struct StagingRing
+	{
+		Mutex                       mutex;
+		eastl::vector<StagingChunk> chunks;
+		uint32_t                    currentChunk;
+		uint32_t                    minChunkCount;
+		uint64_t                    chunkSize;
+		uint64_t                    totalSize;
+		/// loader batch being recorded and last batch whose copies are known to be complete
+		uint64_t                    currentBatch;
+		uint64_t                    completedBatch;
+		/// most chunks in flight at once since the last shrink
+		uint32_t                    highWaterMark;
+	} StagingRing;
+
 	// Synchronization? (i think we need a asynchronization loading system)
 	// CopyEngine is just a transqueue with some extra data
 	typedef struct CopyEngine
 	{
 		Queue* pQueue;
-		CopyResourceSet* resourceSets;
+		/// grows when every set is still in flight, the loader thread never waits for the copy queue
+		eastl::vector<CopyResourceSet> resourceSets;
+		StagingRing      stagingRing;
 		uint64_t         bufferSize;
-		uint32_t         bufferCount;
 		bool             isRecording;
+		/// signaled with an increasing value by every submission when the renderer has timeline semaphores,
+		/// the sets are waited on through it instead of their fences and graphics submissions can wait on it directly
+		Semaphore*       pTimelineSemaphore;
+		uint64_t         timelineValue;
+		/// the copy queue is of another family than the graphics queue (a dedicated transfer queue) and
+		/// ResourceLoaderDesc::queueOwnershipTransfer is set, everything it uploads is released to the graphics family
+		bool             ownershipTransfer;
+		/// guards the acquires below, they are handed out by cmd_acquire_loaded_resources
+		Mutex                         acquireMutex;
+		eastl::vector<BufferBarrier>  bufferAcquires;
+		eastl::vector<TextureBarrier> textureAcquires;
+		/// timeline value of the last submission, the graphics queue waits for it before it uses what was uploaded
+		uint64_t                      acquireValue;
 	} CopyEngine;
 
 	typedef enum UpdateRequestType
@@ -409,6 +409,51 @@ namespace SG
 		SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST
 	} UploadFunctionResult;
 
+	/// A texture loaded with TextureLoadDesc::minResidentMips.
+	/// The user's Texture holds the resident chain, a larger or smaller chain is loaded into pPendingTexture
+	/// and swapped into the user's Texture by update_texture_streaming once its token completed.
+	typedef struct StreamedTexture
+	{
+		Texture*             pTexture;
+		Texture*             pPendingTexture;
+		SyncToken            pendingToken;
+		char                 fileName[SG_MAX_FILEPATH];
+		TextureContainerType container;
+		TextureCreationFlags creationFlag;
+		uint32_t             nodeIndex;
+		uint32_t             minResidentMips;
+		/// header of the file, filled by the decode stage of the first load
+		uint32_t             width;
+		uint32_t             height;
+		uint32_t             depth;
+		uint32_t             arraySize;
+		uint32_t             mipLevels;
+		uint32_t             format;
+		/// first mip of the file in pTexture, UINT32_MAX until the first load completed
+		uint32_t             residentMip;
+		/// first mip of the file in the chain being loaded, UINT32_MAX for the first load (the decode stage picks the tail)
+		uint32_t             pendingMip;
+		uint64_t             residentSize;
+		float                screenSize;
+		/// a mip load failed, the texture keeps what it has
+		bool                 failed;
+	} StreamedTexture;
+
+	/// A texture or geometry shared through the resource cache (ResourceLoaderDesc::enableResourceCache)
+	typedef struct CachedResource
+	{
+		/// normalized path and load parameters
+		eastl::string        key;
+		/// Texture* or Geometry*, null until the load is recorded
+		void*                pResource;
+		/// token of the load, the resource is ready once it completed
+		SyncToken            token;
+		/// add_resource calls which returned the resource and were not removed yet
+		uint32_t             refCount;
+		/// ppTexture / ppGeometry of the add_resource calls which joined the load while it was in flight
+		eastl::vector<void**> waiters;
+	} CachedResource;
+
 	// abstraction of any kind of update event happened in the resource
 	struct UpdateRequest
 	{
@@ -421,7 +466,12 @@ namespace SG
 
 		UpdateRequestType type = SG_UPDATE_REQUEST_INVALID;
 		uint64_t waitIndex = 0;
+		/// staging chunk of a range handed out by begin_update_resource, released back to the ring when the copy is recorded
 		Buffer* pUploadBuffer = nullptr;
+		/// streaming record of a texture load with TextureLoadDesc::minResidentMips
+		StreamedTexture* pStreamedTexture = nullptr;
+		/// cache entry of a texture or geometry load which other add_resource calls may join
+		CachedResource* pCachedResource = nullptr;
 		union
 		{
 			BufferUpdateDesc          bufferUpdateDesc;
@@ -433,6 +483,129 @@ namespace SG
 		};
 	};
 
+	typedef void(*PackingFunction)(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+
+	/// CPU side state of a texture load, carried between the load stages
+	typedef struct TextureLoadState
+	{
+		TextureCreateDesc         textureDesc;
+		TextureUpdateDescInternal updateDesc;
+		TextureContainerType      container;
+		char                      fileName[SG_MAX_FILEPATH];
+		StreamedTexture*          pStreamed;
+		/// the file only has the first mip, the others are filtered from it after it was read (SG_MIP_FILTER_NONE otherwise)
+		MipFilter                 mipFilter;
+		MipGenerationFlags        mipFlags;
+		/// header was parsed by the decode stage, texels go through the staging memory
+		bool                      decoded;
+	} TextureLoadState;
+
+	#define SG_COOKED_GEOMETRY_MAGIC 0x534D4753 // "SGMS"
+	#define SG_COOKED_GEOMETRY_VERSION 3
+	#define SG_COOKED_GEOMETRY_EXTENSION "sgmesh"
+	/// Every section of a cooked geometry starts at this alignment, so it can be read (or mapped) straight into staging memory
+	#define SG_COOKED_GEOMETRY_ALIGNMENT 256
+
+	/// Header of a cooked geometry (.sgmesh), followed by the sections at the offsets it lists.
+	/// The index and vertex sections hold the final GPU streams for the vertex layout the geometry was cooked with
+	typedef struct CookedGeometryHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		/// Hash of the vertex layout and the optimization flags the streams were cooked with
+		uint64_t layoutHash;
+		uint32_t drawCount;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		uint32_t jointCount;
+		uint32_t indexStride;
+		uint32_t vertexBufferCount;
+		uint32_t hairVertexCountPerStrand;
+		uint32_t hairGuideCountPerStrand;
+		/// Stride of the shadow copy of the positions, 0 if the geometry was cooked without SG_GEOMETRY_LOAD_FLAG_SHADOWED
+		uint32_t shadowPositionStride;
+		/// Vertex stride of every binding, 0 for unused bindings
+		uint32_t vertexStrides[SG_MAX_VERTEX_BINDINGS];
+		/// Levels of detail, the draw arguments section holds drawCount draws for each of them
+		uint32_t lodCount;
+		float    lodErrors[SG_MAX_GEOMETRY_LODS];
+		/// Counts of the meshlet data, 0 meshlets if the geometry was cooked without SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS
+		uint32_t meshletCount;
+		uint32_t meshletVertexCount;
+		uint32_t meshletTriangleCount;
+		uint64_t drawArgsOffset;
+		uint64_t inverseBindPosesOffset;
+		uint64_t jointRemapsOffset;
+		uint64_t indexOffset;
+		uint64_t vertexOffsets[SG_MAX_VERTEX_BINDINGS];
+		uint64_t shadowPositionOffset;
+		/// The meshlet data arrays as laid out by util_allocate_meshlet_data
+		uint64_t meshletDataOffset;
+	} CookedGeometryHeader;
+
+	/// CPU side state of a geometry load, carried between the load stages
+	typedef struct GeometryLoadState
+	{
+		cgltf_data*      pData;
+		void*            pFileData;
+		Geometry*        pGeom;
+		uint32_t         vertexStrides[SG_SEMANTIC_TEXCOORD9 + 1];
+		uint32_t         vertexAttribCount[SG_SEMANTIC_TEXCOORD9 + 1];
+		uint32_t         vertexOffsets[SG_SEMANTIC_TEXCOORD9 + 1];
+		uint32_t         vertexBindings[SG_SEMANTIC_TEXCOORD9 + 1];
+		PackingFunction  vertexPacking[SG_SEMANTIC_TEXCOORD9 + 1];
+		uint32_t         vertexPackingComponents[SG_SEMANTIC_TEXCOORD9 + 1];
+		uint32_t         indexStride;
+		/// Rebased and optimized indices of all the draws, nullptr if no optimization was requested
+		uint32_t*        pIndices;
+		/// Source vertex -> vertex buffer slot (UINT32_MAX for dropped vertices), nullptr if the vertices keep their order
+		uint32_t*        pVertexRemap;
+		BufferUpdateDesc indexUpdateDesc;
+		BufferUpdateDesc vertexUpdateDesc[SG_MAX_VERTEX_BINDINGS];
+		/// Stride of the positions in the shadow copy
+		uint32_t         shadowPositionStride;
+		/// The load reads a cooked geometry instead of the gltf, the stream stays open until the fill stage
+		bool                 cooked;
+		FileStream           cookedStream;
+		CookedGeometryHeader cookedHeader;
+	} GeometryLoadState;
+
+	/// A texture or geometry load of the batch the streamer is currently working on
+	typedef struct LoadTask
+	{
+		UpdateRequest*       pRequest;
+		UploadFunctionResult result;
+		union
+		{
+			TextureLoadState*  pTextureState;
+			GeometryLoadState* pGeometryState;
+		};
+	} LoadTask;
+
+	/// A thread sleeping in wait_for_token, it is only woken once its own token is reached
+	typedef struct TokenWaiter
+	{
+		SyncToken         token;
+		ConditionVariable cv;
+	} TokenWaiter;
+
+	/// A token whose own work is done (its request was recorded or cancelled, or it joins other tokens), it completes
+	/// once the tokens it waits for completed as well
+	typedef struct PendingToken
+	{
+		SyncToken token;
+		/// 0 if unused
+		SyncToken waitFor[2];
+	} PendingToken;
+
+	typedef struct LoadCallback
+	{
+		SyncToken            token;
+		LoadCompletedFunc    pFunc;
+		void*                pUserData;
+		LoadCallbackDispatch dispatch;
+	} LoadCallback;
+
 	struct ResourceLoader
 	{
 		Renderer* pRenderer;
@@ -442,21 +615,66 @@ namespace SG
 		volatile int                 run;
 		ThreadDesc				     threadDesc;
 		ThreadHandle                 mThread;
+		/// workers for the CPU side of texture and geometry loads, null when single threaded
+		ThreadSystem*                pThreadSystem;
+		/// workers compiling the stages and variants of add_shaders, null when single threaded
+		ThreadSystem*                pShaderThreadSystem;
+		/// workers running the worker load callbacks, null when single threaded. The loader thread waits for the decoding workers
+		/// to go idle, a callback waiting on a load from them would never let them
+		ThreadSystem*                pCallbackThreadSystem;
+		/// guards loading the shader compiler library
+		Mutex                        shaderCompilerMutex;
 
 		Mutex                        queueMutex;
 		ConditionVariable            queueCv;
+		/// guards the token waiters and the callbacks
 		Mutex                        tokenMutex;
-		ConditionVariable            tokenCv;
-		eastl::vector<UpdateRequest> requestQueue[SG_MAX_LINKED_GPUS];
+		eastl::vector<TokenWaiter*>  tokenWaiters;
+		/// callbacks whose token is not completed yet
+		eastl::vector<LoadCallback>  loadCallbacks;
+		/// completed callbacks waiting for dispatch_resource_load_callbacks
+		eastl::vector<LoadCallback>  readyCallbacks;
+		/// completed worker callbacks, drained from nextWorkerCallback on by at most SG_LOAD_CALLBACK_THREAD_COUNT tasks,
+		/// so a burst of completions never floods the task queue of pCallbackThreadSystem
+		eastl::vector<LoadCallback>  workerCallbacks;
+		uint32_t                     nextWorkerCallback;
+		uint32_t                     workerCallbackTaskCount;
+		/// tokens done with their own work but still waiting for others
+		eastl::vector<PendingToken>  pendingTokens;
+		/// completed tokens above tokenCompleted (sorted), requests of a higher priority overtake the older ones
+		eastl::vector<SyncToken>     completedTokens;
+		/// one queue per priority, each one sorted by token
+		eastl::vector<UpdateRequest> requestQueue[SG_MAX_LINKED_GPUS][SG_LOAD_PRIORITY_COUNT];
+		uint32_t                     peakQueueDepth[SG_LOAD_PRIORITY_COUNT];
+		uint64_t                     cancelledCount;
 
 		sg_atomic64_t                tokenCompleted;
 		sg_atomic64_t                tokenCounter;
+		/// highest token whose copies were submitted to the copy queues
+		sg_atomic64_t                tokenSubmitted;
+
+		/// tokens of the requests recorded into each set, they complete once its copies are done
+		eastl::vector<eastl::vector<PendingToken>> setTokens;
+
+		/// guards the streamed texture records shared by the decode stage, the loader thread and update_texture_streaming
+		Mutex                        streamingMutex;
+		eastl::vector<StreamedTexture*>                    streamedTextures;
+		eastl::unordered_map<Texture*, StreamedTexture*>   streamedTextureMap;
+		/// old mip chains swapped out of streamed textures, removed once the frames that may sample them are done
+		eastl::vector<eastl::pair<Texture*, uint64_t>>     retiredTextures;
+		uint64_t                                           streamingFrame;
 
-		SyncToken                    currentTokenState[MAX_FRAMES];
+		/// guards the resource cache, taken before queueMutex when both are needed
+		Mutex                                              resourceCacheMutex;
+		eastl::unordered_map<eastl::string, CachedResource*> resourceCache;
+		/// Texture* / Geometry* -> its entry, once the load was recorded
+		eastl::unordered_map<void*, CachedResource*>       cachedResources;
+		uint64_t                                           resourceCacheHits;
+
+		sg_atomic64_t                directUploadBytes;
 
 		CopyEngine                   pCopyEngines[SG_MAX_LINKED_GPUS];
 		uint32_t                     nextSet;
-		uint32_t                     submittedSets;
 
 	#if defined(NX64)
 		ThreadTypeNX                 threadType;
@@ -466,6 +684,31 @@ namespace SG
 
 	static ResourceLoader* pResourceLoader = nullptr;
 
+	/// Tokens up to tokenCompleted are all completed, above it only the ones in completedTokens (call inside tokenMutex)
+	static bool util_is_token_completed(ResourceLoader* pLoader, SyncToken token)
+	{
+		return token <= sg_atomic64_load_acquire(&pLoader->tokenCompleted) ||
+			eastl::binary_search(pLoader->completedTokens.begin(), pLoader->completedTokens.end(), token);
+	}
+
+	/// Let *pToken also wait for token. Requests of different priorities complete out of order, so the higher of two pending
+	/// tokens says nothing about the lower one, they are joined into a new token which completes with both
+	static void util_merge_token(ResourceLoader* pLoader, SyncToken* pToken, SyncToken token)
+	{
+		MutexLock lck(pLoader->tokenMutex);
+		if (*pToken == token || util_is_token_completed(pLoader, token))
+			return;
+		if (!*pToken || util_is_token_completed(pLoader, *pToken))
+		{
+			*pToken = token;
+			return;
+		}
+
+		PendingToken join = { sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1, { *pToken, token } };
+		pLoader->pendingTokens.push_back(join);
+		*pToken = join.token;
+	}
+
 	static uint32_t util_get_texture_row_alignment(Renderer* pRenderer)
 	{
 		return eastl::max(1u, pRenderer->pActiveGpuSettings->uploadBufferTextureRowAlignment);
@@ -479,7 +722,7 @@ namespace SG
 	}
 
 	//  Internal Functions
-	/// Return a new staging buffer
+	/// Return a new persistently mapped staging buffer
 	static MappedMemoryRange allocate_upload_memory(Renderer* pRenderer, uint64_t memoryRequirement, uint32_t alignment)
 	{
 	#if defined(SG_GRAPHIC_API_D3D11) || defined(SG_GRAPHIC_API_GLES)
@@ -490,7 +733,6 @@ namespace SG
 		buffer->pCpuMappedAddress = buffer + 1;
 		buffer->size = memoryRequirement;
 	#else
-		SG_LOG_INFO("Allocating temporary staging buffer.Required allocation size of %llu is larger than the staging buffer capacity of ", memoryRequirement);
 		Buffer* buffer = {};
 		BufferCreateDesc bufferDesc = {};
 		bufferDesc.size = memoryRequirement;
@@ -502,101 +744,241 @@ namespace SG
 		return { (uint8_t*)buffer->pCpuMappedAddress, buffer, 0, memoryRequirement };
 	}
 
+	static uint32_t add_staging_chunk(Renderer* pRenderer, StagingRing* pRing, uint64_t size)
+	{
+		StagingChunk chunk = {};
+		chunk.pBuffer = allocate_upload_memory(pRenderer, size, util_get_texture_subresource_alignment(pRenderer)).pBuffer;
+		pRing->chunks.push_back(chunk);
+		pRing->totalSize += size;
+		return (uint32_t)pRing->chunks.size() - 1;
+	}
+
+	static inline bool util_is_staging_chunk_free(const StagingRing& ring, const StagingChunk& chunk)
+	{
+		return !chunk.pendingCount && chunk.lastBatch <= ring.completedBatch;
+	}
+
+	static void add_copy_engine_set(Renderer* pRenderer, CopyEngine* pCopyEngine)
+	{
+		pCopyEngine->resourceSets.push_back(CopyResourceSet{});
+		CopyResourceSet& resourceSet = pCopyEngine->resourceSets.back();
+	#if !defined(SG_GRAPHIC_API_D3D11)
+		add_fence(pRenderer, &resourceSet.pFence);
+	#endif
+		CmdPoolCreateDesc cmdPoolDesc = {};
+		cmdPoolDesc.pQueue = pCopyEngine->pQueue;
+		cmdPoolDesc.transient = true;
+		add_command_pool(pRenderer, &cmdPoolDesc, &resourceSet.pCmdPool);
+
+		CmdCreateDesc cmdDesc = {};
+		cmdDesc.pPool = resourceSet.pCmdPool;
+		add_cmd(pRenderer, &cmdDesc, &resourceSet.pCmd);
+	}
+
 	// create the transfer queue and staging buffer
-	static void setup_copy_engine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, uint64_t size, uint32_t bufferCount)
+	static void setup_copy_engine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, uint64_t size, uint32_t bufferCount,
+		bool queueOwnershipTransfer)
 	{
+		// the renderer picks a transfer only family if the GPU has one, so copies run next to the graphics work
 		QueueCreateDesc desc = { SG_QUEUE_TYPE_TRANSFER, SG_QUEUE_FLAG_NONE, SG_QUEUE_PRIORITY_NORMAL, nodeIndex };
 		add_queue(pRenderer, &desc, &pCopyEngine->pQueue);
 
+		pCopyEngine->pTimelineSemaphore = nullptr;
+		pCopyEngine->timelineValue = 0;
+		pCopyEngine->ownershipTransfer = false;
+		pCopyEngine->acquireMutex.Init();
+		pCopyEngine->acquireValue = 0;
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		if (pRenderer->timelineSemaphoreSupport)
+		{
+			add_timeline_semaphore(pRenderer, 0, &pCopyEngine->pTimelineSemaphore);
+		}
+
+		uint8_t graphicsFamilyIndex = 0;
+		util_find_queue_family_index(pRenderer, nodeIndex, SG_QUEUE_TYPE_GRAPHICS, nullptr, &graphicsFamilyIndex, nullptr);
+		// without ownership transfers the resources are created shared by both families, the graphics queue only has to
+		// wait on the timeline semaphore before it uses them
+		const bool dedicatedFamily = graphicsFamilyIndex != pCopyEngine->pQueue->vkQueueFamilyIndex;
+		pCopyEngine->ownershipTransfer = dedicatedFamily && queueOwnershipTransfer;
+		if (dedicatedFamily && !queueOwnershipTransfer)
+		{
+			pRenderer->concurrentTransferSharing = 1;
+		}
+	#else
+		UNREF_PARAM(queueOwnershipTransfer);
+	#endif
+
 		const uint64_t maxBlockSize = 32;
 		size = eastl::max(size, maxBlockSize);
 
 		// resources that we want to copy
-		pCopyEngine->resourceSets = (CopyResourceSet*)sg_malloc(sizeof(CopyResourceSet) * bufferCount);
 		for (uint32_t i = 0; i < bufferCount; ++i)
 		{
-			sg_placement_new<CopyResourceSet>(pCopyEngine->resourceSets + i);
-
-			CopyResourceSet& resourceSet = pCopyEngine->resourceSets[i];
-	#if !defined(SG_GRAPHIC_API_D3D11)
-			add_fence(pRenderer, &resourceSet.pFence);
-	#endif
-			CmdPoolCreateDesc cmdPoolDesc = {};
-			cmdPoolDesc.pQueue = pCopyEngine->pQueue;
-			cmdPoolDesc.transient = true;
-			add_command_pool(pRenderer, &cmdPoolDesc, &resourceSet.pCmdPool);
-
-			CmdCreateDesc cmdDesc = {};
-			cmdDesc.pPool = resourceSet.pCmdPool;
-			add_cmd(pRenderer, &cmdDesc, &resourceSet.pCmd);
+			add_copy_engine_set(pRenderer, pCopyEngine);
+		}
 
-			resourceSet.pBuffer = allocate_upload_memory(pRenderer, size, util_get_texture_subresource_alignment(pRenderer)).pBuffer;
+		// start with one chunk per set, the same amount of staging memory a set used to own
+		StagingRing& ring = pCopyEngine->stagingRing;
+		ring.mutex.Init();
+		ring.chunkSize = size;
+		ring.minChunkCount = bufferCount;
+		ring.currentChunk = 0;
+		ring.totalSize = 0;
+		ring.currentBatch = 0;
+		ring.completedBatch = 0;
+		ring.highWaterMark = 0;
+		for (uint32_t i = 0; i < bufferCount; ++i)
+		{
+			add_staging_chunk(pRenderer, &ring, size);
 		}
 
 		pCopyEngine->bufferSize = size;
-		pCopyEngine->bufferCount = bufferCount;
 		pCopyEngine->isRecording = false;
 	}
 
 	static void cleanup_copy_engine(Renderer* pRenderer, CopyEngine* pCopyEngine)
 	{
-		for (uint32_t i = 0; i < pCopyEngine->bufferCount; ++i)
+		for (CopyResourceSet& resourceSet : pCopyEngine->resourceSets)
 		{
-			CopyResourceSet& resourceSet = pCopyEngine->resourceSets[i];
-			remove_buffer(pRenderer, resourceSet.pBuffer);
-
 			remove_cmd(pRenderer, resourceSet.pCmd);
 			remove_command_pool(pRenderer, resourceSet.pCmdPool);
 	#if !defined(SG_GRAPHIC_API_D3D11)
 			remove_fence(pRenderer, resourceSet.pFence);
 	#endif
-			if (!resourceSet.tempBuffers.empty())
-				SG_LOG_INFO("Was not cleaned up %d", i);
-			for (Buffer*& buffer : resourceSet.tempBuffers)
-			{
-				remove_buffer(pRenderer, buffer);
-			}
-			pCopyEngine->resourceSets[i].tempBuffers.set_capacity(0);
 		}
+		pCopyEngine->resourceSets.set_capacity(0);
+
+		if (pCopyEngine->pTimelineSemaphore)
+		{
+			remove_semaphore(pRenderer, pCopyEngine->pTimelineSemaphore);
+		}
+		pCopyEngine->bufferAcquires.set_capacity(0);
+		pCopyEngine->textureAcquires.set_capacity(0);
+		pCopyEngine->acquireMutex.Destroy();
 
-		sg_free(pCopyEngine->resourceSets);
+		StagingRing& ring = pCopyEngine->stagingRing;
+		for (StagingChunk& chunk : ring.chunks)
+		{
+			if (chunk.pendingCount)
+				SG_LOG_INFO("Staging chunk still has %u pending ranges", chunk.pendingCount);
+			remove_buffer(pRenderer, chunk.pBuffer);
+		}
+		ring.chunks.set_capacity(0);
+		ring.mutex.Destroy();
 
 		remove_queue(pRenderer, pCopyEngine->pQueue);
 	}
 
-	// wait for the transfer queue's fence
-	static bool wait_copy_engine_set(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, bool wait)
+	/// Turn the release barriers of a submitted set into the acquires the graphics queue has to record
+	static void util_hand_over_released_resources(CopyEngine* pCopyEngine, CopyResourceSet& resourceSet)
 	{
-		ASSERT(!pCopyEngine->isRecording);
-		CopyResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
-		bool             completed = true;
-	#if !defined(SG_GRAPHIC_API_D3D11)
-		FenceStatus status;
-		get_fence_status(pRenderer, resourceSet.pFence, &status);
-		completed = status != SG_FENCE_STATUS_INCOMPLETE;
-		if (wait && !completed)
+		if (resourceSet.bufferReleases.empty() && resourceSet.textureReleases.empty())
+			return;
+
+		MutexLock lck(pCopyEngine->acquireMutex);
+		for (BufferBarrier barrier : resourceSet.bufferReleases)
 		{
-			wait_for_fences(pRenderer, 1, &resourceSet.pFence);
+			barrier.release = 0;
+			barrier.acquire = 1;
+			barrier.queueType = SG_QUEUE_TYPE_TRANSFER;
+			pCopyEngine->bufferAcquires.push_back(barrier);
 		}
+		for (TextureBarrier barrier : resourceSet.textureReleases)
+		{
+			barrier.release = 0;
+			barrier.acquire = 1;
+			barrier.queueType = SG_QUEUE_TYPE_TRANSFER;
+			pCopyEngine->textureAcquires.push_back(barrier);
+		}
+		pCopyEngine->acquireValue = eastl::max(pCopyEngine->acquireValue, resourceSet.timelineValue);
+
+		resourceSet.bufferReleases.clear();
+		resourceSet.textureReleases.clear();
+	}
+
+	/// Retire the submitted sets the copy queue is done with, through the timeline semaphore (or the fences without one).
+	/// Only polls, a set still in flight is left alone
+	static void poll_copy_engine_sets(Renderer* pRenderer, CopyEngine* pCopyEngine)
+	{
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		if (pCopyEngine->pTimelineSemaphore)
+		{
+			const uint64_t completedValue = get_semaphore_value(pRenderer, pCopyEngine->pTimelineSemaphore);
+			for (CopyResourceSet& resourceSet : pCopyEngine->resourceSets)
+			{
+				if (resourceSet.submitted && completedValue >= resourceSet.timelineValue)
+					resourceSet.submitted = false;
+			}
+			return;
+		}
+	#endif
+		for (CopyResourceSet& resourceSet : pCopyEngine->resourceSets)
+		{
+			if (!resourceSet.submitted)
+				continue;
+	#if !defined(SG_GRAPHIC_API_D3D11)
+			FenceStatus status;
+			get_fence_status(pRenderer, resourceSet.pFence, &status);
+			if (status == SG_FENCE_STATUS_INCOMPLETE)
+				continue;
+			// without a semaphore to wait on, the graphics queue may only acquire what the copy queue is done with
+			util_hand_over_released_resources(pCopyEngine, resourceSet);
 	#else
-		UNREF_PARAM(pRenderer);
-		UNREF_PARAM(pCopyEngine);
-		UNREF_PARAM(activeSet);
+			UNREF_PARAM(pRenderer);
 	#endif
-		return completed;
+			resourceSet.submitted = false;
+		}
 	}
 
+	/// Start a new loader batch on a set that is not in flight.
+	/// Staging chunks last used by batches older than every set still in flight are retired, and every
+	/// SG_STAGING_RING_SHRINK_INTERVAL batches the idle chunks above the high-water mark are given back.
 	static void reset_copy_engine_set(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet)
 	{
 		ASSERT(!pCopyEngine->isRecording);
-		pCopyEngine->resourceSets[activeSet].allocatedSpace = 0;
 		pCopyEngine->isRecording = false;
 
-		for (Buffer*& buffer : pCopyEngine->resourceSets[activeSet].tempBuffers)
+		StagingRing& ring = pCopyEngine->stagingRing;
+		MutexLock lck(ring.mutex);
+
+		++ring.currentBatch;
+		pCopyEngine->resourceSets[activeSet].batch = ring.currentBatch;
+		// the copy queue executes the batches in order, all of them before the oldest one in flight are complete
+		uint64_t oldestBatch = ring.currentBatch;
+		for (const CopyResourceSet& resourceSet : pCopyEngine->resourceSets)
+		{
+			if (resourceSet.submitted)
+				oldestBatch = eastl::min(oldestBatch, resourceSet.batch);
+		}
+		ring.completedBatch = oldestBatch - 1;
+
+		uint32_t inFlight = 0;
+		for (const StagingChunk& chunk : ring.chunks)
+		{
+			if (!util_is_staging_chunk_free(ring, chunk))
+				++inFlight;
+		}
+		ring.highWaterMark = eastl::max(ring.highWaterMark, inFlight + 1);
+
+		if (ring.currentBatch % SG_STAGING_RING_SHRINK_INTERVAL)
+		{
+			return;
+		}
+
+		const uint32_t keepCount = eastl::max(ring.minChunkCount, ring.highWaterMark);
+		for (uint32_t i = (uint32_t)ring.chunks.size(); i-- > 0 && ring.chunks.size() > keepCount;)
 		{
-			remove_buffer(pRenderer, buffer);
+			StagingChunk& chunk = ring.chunks[i];
+			if (i == ring.currentChunk || !util_is_staging_chunk_free(ring, chunk))
+				continue;
+
+			ring.totalSize -= chunk.pBuffer->size;
+			remove_buffer(pRenderer, chunk.pBuffer);
+			ring.chunks.erase(ring.chunks.begin() + i);
+			if (ring.currentChunk > i)
+				--ring.currentChunk;
 		}
-		pCopyEngine->resourceSets[activeSet].tempBuffers.clear();
+		ring.highWaterMark = inFlight + 1;
 	}
 
 	// if we are not recording the cmds, we start to record cmds and begin_cmd()
@@ -617,457 +999,839 @@ namespace SG
 		if (pCopyEngine->isRecording)
 		{
 			CopyResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+			if (!resourceSet.bufferReleases.empty() || !resourceSet.textureReleases.empty())
+			{
+				cmd_resource_barrier(resourceSet.pCmd, (uint32_t)resourceSet.bufferReleases.size(), resourceSet.bufferReleases.data(),
+					(uint32_t)resourceSet.textureReleases.size(), resourceSet.textureReleases.data(), 0, nullptr);
+			}
 			end_cmd(resourceSet.pCmd);
 			QueueSubmitDesc submitDesc = {};
 			submitDesc.cmdCount = 1;
 			submitDesc.ppCmds = &resourceSet.pCmd;
+			if (pCopyEngine->pTimelineSemaphore)
+			{
+				resourceSet.timelineValue = ++pCopyEngine->timelineValue;
+				submitDesc.signalSemaphoreCount = 1;
+				submitDesc.ppSignalSemaphores = &pCopyEngine->pTimelineSemaphore;
+				submitDesc.pSignalValues = &resourceSet.timelineValue;
+			}
 	#if !defined(SG_GRAPHIC_API_D3D11)
-			submitDesc.pSignalFence = resourceSet.pFence;
+			else
+			{
+				submitDesc.pSignalFence = resourceSet.pFence;
+			}
 	#endif
 			{
 				queue_submit(pCopyEngine->pQueue, &submitDesc);
 			}
 			pCopyEngine->isRecording = false;
+			resourceSet.submitted = true;
+
+			// the graphics queue orders its acquires after the releases by waiting on the timeline value
+			if (pCopyEngine->pTimelineSemaphore)
+			{
+				util_hand_over_released_resources(pCopyEngine, resourceSet);
+				MutexLock lck(pCopyEngine->acquireMutex);
+				pCopyEngine->acquireValue = resourceSet.timelineValue;
+			}
+		}
+	}
+
+	/// Read state a resource uploaded by the copy queue is handed over to the graphics queue in
+	static ResourceState util_get_uploaded_buffer_state(const Buffer* pBuffer)
+	{
+		ResourceState state = SG_RESOURCE_STATE_UNDEFINED;
+		const DescriptorType usage = (DescriptorType)pBuffer->descriptors;
+		if (usage & (SG_DESCRIPTOR_TYPE_VERTEX_BUFFER | SG_DESCRIPTOR_TYPE_UNIFORM_BUFFER))
+			state |= SG_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+		if (usage & SG_DESCRIPTOR_TYPE_INDEX_BUFFER)
+			state |= SG_RESOURCE_STATE_INDEX_BUFFER;
+		if (usage & SG_DESCRIPTOR_TYPE_INDIRECT_BUFFER)
+			state |= SG_RESOURCE_STATE_INDIRECT_ARGUMENT;
+		if (usage & SG_DESCRIPTOR_TYPE_RW_BUFFER)
+			state |= SG_RESOURCE_STATE_UNORDERED_ACCESS;
+		if ((usage & SG_DESCRIPTOR_TYPE_BUFFER) || state == SG_RESOURCE_STATE_UNDEFINED)
+			state |= SG_RESOURCE_STATE_SHADER_RESOURCE;
+		return state;
+	}
+
+	/// Record the last barrier of a buffer or texture the copy queue wrote. With a dedicated transfer family it becomes
+	/// a release to the graphics family, batched until the set is submitted
+	static void util_hand_over_buffer(CopyEngine* pCopyEngine, size_t activeSet, BufferBarrier barrier)
+	{
+		if (!pCopyEngine->ownershipTransfer)
+		{
+			cmd_resource_barrier(acquire_cmd(pCopyEngine, activeSet), 1, &barrier, 0, nullptr, 0, nullptr);
+			return;
 		}
+		barrier.release = 1;
+		barrier.queueType = SG_QUEUE_TYPE_GRAPHICS;
+		pCopyEngine->resourceSets[activeSet].bufferReleases.push_back(barrier);
 	}
 
-	/// Return memory from pre-allocated staging buffer or create a temporary buffer if the streamer ran out of memory
-	static MappedMemoryRange allocate_staging_memory(uint64_t memoryRequirement, uint32_t alignment)
+	static void util_hand_over_texture(CopyEngine* pCopyEngine, size_t activeSet, TextureBarrier barrier)
 	{
-		// use the copy engine for GPU 0.
-		CopyEngine* pCopyEngine = &pResourceLoader->pCopyEngines[0];
+		if (!pCopyEngine->ownershipTransfer)
+		{
+			cmd_resource_barrier(acquire_cmd(pCopyEngine, activeSet), 0, nullptr, 1, &barrier, 0, nullptr);
+			return;
+		}
+		barrier.release = 1;
+		barrier.queueType = SG_QUEUE_TYPE_GRAPHICS;
+		// the set has to be recording for the releases to be submitted with it
+		acquire_cmd(pCopyEngine, activeSet);
+		pCopyEngine->resourceSets[activeSet].textureReleases.push_back(barrier);
+	}
+
+	/// Sub-allocate from the staging ring of a copy engine.
+	/// Ranges allocated by the loader thread belong to the batch being recorded. Pending ranges are handed out
+	/// to begin_update_resource, they stay reserved until release_staging_memory is called for them.
+	static MappedMemoryRange allocate_staging_memory(CopyEngine* pCopyEngine, uint64_t memoryRequirement, uint32_t alignment, bool pending = false)
+	{
+		StagingRing& ring = pCopyEngine->stagingRing;
+		MutexLock lck(ring.mutex);
+
+		const uint32_t chunkCount = (uint32_t)ring.chunks.size();
+		uint32_t chunkIndex = UINT32_MAX;
+		uint64_t offset = 0;
 
-		uint64_t offset = pCopyEngine->resourceSets[pResourceLoader->nextSet].allocatedSpace;
-		if (alignment != 0)
+		// keep filling the current chunk
+		if (ring.currentChunk < chunkCount)
 		{
-			offset = round_up(offset, alignment);
+			const StagingChunk& chunk = ring.chunks[ring.currentChunk];
+			offset = alignment ? round_up_64(chunk.allocatedSpace, alignment) : chunk.allocatedSpace;
+			if (offset < chunk.pBuffer->size && memoryRequirement <= chunk.pBuffer->size - offset)
+				chunkIndex = ring.currentChunk;
+		}
+
+		// wrap around to the next chunk the GPU is done with,
+		// oversized chunks are only reused for allocations that need them
+		if (UINT32_MAX == chunkIndex)
+		{
+			offset = 0;
+			for (uint32_t i = 1; i <= chunkCount; ++i)
+			{
+				uint32_t index = (ring.currentChunk + i) % chunkCount;
+				const StagingChunk& chunk = ring.chunks[index];
+				bool fits = memoryRequirement <= ring.chunkSize ? chunk.pBuffer->size == ring.chunkSize : chunk.pBuffer->size >= memoryRequirement;
+				if (fits && util_is_staging_chunk_free(ring, chunk))
+				{
+					ring.chunks[index].allocatedSpace = 0;
+					chunkIndex = index;
+					break;
+				}
+			}
 		}
 
-		CopyResourceSet* pResourceSet = &pCopyEngine->resourceSets[pResourceLoader->nextSet];
-		uint64_t size = (uint64_t)pResourceSet->pBuffer->size;
-		bool memoryAvailable = (offset < size) && (memoryRequirement <= size - offset);
-		if (memoryAvailable && pResourceSet->pBuffer->pCpuMappedAddress)
+		// everything is in flight, grow the ring
+		if (UINT32_MAX == chunkIndex)
 		{
-			Buffer* buffer = pResourceSet->pBuffer;
-			ASSERT(buffer->pCpuMappedAddress);
-			uint8_t* pDstData = (uint8_t*)buffer->pCpuMappedAddress + offset;
-			pCopyEngine->resourceSets[pResourceLoader->nextSet].allocatedSpace = offset + memoryRequirement;
-			return { pDstData, buffer, offset, memoryRequirement };
+			uint64_t size = round_up_64(memoryRequirement, ring.chunkSize);
+			chunkIndex = add_staging_chunk(pResourceLoader->pRenderer, &ring, size);
+			if (ring.totalSize > ring.chunkSize * ring.minChunkCount * SG_STAGING_RING_MAX_GROWTH)
+				SG_LOG_WARNING("Staging ring grew by %llu to %llu bytes, consider a larger ResourceLoaderDesc::bufferSize", size, ring.totalSize);
 		}
+
+		StagingChunk& chunk = ring.chunks[chunkIndex];
+		// an oversized chunk serves its one allocation, regular allocations keep going in the current chunk
+		if (chunk.pBuffer->size == ring.chunkSize)
+			ring.currentChunk = chunkIndex;
+
+		chunk.allocatedSpace = offset + memoryRequirement;
+		if (pending)
+			++chunk.pendingCount;
 		else
+			chunk.lastBatch = ring.currentBatch;
+
+		ASSERT(chunk.pBuffer->pCpuMappedAddress);
+		return { (uint8_t*)chunk.pBuffer->pCpuMappedAddress + offset, chunk.pBuffer, offset, memoryRequirement, pending ? (uint32_t)MAPPED_RANGE_FLAG_STAGING_RING : 0u };
+	}
+
+	/// Give a pending staging range back to the ring. If its copy was recorded, the chunk retires with the current batch.
+	static void release_staging_memory(CopyEngine* pCopyEngine, Buffer* pBuffer, bool recorded)
+	{
+		StagingRing& ring = pCopyEngine->stagingRing;
+		MutexLock lck(ring.mutex);
+
+		for (StagingChunk& chunk : ring.chunks)
 		{
-			if (pCopyEngine->bufferSize < memoryRequirement)
+			if (chunk.pBuffer == pBuffer)
 			{
-				MappedMemoryRange range = allocate_upload_memory(pResourceLoader->pRenderer, memoryRequirement, alignment);
-				SG_LOG_INFO("Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-				pResourceSet->tempBuffers.emplace_back(range.pBuffer);
-				return range;
+				ASSERT(chunk.pendingCount);
+				--chunk.pendingCount;
+				if (recorded)
+					chunk.lastBatch = eastl::max(chunk.lastBatch, ring.currentBatch);
+				return;
 			}
 		}
+		ASSERT(false && "Staging range does not belong to this copy engine");
+	}
 
-		MappedMemoryRange range = allocate_upload_memory(pResourceLoader->pRenderer, memoryRequirement, alignment);
-		SG_LOG_INFO("Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-		pResourceSet->tempBuffers.emplace_back(range.pBuffer);
-		return range;
+	/// Free what a request that will never run still holds
+	static void release_update_request(ResourceLoader* pLoader, UpdateRequest& request)
+	{
+		if (request.pUploadBuffer)
+		{
+			uint32_t nodeIndex = SG_UPDATE_REQUEST_UPDATE_BUFFER == request.type ?
+				request.bufferUpdateDesc.pBuffer->nodeIndex : request.texUpdateDesc.pTexture->nodeIndex;
+			release_staging_memory(&pLoader->pCopyEngines[nodeIndex], request.pUploadBuffer, false);
+		}
+		if (SG_UPDATE_REQUEST_LOAD_GEOMETRY == request.type)
+		{
+			sg_free(request.geomLoadDesc.pVertexLayout);
+		}
 	}
 
 	static void free_all_upload_memory()
 	{
 		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
 		{
-			for (UpdateRequest& request : pResourceLoader->requestQueue[i])
+			for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
 			{
-				if (request.pUploadBuffer)
+				for (UpdateRequest& request : pResourceLoader->requestQueue[i][priority])
 				{
-					remove_buffer(pResourceLoader->pRenderer, request.pUploadBuffer);
+					release_update_request(pResourceLoader, request);
 				}
+				pResourceLoader->requestQueue[i][priority].clear();
 			}
 		}
 	}
 
-	static UploadFunctionResult update_texture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureUpdateDescInternal& texUpdateDesc)
+	typedef struct TextureSubresourceLayout
 	{
-		// when this call comes from updateResource, staging buffer data is already filled
-		// all that is left to do is record and execute the Copy commands
-		bool dataAlreadyFilled = texUpdateDesc.range.pBuffer ? true : false;
-		Texture* texture = texUpdateDesc.pTexture;
+		uint32_t mipLevel;
+		uint32_t arrayLayer;
+		uint32_t rowSize;
+		uint32_t rowCount;
+		uint32_t rowPitch;
+		uint32_t slicePitch;
+		uint32_t depth;
+		/// offset of this subresource from the start of the staging range
+		uint64_t offset;
+		/// mip of the file above the texture's chain, only the stream position has to move past it
+		bool     skipped;
+	} TextureSubresourceLayout;
+
+	static uint64_t util_get_texture_update_size(Renderer* pRenderer, const TextureUpdateDescInternal& texUpdateDesc)
+	{
+		const Texture* texture = texUpdateDesc.pTexture;
 		const TinyImageFormat fmt = (TinyImageFormat)texture->format;
-		FileStream stream = texUpdateDesc.stream;
-		Cmd* cmd = acquire_cmd(pCopyEngine, activeSet);
-
-		ASSERT(pCopyEngine->pQueue->nodeIndex == texUpdateDesc.pTexture->nodeIndex);
-
-		const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
-		const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
-		const uint64_t requiredSize = util_get_surface_size(fmt, texture->width, texture->height, texture->depth,
-			rowAlignment,
-			sliceAlignment,
+		return util_get_surface_size(fmt, texture->width, texture->height, texture->depth,
+			util_get_texture_row_alignment(pRenderer),
+			util_get_texture_subresource_alignment(pRenderer, fmt),
 			texUpdateDesc.baseMipLevel, texUpdateDesc.mipLevels,
 			texUpdateDesc.baseArrayLayer, texUpdateDesc.layerCount);
+	}
 
-	#if defined(SG_GRAPHIC_API_VULKAN)
-		TextureBarrier barrier = { texture, SG_RESOURCE_STATE_UNDEFINED, SG_RESOURCE_STATE_COPY_DEST };
-		cmd_resource_barrier(cmd, 0, nullptr, 1, &barrier, 0, nullptr);
-	#endif
-
-		MappedMemoryRange upload = dataAlreadyFilled ? texUpdateDesc.range : allocate_staging_memory(requiredSize, sliceAlignment);
-		uint64_t offset = 0;
-
-		// #TODO: Investigate - fsRead crashes if we pass the upload buffer mapped address. Allocating temporary buffer as a workaround. Does NX support loading from disk to GPU shared memory?
-		//#ifdef NX64
-		//	void* nxTempBuffer = NULL;
-		//	if (!dataAlreadyFilled)
-		//	{
-		//		size_t remainingBytes = fsGetStreamFileSize(&stream) - fsGetStreamSeekPosition(&stream);
-		//		nxTempBuffer = tf_malloc(remainingBytes);
-		//		ssize_t bytesRead = fsReadFromStream(&stream, nxTempBuffer, remainingBytes);
-		//		if (bytesRead != remainingBytes)
-		//		{
-		//			fsCloseStream(&stream);
-		//			tf_free(nxTempBuffer);
-		//			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-		//		}
-
-		//		fsCloseStream(&stream);
-		//		fsOpenStreamFromMemory(nxTempBuffer, remainingBytes, FM_READ_BINARY, true, &stream);
-		//	}
-		//#endif
+	/// Walk the subresources of an update in the order they are stored in the file (and so in the staging memory).
+	/// If pStream is not null, the per-mip callback of the container is invoked to keep the stream in sync.
+	template <typename SubresourceFunc>
+	static bool util_for_each_texture_subresource(Renderer* pRenderer, const TextureUpdateDescInternal& texUpdateDesc, FileStream* pStream, SubresourceFunc func)
+	{
+		const Texture* texture = texUpdateDesc.pTexture;
+		const TinyImageFormat fmt = (TinyImageFormat)texture->format;
+		const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
+		const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
 
-		if (!upload.pData)
-		{
-			return SG_UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
-		}
+		// mips the texture does not have are only walked to skip them in the stream, they are reported with skipped set
+		const uint32_t skipMips = pStream ? texUpdateDesc.skipMipLevels : 0;
+		const uint32_t mipEnd = texUpdateDesc.baseMipLevel + texUpdateDesc.mipLevels + skipMips;
 
 		uint32_t firstStart = texUpdateDesc.mipsAfterSlice ? texUpdateDesc.baseMipLevel : texUpdateDesc.baseArrayLayer;
-		uint32_t firstEnd = texUpdateDesc.mipsAfterSlice ? (texUpdateDesc.baseMipLevel + texUpdateDesc.mipLevels) : (texUpdateDesc.baseArrayLayer + texUpdateDesc.layerCount);
+		uint32_t firstEnd = texUpdateDesc.mipsAfterSlice ? mipEnd : (texUpdateDesc.baseArrayLayer + texUpdateDesc.layerCount);
 		uint32_t secondStart = texUpdateDesc.mipsAfterSlice ? texUpdateDesc.baseArrayLayer : texUpdateDesc.baseMipLevel;
-		uint32_t secondEnd = texUpdateDesc.mipsAfterSlice ? (texUpdateDesc.baseArrayLayer + texUpdateDesc.layerCount) : (texUpdateDesc.baseMipLevel + texUpdateDesc.mipLevels);
+		uint32_t secondEnd = texUpdateDesc.mipsAfterSlice ? (texUpdateDesc.baseArrayLayer + texUpdateDesc.layerCount) : mipEnd;
 
-		for (uint32_t p = 0; p < 1; ++p)
+		uint64_t offset = 0;
+		for (uint32_t j = firstStart; j < firstEnd; ++j)
 		{
-			for (uint32_t j = firstStart; j < firstEnd; ++j)
+			if (pStream && texUpdateDesc.mipsAfterSlice && texUpdateDesc.preMipFunc)
 			{
-				if (texUpdateDesc.mipsAfterSlice && texUpdateDesc.preMipFunc)
-				{
-					texUpdateDesc.preMipFunc(&stream, j);
-				}
+				texUpdateDesc.preMipFunc(pStream, j);
+			}
 
-				for (uint32_t i = secondStart; i < secondEnd; ++i)
+			for (uint32_t i = secondStart; i < secondEnd; ++i)
+			{
+				if (pStream && !texUpdateDesc.mipsAfterSlice && texUpdateDesc.preMipFunc)
 				{
-					if (!texUpdateDesc.mipsAfterSlice && texUpdateDesc.preMipFunc)
-					{
-						texUpdateDesc.preMipFunc(&stream, i);
-					}
-
-					uint32_t mip = texUpdateDesc.mipsAfterSlice ? j : i;
-					uint32_t layer = texUpdateDesc.mipsAfterSlice ? i : j;
-
-					uint32_t width = SG_MIP_REDUCE(texture->width, mip);
-					uint32_t height = SG_MIP_REDUCE(texture->height, mip);
-					uint32_t depth = SG_MIP_REDUCE(texture->depth, mip);
+					texUpdateDesc.preMipFunc(pStream, i);
+				}
 
-					uint32_t numBytes = 0;
-					uint32_t rowBytes = 0;
-					uint32_t numRows = 0;
+				TextureSubresourceLayout layout = {};
+				uint32_t streamMip = texUpdateDesc.mipsAfterSlice ? j : i;
+				layout.arrayLayer = texUpdateDesc.mipsAfterSlice ? i : j;
+				layout.skipped = streamMip < skipMips;
+				layout.mipLevel = layout.skipped ? 0 : streamMip - skipMips;
 
-					bool ret = util_get_surface_info(width, height, fmt, &numBytes, &rowBytes, &numRows);
-					if (!ret)
-					{
-						return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-					}
+				uint32_t width = layout.skipped ? SG_MIP_REDUCE(texUpdateDesc.fileWidth, streamMip) : SG_MIP_REDUCE(texture->width, layout.mipLevel);
+				uint32_t height = layout.skipped ? SG_MIP_REDUCE(texUpdateDesc.fileHeight, streamMip) : SG_MIP_REDUCE(texture->height, layout.mipLevel);
+				uint32_t numBytes = 0;
 
-					uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
-					uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
-					uint32_t subNumRows = numRows;
-					uint32_t subDepth = depth;
-					uint32_t subRowSize = rowBytes;
-					uint8_t* data = upload.pData + offset;
+				bool ret = util_get_surface_info(width, height, fmt, &numBytes, &layout.rowSize, &layout.rowCount);
+				if (!ret)
+				{
+					return false;
+				}
 
-					if (!dataAlreadyFilled)
-					{
-						for (uint32_t z = 0; z < subDepth; ++z)
-						{
-							uint8_t* dstData = data + subSlicePitch * z;
-							for (uint32_t r = 0; r < subNumRows; ++r)
-							{
-								ssize_t bytesRead = sgfs_read_from_stream(&stream, dstData + r * subRowPitch, subRowSize);
-								if (bytesRead != subRowSize)
-								{
-									return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-								}
-							}
-						}
-					}
+				layout.rowPitch = round_up(layout.rowSize, rowAlignment);
+				layout.slicePitch = round_up(layout.rowPitch * layout.rowCount, sliceAlignment);
+				layout.depth = layout.skipped ? SG_MIP_REDUCE(texUpdateDesc.fileDepth, streamMip) : SG_MIP_REDUCE(texture->depth, layout.mipLevel);
+				layout.offset = offset;
 
-					SubresourceDataDesc subresourceDesc = {};
-					subresourceDesc.arrayLayer = layer;
-					subresourceDesc.mipLevel = mip;
-					subresourceDesc.srcOffset = upload.offset + offset;
-	#if defined(SG_GRAPHIC_API_D3D11) || defined(SG_GRAPHIC_API_METAL) || defined(SG_GRAPHIC_API_VULKAN)
-					subresourceDesc.rowPitch = subRowPitch;
-					subresourceDesc.slicePitch = subSlicePitch;
-	#endif
-					// copy the buffer to the texture
-					cmd_update_subresource(cmd, texture, upload.pBuffer, &subresourceDesc);
-					offset += subDepth * subSlicePitch;
+				if (!func(layout))
+				{
+					return false;
+				}
+				if (!layout.skipped)
+				{
+					offset += layout.depth * layout.slicePitch;
 				}
 			}
 		}
 
-	#if defined(SG_GRAPHIC_API_VULKAN)
-		barrier = { texture, SG_RESOURCE_STATE_COPY_DEST, SG_RESOURCE_STATE_SHADER_RESOURCE };
-		cmd_resource_barrier(cmd, 0, nullptr, 1, &barrier, 0, nullptr);
-	#endif
-
-		if (stream.pIO)
-		{
-			sgfs_close_stream(&stream);
-		}
-
-		return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+		return true;
 	}
 
-	static UploadFunctionResult load_texture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const UpdateRequest& pTextureUpdate)
+	/// Read every subresource of the update from its stream into the staging range and close the stream.
+	/// Only touches CPU memory, so this is safe to call from the decode workers.
+	static bool fill_texture_staging(Renderer* pRenderer, TextureUpdateDescInternal& texUpdateDesc)
 	{
-		const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
+		FileStream* pStream = &texUpdateDesc.stream;
+		uint8_t* pData = texUpdateDesc.range.pData;
 
-		if (pTextureDesc->fileName)
+		bool success = util_for_each_texture_subresource(pRenderer, texUpdateDesc, pStream, [pStream, pData](const TextureSubresourceLayout& layout)
 		{
-			FileStream stream = {};
-			char fileName[SG_MAX_FILEPATH] = {};
-			bool success = false;
-
-			TextureUpdateDescInternal updateDesc = {};
-			TextureContainerType container = pTextureDesc->container;
-			static const char* extensions[] = { nullptr, "dds", "ktx", "gnf", "basis", "svt" };
-
-			// find the texture format's extension that we use
-			if (SG_TEXTURE_CONTAINER_DEFAULT == container)
+			if (layout.skipped)
 			{
-	#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
-				container = SG_TEXTURE_CONTAINER_KTX;
-	#elif defined(SG_PLATFORM_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
-				container = SG_TEXTURE_CONTAINER_DDS;
-	#elif defined(ORBIS) || defined(PROSPERO)
-				container = SG_TEXTURE_CONTAINER_GNF;
-	#endif
+				return sgfs_seek_stream(pStream, SG_SBO_CURRENT_POSITION, (ssize_t)layout.rowSize * layout.rowCount * layout.depth);
+			}
+
+			for (uint32_t z = 0; z < layout.depth; ++z)
+			{
+				uint8_t* dstData = pData + layout.offset + layout.slicePitch * z;
+				// rows are tightly packed in the staging memory too, read the whole slice at once
+				if (layout.rowPitch == layout.rowSize)
+				{
+					ssize_t sliceSize = (ssize_t)layout.rowSize * layout.rowCount;
+					if (sgfs_read_from_stream(pStream, dstData, sliceSize) != sliceSize)
+					{
+						return false;
+					}
+					continue;
+				}
+
+				for (uint32_t r = 0; r < layout.rowCount; ++r)
+				{
+					ssize_t bytesRead = sgfs_read_from_stream(pStream, dstData + r * layout.rowPitch, layout.rowSize);
+					if (bytesRead != layout.rowSize)
+					{
+						return false;
+					}
+				}
 			}
+			return true;
+		});
+
+		if (pStream->pIO)
+		{
+			sgfs_close_stream(pStream);
+		}
+		*pStream = {};
+
+		return success;
+	}
+
+	static UploadFunctionResult update_texture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureUpdateDescInternal& texUpdateDesc)
+	{
+		// when this call comes from updateResource or from a decoded texture load, staging buffer data is already filled
+		// all that is left to do is record and execute the Copy commands
+		TextureUpdateDescInternal updateDesc = texUpdateDesc;
+		Texture* texture = updateDesc.pTexture;
+		Cmd* cmd = acquire_cmd(pCopyEngine, activeSet);
+
+		ASSERT(pCopyEngine->pQueue->nodeIndex == updateDesc.pTexture->nodeIndex);
+
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		TextureBarrier barrier = { texture, SG_RESOURCE_STATE_UNDEFINED, SG_RESOURCE_STATE_COPY_DEST };
+		cmd_resource_barrier(cmd, 0, nullptr, 1, &barrier, 0, nullptr);
+	#endif
 
-			TextureCreateDesc textureDesc = {};
-			textureDesc.name = pTextureDesc->fileName;
+		if (!updateDesc.range.pBuffer)
+		{
+			const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, (TinyImageFormat)texture->format);
+			updateDesc.range = allocate_staging_memory(pCopyEngine, util_get_texture_update_size(pRenderer, updateDesc), sliceAlignment);
+			if (!updateDesc.range.pData)
+			{
+				return SG_UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
+			}
 
-			// validate that we have found the file format now
-			ASSERT(container != SG_TEXTURE_CONTAINER_DEFAULT);
-			if (SG_TEXTURE_CONTAINER_DEFAULT == container)
+			if (!fill_texture_staging(pRenderer, updateDesc))
 			{
 				return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 			}
-			// append the extension to the name
-			sgfs_append_path_extension(pTextureDesc->fileName, extensions[container], fileName);
+		}
 
-			switch (container)
-			{
-			case SG_TEXTURE_CONTAINER_DDS:
+		const MappedMemoryRange& upload = updateDesc.range;
+		bool success = util_for_each_texture_subresource(pRenderer, updateDesc, nullptr, [cmd, texture, &upload](const TextureSubresourceLayout& layout)
+		{
+			SubresourceDataDesc subresourceDesc = {};
+			subresourceDesc.arrayLayer = layout.arrayLayer;
+			subresourceDesc.mipLevel = layout.mipLevel;
+			subresourceDesc.srcOffset = upload.offset + layout.offset;
+	#if defined(SG_GRAPHIC_API_D3D11) || defined(SG_GRAPHIC_API_METAL) || defined(SG_GRAPHIC_API_VULKAN)
+			subresourceDesc.rowPitch = layout.rowPitch;
+			subresourceDesc.slicePitch = layout.slicePitch;
+	#endif
+			// copy the buffer to the texture
+			cmd_update_subresource(cmd, texture, upload.pBuffer, &subresourceDesc);
+			return true;
+		});
+
+		if (!success)
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		barrier = { texture, SG_RESOURCE_STATE_COPY_DEST, SG_RESOURCE_STATE_SHADER_RESOURCE };
+		util_hand_over_texture(pCopyEngine, activeSet, barrier);
+	#endif
+
+		return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+	}
+
+	/// Drop the largest mips of a streamed texture load from the texture that is going to be created.
+	/// The first load of a streamed texture records the file header and starts with the resident tail.
+	static void apply_texture_streaming(StreamedTexture* pStreamed, TextureLoadState* pState)
+	{
+		TextureCreateDesc& textureDesc = pState->textureDesc;
+
+		uint32_t skipMips = 0;
+		{
+			MutexLock lck(pResourceLoader->streamingMutex);
+			if (UINT32_MAX == pStreamed->pendingMip)
 			{
-	#if defined(XBOX)
-				success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
-				uint32_t res = 1;
-				if (success)
-				{
-					extern uint32_t load_dds_texture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags, Texture * *ppTexture);
-					res = load_dds_texture(pRenderer, &stream, fileName, pTextureDesc->creationFlag, pTextureDesc->ppTexture);
-					sgfs_close_stream(&stream);
-				}
+				pStreamed->width = textureDesc.width;
+				pStreamed->height = textureDesc.height;
+				pStreamed->depth = textureDesc.depth;
+				pStreamed->arraySize = textureDesc.arraySize;
+				pStreamed->mipLevels = textureDesc.mipLevels;
+				pStreamed->format = textureDesc.format;
+				pStreamed->pendingMip = textureDesc.mipLevels - eastl::min(pStreamed->minResidentMips, textureDesc.mipLevels);
+			}
+			skipMips = eastl::min(pStreamed->pendingMip, textureDesc.mipLevels - 1);
+		}
 
-				return res ? SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-	#else
-				success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
-				if (success)
-				{
-					success = load_dds_texture(&stream, &textureDesc);
-				}
+		if (!skipMips)
+		{
+			return;
+		}
+
+		TextureUpdateDescInternal& updateDesc = pState->updateDesc;
+		updateDesc.skipMipLevels = skipMips;
+		updateDesc.fileWidth = textureDesc.width;
+		updateDesc.fileHeight = textureDesc.height;
+		updateDesc.fileDepth = textureDesc.depth;
+
+		textureDesc.width = SG_MIP_REDUCE(textureDesc.width, skipMips);
+		textureDesc.height = SG_MIP_REDUCE(textureDesc.height, skipMips);
+		textureDesc.depth = SG_MIP_REDUCE(textureDesc.depth, skipMips);
+		textureDesc.mipLevels -= skipMips;
+	}
+
+	static bool util_get_mip_texel_type(TinyImageFormat format, MipTexelType* pTexelType, uint32_t* pChannelCount)
+	{
+		switch (format)
+		{
+		case TinyImageFormat_R8_UNORM:
+		case TinyImageFormat_R8_SRGB:
+		case TinyImageFormat_R8G8_UNORM:
+		case TinyImageFormat_R8G8_SRGB:
+		case TinyImageFormat_R8G8B8A8_UNORM:
+		case TinyImageFormat_R8G8B8A8_SRGB:
+		case TinyImageFormat_B8G8R8A8_UNORM:
+		case TinyImageFormat_B8G8R8A8_SRGB:
+			*pTexelType = SG_MIP_TEXEL_UNORM8;
+			break;
+		case TinyImageFormat_R32_SFLOAT:
+		case TinyImageFormat_R32G32_SFLOAT:
+		case TinyImageFormat_R32G32B32A32_SFLOAT:
+			*pTexelType = SG_MIP_TEXEL_FLOAT32;
+			break;
+		default:
+			return false;
+		}
+		*pChannelCount = TinyImageFormat_ChannelCount(format);
+		return true;
+	}
+
+	/// Extend a texture whose file only stores the first mip to the full chain. The staging range is laid out mip after mip,
+	/// so reading the first mip of every layer puts it at the same offsets as in the full layout
+	static void util_prepare_mip_generation(const TextureLoadDesc* pTextureDesc, TextureLoadState* pState)
+	{
+		TextureCreateDesc& textureDesc = pState->textureDesc;
+		MipTexelType texelType = SG_MIP_TEXEL_UNORM8;
+		uint32_t channelCount = 0;
+		if (textureDesc.mipLevels != 1 || textureDesc.depth != 1 || !util_get_mip_texel_type(textureDesc.format, &texelType, &channelCount))
+		{
+			return;
+		}
+
+		const uint32_t mipLevels = get_mip_level_count(textureDesc.width, textureDesc.height);
+		if (mipLevels == 1)
+		{
+			return;
+		}
+
+		textureDesc.mipLevels = mipLevels;
+		pState->updateDesc.mipsAfterSlice = true;
+		pState->mipFilter = pTextureDesc->mipFilter;
+		pState->mipFlags = pTextureDesc->mipFlags;
+		if (TinyImageFormat_IsSRGB(textureDesc.format))
+		{
+			pState->mipFlags = (MipGenerationFlags)(pState->mipFlags | SG_MIP_GENERATION_FLAG_SRGB);
+		}
+	}
+
+	/// Decode stage of a texture load (worker thread): resolve the container, open the file and parse the header.
+	/// Containers that need the renderer to be parsed (svt, platform formats) are left for load_texture.
+	static UploadFunctionResult decode_texture(const TextureLoadDesc* pTextureDesc, TextureLoadState* pState)
+	{
+		if (!pTextureDesc->fileName)
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+		TextureContainerType container = pTextureDesc->container;
+		static const char* extensions[] = { nullptr, "dds", "ktx", "gnf", "basis", "svt", "ktx2" };
+
+		// find the texture format's extension that we use
+		if (SG_TEXTURE_CONTAINER_DEFAULT == container)
+		{
+	#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
+			container = SG_TEXTURE_CONTAINER_KTX;
+	#elif defined(SG_PLATFORM_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
+			container = SG_TEXTURE_CONTAINER_DDS;
+	#elif defined(ORBIS) || defined(PROSPERO)
+			container = SG_TEXTURE_CONTAINER_GNF;
 	#endif
-				break;
+		}
+
+		pState->textureDesc.name = pTextureDesc->fileName;
+
+		// validate that we have found the file format now
+		ASSERT(container != SG_TEXTURE_CONTAINER_DEFAULT);
+		if (SG_TEXTURE_CONTAINER_DEFAULT == container)
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+		// append the extension to the name
+		sgfs_append_path_extension(pTextureDesc->fileName, extensions[container], pState->fileName);
+		pState->container = container;
+
+		FileStream stream = {};
+		bool success = false;
+
+		switch (container)
+		{
+		case SG_TEXTURE_CONTAINER_DDS:
+		{
+	#if !defined(XBOX)
+			success = sgfs_open_stream_from_path(SG_RD_TEXTURES, pState->fileName, SG_FM_READ_BINARY, &stream);
+			if (success)
+			{
+				success = load_dds_texture(&stream, &pState->textureDesc);
+			}
+	#endif
+			break;
+		}
+		case SG_TEXTURE_CONTAINER_KTX:
+		{
+			success = sgfs_open_stream_from_path(SG_RD_TEXTURES, pState->fileName, SG_FM_READ_BINARY, &stream);
+			if (success)
+			{
+				success = load_ktx_texture(&stream, &pState->textureDesc);
+				pState->updateDesc.mipsAfterSlice = true;
+				// KTX stores mip size before the mip data
+				// This function gets called to skip the mip size so we read the mip data
+				pState->updateDesc.preMipFunc = [](FileStream* pStream, uint32_t)
+				{
+					uint32_t mipSize = 0;
+					sgfs_read_from_stream(pStream, &mipSize, sizeof(mipSize));
+				};
 			}
-			case SG_TEXTURE_CONTAINER_KTX:
+			break;
+		}
+		case SG_TEXTURE_CONTAINER_BASIS:
+		case SG_TEXTURE_CONTAINER_KTX2:
+		{
+			// the texels are inflated / transcoded right here on the worker, the update then reads them from memory
+			void* data = nullptr;
+			uint32_t dataSize = 0;
+			const GPUCapBits* pCapBits = pResourceLoader->pRenderer->pCapBits;
+			success = sgfs_open_stream_from_path(SG_RD_TEXTURES, pState->fileName, SG_FM_READ_BINARY, &stream);
+			if (success)
 			{
-				success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
+				success = SG_TEXTURE_CONTAINER_KTX2 == container ?
+					load_ktx2_texture(&stream, &pState->textureDesc, pCapBits, &data, &dataSize) :
+					load_basis_texture(&stream, &pState->textureDesc, pCapBits, &data, &dataSize);
+				sgfs_close_stream(&stream);
+				stream = {};
 				if (success)
 				{
-					success = load_ktx_texture(&stream, &textureDesc);
-					updateDesc.mipsAfterSlice = true;
-					// KTX stores mip size before the mip data
-					// This function gets called to skip the mip size so we read the mip data
-					updateDesc.preMipFunc = [](FileStream* pStream, uint32_t)
-					{
-						uint32_t mipSize = 0;
-						sgfs_read_from_stream(pStream, &mipSize, sizeof(mipSize));
-					};
+					success = sgfs_open_stream_from_memory(data, dataSize, SG_FM_READ_BINARY, true, &stream);
+					pState->updateDesc.mipsAfterSlice = SG_TEXTURE_CONTAINER_KTX2 == container;
 				}
-				break;
-			}
-			//case SG_TEXTURE_CONTAINER_BASIS:
-			//{
-			//	void* data = nullptr;
-			//	uint32_t dataSize = 0;
-			//	success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
-			//	if (success)
-			//	{
-			//		//success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
-			//		if (success)
-			//		{
-			//			sgfs_close_stream(&stream);
-			//			sgfs_open_stream_from_memory(data, dataSize, SG_FM_READ_BINARY, true, &stream);
-			//		}
-			//	}
-			//	break;
-			//}
-	//		case SG_TEXTURE_CONTAINER_GNF:
-	//		{
-	//#if defined(ORBIS) || defined(PROSPERO)
-	//			success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
-	//			uint32_t res = 1;
-	//			if (success)
-	//			{
-	//				extern uint32_t loadGnfTexture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags, Texture * *ppTexture);
-	//				res = loadGnfTexture(pRenderer, &stream, fileName, pTextureDesc->mCreationFlag, pTextureDesc->ppTexture);
-	//				sgfs_close_stream(&stream);
-	//			}
-
-	//			return res ? SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-	//#endif
-	//		}
-			default:
-				break;
 			}
+			break;
+		}
+		default:
+			break;
+		}
 
-			if (success)
+		if (success)
+		{
+			if (pState->pStreamed)
+			{
+				apply_texture_streaming(pState->pStreamed, pState);
+			}
+			else if (SG_MIP_FILTER_NONE != pTextureDesc->mipFilter)
 			{
-				textureDesc.startState = SG_RESOURCE_STATE_COMMON;
-				textureDesc.flags |= pTextureDesc->creationFlag;
-				textureDesc.nodeIndex = pTextureDesc->nodeIndex;
+				util_prepare_mip_generation(pTextureDesc, pState);
+			}
+			pState->updateDesc.stream = stream;
+			pState->decoded = true;
+		}
+		else if (stream.pIO)
+		{
+			sgfs_close_stream(&stream);
+		}
+
+		return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+	}
+
+	/// Reserve stage of a texture load (loader thread): create the texture and reserve the staging range the texels are decoded into
+	static void reserve_texture(Renderer* pRenderer, const TextureLoadDesc* pTextureDesc, TextureLoadState* pState)
+	{
+		if (!pState->decoded)
+		{
+			return;
+		}
+
+		TextureCreateDesc& textureDesc = pState->textureDesc;
+		textureDesc.startState = SG_RESOURCE_STATE_COMMON;
+		textureDesc.flags |= pTextureDesc->creationFlag;
+		textureDesc.nodeIndex = pTextureDesc->nodeIndex;
 	#if defined (SG_GRAPHIC_API_VULKAN)
-				if (nullptr != pTextureDesc->desc)
-					textureDesc.pVkSamplerYcbcrConversionInfo = pTextureDesc->desc->pVkSamplerYcbcrConversionInfo;
+		if (nullptr != pTextureDesc->desc)
+			textureDesc.pVkSamplerYcbcrConversionInfo = pTextureDesc->desc->pVkSamplerYcbcrConversionInfo;
 	#endif
-				add_texture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
+		add_texture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
+
+		// the first load of a streamed texture creates the user's texture, later loads go to the pending texture
+		StreamedTexture* pStreamed = pState->pStreamed;
+		if (pStreamed && !pStreamed->pTexture)
+		{
+			MutexLock lck(pResourceLoader->streamingMutex);
+			pStreamed->pTexture = *pTextureDesc->ppTexture;
+			pResourceLoader->streamedTextureMap[pStreamed->pTexture] = pStreamed;
+		}
+
+		TextureUpdateDescInternal& updateDesc = pState->updateDesc;
+		updateDesc.pTexture = *pTextureDesc->ppTexture;
+		updateDesc.baseMipLevel = 0;
+		updateDesc.mipLevels = textureDesc.mipLevels;
+		updateDesc.baseArrayLayer = 0;
+		updateDesc.layerCount = textureDesc.arraySize;
+		updateDesc.range = allocate_staging_memory(&pResourceLoader->pCopyEngines[pTextureDesc->nodeIndex], util_get_texture_update_size(pRenderer, updateDesc),
+			util_get_texture_subresource_alignment(pRenderer, (TinyImageFormat)textureDesc.format));
+	}
 
-				updateDesc.stream = stream;
-				updateDesc.pTexture = *pTextureDesc->ppTexture;
-				updateDesc.baseMipLevel = 0;
-				updateDesc.mipLevels = textureDesc.mipLevels;
-				updateDesc.baseArrayLayer = 0;
-				updateDesc.layerCount = textureDesc.arraySize;
+	/// Fill stage of a texture load (worker thread): stream the texels into the reserved staging range
+	static UploadFunctionResult fill_texture(Renderer* pRenderer, TextureLoadState* pState)
+	{
+		if (!pState->decoded)
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+		}
+
+		if (SG_MIP_FILTER_NONE == pState->mipFilter)
+		{
+			return fill_texture_staging(pRenderer, pState->updateDesc) ? SG_UPLOAD_FUNCTION_RESULT_COMPLETED : SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+		// the file only holds the first mip, read it into place and filter the rest of the chain from it
+		TextureUpdateDescInternal& updateDesc = pState->updateDesc;
+		const uint32_t mipLevels = updateDesc.mipLevels;
+		updateDesc.mipLevels = 1;
+		bool success = fill_texture_staging(pRenderer, updateDesc);
+		updateDesc.mipLevels = mipLevels;
+		if (!success)
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+		const uint32_t subresourceCount = mipLevels * updateDesc.layerCount;
+		eastl::vector<uint8_t*> levels(subresourceCount);
+		eastl::vector<uint32_t> rowPitches(subresourceCount);
+		uint8_t* pData = updateDesc.range.pData;
+		util_for_each_texture_subresource(pRenderer, updateDesc, nullptr, [&levels, &rowPitches, pData, mipLevels](const TextureSubresourceLayout& layout)
+		{
+			levels[layout.arrayLayer * mipLevels + layout.mipLevel] = pData + layout.offset;
+			rowPitches[layout.arrayLayer * mipLevels + layout.mipLevel] = layout.rowPitch;
+			return true;
+		});
+
+		const TextureCreateDesc& textureDesc = pState->textureDesc;
+		MipChainDesc mipDesc = {};
+		mipDesc.ppLevels = levels.data();
+		mipDesc.pRowPitches = rowPitches.data();
+		mipDesc.width = textureDesc.width;
+		mipDesc.height = textureDesc.height;
+		mipDesc.levelCount = mipLevels;
+		mipDesc.layerCount = updateDesc.layerCount;
+		util_get_mip_texel_type(textureDesc.format, &mipDesc.texelType, &mipDesc.channelCount);
+		mipDesc.filter = pState->mipFilter;
+		mipDesc.flags = pState->mipFlags;
+		mipDesc.cubemap = (textureDesc.descriptors & SG_DESCRIPTOR_TYPE_TEXTURE_CUBE) != 0;
+		return generate_mip_chain(&mipDesc) ? SG_UPLOAD_FUNCTION_RESULT_COMPLETED : SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+	}
+
+	static UploadFunctionResult load_texture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureLoadDesc* pTextureDesc, TextureLoadState* pState)
+	{
+		// texels are already in the staging memory, record the copies
+		if (pState->decoded)
+		{
+			return update_texture(pRenderer, pCopyEngine, activeSet, pState->updateDesc);
+		}
+
+		FileStream stream = {};
+		const char* fileName = pState->fileName;
+		TextureCreateDesc& textureDesc = pState->textureDesc;
+		bool success = false;
+		UNREF_PARAM(success);
 
-				return update_texture(pRenderer, pCopyEngine, activeSet, updateDesc);
+	#if defined(XBOX)
+		if (SG_TEXTURE_CONTAINER_DDS == pState->container)
+		{
+			success = sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream);
+			uint32_t res = 1;
+			if (success)
+			{
+				extern uint32_t load_dds_texture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags, Texture * *ppTexture);
+				res = load_dds_texture(pRenderer, &stream, fileName, pTextureDesc->creationFlag, pTextureDesc->ppTexture);
+				sgfs_close_stream(&stream);
 			}
 
-			// Sparse Textures
+			return res ? SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+		}
+	#endif
+
+		// Sparse Textures
 	#if defined(SG_GRAPHIC_API_D3D12) || defined(SG_GRAPHIC_API_VULKAN)
-			if (SG_TEXTURE_CONTAINER_SVT == container)
+		if (SG_TEXTURE_CONTAINER_SVT == pState->container)
+		{
+			if (sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream))
 			{
-				if (sgfs_open_stream_from_path(SG_RD_TEXTURES, fileName, SG_FM_READ_BINARY, &stream))
+				success = load_svt_texture(&stream, &textureDesc);
+				if (success)
 				{
-					success = load_svt_texture(&stream, &textureDesc);
-					if (success)
-					{
-						ssize_t dataSize = sgfs_get_stream_file_size(&stream) - sgfs_get_offset_stream_position(&stream);
-						void* data = sg_malloc(dataSize);
-						sgfs_read_from_stream(&stream, data, dataSize);
-
-						textureDesc.startState = SG_RESOURCE_STATE_COPY_DEST;
-						textureDesc.flags |= pTextureDesc->creationFlag;
-						textureDesc.nodeIndex = pTextureDesc->nodeIndex;
-						//add_virtual_texture(acquire_cmd(pCopyEngine, activeSet), &textureDesc, pTextureDesc->ppTexture, data);
-						// Create visibility buffer
-						eastl::vector<VirtualTexturePage>* pPageTable = (eastl::vector<VirtualTexturePage>*)(*pTextureDesc->ppTexture)->pSvt->pPages;
-
-						if (pPageTable == nullptr)
-							return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-
-						BufferLoadDesc visDesc = {};
-						visDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER; // UAV
-						visDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
-						visDesc.desc.structStride = sizeof(unsigned int);
-						visDesc.desc.elementCount = (uint64_t)pPageTable->size();
-						visDesc.desc.size = visDesc.desc.structStride * visDesc.desc.elementCount;
-						visDesc.desc.startState = SG_RESOURCE_STATE_COMMON;
-						visDesc.desc.name = "Vis Buffer for Sparse Texture";
-						visDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->visibility;
-						add_resource(&visDesc, nullptr);
-
-						BufferLoadDesc prevVisDesc = {};
-						prevVisDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
-						prevVisDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
-						prevVisDesc.desc.structStride = sizeof(unsigned int);
-						prevVisDesc.desc.elementCount = (uint64_t)pPageTable->size();
-						prevVisDesc.desc.size = prevVisDesc.desc.structStride * prevVisDesc.desc.elementCount;
-						prevVisDesc.desc.startState = SG_RESOURCE_STATE_COMMON;
-						prevVisDesc.desc.name = "Prev Vis Buffer for Sparse Texture";
-						prevVisDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->prevVisibility;
-						add_resource(&prevVisDesc, nullptr);
-
-						BufferLoadDesc alivePageDesc = {};
-						alivePageDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
-						alivePageDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+					ssize_t dataSize = sgfs_get_stream_file_size(&stream) - sgfs_get_offset_stream_position(&stream);
+					void* data = sg_malloc(dataSize);
+					sgfs_read_from_stream(&stream, data, dataSize);
+
+					textureDesc.startState = SG_RESOURCE_STATE_COPY_DEST;
+					textureDesc.flags |= pTextureDesc->creationFlag;
+					textureDesc.nodeIndex = pTextureDesc->nodeIndex;
+					//add_virtual_texture(acquire_cmd(pCopyEngine, activeSet), &textureDesc, pTextureDesc->ppTexture, data);
+					// Create visibility buffer
+					eastl::vector<VirtualTexturePage>* pPageTable = (eastl::vector<VirtualTexturePage>*)(*pTextureDesc->ppTexture)->pSvt->pPages;
+
+					if (pPageTable == nullptr)
+						return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+
+					BufferLoadDesc visDesc = {};
+					visDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER; // UAV
+					visDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+					visDesc.desc.structStride = sizeof(unsigned int);
+					visDesc.desc.elementCount = (uint64_t)pPageTable->size();
+					visDesc.desc.size = visDesc.desc.structStride * visDesc.desc.elementCount;
+					visDesc.desc.startState = SG_RESOURCE_STATE_COMMON;
+					visDesc.desc.name = "Vis Buffer for Sparse Texture";
+					visDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->visibility;
+					add_resource(&visDesc, nullptr);
+
+					BufferLoadDesc prevVisDesc = {};
+					prevVisDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
+					prevVisDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+					prevVisDesc.desc.structStride = sizeof(unsigned int);
+					prevVisDesc.desc.elementCount = (uint64_t)pPageTable->size();
+					prevVisDesc.desc.size = prevVisDesc.desc.structStride * prevVisDesc.desc.elementCount;
+					prevVisDesc.desc.startState = SG_RESOURCE_STATE_COMMON;
+					prevVisDesc.desc.name = "Prev Vis Buffer for Sparse Texture";
+					prevVisDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->prevVisibility;
+					add_resource(&prevVisDesc, nullptr);
+
+					BufferLoadDesc alivePageDesc = {};
+					alivePageDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
+					alivePageDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 	#if defined(SG_GRAPHIC_API_D3D12)			  
-						alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#elif defined(SG_GRAPHIC_API_VULKAN)	
-						alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+					alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
 	#else							  	  
-						alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					alivePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#endif							  
-						alivePageDesc.desc.structStride = sizeof(unsigned int);
-						alivePageDesc.desc.elementCount = (uint64_t)pPageTable->size();
-						alivePageDesc.desc.size = alivePageDesc.desc.structStride * alivePageDesc.desc.elementCount;
-						alivePageDesc.desc.name = "Alive pages buffer for Sparse Texture";
-						alivePageDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->alivePage;
-						add_resource(&alivePageDesc, nullptr);
-
-						BufferLoadDesc removePageDesc = {};
-						removePageDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
-						removePageDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+					alivePageDesc.desc.structStride = sizeof(unsigned int);
+					alivePageDesc.desc.elementCount = (uint64_t)pPageTable->size();
+					alivePageDesc.desc.size = alivePageDesc.desc.structStride * alivePageDesc.desc.elementCount;
+					alivePageDesc.desc.name = "Alive pages buffer for Sparse Texture";
+					alivePageDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->alivePage;
+					add_resource(&alivePageDesc, nullptr);
+
+					BufferLoadDesc removePageDesc = {};
+					removePageDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
+					removePageDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 	#if defined(SG_GRAPHIC_API_D3D12)
-						removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#elif defined(SG_GRAPHIC_API_VULKAN)
-						removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+					removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
 	#else
-						removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					removePageDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#endif
-						removePageDesc.desc.structStride = sizeof(unsigned int);
-						removePageDesc.desc.elementCount = (uint64_t)pPageTable->size();
-						removePageDesc.desc.size = removePageDesc.desc.structStride * removePageDesc.desc.elementCount;
-						removePageDesc.desc.name = "Remove pages buffer for Sparse Texture";
-						removePageDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->removePage;
-						add_resource(&removePageDesc, nullptr);
-
-						BufferLoadDesc pageCountsDesc = {};
-						pageCountsDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
-						pageCountsDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+					removePageDesc.desc.structStride = sizeof(unsigned int);
+					removePageDesc.desc.elementCount = (uint64_t)pPageTable->size();
+					removePageDesc.desc.size = removePageDesc.desc.structStride * removePageDesc.desc.elementCount;
+					removePageDesc.desc.name = "Remove pages buffer for Sparse Texture";
+					removePageDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->removePage;
+					add_resource(&removePageDesc, nullptr);
+
+					BufferLoadDesc pageCountsDesc = {};
+					pageCountsDesc.desc.descriptors = SG_DESCRIPTOR_TYPE_RW_BUFFER;
+					pageCountsDesc.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 	#if defined(SG_GRAPHIC_API_D3D12)
-						pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#elif defined(SG_GRAPHIC_API_VULKAN)
-						pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+					pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
 	#else
-						pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
+					pageCountsDesc.desc.flags = SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | SG_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	#endif
-						pageCountsDesc.desc.structStride = sizeof(unsigned int);
-						pageCountsDesc.desc.elementCount = 4;
-						pageCountsDesc.desc.size = pageCountsDesc.desc.structStride * pageCountsDesc.desc.elementCount;
-						pageCountsDesc.desc.name = "Page count buffer for Sparse Texture";
-						pageCountsDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->pageCounts;
-						add_resource(&pageCountsDesc, nullptr);
+					pageCountsDesc.desc.structStride = sizeof(unsigned int);
+					pageCountsDesc.desc.elementCount = 4;
+					pageCountsDesc.desc.size = pageCountsDesc.desc.structStride * pageCountsDesc.desc.elementCount;
+					pageCountsDesc.desc.name = "Page count buffer for Sparse Texture";
+					pageCountsDesc.ppBuffer = &(*pTextureDesc->ppTexture)->pSvt->pageCounts;
+					add_resource(&pageCountsDesc, nullptr);
 
-						sgfs_close_stream(&stream);
+					sgfs_close_stream(&stream);
 
-						return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-					}
+					return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
 				}
-
-				return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 			}
-	#endif
+
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 		}
+	#endif
 
 		return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 	}
@@ -1084,6 +1848,12 @@ namespace SG
 		// copy the data from the src buffer to dst buffer
 		cmd_update_buffer(pCmd, pBuffer, bufUpdateDesc.dstOffset, range.pBuffer, range.offset, range.size);
 
+		// buffers have no layout, they only need a barrier to change the queue family that owns them
+		if (pCopyEngine->ownershipTransfer)
+		{
+			util_hand_over_buffer(pCopyEngine, activeSet, BufferBarrier{ pBuffer, SG_RESOURCE_STATE_COPY_DEST, util_get_uploaded_buffer_state(pBuffer) });
+		}
+
 		return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
 	}
 
@@ -1161,1987 +1931,5899 @@ namespace SG
 		}
 	}
 
-	static UploadFunctionResult load_geometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
+	static void util_pack_float3_direction_to_oct16(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
 	{
-		GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
+		pack_float3_direction_to_oct16(count, srcStride, dstStride, src, dst);
+	}
 
-		char iext[SG_MAX_FILEPATH] = { 0 };
-		sgfs_get_path_extension(pDesc->fileName, iext);
+	/// Select the kernel which packs a float attribute into dstFormat, nullptr if there is no such conversion
+	static PackingFunction util_select_vertex_packing(cgltf_attribute_type type, TinyImageFormat srcFormat, TinyImageFormat dstFormat)
+	{
+		if (!TinyImageFormat_IsFloat(srcFormat) || TinyImageFormat_BitSizeOfBlock(srcFormat) != 32 * TinyImageFormat_ChannelCount(srcFormat))
+			return nullptr;
+
+		const uint32_t srcChannels = TinyImageFormat_ChannelCount(srcFormat);
+		const uint32_t dstChannels = TinyImageFormat_ChannelCount(dstFormat);
+		const uint32_t dstBits = TinyImageFormat_BitSizeOfBlock(dstFormat);
+
+		// Directions - Pack float3 to float2 to unorm2x16 (Normal, Tangent)
+		if ((cgltf_attribute_type_normal == type || cgltf_attribute_type_tangent == type) &&
+			srcChannels >= 3 && 2 == dstChannels && 32 == dstBits && TinyImageFormat_IsNormalised(dstFormat))
+			return util_pack_float3_direction_to_oct16;
+
+		if (srcChannels != dstChannels)
+			return nullptr;
+
+		if (TinyImageFormat_IsFloat(dstFormat) && 16 * dstChannels == dstBits)
+			return pack_float_to_half;
+		if (TinyImageFormat_IsNormalised(dstFormat) && 16 * dstChannels == dstBits)
+			return TinyImageFormat_IsSigned(dstFormat) ? pack_float_to_snorm16 : pack_float_to_unorm16;
+		if (TinyImageFormat_IsNormalised(dstFormat) && 8 * dstChannels == dstBits)
+			return TinyImageFormat_IsSigned(dstFormat) ? pack_float_to_snorm8 : pack_float_to_unorm8;
+		return nullptr;
+	}
 
-		// Geometry in gltf container
-		if (iext[0] != 0 && (stricmp(iext, "gltf") == 0 || stricmp(iext, "glb") == 0))
+	/// Entries of the FIFO cache the optimization report simulates, about the size of the post-transform cache of current GPUs
+	#define SG_GEOMETRY_REPORT_CACHE_SIZE 16
+
+	/// Read the positions of all the primitives as float3 into the vertex order given by remap (nullptr keeps the gltf order)
+	static float* util_gather_geometry_positions(const cgltf_data* data, const uint32_t* remap, uint32_t vertexCount)
+	{
+		float* positions = (float*)sg_calloc(vertexCount, sizeof(float[3]));
+		uint32_t primVertexStart = 0;
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
 		{
-			FileStream file = {};
-			if (!sgfs_open_stream_from_path(SG_RD_MESHES, pDesc->fileName, SG_FM_READ_BINARY, &file))
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 			{
-				SG_LOG_ERROR("Failed to open gltf file %s", pDesc->fileName);
-				ASSERT(false);
-				return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-			}
-
-			ssize_t fileSize = sgfs_get_stream_file_size(&file);
-			void* fileData = sg_malloc(fileSize);
-			cgltf_result result = cgltf_result_invalid_gltf;
-
-			sgfs_read_from_stream(&file, fileData, fileSize);
+				const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+				for (uint32_t a = 0; a < prim->attributes_count; ++a)
+				{
+					const cgltf_attribute* attr = &prim->attributes[a];
+					if (cgltf_attribute_type_position != attr->type)
+						continue;
 
-			cgltf_options options = {};
-			cgltf_data* data = nullptr;
-			// use seagull memory allocation
-			options.memory.alloc = [](void* user, cgltf_size size) { return sg_malloc(size); };
-			options.memory.free = [](void* user, void* ptr) { sg_free(ptr); };
-			result = cgltf_parse(&options, fileData, fileSize, &data);
+					for (uint32_t e = 0; e < attr->data->count; ++e)
+					{
+						const uint32_t vertex = remap ? remap[primVertexStart + e] : primVertexStart + e;
+						if (UINT32_MAX != vertex)
+							cgltf_accessor_read_float(attr->data, e, positions + vertex * 3, 3);
+					}
+				}
+				primVertexStart += (uint32_t)prim->attributes->data->count;
+			}
+		}
+		return positions;
+	}
 
-			sgfs_close_stream(&file);
+	/// Run the optimizations requested by the load flags on the CPU.
+	/// The optimized indices and the vertex remap are kept in the load state for fill_geometry, returns the new vertex count
+	static uint32_t util_optimize_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState, uint32_t indexCount, uint32_t vertexCount)
+	{
+		const cgltf_data* data = pState->pData;
+		const GeometryLoadFlags flags = pDesc->flags;
 
-			if (cgltf_result_success != result)
+		uint32_t* indices = (uint32_t*)sg_malloc(indexCount * sizeof(uint32_t));
+		uint32_t primIndexStart = 0;
+		uint32_t primVertexStart = 0;
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
+		{
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 			{
-				SG_LOG_ERROR("Failed to parse gltf file %s with error %u", pDesc->fileName, (uint32_t)result);
-				ASSERT(false);
-				sg_free(fileData);
-				return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+				const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+				for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
+					indices[primIndexStart + idx] = primVertexStart + (uint32_t)cgltf_accessor_read_index(prim->indices, idx);
+				primIndexStart += (uint32_t)prim->indices->count;
+				primVertexStart += (uint32_t)prim->attributes->data->count;
 			}
+		}
 
-	#if defined(SG_DEBUG)
-			result = cgltf_validate(data);
-			if (cgltf_result_success != result)
-			{
-				SG_LOG_WARNING("GLTF validation finished with error %u for file %s", (uint32_t)result, pDesc->fileName);
-			}
-	#endif
+		const VertexCacheStatistics statsBefore = analyze_vertex_cache(indices, indexCount, vertexCount, SG_GEOMETRY_REPORT_CACHE_SIZE);
+		uint32_t* remap = nullptr;
+		uint32_t optimizedVertexCount = vertexCount;
 
-			// Load buffers located in separate files (.bin) using our file system
-			for (uint32_t i = 0; i < data->buffers_count; ++i)
+		if (flags & SG_GEOMETRY_LOAD_FLAG_DEDUPLICATE_VERTICES)
+		{
+			// Compare the attributes the vertex layout uses and the position, which the shadow copy and the overdraw sort read
+			uint32_t keyOffsets[SG_SEMANTIC_TEXCOORD9 + 1] = {};
+			uint32_t keySizes[SG_SEMANTIC_TEXCOORD9 + 1] = {};
+			for (uint32_t i = 0; i < data->meshes_count; ++i)
 			{
-				const char* uri = data->buffers[i].uri;
-
-				if (!uri || data->buffers[i].data)
-				{
-					continue;
-				}
-
-				if (strncmp(uri, "data:", 5) != 0 && !strstr(uri, "://"))
+				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 				{
-					char parent[SG_MAX_FILEPATH] = { 0 };
-					sgfs_get_parent_path(pDesc->fileName, parent);
-					char path[SG_MAX_FILEPATH] = { 0 };
-					sgfs_append_path_component(parent, uri, path);
-					FileStream fs = {};
-					if (sgfs_open_stream_from_path(SG_RD_MESHES, path, SG_FM_READ_BINARY, &fs))
+					const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+					for (uint32_t a = 0; a < prim->attributes_count; ++a)
 					{
-						ASSERT(sgfs_get_stream_file_size(&fs) >= (ssize_t)data->buffers[i].size);
-						data->buffers[i].data = sg_malloc(data->buffers[i].size);
-						sgfs_read_from_stream(&fs, data->buffers[i].data, data->buffers[i].size);
+						const cgltf_attribute* attr = &prim->attributes[a];
+						const uint32_t index = util_cgltf_attrib_type_to_shader_semantic(attr->type, attr->index);
+						if (pState->vertexOffsets[index] != UINT_MAX || SG_SEMANTIC_POSITION == index)
+							keySizes[index] = eastl::max(keySizes[index], (uint32_t)cgltf_calc_size(attr->data->type, attr->data->component_type));
 					}
-					sgfs_close_stream(&fs);
 				}
 			}
 
-			result = cgltf_load_buffers(&options, data, pDesc->fileName);
-			if (cgltf_result_success != result)
+			uint32_t keySize = 0;
+			for (uint32_t i = 0; i < SG_SEMANTIC_TEXCOORD9 + 1; ++i)
 			{
-				SG_LOG_ERROR("Failed to load buffers from gltf file %s with error %u", pDesc->fileName, (uint32_t)result);
-				ASSERT(false);
-				sg_free(fileData);
-				return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+				keyOffsets[i] = keySize;
+				keySize += keySizes[i];
 			}
 
-			typedef void (*PackingFunction)(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst);
-
-			uint32_t vertexStrides[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			uint32_t vertexAttribCount[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			uint32_t vertexOffsets[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			uint32_t vertexBindings[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			cgltf_attribute* vertexAttribs[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			PackingFunction vertexPacking[SG_SEMANTIC_TEXCOORD9 + 1] = {};
-			for (uint32_t i = 0; i < SG_SEMANTIC_TEXCOORD9 + 1; ++i)
-				vertexOffsets[i] = UINT_MAX;
-
-			uint32_t indexCount = 0;
-			uint32_t vertexCount = 0;
-			uint32_t drawCount = 0;
-			uint32_t jointCount = 0;
-			uint32_t vertexBufferCount = 0;
-
-			// Find number of traditional draw calls required to draw this piece of geometry
-			// Find total index count, total vertex count
+			uint8_t* keys = (uint8_t*)sg_calloc(vertexCount, keySize);
+			primVertexStart = 0;
 			for (uint32_t i = 0; i < data->meshes_count; ++i)
 			{
 				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 				{
 					const cgltf_primitive* prim = &data->meshes[i].primitives[p];
-					indexCount += (uint32_t)prim->indices->count;
-					vertexCount += (uint32_t)prim->attributes->data->count;
-					++drawCount;
-
-					for (uint32_t i = 0; i < prim->attributes_count; ++i)
-						vertexAttribs[util_cgltf_attrib_type_to_shader_semantic(prim->attributes[i].type, prim->attributes[i].index)] = &prim->attributes[i];
+					for (uint32_t a = 0; a < prim->attributes_count; ++a)
+					{
+						const cgltf_attribute* attr = &prim->attributes[a];
+						const uint32_t index = util_cgltf_attrib_type_to_shader_semantic(attr->type, attr->index);
+						if (!keySizes[index])
+							continue;
+
+						const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
+						const uint32_t elementSize = (uint32_t)cgltf_calc_size(attr->data->type, attr->data->component_type);
+						for (uint32_t e = 0; e < attr->data->count; ++e)
+							memcpy(keys + (size_t)(primVertexStart + e) * keySize + keyOffsets[index], src + e * attr->data->stride, elementSize);
+					}
+					primVertexStart += (uint32_t)prim->attributes->data->count;
 				}
 			}
 
-			// Determine vertex stride for each binding
-			for (uint32_t i = 0; i < pDesc->pVertexLayout->attribCount; ++i)
-			{
-				const VertexAttrib* attr = &pDesc->pVertexLayout->attribs[i];
-				const cgltf_attribute* cgltfAttr = vertexAttribs[attr->semantic];
-				ASSERT(cgltfAttr);
-
-				const uint32_t dstFormatSize = TinyImageFormat_BitSizeOfBlock(attr->format) >> 3;
-				const uint32_t srcFormatSize = (uint32_t)cgltfAttr->data->stride;
-
-				vertexStrides[attr->binding] += dstFormatSize ? dstFormatSize : srcFormatSize;
-				vertexOffsets[attr->semantic] = attr->offset;
-				vertexBindings[attr->semantic] = attr->binding;
-				++vertexAttribCount[attr->binding];
+			remap = (uint32_t*)sg_malloc(vertexCount * sizeof(uint32_t));
+			optimizedVertexCount = generate_vertex_remap(remap, indices, indexCount, keys, vertexCount, keySize);
+			remap_index_buffer(indices, indexCount, remap);
+			sg_free(keys);
+		}
 
-				// Compare vertex attrib format to the gltf attrib type
-				// Select a packing function if dst format is packed version
-				// Texcoords - Pack float2 to half2
-				// Directions - Pack float3 to float2 to unorm2x16 (Normal, Tangent)
-				// Position - No packing yet
-				const TinyImageFormat srcFormat = util_cgltf_type_to_image_format(cgltfAttr->data->type, cgltfAttr->data->component_type);
-				const TinyImageFormat dstFormat = attr->format == TinyImageFormat_UNDEFINED ? srcFormat : attr->format;
+		// The triangle reorderings stay inside of every draw, so the draw arguments remain valid
+		if (flags & (SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_CACHE | SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_OVERDRAW))
+		{
+			float* positions = nullptr;
+			if (flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_OVERDRAW)
+				positions = util_gather_geometry_positions(data, remap, optimizedVertexCount);
 
-				if (dstFormat != srcFormat)
+			primIndexStart = 0;
+			for (uint32_t i = 0; i < data->meshes_count; ++i)
+			{
+				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 				{
-					// Select appropriate packing function which will be used when filling the vertex buffer
-					switch (cgltfAttr->type)
-					{
-					case cgltf_attribute_type_texcoord:
-					{
-						if (sizeof(uint32_t) == dstFormatSize && sizeof(float[2]) == srcFormatSize)
-							vertexPacking[attr->semantic] = util_pack_float2_to_half2;
-						// #TODO: Add more variations if needed
-						break;
-					}
-					case cgltf_attribute_type_normal:
-					case cgltf_attribute_type_tangent:
-					{
-						if (sizeof(uint32_t) == dstFormatSize && (sizeof(float[3]) == srcFormatSize || sizeof(float[4]) == srcFormatSize))
-							vertexPacking[attr->semantic] = util_pack_float3_direction_to_half2;
-						// #TODO: Add more variations if needed
-						break;
-					}
-					default:
-						break;
-					}
+					const uint32_t primIndexCount = (uint32_t)data->meshes[i].primitives[p].indices->count;
+					uint32_t* primIndices = indices + primIndexStart;
+					if (flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_CACHE)
+						optimize_vertex_cache(primIndices, primIndices, primIndexCount, optimizedVertexCount);
+					if (flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_OVERDRAW)
+						optimize_overdraw(primIndices, primIndices, primIndexCount, positions, sizeof(float[3]), optimizedVertexCount, 1.05f);
+					primIndexStart += primIndexCount;
 				}
 			}
+			sg_free(positions);
+		}
 
-			// determine number of vertex buffers needed based on number of unique bindings found
-			// for each unique binding the vertex stride will be non zero
-			for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
-				if (vertexStrides[i])
-					++vertexBufferCount;
-
-			for (uint32_t i = 0; i < data->skins_count; ++i)
-				jointCount += (uint32_t)data->skins[i].joints_count;
+		if (flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_FETCH)
+		{
+			uint32_t* fetchRemap = (uint32_t*)sg_malloc(optimizedVertexCount * sizeof(uint32_t));
+			const uint32_t fetchVertexCount = optimize_vertex_fetch_remap(fetchRemap, indices, indexCount, optimizedVertexCount);
+			remap_index_buffer(indices, indexCount, fetchRemap);
+			if (remap)
+			{
+				for (uint32_t v = 0; v < vertexCount; ++v)
+					remap[v] = UINT32_MAX == remap[v] ? UINT32_MAX : fetchRemap[remap[v]];
+				sg_free(fetchRemap);
+			}
+			else
+			{
+				remap = fetchRemap;
+			}
+			optimizedVertexCount = fetchVertexCount;
+		}
 
-			// Determine index stride
-			// This depends on vertex count rather than the stride specified in gltf
-			// since gltf assumes we have index buffer per primitive which is non optimal
-			const uint32_t indexStride = vertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+		if (flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZATION_REPORT)
+		{
+			const VertexCacheStatistics statsAfter = analyze_vertex_cache(indices, indexCount, optimizedVertexCount, SG_GEOMETRY_REPORT_CACHE_SIZE);
+			SG_LOG_INFO("Optimized geometry %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, vertices %u -> %u, vertex shader invocations %u -> %u",
+				pDesc->fileName, statsBefore.acmr, statsAfter.acmr, statsBefore.atvr, statsAfter.atvr,
+				vertexCount, optimizedVertexCount, statsBefore.verticesTransformed, statsAfter.verticesTransformed);
+		}
 
-			uint32_t totalSize = 0;
-			totalSize += round_up(sizeof(Geometry), 16);
-			totalSize += round_up(drawCount * sizeof(IndirectDrawIndexArguments), 16);
-			totalSize += round_up(jointCount * sizeof(Matrix4), 16);
-			totalSize += round_up(jointCount * sizeof(uint32_t), 16);
+		pState->pIndices = indices;
+		pState->pVertexRemap = remap;
+		return optimizedVertexCount;
+	}
 
-			Geometry* geom = (Geometry*)sg_calloc(1, totalSize);
-			ASSERT(geom);
+	/// Allocate a Geometry with its draw arguments (drawCount for every LOD), joint data and LOD errors in one block
+	static Geometry* util_allocate_geometry(uint32_t drawCount, uint32_t jointCount, uint32_t lodCount)
+	{
+		uint32_t totalSize = 0;
+		totalSize += round_up(sizeof(Geometry), 16);
+		totalSize += round_up(drawCount * lodCount * sizeof(IndirectDrawIndexArguments), 16);
+		totalSize += round_up(jointCount * sizeof(Matrix4), 16);
+		totalSize += round_up(jointCount * sizeof(uint32_t), 16);
+		totalSize += round_up(lodCount * sizeof(float), 16);
+
+		Geometry* geom = (Geometry*)sg_calloc(1, totalSize);
+		ASSERT(geom);
+
+		geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1);
+		geom->pInverseBindPoses = (Matrix4*)((uint8_t*)geom->pDrawArgs + round_up(drawCount * lodCount * sizeof(*geom->pDrawArgs), 16));
+		geom->pJointRemaps = (uint32_t*)((uint8_t*)geom->pInverseBindPoses + round_up(jointCount * sizeof(*geom->pInverseBindPoses), 16));
+		geom->pLodErrors = (float*)((uint8_t*)geom->pJointRemaps + round_up(jointCount * sizeof(*geom->pJointRemaps), 16));
+		return geom;
+	}
 
-			geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1);
-			geom->pInverseBindPoses = (Matrix4*)((uint8_t*)geom->pDrawArgs + round_up(drawCount * sizeof(*geom->pDrawArgs), 16));
-			geom->pJointRemaps = (uint32_t*)((uint8_t*)geom->pInverseBindPoses + round_up(jointCount * sizeof(*geom->pInverseBindPoses), 16));
+	/// Max simplification error of the generated LODs when the load does not give one, relative to the mesh extent
+	#define SG_GEOMETRY_DEFAULT_LOD_ERROR 0.02f
 
-			uint32_t shadowSize = 0;
-			if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+	/// Simplify every draw of the optimized index buffer into coarser levels of detail, appended to pState->pIndices.
+	/// The draw arguments of LOD 1 and up go to lodDrawArgs, returns the new index count
+	static uint32_t util_generate_geometry_lods(GeometryLoadDesc* pDesc, GeometryLoadState* pState, uint32_t indexCount, uint32_t vertexCount,
+		uint32_t drawCount, eastl::vector<IndirectDrawIndexArguments>& lodDrawArgs, float* pLodErrors, uint32_t* pLodCount)
+	{
+		const cgltf_data* data = pState->pData;
+		const uint32_t maxLodCount = eastl::min(pDesc->lodCount, (uint32_t)SG_MAX_GEOMETRY_LODS);
+		const float targetError = pDesc->lodTargetError > 0.0f ? pDesc->lodTargetError : SG_GEOMETRY_DEFAULT_LOD_ERROR;
+		float* positions = util_gather_geometry_positions(data, pState->pVertexRemap, vertexCount);
+
+		eastl::vector<uint32_t> indices(pState->pIndices, pState->pIndices + indexCount);
+		uint32_t previousLodIndexCount = indexCount;
+		uint32_t lodCount = 1;
+		for (uint32_t lod = 1; lod < maxLodCount; ++lod)
+		{
+			// every level is simplified from the full detail draws, so the errors do not add up along the chain
+			const uint32_t lodStart = (uint32_t)indices.size();
+			uint32_t lodIndexCount = 0;
+			float lodError = 0.0f;
+			uint32_t primIndexStart = 0;
+			for (uint32_t i = 0; i < data->meshes_count; ++i)
 			{
-				shadowSize += (uint32_t)vertexAttribs[SG_SEMANTIC_POSITION]->data->stride * vertexCount;
-				shadowSize += indexCount * indexStride;
-
-				geom->pShadow = (Geometry::ShadowData*)sg_calloc(1, sizeof(Geometry::ShadowData) + shadowSize);
-				geom->pShadow->pIndices = geom->pShadow + 1;
-				geom->pShadow->pAttributes[SG_SEMANTIC_POSITION] = (uint8_t*)geom->pShadow->pIndices + (indexCount * indexStride);
-				// #TODO: Add more if needed
+				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
+				{
+					const uint32_t primIndexCount = (uint32_t)data->meshes[i].primitives[p].indices->count;
+					const uint32_t targetIndexCount = (primIndexCount >> lod) / 3 * 3;
+					indices.resize(lodStart + lodIndexCount + primIndexCount);
+
+					uint32_t* lodIndices = indices.data() + lodStart + lodIndexCount;
+					float error = 0.0f;
+					const uint32_t simplifiedIndexCount = simplify_mesh(lodIndices, indices.data() + primIndexStart, primIndexCount,
+						positions, sizeof(float[3]), vertexCount, targetIndexCount, targetError, &error);
+					if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_VERTEX_CACHE)
+						optimize_vertex_cache(lodIndices, lodIndices, simplifiedIndexCount, vertexCount);
+
+					IndirectDrawIndexArguments args = {};
+					args.indexCount = simplifiedIndexCount;
+					args.instanceCount = 1;
+					args.startIndex = lodStart + lodIndexCount;
+					lodDrawArgs.push_back(args);
+
+					lodIndexCount += simplifiedIndexCount;
+					lodError = eastl::max(lodError, error);
+					primIndexStart += primIndexCount;
+				}
 			}
+			indices.resize(lodStart + lodIndexCount);
 
-			geom->vertexBufferCount = vertexBufferCount;
-			geom->drawArgCount = drawCount;
-			geom->indexCount = indexCount;
-			geom->vertexCount = vertexCount;
-			geom->indexType = (sizeof(uint16_t) == indexStride) ? SG_INDEX_TYPE_UINT16 : SG_INDEX_TYPE_UINT32;
-			geom->jointCount = jointCount;
+			// a level which removes less than 10% of the triangles costs more memory than it saves, the next one would not get further
+			if ((uint64_t)lodIndexCount * 10 > (uint64_t)previousLodIndexCount * 9)
+			{
+				indices.resize(lodStart);
+				lodDrawArgs.resize((lod - 1) * drawCount);
+				break;
+			}
 
-			// Allocate buffer memory
-			const bool structuredBuffers = (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_STRUCTURED_BUFFERS);
+			SG_LOG_IF(SG_LOG_LEVEL_INFO, pDesc->flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZATION_REPORT, "Geometry %s LOD %u: %u triangles, error %f",
+				pDesc->fileName, lod, lodIndexCount / 3, lodError);
+			pLodErrors[lod] = lodError;
+			previousLodIndexCount = lodIndexCount;
+			lodCount = lod + 1;
+		}
+		sg_free(positions);
 
-			// Index buffer
-			BufferCreateDesc indexBufferDesc = {};
-			indexBufferDesc.descriptors = SG_DESCRIPTOR_TYPE_INDEX_BUFFER |
-				(structuredBuffers ?
-					(SG_DESCRIPTOR_TYPE_BUFFER | SG_DESCRIPTOR_TYPE_RW_BUFFER) :
-					(SG_DESCRIPTOR_TYPE_BUFFER_RAW | SG_DESCRIPTOR_TYPE_RW_BUFFER_RAW));
-			indexBufferDesc.size = indexStride * indexCount;
-			indexBufferDesc.elementCount = indexBufferDesc.size / (structuredBuffers ? indexStride : sizeof(uint32_t));
-			indexBufferDesc.structStride = indexStride;
-			indexBufferDesc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
-			add_buffer(pRenderer, &indexBufferDesc, &geom->pIndexBuffer);
+		sg_free(pState->pIndices);
+		pState->pIndices = (uint32_t*)sg_malloc(indices.size() * sizeof(uint32_t));
+		memcpy(pState->pIndices, indices.data(), indices.size() * sizeof(uint32_t));
+		*pLodCount = lodCount;
+		return (uint32_t)indices.size();
+	}
 
-			BufferUpdateDesc indexUpdateDesc = {};
-			BufferUpdateDesc vertexUpdateDesc[SG_MAX_VERTEX_BINDINGS] = {};
+	/// Allocate the meshlet data of a geometry as one block, the arrays follow the header in the order of its members
+	static Geometry::MeshletData* util_allocate_meshlet_data(uint32_t meshletCount, uint32_t vertexCount, uint32_t triangleCount, uint32_t drawCount)
+	{
+		const size_t meshletsSize = round_up_64(meshletCount * sizeof(Meshlet), 16);
+		const size_t boundsSize = round_up_64(meshletCount * sizeof(MeshletBounds), 16);
+		const size_t verticesSize = round_up_64(vertexCount * sizeof(uint32_t), 16);
+		const size_t trianglesSize = round_up_64(triangleCount * 3 * sizeof(uint8_t), 16);
+		const size_t drawOffsetsSize = round_up_64((drawCount + 1) * sizeof(uint32_t), 16);
+
+		Geometry::MeshletData* pMeshlets = (Geometry::MeshletData*)sg_calloc(1,
+			round_up_64(sizeof(Geometry::MeshletData), 16) + meshletsSize + boundsSize + verticesSize + trianglesSize + drawOffsetsSize);
+		pMeshlets->pMeshlets = (Meshlet*)((uint8_t*)pMeshlets + round_up_64(sizeof(Geometry::MeshletData), 16));
+		pMeshlets->pBounds = (MeshletBounds*)((uint8_t*)pMeshlets->pMeshlets + meshletsSize);
+		pMeshlets->pVertices = (uint32_t*)((uint8_t*)pMeshlets->pBounds + boundsSize);
+		pMeshlets->pTriangles = (uint8_t*)pMeshlets->pVertices + verticesSize;
+		pMeshlets->pDrawMeshletOffsets = (uint32_t*)(pMeshlets->pTriangles + trianglesSize);
+		pMeshlets->meshletCount = meshletCount;
+		pMeshlets->vertexCount = vertexCount;
+		pMeshlets->triangleCount = triangleCount;
+		return pMeshlets;
+	}
 
-			indexUpdateDesc.size = indexCount * indexStride;
-			indexUpdateDesc.pBuffer = geom->pIndexBuffer;
-	#if UMA
-			indexUpdateDesc.mInternal.mappedRange = { (uint8_t*)geom->pIndexBuffer->pCpuMappedAddress };
-	#else
-			indexUpdateDesc.mInternal.mappedRange = allocate_staging_memory(indexUpdateDesc.size, SG_RESOURCE_BUFFER_ALIGNMENT);
-	#endif
-			indexUpdateDesc.pMappedData = indexUpdateDesc.mInternal.mappedRange.pData;
+	/// Size of the arrays of a meshlet data block, they are contiguous from pMeshlets on
+	static uint64_t util_get_meshlet_data_size(const Geometry::MeshletData* pMeshlets, uint32_t drawCount)
+	{
+		return (uint64_t)((uint8_t*)(pMeshlets->pDrawMeshletOffsets + drawCount + 1) - (uint8_t*)pMeshlets->pMeshlets);
+	}
 
-			uint32_t bufferCounter = 0;
-			for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
-			{
-				if (!vertexStrides[i])
-					continue;
+	/// Split every draw of the optimized index buffer into meshlets and compute their culling bounds
+	static void util_build_geometry_meshlets(GeometryLoadDesc* pDesc, GeometryLoadState* pState, Geometry* pGeom)
+	{
+		const cgltf_data* data = pState->pData;
+		const uint32_t* indices = pState->pIndices;
+		ASSERT(indices);
 
-				BufferCreateDesc vertexBufferDesc = {};
-				vertexBufferDesc.descriptors = SG_DESCRIPTOR_TYPE_VERTEX_BUFFER |
-					(structuredBuffers ?
-						(SG_DESCRIPTOR_TYPE_BUFFER | SG_DESCRIPTOR_TYPE_RW_BUFFER) :
-						(SG_DESCRIPTOR_TYPE_BUFFER_RAW | SG_DESCRIPTOR_TYPE_RW_BUFFER_RAW));
-				vertexBufferDesc.size = vertexStrides[i] * vertexCount;
-				vertexBufferDesc.elementCount = vertexBufferDesc.size / (structuredBuffers ? vertexStrides[i] : sizeof(uint32_t));
-				vertexBufferDesc.structStride = vertexStrides[i];
-				vertexBufferDesc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
-				add_buffer(pRenderer, &vertexBufferDesc, &geom->pVertexBuffers[bufferCounter]);
-
-				geom->vertexStrides[bufferCounter] = vertexStrides[i];
-
-				vertexUpdateDesc[i].pBuffer = geom->pVertexBuffers[bufferCounter];
-				vertexUpdateDesc[i].size = vertexBufferDesc.size;
-	#if UMA
-				vertexUpdateDesc[i].mInternal.mappedRange = { (uint8_t*)geom->pVertexBuffers[bufferCounter]->pCpuMappedAddress, 0 };
-#else
-				vertexUpdateDesc[i].mInternal.mappedRange = allocate_staging_memory(vertexUpdateDesc[i].size, SG_RESOURCE_BUFFER_ALIGNMENT);
-	#endif
-				vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mappedRange.pData;
-				++bufferCounter;
-			}
+		float* positions = util_gather_geometry_positions(data, pState->pVertexRemap, pGeom->vertexCount);
 
-			indexCount = 0;
-			vertexCount = 0;
-			drawCount = 0;
+		eastl::vector<Meshlet> meshlets;
+		eastl::vector<uint32_t> meshletVertices;
+		eastl::vector<uint8_t> meshletTriangles;
+		eastl::vector<uint32_t> drawMeshletOffsets;
+		drawMeshletOffsets.reserve(pGeom->drawArgCount + 1);
 
-			for (uint32_t i = 0; i < data->meshes_count; ++i)
+		uint32_t primIndexStart = 0;
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
+		{
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 			{
-				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
+				const uint32_t primIndexCount = (uint32_t)data->meshes[i].primitives[p].indices->count;
+				const uint32_t meshletStart = (uint32_t)meshlets.size();
+				const uint32_t vertexStart = (uint32_t)meshletVertices.size();
+				const uint32_t triangleStart = (uint32_t)meshletTriangles.size() / 3;
+				drawMeshletOffsets.push_back(meshletStart);
+
+				meshlets.resize(meshletStart + get_meshlet_bound(primIndexCount, SG_MESHLET_MAX_VERTICES, SG_MESHLET_MAX_TRIANGLES));
+				meshletVertices.resize(vertexStart + primIndexCount);
+				meshletTriangles.resize((size_t)triangleStart * 3 + primIndexCount);
+				const uint32_t primMeshletCount = build_meshlets(meshlets.data() + meshletStart, meshletVertices.data() + vertexStart,
+					meshletTriangles.data() + (size_t)triangleStart * 3, indices + primIndexStart, primIndexCount, pGeom->vertexCount,
+					SG_MESHLET_MAX_VERTICES, SG_MESHLET_MAX_TRIANGLES);
+
+				meshlets.resize(meshletStart + primMeshletCount);
+				uint32_t primVertexCount = 0;
+				uint32_t primTriangleCount = 0;
+				for (uint32_t m = meshletStart; m < meshlets.size(); ++m)
 				{
-					const cgltf_primitive* prim = &data->meshes[i].primitives[p];
-					// Fill index buffer for this primitive
-					if (sizeof(uint16_t) == indexStride)
-					{
-						uint16_t* dst = (uint16_t*)indexUpdateDesc.pMappedData;
-						for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
-							dst[indexCount + idx] = vertexCount + (uint16_t)cgltf_accessor_read_index(prim->indices, idx);
-					}
-					else
-					{
-						uint32_t* dst = (uint32_t*)indexUpdateDesc.pMappedData;
-						for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
-							dst[indexCount + idx] = vertexCount + (uint32_t)cgltf_accessor_read_index(prim->indices, idx);
-					}
+					meshlets[m].vertexOffset += vertexStart;
+					meshlets[m].triangleOffset += triangleStart;
+					primVertexCount += meshlets[m].vertexCount;
+					primTriangleCount += meshlets[m].triangleCount;
+				}
+				meshletVertices.resize(vertexStart + primVertexCount);
+				meshletTriangles.resize((size_t)(triangleStart + primTriangleCount) * 3);
+				primIndexStart += primIndexCount;
+			}
+		}
+		drawMeshletOffsets.push_back((uint32_t)meshlets.size());
+
+		Geometry::MeshletData* pMeshlets = util_allocate_meshlet_data((uint32_t)meshlets.size(), (uint32_t)meshletVertices.size(),
+			(uint32_t)meshletTriangles.size() / 3, pGeom->drawArgCount);
+		memcpy(pMeshlets->pMeshlets, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+		memcpy(pMeshlets->pVertices, meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t));
+		memcpy(pMeshlets->pTriangles, meshletTriangles.data(), meshletTriangles.size());
+		memcpy(pMeshlets->pDrawMeshletOffsets, drawMeshletOffsets.data(), drawMeshletOffsets.size() * sizeof(uint32_t));
+		for (uint32_t m = 0; m < pMeshlets->meshletCount; ++m)
+			pMeshlets->pBounds[m] = compute_meshlet_bounds(&pMeshlets->pMeshlets[m], pMeshlets->pVertices, pMeshlets->pTriangles, positions, sizeof(float[3]));
+		sg_free(positions);
+
+		SG_LOG_IF(SG_LOG_LEVEL_INFO, pDesc->flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZATION_REPORT,
+			"Built %u meshlets for geometry %s: %.1f triangles and %.1f vertices per meshlet", pMeshlets->meshletCount, pDesc->fileName,
+			pMeshlets->meshletCount ? (float)pMeshlets->triangleCount / pMeshlets->meshletCount : 0.0f,
+			pMeshlets->meshletCount ? (float)pMeshlets->vertexCount / pMeshlets->meshletCount : 0.0f);
+
+		pGeom->pMeshlets = pMeshlets;
+	}
 
-					// Fill vertex buffers for this primitive
-					for (uint32_t a = 0; a < prim->attributes_count; ++a)
-					{
-						cgltf_attribute* attr = &prim->attributes[a];
-						uint32_t index = util_cgltf_attrib_type_to_shader_semantic(attr->type, attr->index);
+	/// Decode stage of a gltf geometry load (worker thread): parse the gltf, load its buffers and work out the vertex layout and sizes
+	static UploadFunctionResult decode_gltf_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState)
+	{
+		char iext[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_extension(pDesc->fileName, iext);
 
-						if (vertexOffsets[index] != UINT_MAX)
-						{
-							const uint32_t binding = vertexBindings[index];
-							const uint32_t offset = vertexOffsets[index];
-							const uint32_t stride = vertexStrides[binding];
-							const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
+		// Geometry in gltf container
+		if (iext[0] == 0 || (stricmp(iext, "gltf") != 0 && stricmp(iext, "glb") != 0))
+		{
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
 
-							// If this vertex attribute is not interleaved with any other attribute use fast path instead of copying one by one
-							// In this case a simple memcpy will be enough to transfer the data to the buffer
-							if (1 == vertexAttribCount[binding])
-							{
-								uint8_t* dst = (uint8_t*)vertexUpdateDesc[binding].pMappedData + vertexCount * stride;
-								if (vertexPacking[index])
-									vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, 0, src, dst);
-								else
-									memcpy(dst, src, attr->data->count * attr->data->stride);
-							}
-							else
-							{
-								uint8_t* dst = (uint8_t*)vertexUpdateDesc[binding].pMappedData + vertexCount * stride;
-								// Loop through all vertices copying into the correct place in the vertex buffer
-								// Example:
-								// [ POSITION | NORMAL | TEXCOORD ] => [ 0 | 12 | 24 ], [ 32 | 44 | 52 ], ... (vertex stride of 32 => 12 + 12 + 8)
-								if (vertexPacking[index])
-									vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, offset, src, dst);
-								else
-									for (uint32_t e = 0; e < attr->data->count; ++e)
-										memcpy(dst + e * stride + offset, src + e * attr->data->stride, attr->data->stride);
-							}
-						}
-					}
+		FileStream file = {};
+		if (!sgfs_open_stream_from_path(SG_RD_MESHES, pDesc->fileName, SG_FM_READ_BINARY, &file))
+		{
+			SG_LOG_ERROR("Failed to open gltf file %s", pDesc->fileName);
+			ASSERT(false);
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
 
-					// Fill draw arguments for this primitive
-					geom->pDrawArgs[drawCount].indexCount = (uint32_t)prim->indices->count;
-					geom->pDrawArgs[drawCount].instanceCount = 1;
-					geom->pDrawArgs[drawCount].startIndex = indexCount;
-					geom->pDrawArgs[drawCount].startInstance = 0;
-					// Since we already offset indices when creating the index buffer, vertex offset will be zero
-					// With this approach, we can draw everything in one draw call or use the traditional draw per subset without the
-					// need for changing shader code
-					geom->pDrawArgs[drawCount].vertexOffset = 0;
-
-					indexCount += (uint32_t)prim->indices->count;
-					vertexCount += (uint32_t)prim->attributes->data->count;
-					++drawCount;
-				}
-			}
+		ssize_t fileSize = sgfs_get_stream_file_size(&file);
+		void* fileData = sg_malloc(fileSize);
+		cgltf_result result = cgltf_result_invalid_gltf;
 
-			UploadFunctionResult uploadResult = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-	#if !UMA
-			uploadResult = update_buffer(pRenderer, pCopyEngine, activeSet, indexUpdateDesc);
+		sgfs_read_from_stream(&file, fileData, fileSize);
 
-			for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+		cgltf_options options = {};
+		cgltf_data* data = nullptr;
+		// use seagull memory allocation
+		options.memory.alloc = [](void* user, cgltf_size size) { return sg_malloc(size); };
+		options.memory.free = [](void* user, void* ptr) { sg_free(ptr); };
+		result = cgltf_parse(&options, fileData, fileSize, &data);
+
+		sgfs_close_stream(&file);
+
+		if (cgltf_result_success != result)
+		{
+			SG_LOG_ERROR("Failed to parse gltf file %s with error %u", pDesc->fileName, (uint32_t)result);
+			ASSERT(false);
+			sg_free(fileData);
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+
+	#if defined(SG_DEBUG)
+		result = cgltf_validate(data);
+		if (cgltf_result_success != result)
+		{
+			SG_LOG_WARNING("GLTF validation finished with error %u for file %s", (uint32_t)result, pDesc->fileName);
+		}
+	#endif
+
+		// Load buffers located in separate files (.bin) using our file system
+		for (uint32_t i = 0; i < data->buffers_count; ++i)
+		{
+			const char* uri = data->buffers[i].uri;
+
+			if (!uri || data->buffers[i].data)
 			{
-				if (vertexUpdateDesc[i].pMappedData)
-				{
-					uploadResult = update_buffer(pRenderer, pCopyEngine, activeSet, vertexUpdateDesc[i]);
-				}
+				continue;
 			}
-	#endif
 
-			// Load the remap joint indices generated in the offline process
-			uint32_t remapCount = 0;
-			for (uint32_t i = 0; i < data->skins_count; ++i)
+			if (strncmp(uri, "data:", 5) != 0 && !strstr(uri, "://"))
 			{
-				const cgltf_skin* skin = &data->skins[i];
-				uint32_t extrasSize = (uint32_t)(skin->extras.end_offset - skin->extras.start_offset);
-				if (extrasSize)
+				char parent[SG_MAX_FILEPATH] = { 0 };
+				sgfs_get_parent_path(pDesc->fileName, parent);
+				char path[SG_MAX_FILEPATH] = { 0 };
+				sgfs_append_path_component(parent, uri, path);
+				FileStream fs = {};
+				if (sgfs_open_stream_from_path(SG_RD_MESHES, path, SG_FM_READ_BINARY, &fs))
 				{
-					const char* jointRemaps = (const char*)data->json + skin->extras.start_offset;
-					jsmn_parser parser = {};
-					jsmntok_t* tokens = (jsmntok_t*)sg_malloc((skin->joints_count + 1) * sizeof(jsmntok_t));
-					jsmn_parse(&parser, (const char*)jointRemaps, extrasSize, tokens, skin->joints_count + 1);
-					ASSERT(tokens[0].size == skin->joints_count + 1);
-					cgltf_accessor_unpack_floats(skin->inverse_bind_matrices, (cgltf_float*)geom->pInverseBindPoses, skin->joints_count * sizeof(float[16]) / sizeof(float));
-					for (uint32_t r = 0; r < skin->joints_count; ++r)
-						geom->pJointRemaps[remapCount + r] = atoi(jointRemaps + tokens[1 + r].start);
-					sg_free(tokens);
+					ASSERT(sgfs_get_stream_file_size(&fs) >= (ssize_t)data->buffers[i].size);
+					data->buffers[i].data = sg_malloc(data->buffers[i].size);
+					sgfs_read_from_stream(&fs, data->buffers[i].data, data->buffers[i].size);
 				}
-
-				remapCount += (uint32_t)skin->joints_count;
+				sgfs_close_stream(&fs);
 			}
+		}
+
+		result = cgltf_load_buffers(&options, data, pDesc->fileName);
+		if (cgltf_result_success != result)
+		{
+			SG_LOG_ERROR("Failed to load buffers from gltf file %s with error %u", pDesc->fileName, (uint32_t)result);
+			ASSERT(false);
+			data->file_data = fileData;
+			cgltf_free(data);
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
 
-			// Load the tressfx specific data generated in the offline process
-			if (stricmp(data->asset.generator, "tressfx") == 0)
+		pState->pData = data;
+		pState->pFileData = fileData;
+
+		uint32_t* vertexStrides = pState->vertexStrides;
+		uint32_t* vertexAttribCount = pState->vertexAttribCount;
+		uint32_t* vertexOffsets = pState->vertexOffsets;
+		uint32_t* vertexBindings = pState->vertexBindings;
+		PackingFunction* vertexPacking = pState->vertexPacking;
+		uint32_t* vertexPackingComponents = pState->vertexPackingComponents;
+		cgltf_attribute* vertexAttribs[SG_SEMANTIC_TEXCOORD9 + 1] = {};
+		for (uint32_t i = 0; i < SG_SEMANTIC_TEXCOORD9 + 1; ++i)
+			vertexOffsets[i] = UINT_MAX;
+
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+		uint32_t drawCount = 0;
+		uint32_t jointCount = 0;
+		uint32_t vertexBufferCount = 0;
+
+		// Find number of traditional draw calls required to draw this piece of geometry
+		// Find total index count, total vertex count
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
+		{
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 			{
-				// { "mVertexCountPerStrand" : "16", "mGuideCountPerStrand" : "3456" }
-				uint32_t extrasSize = (uint32_t)(data->asset.extras.end_offset - data->asset.extras.start_offset);
-				const char* json = data->json + data->asset.extras.start_offset;
-				jsmn_parser parser = {};
-				jsmntok_t tokens[5] = {};
-				jsmn_parse(&parser, (const char*)json, extrasSize, tokens, 5);
-				geom->hair.vertexCountPerStrand = atoi(json + tokens[2].start);
-				geom->hair.guideCountPerStrand = atoi(json + tokens[4].start);
+				const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+				indexCount += (uint32_t)prim->indices->count;
+				vertexCount += (uint32_t)prim->attributes->data->count;
+				++drawCount;
+
+				for (uint32_t i = 0; i < prim->attributes_count; ++i)
+					vertexAttribs[util_cgltf_attrib_type_to_shader_semantic(prim->attributes[i].type, prim->attributes[i].index)] = &prim->attributes[i];
 			}
+		}
 
-			if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+		// Determine vertex stride for each binding
+		for (uint32_t i = 0; i < pDesc->pVertexLayout->attribCount; ++i)
+		{
+			const VertexAttrib* attr = &pDesc->pVertexLayout->attribs[i];
+			const cgltf_attribute* cgltfAttr = vertexAttribs[attr->semantic];
+			ASSERT(cgltfAttr);
+
+			const uint32_t dstFormatSize = TinyImageFormat_BitSizeOfBlock(attr->format) >> 3;
+			const uint32_t srcFormatSize = (uint32_t)cgltfAttr->data->stride;
+
+			vertexStrides[attr->binding] += dstFormatSize ? dstFormatSize : srcFormatSize;
+			vertexOffsets[attr->semantic] = attr->offset;
+			vertexBindings[attr->semantic] = attr->binding;
+			++vertexAttribCount[attr->binding];
+
+			// Compare vertex attrib format to the gltf attrib type
+			// Select a packing function if dst format is packed version
+			// Float attributes - Pack to half, unorm or snorm of the same channel count
+			// Directions - Pack float3 to float2 to unorm2x16 (Normal, Tangent)
+			const TinyImageFormat srcFormat = util_cgltf_type_to_image_format(cgltfAttr->data->type, cgltfAttr->data->component_type);
+			const TinyImageFormat dstFormat = attr->format == TinyImageFormat_UNDEFINED ? srcFormat : attr->format;
+
+			if (dstFormat != srcFormat)
 			{
-				indexCount = 0;
-				vertexCount = 0;
+				// Select appropriate packing function which will be used when filling the vertex buffer
+				vertexPacking[attr->semantic] = util_select_vertex_packing(cgltfAttr->type, srcFormat, dstFormat);
+				vertexPackingComponents[attr->semantic] = TinyImageFormat_ChannelCount(dstFormat);
+				if (!vertexPacking[attr->semantic])
+					SG_LOG_WARNING("No packing from %s to %s for vertex attribute %u of %s, data is copied as is",
+						TinyImageFormat_Name(srcFormat), TinyImageFormat_Name(dstFormat), (uint32_t)attr->semantic, pDesc->fileName);
+			}
+		}
 
-				for (uint32_t i = 0; i < data->meshes_count; ++i)
-				{
-					for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
-					{
-						const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+		// determine number of vertex buffers needed based on number of unique bindings found
+		// for each unique binding the vertex stride will be non zero
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+			if (vertexStrides[i])
+				++vertexBufferCount;
+
+		for (uint32_t i = 0; i < data->skins_count; ++i)
+			jointCount += (uint32_t)data->skins[i].joints_count;
+
+		// Optimize before the sizes are known, deduplication can shrink the vertex count and with it the index stride.
+		// The meshlets are built from the final index buffer the optimization stage produces
+		if ((pDesc->flags & (SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_ALL | SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS)) || pDesc->lodCount > 1)
+			vertexCount = util_optimize_geometry(pDesc, pState, indexCount, vertexCount);
+
+		// The LODs go after the full detail indices and reference the same vertices
+		eastl::vector<IndirectDrawIndexArguments> lodDrawArgs;
+		float lodErrors[SG_MAX_GEOMETRY_LODS] = {};
+		uint32_t lodCount = 1;
+		if (pDesc->lodCount > 1)
+			indexCount = util_generate_geometry_lods(pDesc, pState, indexCount, vertexCount, drawCount, lodDrawArgs, lodErrors, &lodCount);
+
+		// Determine index stride
+		// This depends on vertex count rather than the stride specified in gltf
+		// since gltf assumes we have index buffer per primitive which is non optimal
+		const uint32_t indexStride = vertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+		pState->indexStride = indexStride;
+
+		Geometry* geom = util_allocate_geometry(drawCount, jointCount, lodCount);
+		memcpy(geom->pDrawArgs + drawCount, lodDrawArgs.data(), lodDrawArgs.size() * sizeof(IndirectDrawIndexArguments));
+		memcpy(geom->pLodErrors, lodErrors, lodCount * sizeof(float));
+
+		uint64_t shadowSize = 0;
+		if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+		{
+			pState->shadowPositionStride = (uint32_t)vertexAttribs[SG_SEMANTIC_POSITION]->data->stride;
+			shadowSize += (uint64_t)pState->shadowPositionStride * vertexCount;
+			shadowSize += (uint64_t)indexCount * indexStride;
+
+			geom->pShadow = (Geometry::ShadowData*)sg_calloc(1, sizeof(Geometry::ShadowData) + (size_t)shadowSize);
+			geom->pShadow->pIndices = geom->pShadow + 1;
+			geom->pShadow->pAttributes[SG_SEMANTIC_POSITION] = (uint8_t*)geom->pShadow->pIndices + ((uint64_t)indexCount * indexStride);
+			// #TODO: Add more if needed
+		}
 
-						// Fill index buffer for this primitive
-						if (sizeof(uint16_t) == indexStride)
-						{
-							uint16_t* dst = (uint16_t*)geom->pShadow->pIndices;
-							for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
-								dst[indexCount + idx] = vertexCount + (uint16_t)cgltf_accessor_read_index(prim->indices, idx);
-						}
-						else
-						{
-							uint32_t* dst = (uint32_t*)geom->pShadow->pIndices;
-							for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
-								dst[indexCount + idx] = vertexCount + (uint32_t)cgltf_accessor_read_index(prim->indices, idx);
-						}
+		geom->vertexBufferCount = vertexBufferCount;
+		geom->drawArgCount = drawCount;
+		geom->indexCount = indexCount;
+		geom->vertexCount = vertexCount;
+		geom->indexType = (sizeof(uint16_t) == indexStride) ? SG_INDEX_TYPE_UINT16 : SG_INDEX_TYPE_UINT32;
+		geom->jointCount = jointCount;
+		geom->lodCount = lodCount;
 
-						for (uint32_t a = 0; a < prim->attributes_count; ++a)
-						{
-							cgltf_attribute* attr = &prim->attributes[a];
-							if (cgltf_attribute_type_position == attr->type)
-							{
-								const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
-								uint8_t* dst = (uint8_t*)geom->pShadow->pAttributes[SG_SEMANTIC_POSITION] + vertexCount * attr->data->stride;
-								memcpy(dst, src, attr->data->count * attr->data->stride);
-							}
-						}
+		if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS)
+			util_build_geometry_meshlets(pDesc, pState, geom);
 
-						indexCount += (uint32_t)prim->indices->count;
-						vertexCount += (uint32_t)prim->attributes->data->count;
-					}
-				}
-			}
+		pState->pGeom = geom;
 
-			data->file_data = fileData;
-			cgltf_free(data);
+		return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+	}
 
-			sg_free(pDesc->pVertexLayout);
+	/// Point the update of a geometry buffer at the buffer itself if it got host visible device memory, at staging memory otherwise
+	static void util_reserve_geometry_range(CopyEngine* pCopyEngine, BufferUpdateDesc* pUpdate)
+	{
+	#if UMA
+		UNREF_PARAM(pCopyEngine);
+		pUpdate->mInternal.mappedRange = { (uint8_t*)pUpdate->pBuffer->pCpuMappedAddress, 0 };
+	#else
+		if (pUpdate->pBuffer->pCpuMappedAddress)
+		{
+			// the fill stage writes the buffer in place, the copy queue never sees it
+			pUpdate->mInternal.mappedRange = { (uint8_t*)pUpdate->pBuffer->pCpuMappedAddress, pUpdate->pBuffer, 0, pUpdate->size, MAPPED_RANGE_FLAG_DIRECT_WRITE };
+			sg_atomic64_add_relaxed(&pResourceLoader->directUploadBytes, (int64_t)pUpdate->size);
+		}
+		else
+		{
+			pUpdate->mInternal.mappedRange = allocate_staging_memory(pCopyEngine, pUpdate->size, SG_RESOURCE_BUFFER_ALIGNMENT);
+		}
+	#endif
+		pUpdate->pMappedData = pUpdate->mInternal.mappedRange.pData;
+	}
 
-			*pDesc->ppGeometry = geom;
+	/// Reserve stage of a geometry load (loader thread): create the GPU buffers and reserve the staging ranges the vertices are packed into.
+	/// On resizable BAR and unified memory GPUs the buffers are placed in host visible device memory while its budget lasts and get no staging range
+	static void reserve_geometry(Renderer* pRenderer, GeometryLoadDesc* pDesc, GeometryLoadState* pState)
+	{
+		Geometry* geom = pState->pGeom;
+		const uint32_t indexStride = pState->indexStride;
+
+		// Allocate buffer memory
+		const bool structuredBuffers = (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_STRUCTURED_BUFFERS);
+
+		// Index buffer
+		BufferCreateDesc indexBufferDesc = {};
+		indexBufferDesc.descriptors = SG_DESCRIPTOR_TYPE_INDEX_BUFFER |
+			(structuredBuffers ?
+				(SG_DESCRIPTOR_TYPE_BUFFER | SG_DESCRIPTOR_TYPE_RW_BUFFER) :
+				(SG_DESCRIPTOR_TYPE_BUFFER_RAW | SG_DESCRIPTOR_TYPE_RW_BUFFER_RAW));
+		indexBufferDesc.size = (uint64_t)indexStride * geom->indexCount;
+		indexBufferDesc.elementCount = indexBufferDesc.size / (structuredBuffers ? indexStride : sizeof(uint32_t));
+		indexBufferDesc.structStride = indexStride;
+		indexBufferDesc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+		indexBufferDesc.flags = SG_BUFFER_CREATION_FLAG_HOST_VISIBLE_DEVICE_LOCAL;
+		add_buffer(pRenderer, &indexBufferDesc, &geom->pIndexBuffer);
+
+		BufferUpdateDesc& indexUpdateDesc = pState->indexUpdateDesc;
+		BufferUpdateDesc* vertexUpdateDesc = pState->vertexUpdateDesc;
+
+		indexUpdateDesc.size = (uint64_t)geom->indexCount * indexStride;
+		indexUpdateDesc.pBuffer = geom->pIndexBuffer;
+		util_reserve_geometry_range(&pResourceLoader->pCopyEngines[pDesc->nodeIndex], &indexUpdateDesc);
+
+		uint32_t bufferCounter = 0;
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+		{
+			if (!pState->vertexStrides[i])
+				continue;
 
-			return uploadResult;
+			BufferCreateDesc vertexBufferDesc = {};
+			vertexBufferDesc.descriptors = SG_DESCRIPTOR_TYPE_VERTEX_BUFFER |
+				(structuredBuffers ?
+					(SG_DESCRIPTOR_TYPE_BUFFER | SG_DESCRIPTOR_TYPE_RW_BUFFER) :
+					(SG_DESCRIPTOR_TYPE_BUFFER_RAW | SG_DESCRIPTOR_TYPE_RW_BUFFER_RAW));
+			vertexBufferDesc.size = (uint64_t)pState->vertexStrides[i] * geom->vertexCount;
+			vertexBufferDesc.elementCount = vertexBufferDesc.size / (structuredBuffers ? pState->vertexStrides[i] : sizeof(uint32_t));
+			vertexBufferDesc.structStride = pState->vertexStrides[i];
+			vertexBufferDesc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+			vertexBufferDesc.flags = SG_BUFFER_CREATION_FLAG_HOST_VISIBLE_DEVICE_LOCAL;
+			add_buffer(pRenderer, &vertexBufferDesc, &geom->pVertexBuffers[bufferCounter]);
+
+			geom->vertexStrides[bufferCounter] = pState->vertexStrides[i];
+
+			vertexUpdateDesc[i].pBuffer = geom->pVertexBuffers[bufferCounter];
+			vertexUpdateDesc[i].size = vertexBufferDesc.size;
+			util_reserve_geometry_range(&pResourceLoader->pCopyEngines[pDesc->nodeIndex], &vertexUpdateDesc[i]);
+			++bufferCounter;
 		}
-
-		return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 	}
 
-	// internal Resource Loader Implementation
-	// to check if there are some loading operation is functioning
-	static bool are_tasks_available(ResourceLoader* pLoader)
+	/// Write the index buffer of all the draws, either the optimized indices or the gltf indices rebased by the vertex count of the previous draws
+	static void util_fill_geometry_indices(const cgltf_data* data, const GeometryLoadState* pState, uint32_t indexCount, void* pDst)
 	{
-		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
+		const uint32_t indexStride = pState->indexStride;
+		if (pState->pIndices)
 		{
-			if (!pLoader->requestQueue[i].empty())
+			if (sizeof(uint16_t) == indexStride)
+			{
+				uint16_t* dst = (uint16_t*)pDst;
+				for (uint32_t idx = 0; idx < indexCount; ++idx)
+					dst[idx] = (uint16_t)pState->pIndices[idx];
+			}
+			else
 			{
-				return true;
+				memcpy(pDst, pState->pIndices, indexCount * sizeof(uint32_t));
+			}
+			return;
+		}
+
+		uint32_t primIndexStart = 0;
+		uint32_t primVertexStart = 0;
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
+		{
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
+			{
+				const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+				if (sizeof(uint16_t) == indexStride)
+				{
+					uint16_t* dst = (uint16_t*)pDst;
+					for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
+						dst[primIndexStart + idx] = primVertexStart + (uint16_t)cgltf_accessor_read_index(prim->indices, idx);
+				}
+				else
+				{
+					uint32_t* dst = (uint32_t*)pDst;
+					for (uint32_t idx = 0; idx < prim->indices->count; ++idx)
+						dst[primIndexStart + idx] = primVertexStart + (uint32_t)cgltf_accessor_read_index(prim->indices, idx);
+				}
+				primIndexStart += (uint32_t)prim->indices->count;
+				primVertexStart += (uint32_t)prim->attributes->data->count;
 			}
 		}
-		return false;
 	}
 
-	// for each thread to load the data
-	static void streamer_thread_func(void* pThreadData)
+	/// Pack the vertices through the vertex remap of the optimizations.
+	/// Every attribute is gathered in the new vertex order first, so that the packing kernels still see one contiguous stream
+	static void util_fill_remapped_vertices(const cgltf_data* data, GeometryLoadState* pState, uint32_t vertexCount)
 	{
-		Thread::set_curr_thread_name("ResourceLoading");
-		SG_LOG_DEBUG("Thread ID: %ul is loading resourece", Thread::get_curr_thread_id());
+		const uint32_t* remap = pState->pVertexRemap;
+		eastl::vector<uint8_t> gathered;
 
-		ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
-		ASSERT(pLoader);
+		for (uint32_t index = 0; index < SG_SEMANTIC_TEXCOORD9 + 1; ++index)
+		{
+			if (pState->vertexOffsets[index] == UINT_MAX)
+				continue;
 
-	#if defined(SG_GRAPHIC_API_GLES)
-		GLContext localContext;
-		if (!pLoader->desc.mSingleThreaded)
-			initGLContext(pLoader->pRenderer->pConfig, &localContext, pLoader->pRenderer->pContext);
-	#endif
+			uint32_t srcStride = 0;
+			uint32_t primVertexStart = 0;
+			for (uint32_t i = 0; i < data->meshes_count; ++i)
+			{
+				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
+				{
+					const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+					for (uint32_t a = 0; a < prim->attributes_count; ++a)
+					{
+						const cgltf_attribute* attr = &prim->attributes[a];
+						if (util_cgltf_attrib_type_to_shader_semantic(attr->type, attr->index) != index)
+							continue;
 
-		uint32_t linkedGPUCount = pLoader->pRenderer->linkedNodeCount;
+						if (!srcStride)
+						{
+							srcStride = (uint32_t)attr->data->stride;
+							gathered.resize((size_t)vertexCount * srcStride);
+						}
+						ASSERT(srcStride == attr->data->stride);
 
-		SyncToken maxToken = {};
+						const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
+						for (uint32_t e = 0; e < attr->data->count; ++e)
+						{
+							const uint32_t vertex = remap[primVertexStart + e];
+							if (UINT32_MAX != vertex)
+								memcpy(gathered.data() + (size_t)vertex * srcStride, src + e * srcStride, srcStride);
+						}
+					}
+					primVertexStart += (uint32_t)prim->attributes->data->count;
+				}
+			}
 
-		while (pLoader->run)
-		{
-			{
-				MutexLock lck(pLoader->queueMutex);
-				//pLoader->queueMutex.Acquire();
+			if (!srcStride)
+				continue;
 
-				// check for pending tokens
-				// safe to use tokenCounter as we are inside critical section
+			const uint32_t binding = pState->vertexBindings[index];
+			const uint32_t stride = pState->vertexStrides[binding];
+			uint8_t* dst = (uint8_t*)pState->vertexUpdateDesc[binding].pMappedData;
+			if (pState->vertexAttribCount[binding] > 1)
+				dst += pState->vertexOffsets[index];
 
-				// we are in the beginning of a new round
-				bool allTokensSignaled = (pLoader->tokenCompleted == sg_atomic64_load_relaxed(&pLoader->tokenCounter));
+			if (pState->vertexPacking[index])
+				pState->vertexPacking[index](vertexCount, pState->vertexPackingComponents[index], srcStride, stride, gathered.data(), dst);
+			else
+				interleave_vertex_attribute(vertexCount, srcStride, srcStride, stride, gathered.data(), dst);
+		}
+	}
 
-				while (!are_tasks_available(pLoader) && allTokensSignaled && pLoader->run)
+	/// Fill stage of a gltf geometry load (worker thread): rebase the indices and pack the vertices into the reserved staging ranges,
+	/// read the joint and shadow data and release the gltf
+	static void fill_gltf_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState)
+	{
+		cgltf_data* data = pState->pData;
+		Geometry* geom = pState->pGeom;
+		const uint32_t* vertexStrides = pState->vertexStrides;
+		const uint32_t* vertexAttribCount = pState->vertexAttribCount;
+		const uint32_t* vertexOffsets = pState->vertexOffsets;
+		const uint32_t* vertexBindings = pState->vertexBindings;
+		const PackingFunction* vertexPacking = pState->vertexPacking;
+		const uint32_t* vertexPackingComponents = pState->vertexPackingComponents;
+		BufferUpdateDesc& indexUpdateDesc = pState->indexUpdateDesc;
+		BufferUpdateDesc* vertexUpdateDesc = pState->vertexUpdateDesc;
+
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+		uint32_t drawCount = 0;
+
+		util_fill_geometry_indices(data, pState, geom->indexCount, indexUpdateDesc.pMappedData);
+		if (pState->pVertexRemap)
+			util_fill_remapped_vertices(data, pState, geom->vertexCount);
+
+		for (uint32_t i = 0; i < data->meshes_count; ++i)
+		{
+			for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
+			{
+				const cgltf_primitive* prim = &data->meshes[i].primitives[p];
+
+				// Fill vertex buffers for this primitive, remapped vertices were already packed for all the primitives at once
+				for (uint32_t a = 0; a < prim->attributes_count; ++a)
 				{
-					// no waiting if not running dedicated resource loader thread.
-					if (pLoader->desc.singleThreaded)
+					cgltf_attribute* attr = &prim->attributes[a];
+					uint32_t index = util_cgltf_attrib_type_to_shader_semantic(attr->type, attr->index);
+
+					if (vertexOffsets[index] != UINT_MAX && !pState->pVertexRemap)
 					{
-						return;
+						const uint32_t binding = vertexBindings[index];
+						const uint32_t offset = vertexOffsets[index];
+						const uint32_t stride = vertexStrides[binding];
+						const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
+
+						// Loop through all vertices copying (or packing) into the correct place in the vertex buffer
+						// Example:
+						// [ POSITION | NORMAL | TEXCOORD ] => [ 0 | 12 | 24 ], [ 32 | 44 | 52 ], ... (vertex stride of 32 => 12 + 12 + 8)
+						// An attribute which is not interleaved with any other attribute ends up as a single memcpy
+						uint8_t* dst = (uint8_t*)vertexUpdateDesc[binding].pMappedData + vertexCount * stride;
+						if (vertexAttribCount[binding] > 1)
+							dst += offset;
+
+						const uint32_t count = (uint32_t)attr->data->count;
+						const uint32_t srcStride = (uint32_t)attr->data->stride;
+						if (vertexPacking[index])
+							vertexPacking[index](count, vertexPackingComponents[index], srcStride, stride, src, dst);
+						else
+							interleave_vertex_attribute(count, srcStride, srcStride, stride, src, dst);
 					}
-					// sleep until someone adds an update request to the queue
-					pLoader->queueCv.Wait(pLoader->queueMutex);
 				}
-				//pLoader->queueMutex.Release();
+
+				// Fill draw arguments for this primitive
+				geom->pDrawArgs[drawCount].indexCount = (uint32_t)prim->indices->count;
+				geom->pDrawArgs[drawCount].instanceCount = 1;
+				geom->pDrawArgs[drawCount].startIndex = indexCount;
+				geom->pDrawArgs[drawCount].startInstance = 0;
+				// Since we already offset indices when creating the index buffer, vertex offset will be zero
+				// With this approach, we can draw everything in one draw call or use the traditional draw per subset without the
+				// need for changing shader code
+				geom->pDrawArgs[drawCount].vertexOffset = 0;
+
+				indexCount += (uint32_t)prim->indices->count;
+				vertexCount += (uint32_t)prim->attributes->data->count;
+				++drawCount;
 			}
+		}
 
-			pLoader->nextSet = (pLoader->nextSet + 1) % pLoader->desc.bufferCount;
-			for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+		// Load the remap joint indices generated in the offline process
+		uint32_t remapCount = 0;
+		for (uint32_t i = 0; i < data->skins_count; ++i)
+		{
+			const cgltf_skin* skin = &data->skins[i];
+			uint32_t extrasSize = (uint32_t)(skin->extras.end_offset - skin->extras.start_offset);
+			if (extrasSize)
 			{
-				// wait for the transfer queue to do the next job
-				wait_copy_engine_set(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->nextSet, true);
-				reset_copy_engine_set(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
+				const char* jointRemaps = (const char*)data->json + skin->extras.start_offset;
+				jsmn_parser parser = {};
+				jsmntok_t* tokens = (jsmntok_t*)sg_malloc((skin->joints_count + 1) * sizeof(jsmntok_t));
+				jsmn_parse(&parser, (const char*)jointRemaps, extrasSize, tokens, skin->joints_count + 1);
+				ASSERT(tokens[0].size == skin->joints_count + 1);
+				cgltf_accessor_unpack_floats(skin->inverse_bind_matrices, (cgltf_float*)geom->pInverseBindPoses, skin->joints_count * sizeof(float[16]) / sizeof(float));
+				for (uint32_t r = 0; r < skin->joints_count; ++r)
+					geom->pJointRemaps[remapCount + r] = atoi(jointRemaps + tokens[1 + r].start);
+				sg_free(tokens);
 			}
 
-			// signal pending tokens from previous frames
-			pLoader->tokenMutex.Acquire();
-			sg_atomic64_store_release(&pLoader->tokenCompleted, pLoader->currentTokenState[pLoader->nextSet]);
-			pLoader->tokenMutex.Release();
-			pLoader->tokenCv.WakeAll();
+			remapCount += (uint32_t)skin->joints_count;
+		}
 
-			for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
-			{
-				uint64_t completionMask = 0;
+		// Load the tressfx specific data generated in the offline process
+		if (stricmp(data->asset.generator, "tressfx") == 0)
+		{
+			// { "mVertexCountPerStrand" : "16", "mGuideCountPerStrand" : "3456" }
+			uint32_t extrasSize = (uint32_t)(data->asset.extras.end_offset - data->asset.extras.start_offset);
+			const char* json = data->json + data->asset.extras.start_offset;
+			jsmn_parser parser = {};
+			jsmntok_t tokens[5] = {};
+			jsmn_parse(&parser, (const char*)json, extrasSize, tokens, 5);
+			geom->hair.vertexCountPerStrand = atoi(json + tokens[2].start);
+			geom->hair.guideCountPerStrand = atoi(json + tokens[4].start);
+		}
 
-				pLoader->queueMutex.Acquire();
+		if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+		{
+			vertexCount = 0;
 
-				eastl::vector<UpdateRequest>& requestQueue = pLoader->requestQueue[nodeIndex];
-				CopyEngine& copyEngine = pLoader->pCopyEngines[nodeIndex];
+			util_fill_geometry_indices(data, pState, geom->indexCount, geom->pShadow->pIndices);
 
-				if (requestQueue.empty()) // no job to do
+			for (uint32_t i = 0; i < data->meshes_count; ++i)
+			{
+				for (uint32_t p = 0; p < data->meshes[i].primitives_count; ++p)
 				{
-					pLoader->queueMutex.Release();
-					continue;
-				}
+					const cgltf_primitive* prim = &data->meshes[i].primitives[p];
 
-				eastl::vector<UpdateRequest> activeQueue;
-				eastl::swap(requestQueue, activeQueue);
-				pLoader->queueMutex.Release();
-
-				size_t requestCount = activeQueue.size();
-				for (size_t j = 0; j < requestCount; ++j)
-				{
-					UpdateRequest updateState = activeQueue[j];
-
-					UploadFunctionResult result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-					switch (updateState.type)
-					{
-					case SG_UPDATE_REQUEST_UPDATE_BUFFER:
-						result = update_buffer(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState.bufferUpdateDesc);
-						break;
-					case SG_UPDATE_REQUEST_UPDATE_TEXTURE:
-						result = update_texture(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState.texUpdateDesc);
-						break;
-					case SG_UPDATE_REQUEST_BUFFER_BARRIER:
-						cmd_resource_barrier(acquire_cmd(&copyEngine, pLoader->nextSet), 1, &updateState.bufferBarrier, 0, nullptr, 0, nullptr);
-						result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-						break;
-					case SG_UPDATE_REQUEST_TEXTURE_BARRIER:
-						cmd_resource_barrier(acquire_cmd(&copyEngine, pLoader->nextSet), 0, nullptr, 1, &updateState.textureBarrier, 0, nullptr);
-						result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
-						break;
-					case SG_UPDATE_REQUEST_LOAD_TEXTURE:
-						result = load_texture(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState);
-						break;
-					case SG_UPDATE_REQUEST_LOAD_GEOMETRY:
-						result = load_geometry(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState);
-						break;
-					case SG_UPDATE_REQUEST_INVALID:
-						break;
-					}
-
-					if (updateState.pUploadBuffer)
+					for (uint32_t a = 0; a < prim->attributes_count; ++a)
 					{
-						CopyResourceSet& resourceSet = copyEngine.resourceSets[pLoader->nextSet];
-						resourceSet.tempBuffers.push_back(updateState.pUploadBuffer);
+						cgltf_attribute* attr = &prim->attributes[a];
+						if (cgltf_attribute_type_position == attr->type)
+						{
+							const uint8_t* src = (uint8_t*)attr->data->buffer_view->buffer->data + attr->data->offset + attr->data->buffer_view->offset;
+							uint8_t* dst = (uint8_t*)geom->pShadow->pAttributes[SG_SEMANTIC_POSITION];
+							if (pState->pVertexRemap)
+							{
+								for (uint32_t e = 0; e < attr->data->count; ++e)
+								{
+									const uint32_t vertex = pState->pVertexRemap[vertexCount + e];
+									if (UINT32_MAX != vertex)
+										memcpy(dst + vertex * attr->data->stride, src + e * attr->data->stride, attr->data->stride);
+								}
+							}
+							else
+							{
+								memcpy(dst + vertexCount * attr->data->stride, src, attr->data->count * attr->data->stride);
+							}
+						}
 					}
 
-					bool completed = result == SG_UPLOAD_FUNCTION_RESULT_COMPLETED || result == SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-
-					completionMask |= completed << nodeIndex;
+					vertexCount += (uint32_t)prim->attributes->data->count;
+				}
+			}
+		}
 
-					if (updateState.waitIndex && completed)
-					{
-						ASSERT(maxToken < updateState.waitIndex);
-						maxToken = updateState.waitIndex;
-					}
+		sg_free(pState->pIndices);
+		sg_free(pState->pVertexRemap);
+		pState->pIndices = nullptr;
+		pState->pVertexRemap = nullptr;
 
-					ASSERT(result != SG_UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
-				}
+		data->file_data = pState->pFileData;
+		cgltf_free(data);
+		pState->pData = nullptr;
+		pState->pFileData = nullptr;
+	}
 
-				if (completionMask != 0)
-				{
-					for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
-					{
-						// commands recording complete
-						flush_cmd(&pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
-					}
-				}
-			}
+	// Cooked Geometry
 
-			SyncToken nextToken = eastl::max(maxToken, get_last_token_completed());
-			pLoader->currentTokenState[pLoader->nextSet] = nextToken;
-			if (pResourceLoader->desc.singleThreaded)
+	static uint64_t util_hash_cooked_geometry_layout(const GeometryLoadDesc* pDesc)
+	{
+		// FNV-1a over the fields which change the cooked streams
+		uint64_t hash = 14695981039346656037ull;
+		auto hashValue = [&hash](uint32_t value)
+		{
+			for (uint32_t i = 0; i < sizeof(value); ++i)
 			{
-				return;
+				hash ^= (value >> (i * 8)) & 0xff;
+				hash *= 1099511628211ull;
 			}
-		}
+		};
 
-		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+		const VertexLayout* pLayout = pDesc->pVertexLayout;
+		hashValue(pLayout->attribCount);
+		for (uint32_t i = 0; i < pLayout->attribCount; ++i)
 		{
-			flush_cmd(&pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
-	#if !defined(SG_GRAPHIC_API_D3D11) && !defined(SG_GRAPHIC_API_GLES)
-			wait_queue_idle(pLoader->pCopyEngines[nodeIndex].pQueue);
-	#endif
-			cleanup_copy_engine(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex]);
+			hashValue((uint32_t)pLayout->attribs[i].semantic);
+			hashValue((uint32_t)pLayout->attribs[i].format);
+			hashValue(pLayout->attribs[i].binding);
+			hashValue(pLayout->attribs[i].offset);
 		}
-
-		free_all_upload_memory();
-
-	#if defined(GLES)
-		if (!pResourceLoader->desc.mSingleThreaded)
-			removeGLContext(&localContext);
-	#endif
+		hashValue((uint32_t)(pDesc->flags & SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_ALL));
+		// the LODs are part of the index stream
+		if (pDesc->lodCount > 1)
+		{
+			uint32_t lodTargetError = 0;
+			memcpy(&lodTargetError, &pDesc->lodTargetError, sizeof(lodTargetError));
+			hashValue(eastl::min(pDesc->lodCount, (uint32_t)SG_MAX_GEOMETRY_LODS));
+			hashValue(lodTargetError);
+		}
+		return hash;
 	}
 
-	// init function
-	static void add_resource_loader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, ResourceLoader** ppLoader)
+	/// mesh.gltf -> mesh.sgmesh
+	static void util_get_cooked_geometry_path(const char* fileName, char* output)
 	{
-		ResourceLoader* pLoader = sg_new(ResourceLoader);
-		pLoader->pRenderer = pRenderer;
-
-		pLoader->run = true;
-		pLoader->desc = pDesc ? *pDesc : gDefaultResourceLoaderDesc;
+		char ext[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_extension(fileName, ext);
+
+		char basePath[SG_MAX_FILEPATH] = { 0 };
+		const size_t extLength = strlen(ext);
+		const size_t baseLength = strlen(fileName) - (extLength ? extLength + 1 : 0);
+		strncpy(basePath, fileName, baseLength);
+		sgfs_append_path_extension(basePath, SG_COOKED_GEOMETRY_EXTENSION, output);
+	}
 
-		pLoader->queueMutex.Init();
-		pLoader->tokenMutex.Init();
-		pLoader->queueCv.Init();
-		pLoader->tokenCv.Init();
+	static bool util_read_cooked_section(FileStream* pStream, uint64_t offset, void* pDst, uint64_t size)
+	{
+		if (!size)
+			return true;
+		if (!sgfs_seek_stream(pStream, SG_SBO_START_OF_FILE, (ssize_t)offset))
+			return false;
+		return sgfs_read_from_stream(pStream, pDst, (size_t)size) == size;
+	}
 
-		pLoader->tokenCounter = 0;
-		pLoader->tokenCompleted = 0;
+	/// The section of count elements lies inside the file. The sizes are computed in 64 bits from 32 bit counts, so they cannot wrap
+	static inline bool util_is_cooked_section_in_file(uint64_t fileSize, uint64_t offset, uint64_t count, uint64_t elementSize)
+	{
+		return offset <= fileSize && count * elementSize <= fileSize - offset;
+	}
 
-		uint32_t linkedGPUCount = pLoader->pRenderer->linkedNodeCount;
-		for (uint32_t i = 0; i < linkedGPUCount; ++i)
+	/// Every section the fill stage reads straight into the buffers lies inside the file, so a truncated or corrupt file
+	/// fails the load here instead of reading (or writing) past the ranges reserved for it
+	static bool util_are_cooked_streams_in_file(const GeometryLoadDesc* pDesc, const CookedGeometryHeader& header, uint64_t fileSize)
+	{
+		if (!util_is_cooked_section_in_file(fileSize, header.indexOffset, header.indexCount, header.indexStride))
+			return false;
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
 		{
-			setup_copy_engine(pLoader->pRenderer, &pLoader->pCopyEngines[i], i, pLoader->desc.bufferSize, pLoader->desc.bufferCount);
+			if (!util_is_cooked_section_in_file(fileSize, header.vertexOffsets[i], header.vertexCount, header.vertexStrides[i]))
+				return false;
 		}
+		if ((pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED) &&
+			!util_is_cooked_section_in_file(fileSize, header.shadowPositionOffset, header.vertexCount, header.shadowPositionStride))
+			return false;
+		return true;
+	}
 
-		pLoader->threadDesc.pFunc = streamer_thread_func;
-		pLoader->threadDesc.pData = pLoader;
+	/// Decode stage of a cooked geometry load: validate the header and create the Geometry, the streams are read by the fill stage.
+	/// Returns false if there is no usable cooked geometry, gltf loads then fall back to the gltf
+	static bool decode_cooked_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState, bool cookedRequest)
+	{
+		char cookedPath[SG_MAX_FILEPATH] = { 0 };
+		if (cookedRequest)
+			strncpy(cookedPath, pDesc->fileName, SG_MAX_FILEPATH - 1);
+		else
+			util_get_cooked_geometry_path(pDesc->fileName, cookedPath);
 
-	#if defined(NX64)
-		pLoader->mThreadDesc.pThreadStack = aligned_alloc(THREAD_STACK_ALIGNMENT_NX, ALIGNED_THREAD_STACK_SIZE_NX);
-		pLoader->mThreadDesc.hThread = &pLoader->mThreadType;
-		pLoader->mThreadDesc.pThreadName = "ResourceLoaderTask";
-		pLoader->mThreadDesc.preferredCore = 1;
-	#endif
+		// cooked geometries are optional, only look for the file if it exists so a missing one does not log an error
+		const time_t cookedTime = sgfs_get_last_modified_time(SG_RD_MESHES, cookedPath);
+		if (!cookedTime)
+			return false;
+		if (!cookedRequest && sgfs_get_last_modified_time(SG_RD_MESHES, pDesc->fileName) > cookedTime)
+		{
+			SG_LOG_INFO("Cooked geometry %s is older than %s, loading the gltf", cookedPath, pDesc->fileName);
+			return false;
+		}
 
-	#if defined(SG_GRAPHIC_API_D3D11)
-		pLoader->desc.singleThreaded = true;
-	#endif
+		FileStream* pStream = &pState->cookedStream;
+		if (!sgfs_open_stream_from_path(SG_RD_MESHES, cookedPath, SG_FM_READ_BINARY, pStream))
+			return false;
 
-		// create dedicated resource loader thread.
-		if (!pLoader->desc.singleThreaded)
+		CookedGeometryHeader& header = pState->cookedHeader;
+		const ssize_t fileSize = sgfs_get_stream_file_size(pStream);
+		const char* mismatch = nullptr;
+		if (sgfs_read_from_stream(pStream, &header, sizeof(header)) != sizeof(header) || SG_COOKED_GEOMETRY_MAGIC != header.magic)
+			mismatch = "not a cooked geometry";
+		else if (SG_COOKED_GEOMETRY_VERSION != header.version)
+			mismatch = "cooked with another version";
+		else if (!header.lodCount || header.lodCount > SG_MAX_GEOMETRY_LODS)
+			mismatch = "invalid LOD count";
+		else if (util_hash_cooked_geometry_layout(pDesc) != header.layoutHash)
+			mismatch = "cooked for another vertex layout or other optimization flags";
+		else if ((pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED) && !header.shadowPositionStride)
+			mismatch = "cooked without a shadow copy";
+		else if ((pDesc->flags & SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS) && !header.meshletCount && header.indexCount)
+			mismatch = "cooked without meshlets";
+		else if ((sizeof(uint16_t) != header.indexStride && sizeof(uint32_t) != header.indexStride) || header.vertexBufferCount > SG_MAX_VERTEX_BINDINGS)
+			mismatch = "invalid stream layout";
+		else if (fileSize < 0 || !util_are_cooked_streams_in_file(pDesc, header, (uint64_t)fileSize))
+			mismatch = "file is truncated";
+
+		if (mismatch)
 		{
-			pLoader->mThread = create_thread(&pLoader->threadDesc);
+			SG_LOG_WARNING("Ignoring cooked geometry %s: %s", cookedPath, mismatch);
+			sgfs_close_stream(pStream);
+			return false;
 		}
 
-		*ppLoader = pLoader;
-	}
-
-	// exit function
-	static void remove_resource_loader(ResourceLoader* pLoader)
-	{
-		pLoader->run = false;
+		Geometry* geom = util_allocate_geometry(header.drawCount, header.jointCount, header.lodCount);
+		memcpy(geom->pLodErrors, header.lodErrors, header.lodCount * sizeof(float));
 
-		if (pLoader->desc.singleThreaded)
+		bool read = util_read_cooked_section(pStream, header.drawArgsOffset, geom->pDrawArgs, header.drawCount * header.lodCount * sizeof(IndirectDrawIndexArguments));
+		read = read && util_read_cooked_section(pStream, header.inverseBindPosesOffset, geom->pInverseBindPoses, header.jointCount * sizeof(Matrix4));
+		read = read && util_read_cooked_section(pStream, header.jointRemapsOffset, geom->pJointRemaps, header.jointCount * sizeof(uint32_t));
+		if (read && (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS))
 		{
-			streamer_thread_func(pLoader);
+			geom->pMeshlets = util_allocate_meshlet_data(header.meshletCount, header.meshletVertexCount, header.meshletTriangleCount, header.drawCount);
+			read = util_read_cooked_section(pStream, header.meshletDataOffset, geom->pMeshlets->pMeshlets, util_get_meshlet_data_size(geom->pMeshlets, header.drawCount));
 		}
-		else
+		if (!read)
 		{
-			pLoader->queueCv.WakeOne();
-			destroy_thread(pLoader->mThread);
+			SG_LOG_WARNING("Ignoring cooked geometry %s: file is truncated", cookedPath);
+			sg_free(geom->pMeshlets);
+			sg_free(geom);
+			sgfs_close_stream(pStream);
+			return false;
 		}
 
-		pLoader->queueCv.Destroy();
-		pLoader->tokenCv.Destroy();
-		pLoader->queueMutex.Destroy();
-		pLoader->tokenMutex.Destroy();
+		if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+		{
+			const uint64_t shadowSize = (uint64_t)header.shadowPositionStride * header.vertexCount + (uint64_t)header.indexCount * header.indexStride;
+			geom->pShadow = (Geometry::ShadowData*)sg_calloc(1, sizeof(Geometry::ShadowData) + (size_t)shadowSize);
+			geom->pShadow->pIndices = geom->pShadow + 1;
+			geom->pShadow->pAttributes[SG_SEMANTIC_POSITION] = (uint8_t*)geom->pShadow->pIndices + ((uint64_t)header.indexCount * header.indexStride);
+		}
 
-		sg_delete(pLoader);
-		pLoader = nullptr;
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+			pState->vertexStrides[i] = header.vertexStrides[i];
+		pState->indexStride = header.indexStride;
+
+		geom->vertexBufferCount = header.vertexBufferCount;
+		geom->drawArgCount = header.drawCount;
+		geom->indexCount = header.indexCount;
+		geom->vertexCount = header.vertexCount;
+		geom->indexType = (sizeof(uint16_t) == header.indexStride) ? SG_INDEX_TYPE_UINT16 : SG_INDEX_TYPE_UINT32;
+		geom->jointCount = header.jointCount;
+		geom->hair.vertexCountPerStrand = header.hairVertexCountPerStrand;
+		geom->hair.guideCountPerStrand = header.hairGuideCountPerStrand;
+		geom->lodCount = header.lodCount;
+
+		pState->pGeom = geom;
+		pState->cooked = true;
+		return true;
 	}
 
-	static void queue_buffer_update(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+	/// Fill stage of a cooked geometry load: the streams are already in their final layout and go straight into the staging memory
+	static void fill_cooked_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState)
 	{
-		uint32_t nodeIndex = pBufferUpdate->pBuffer->nodeIndex;
-		pLoader->queueMutex.Acquire();
+		const CookedGeometryHeader& header = pState->cookedHeader;
+		FileStream* pStream = &pState->cookedStream;
+		Geometry* geom = pState->pGeom;
 
-		// add one
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+		bool read = util_read_cooked_section(pStream, header.indexOffset, pState->indexUpdateDesc.pMappedData, (uint64_t)header.indexCount * header.indexStride);
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+		{
+			if (header.vertexStrides[i])
+				read = read && util_read_cooked_section(pStream, header.vertexOffsets[i], pState->vertexUpdateDesc[i].pMappedData, (uint64_t)header.vertexStrides[i] * header.vertexCount);
+		}
 
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest(*pBufferUpdate));
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->requestQueue[nodeIndex].back().pUploadBuffer =
-			(pBufferUpdate->mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_TEMP_BUFFER) ? pBufferUpdate->mInternal.mappedRange.pBuffer
-			: nullptr;
+		if (pDesc->flags & SG_GEOMETRY_LOAD_FLAG_SHADOWED)
+		{
+			read = read && util_read_cooked_section(pStream, header.indexOffset, geom->pShadow->pIndices, (uint64_t)header.indexCount * header.indexStride);
+			read = read && util_read_cooked_section(pStream, header.shadowPositionOffset, geom->pShadow->pAttributes[SG_SEMANTIC_POSITION], (uint64_t)header.shadowPositionStride * header.vertexCount);
+		}
 
-		pLoader->queueMutex.Release();
-		// update finish, one thread can go and get the job
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+		// the decode stage checked that the sections lie inside the file, only a read error gets here
+		SG_LOG_IF(SG_LOG_LEVEL_ERROR, !read, "Failed to read the streams of cooked geometry %s", pDesc->fileName);
+
+		sgfs_close_stream(pStream);
+		pState->cooked = false;
 	}
 
-	static void queue_texture_load(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token)
+	/// Decode stage of a geometry load (worker thread): a cooked geometry if there is an up to date one for this vertex layout, the gltf otherwise
+	static UploadFunctionResult decode_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState)
 	{
-		uint32_t nodeIndex = pTextureUpdate->nodeIndex;
-		pLoader->queueMutex.Acquire();
+		char iext[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_extension(pDesc->fileName, iext);
+		const bool cookedRequest = stricmp(iext, SG_COOKED_GEOMETRY_EXTENSION) == 0;
 
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+		if (decode_cooked_geometry(pDesc, pState, cookedRequest))
+			return SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
 
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->queueMutex.Release();
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+		if (cookedRequest)
+		{
+			SG_LOG_ERROR("Failed to load cooked geometry %s", pDesc->fileName);
+			return SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+		return decode_gltf_geometry(pDesc, pState);
 	}
 
-	static void queue_geometry_load(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+	/// Fill stage of a geometry load (worker thread)
+	/// Copy into write combined memory with streaming stores: whole lines are written past the caches and the destination is never read
+	static void util_stream_copy(void* pDst, const void* pSrc, size_t size)
 	{
-		uint32_t nodeIndex = pGeometryLoad->nodeIndex;
-		pLoader->queueMutex.Acquire();
-
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
-
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest(*pGeometryLoad));
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->queueMutex.Release();
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+	#if defined(SG_RESOURCE_LOADER_SSE2)
+		uint8_t* dst = (uint8_t*)pDst;
+		const uint8_t* src = (const uint8_t*)pSrc;
+		const size_t head = eastl::min(size, (size_t)((16 - ((uintptr_t)dst & 15)) & 15));
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		size -= head;
+		for (; size >= 64; size -= 64, dst += 64, src += 64)
+		{
+			_mm_stream_si128((__m128i*)dst + 0, _mm_loadu_si128((const __m128i*)src + 0));
+			_mm_stream_si128((__m128i*)dst + 1, _mm_loadu_si128((const __m128i*)src + 1));
+			_mm_stream_si128((__m128i*)dst + 2, _mm_loadu_si128((const __m128i*)src + 2));
+			_mm_stream_si128((__m128i*)dst + 3, _mm_loadu_si128((const __m128i*)src + 3));
+		}
+		for (; size >= 16; size -= 16, dst += 16, src += 16)
+			_mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+		memcpy(dst, src, size);
+		// the streaming stores are weakly ordered, finish them before the load is reported done
+		_mm_sfence();
+	#else
+		memcpy(pDst, pSrc, size);
+	#endif
 	}
 
-	static void queue_texture_update(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, SyncToken* token)
+	static void fill_geometry(GeometryLoadDesc* pDesc, GeometryLoadState* pState)
 	{
-		ASSERT(pTextureUpdate->range.pBuffer);
+		if (pState->cooked)
+		{
+			// the cooked sections are read in order, which writes the direct buffers sequentially as well
+			fill_cooked_geometry(pDesc, pState);
+			return;
+		}
 
-		uint32_t nodeIndex = pTextureUpdate->pTexture->nodeIndex;
-		pLoader->queueMutex.Acquire();
+		// The packing writes strided and partial lines, which is slow on the uncached mapping of host visible device memory.
+		// Direct buffers are packed in CPU memory and streamed over afterwards
+		BufferUpdateDesc* directUpdates[SG_MAX_VERTEX_BINDINGS + 1];
+		uint32_t directUpdateCount = 0;
+		if (pState->indexUpdateDesc.mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_DIRECT_WRITE)
+			directUpdates[directUpdateCount++] = &pState->indexUpdateDesc;
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+		{
+			if (pState->vertexUpdateDesc[i].mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_DIRECT_WRITE)
+				directUpdates[directUpdateCount++] = &pState->vertexUpdateDesc[i];
+		}
+		for (uint32_t i = 0; i < directUpdateCount; ++i)
+			directUpdates[i]->pMappedData = sg_malloc(directUpdates[i]->size);
 
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+		fill_gltf_geometry(pDesc, pState);
 
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->requestQueue[nodeIndex].back().pUploadBuffer =
-			(pTextureUpdate->range.flags & MAPPED_RANGE_FLAG_TEMP_BUFFER) ? pTextureUpdate->range.pBuffer : nullptr;
-		pLoader->queueMutex.Release();
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+		for (uint32_t i = 0; i < directUpdateCount; ++i)
+		{
+			BufferUpdateDesc* pUpdate = directUpdates[i];
+			util_stream_copy(pUpdate->mInternal.mappedRange.pData, pUpdate->pMappedData, pUpdate->size);
+			sg_free(pUpdate->pMappedData);
+			pUpdate->pMappedData = pUpdate->mInternal.mappedRange.pData;
+		}
 	}
 
-	static void queue_buffer_barrier(ResourceLoader* pLoader, Buffer* pBuffer, ResourceState state, SyncToken* token)
+	static uint64_t util_place_cooked_section(uint64_t* pFileSize, uint64_t size)
 	{
-		uint32_t nodeIndex = pBuffer->nodeIndex;
-		pLoader->queueMutex.Acquire();
-
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
-
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, SG_RESOURCE_STATE_UNDEFINED, state } });
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->queueMutex.Release();
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+		const uint64_t offset = round_up_64(*pFileSize, SG_COOKED_GEOMETRY_ALIGNMENT);
+		*pFileSize = offset + size;
+		return offset;
 	}
 
-	static void queue_texture_barrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
+	static bool util_write_cooked_section(FileStream* pStream, uint64_t* pWritten, uint64_t offset, const void* pData, uint64_t size)
 	{
-		uint32_t nodeIndex = pTexture->nodeIndex;
-		pLoader->queueMutex.Acquire();
-
-		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
-
-		pLoader->requestQueue[nodeIndex].emplace_back(UpdateRequest{ TextureBarrier{ pTexture, SG_RESOURCE_STATE_UNDEFINED, state } });
-		pLoader->requestQueue[nodeIndex].back().waitIndex = t;
-		pLoader->queueMutex.Release();
-		pLoader->queueCv.WakeOne();
-		if (token) *token = eastl::max(t, *token);
+		static const uint8_t padding[SG_COOKED_GEOMETRY_ALIGNMENT] = {};
+		ASSERT(offset >= *pWritten && offset - *pWritten <= SG_COOKED_GEOMETRY_ALIGNMENT);
+		bool written = sgfs_write_to_stream(pStream, padding, (size_t)(offset - *pWritten)) == offset - *pWritten;
+		written = written && sgfs_write_to_stream(pStream, pData, (size_t)size) == size;
+		*pWritten = offset + size;
+		return written;
 	}
 
-	static void wait_for_token(ResourceLoader* pLoader, const SyncToken* token)
+	bool cook_geometry(const GeometryLoadDesc* pDesc, const char* cookedFileName)
 	{
-		if (pLoader->desc.singleThreaded)
+		ASSERT(pDesc && pDesc->fileName && pDesc->pVertexLayout);
+
+		GeometryLoadDesc desc = *pDesc;
+		GeometryLoadState* pState = sg_new(GeometryLoadState);
+		if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED != decode_gltf_geometry(&desc, pState))
 		{
-			return;
+			sg_delete(pState);
+			return false;
+		}
+
+		// pack into CPU memory instead of the staging ranges reserve_geometry hands out
+		Geometry* geom = pState->pGeom;
+		pState->indexUpdateDesc.pMappedData = sg_malloc(geom->indexCount * pState->indexStride);
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+		{
+			if (pState->vertexStrides[i])
+				pState->vertexUpdateDesc[i].pMappedData = sg_malloc(pState->vertexStrides[i] * geom->vertexCount);
 		}
-		pLoader->tokenMutex.Acquire();
-		while (!is_token_completed(token))
+		fill_gltf_geometry(&desc, pState);
+
+		CookedGeometryHeader header = {};
+		header.magic = SG_COOKED_GEOMETRY_MAGIC;
+		header.version = SG_COOKED_GEOMETRY_VERSION;
+		header.layoutHash = util_hash_cooked_geometry_layout(pDesc);
+		header.drawCount = geom->drawArgCount;
+		header.indexCount = geom->indexCount;
+		header.vertexCount = geom->vertexCount;
+		header.jointCount = geom->jointCount;
+		header.indexStride = pState->indexStride;
+		header.vertexBufferCount = geom->vertexBufferCount;
+		header.hairVertexCountPerStrand = geom->hair.vertexCountPerStrand;
+		header.hairGuideCountPerStrand = geom->hair.guideCountPerStrand;
+		header.lodCount = geom->lodCount;
+		memcpy(header.lodErrors, geom->pLodErrors, geom->lodCount * sizeof(float));
+
+		uint64_t fileSize = sizeof(header);
+		header.drawArgsOffset = util_place_cooked_section(&fileSize, header.drawCount * header.lodCount * sizeof(IndirectDrawIndexArguments));
+		header.inverseBindPosesOffset = util_place_cooked_section(&fileSize, header.jointCount * sizeof(Matrix4));
+		header.jointRemapsOffset = util_place_cooked_section(&fileSize, header.jointCount * sizeof(uint32_t));
+		header.indexOffset = util_place_cooked_section(&fileSize, (uint64_t)header.indexCount * header.indexStride);
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
 		{
-			pLoader->tokenCv.Wait(pLoader->tokenMutex);
+			header.vertexStrides[i] = pState->vertexStrides[i];
+			if (header.vertexStrides[i])
+				header.vertexOffsets[i] = util_place_cooked_section(&fileSize, (uint64_t)header.vertexStrides[i] * header.vertexCount);
+		}
+		if (geom->pShadow)
+		{
+			// the shadow copy keeps the positions in their source format, the indices are the same as the GPU ones
+			header.shadowPositionStride = pState->shadowPositionStride;
+			header.shadowPositionOffset = util_place_cooked_section(&fileSize, (uint64_t)header.shadowPositionStride * header.vertexCount);
+		}
+		if (geom->pMeshlets)
+		{
+			header.meshletCount = geom->pMeshlets->meshletCount;
+			header.meshletVertexCount = geom->pMeshlets->vertexCount;
+			header.meshletTriangleCount = geom->pMeshlets->triangleCount;
+			header.meshletDataOffset = util_place_cooked_section(&fileSize, util_get_meshlet_data_size(geom->pMeshlets, header.drawCount));
 		}
-		pLoader->tokenMutex.Release();
-	}
 
-#pragma region (Interface Implemetation)
+		char cookedPath[SG_MAX_FILEPATH] = { 0 };
+		if (cookedFileName)
+			strncpy(cookedPath, cookedFileName, SG_MAX_FILEPATH - 1);
+		else
+			util_get_cooked_geometry_path(pDesc->fileName, cookedPath);
 
-	void init_resource_loader_interface(Renderer* pRenderer, ResourceLoaderDesc* pDesc)
-	{
-		add_resource_loader(pRenderer, pDesc, &pResourceLoader);
+		bool written = false;
+		FileStream file = {};
+		if (sgfs_open_stream_from_path(SG_RD_MESHES, cookedPath, SG_FM_WRITE_BINARY, &file))
+		{
+			uint64_t writtenSize = 0;
+			written = util_write_cooked_section(&file, &writtenSize, 0, &header, sizeof(header));
+			written = written && util_write_cooked_section(&file, &writtenSize, header.drawArgsOffset, geom->pDrawArgs, header.drawCount * header.lodCount * sizeof(IndirectDrawIndexArguments));
+			written = written && util_write_cooked_section(&file, &writtenSize, header.inverseBindPosesOffset, geom->pInverseBindPoses, header.jointCount * sizeof(Matrix4));
+			written = written && util_write_cooked_section(&file, &writtenSize, header.jointRemapsOffset, geom->pJointRemaps, header.jointCount * sizeof(uint32_t));
+			written = written && util_write_cooked_section(&file, &writtenSize, header.indexOffset, pState->indexUpdateDesc.pMappedData, (uint64_t)header.indexCount * header.indexStride);
+			for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+			{
+				if (header.vertexStrides[i])
+					written = written && util_write_cooked_section(&file, &writtenSize, header.vertexOffsets[i], pState->vertexUpdateDesc[i].pMappedData, (uint64_t)header.vertexStrides[i] * header.vertexCount);
+			}
+			if (geom->pShadow)
+				written = written && util_write_cooked_section(&file, &writtenSize, header.shadowPositionOffset, geom->pShadow->pAttributes[SG_SEMANTIC_POSITION], (uint64_t)header.shadowPositionStride * header.vertexCount);
+			if (geom->pMeshlets)
+				written = written && util_write_cooked_section(&file, &writtenSize, header.meshletDataOffset, geom->pMeshlets->pMeshlets, util_get_meshlet_data_size(geom->pMeshlets, header.drawCount));
+			ASSERT(!written || writtenSize == fileSize);
+			sgfs_close_stream(&file);
+		}
+
+		if (written)
+			SG_LOG_INFO("Cooked geometry %s into %s (%llu bytes)", pDesc->fileName, cookedPath, (unsigned long long)fileSize);
+		else
+			SG_LOG_ERROR("Failed to write cooked geometry %s", cookedPath);
+
+		sg_free(pState->indexUpdateDesc.pMappedData);
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
+			sg_free(pState->vertexUpdateDesc[i].pMappedData);
+		sg_free(geom->pShadow);
+		sg_free(geom->pMeshlets);
+		sg_free(geom);
+		sg_delete(pState);
+		return written;
 	}
 
-	void exit_resource_loader_interface(Renderer* pRenderer)
+	uint32_t select_geometry_lod(const Geometry* pGeom, float pixelsPerUnit, float maxPixelError)
 	{
-		remove_resource_loader(pResourceLoader);
+		// the errors grow with the LOD, so the last level which still passes is the coarsest acceptable one
+		uint32_t lod = 0;
+		for (uint32_t l = 1; l < pGeom->lodCount; ++l)
+		{
+			if (pGeom->pLodErrors[l] * pixelsPerUnit > maxPixelError)
+				break;
+			lod = l;
+		}
+		return lod;
 	}
 
-	void add_resource(BufferLoadDesc* pBufferDesc, SyncToken* token)
+	static const char* gBlockCompressionNames[SG_BLOCK_COMPRESSION_COUNT] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+
+	bool cook_texture(const TextureCookDesc* pDesc, const char* cookedFileName)
 	{
-		uint64_t stagingBufferSize = pResourceLoader->pCopyEngines[0].bufferSize;
-		bool update = pBufferDesc->pData || pBufferDesc->forceReset;
+		ASSERT(pDesc && pDesc->fileName && pDesc->format < SG_BLOCK_COMPRESSION_COUNT);
 
-		ASSERT(stagingBufferSize > 0);
-		if (SG_RESOURCE_MEMORY_USAGE_GPU_ONLY == pBufferDesc->desc.memoryUsage && !pBufferDesc->desc.startState && !update)
-		{
-			pBufferDesc->desc.startState = util_determine_resource_start_state(&pBufferDesc->desc);
-			SG_LOG_WARNING("Buffer start state not provided. Determined the start state as (%u) based on the provided BufferCreateDesc",
-				(uint32_t)pBufferDesc->desc.startState);
+		char ext[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_extension(pDesc->fileName, ext);
+		char sourcePath[SG_MAX_FILEPATH] = { 0 };
+		if (ext[0])
+			strncpy(sourcePath, pDesc->fileName, SG_MAX_FILEPATH - 1);
+		else
+			sgfs_append_path_extension(pDesc->fileName, "dds", sourcePath);
+
+		FileStream stream = {};
+		if (!sgfs_open_stream_from_path(SG_RD_TEXTURES, sourcePath, SG_FM_READ_BINARY, &stream))
+		{
+			SG_LOG_ERROR("Failed to open texture %s", sourcePath);
+			return false;
 		}
 
-		if (pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY && update)
+		TextureCreateDesc textureDesc = {};
+		bool success = load_dds_texture(&stream, &textureDesc);
+		const TinyImageFormat sourceFormat = textureDesc.format;
+		const bool bgra = sourceFormat == TinyImageFormat_B8G8R8A8_UNORM || sourceFormat == TinyImageFormat_B8G8R8A8_SRGB;
+		if (!success || textureDesc.depth > 1 ||
+			!(bgra || sourceFormat == TinyImageFormat_R8G8B8A8_UNORM || sourceFormat == TinyImageFormat_R8G8B8A8_SRGB))
 		{
-			pBufferDesc->desc.startState = SG_RESOURCE_STATE_COMMON;
+			SG_LOG_ERROR("Texture %s is not an uncompressed RGBA8 2D DDS, it can't be cooked", sourcePath);
+			sgfs_close_stream(&stream);
+			return false;
 		}
-		add_buffer(pResourceLoader->pRenderer, &pBufferDesc->desc, pBufferDesc->ppBuffer);
 
-		if (update)
+		TextureCreateDesc cookedDesc = textureDesc;
+		cookedDesc.format = get_block_compression_texture_format(pDesc->format, pDesc->srgb || TinyImageFormat_IsSRGB(sourceFormat));
+
+		uint32_t uncompressedSize = 0;
+		uint32_t cookedSize = 0;
+		for (uint32_t mip = 0; mip < textureDesc.mipLevels; ++mip)
 		{
-			if (pBufferDesc->desc.size > stagingBufferSize &&
-				pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
-			{
-				// the data is too large for a single staging buffer copy, so perform it in stages.
-				// save the data parameter so we can restore it later.
-				const void* data = pBufferDesc->pData;
+			const uint32_t width = eastl::max(1U, textureDesc.width >> mip);
+			const uint32_t height = eastl::max(1U, textureDesc.height >> mip);
+			uncompressedSize += width * height * 4 * textureDesc.arraySize;
+			cookedSize += get_block_compressed_size(pDesc->format, width, height) * textureDesc.arraySize;
+		}
 
-				BufferUpdateDesc updateDesc = {};
-				updateDesc.pBuffer = *pBufferDesc->ppBuffer;
-				for (uint64_t offset = 0; offset < pBufferDesc->desc.size; offset += stagingBufferSize)
-				{
-					size_t chunkSize = (size_t)eastl::min(stagingBufferSize, pBufferDesc->desc.size - offset);
-					updateDesc.size = chunkSize;
-					updateDesc.dstOffset = offset;
-					begin_update_resource(&updateDesc);
-					if (pBufferDesc->forceReset)
-					{
-						memset(updateDesc.pMappedData, 0, chunkSize);
-					}
-					else
-					{
-						memcpy(updateDesc.pMappedData, (char*)data + offset, chunkSize);
-					}
-					end_update_resource(&updateDesc, token);
-				}
-			}
-			else
+		// the first mip is the largest subresource
+		uint8_t* pSource = (uint8_t*)sg_malloc(textureDesc.width * textureDesc.height * 4);
+		uint8_t* pCooked = (uint8_t*)sg_malloc(cookedSize);
+
+		// DDS stores every array slice with all of its mips
+		TextureCompressDesc compressDesc = {};
+		compressDesc.pRGBA = pSource;
+		compressDesc.format = pDesc->format;
+		compressDesc.quality = pDesc->quality;
+		compressDesc.pThreadSystem = pResourceLoader ? pResourceLoader->pThreadSystem : nullptr;
+		uint8_t* pDst = pCooked;
+		for (uint32_t slice = 0; success && slice < textureDesc.arraySize; ++slice)
+		{
+			for (uint32_t mip = 0; success && mip < textureDesc.mipLevels; ++mip)
 			{
-				BufferUpdateDesc updateDesc = {};
-				updateDesc.pBuffer = *pBufferDesc->ppBuffer;
-				begin_update_resource(&updateDesc);
-				if (pBufferDesc->forceReset)
-				{
-					memset(updateDesc.pMappedData, 0, (size_t)pBufferDesc->desc.size);
-				}
-				else
+				compressDesc.width = eastl::max(1U, textureDesc.width >> mip);
+				compressDesc.height = eastl::max(1U, textureDesc.height >> mip);
+				const uint32_t size = compressDesc.width * compressDesc.height * 4;
+				success = sgfs_read_from_stream(&stream, pSource, size) == size;
+				if (success && bgra)
 				{
-					memcpy(updateDesc.pMappedData, pBufferDesc->pData, (size_t)pBufferDesc->desc.size);
+					for (uint32_t i = 0; i < size; i += 4)
+						eastl::swap(pSource[i], pSource[i + 2]);
 				}
-				end_update_resource(&updateDesc, token);
+
+				success = success && compress_texture_blocks(&compressDesc, pDst);
+				pDst += get_block_compressed_size(pDesc->format, compressDesc.width, compressDesc.height);
 			}
 		}
+		sgfs_close_stream(&stream);
+
+		char cookedPath[SG_MAX_FILEPATH] = { 0 };
+		if (cookedFileName)
+		{
+			strncpy(cookedPath, cookedFileName, SG_MAX_FILEPATH - 1);
+		}
 		else
 		{
-			// transition GPU buffer to desired state for Vulkan since all Vulkan resources are created in undefined state
-			if (pResourceLoader->pRenderer->api == SG_RENDERER_API_VULKAN &&
-				pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY &&
-				// check whether this is required (user specified a state other than undefined / common)
-				(pBufferDesc->desc.startState != SG_RESOURCE_STATE_UNDEFINED && pBufferDesc->desc.startState != SG_RESOURCE_STATE_COMMON))
-				queue_buffer_barrier(pResourceLoader, *pBufferDesc->ppBuffer, pBufferDesc->desc.startState, token);
+			char basePath[SG_MAX_FILEPATH] = { 0 };
+			const size_t extLength = strlen(ext);
+			strncpy(basePath, pDesc->fileName, strlen(pDesc->fileName) - (extLength ? extLength + 1 : 0));
+			snprintf(cookedPath, SG_MAX_FILEPATH, "%s_%s.dds", basePath, gBlockCompressionNames[pDesc->format]);
+		}
+
+		bool written = false;
+		FileStream file = {};
+		if (success && sgfs_open_stream_from_path(SG_RD_TEXTURES, cookedPath, SG_FM_WRITE_BINARY, &file))
+		{
+			written = save_dds_texture(&file, &cookedDesc, pCooked, cookedSize);
+			sgfs_close_stream(&file);
 		}
+
+		if (written)
+			SG_LOG_INFO("Cooked texture %s into %s (%u bytes, %u uncompressed)", sourcePath, cookedPath, cookedSize, uncompressedSize);
+		else if (success)
+			SG_LOG_ERROR("Failed to write cooked texture %s", cookedPath);
+		else
+			SG_LOG_ERROR("Failed to read the texture data of %s", sourcePath);
+
+		sg_free(pSource);
+		sg_free(pCooked);
+		return written;
 	}
 
-	void add_resource(TextureLoadDesc* pTextureDesc, SyncToken* token)
+	static UploadFunctionResult load_geometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, GeometryLoadDesc* pDesc, GeometryLoadState* pState)
 	{
-		ASSERT(pTextureDesc->ppTexture);
+		UploadFunctionResult uploadResult = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+	#if !UMA
+		// buffers written in place by the fill stage need no copy
+		if (!(pState->indexUpdateDesc.mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_DIRECT_WRITE))
+			uploadResult = update_buffer(pRenderer, pCopyEngine, activeSet, pState->indexUpdateDesc);
 
-		if (!pTextureDesc->fileName && pTextureDesc->desc)
+		for (uint32_t i = 0; i < SG_MAX_VERTEX_BINDINGS; ++i)
 		{
-			ASSERT(pTextureDesc->desc->startState);
-
-			// If texture is supposed to be filled later (UAV / Update later / ...) proceed with the startState provided by the user in the texture description
-			add_texture(pResourceLoader->pRenderer, pTextureDesc->desc, pTextureDesc->ppTexture);
-
-			// Transition texture to desired state for Vulkan since all Vulkan resources are created in undefined state
-			if (pResourceLoader->pRenderer->api == SG_RENDERER_API_VULKAN)
+			if (pState->vertexUpdateDesc[i].pMappedData && !(pState->vertexUpdateDesc[i].mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_DIRECT_WRITE))
 			{
-				ResourceState startState = pTextureDesc->desc->startState;
-				// Check whether this is required (user specified a state other than undefined / common)
-				if (startState == SG_RESOURCE_STATE_UNDEFINED || startState == SG_RESOURCE_STATE_COMMON)
-				{
-					startState = util_determine_resource_start_state(pTextureDesc->desc->descriptors & SG_DESCRIPTOR_TYPE_RW_TEXTURE);
-				}
-				queue_texture_barrier(pResourceLoader, *pTextureDesc->ppTexture, startState, token);
+				uploadResult = update_buffer(pRenderer, pCopyEngine, activeSet, pState->vertexUpdateDesc[i]);
 			}
 		}
-		else
+	#endif
+
+		sg_free(pDesc->pVertexLayout);
+
+		*pDesc->ppGeometry = pState->pGeom;
+
+		return uploadResult;
+	}
+
+	// Resource cache
+	// with ResourceLoaderDesc::enableResourceCache every file load of add_resource gets an entry keyed by the normalized path and the
+	// load parameters, later add_resource calls with the same key take a reference to it instead of loading the file again
+
+	/// Spell a path one way: forward slashes, no empty or "." segments and ".." folded into the segment before it
+	static void util_normalize_resource_path(const char* path, char* pOut)
+	{
+		uint32_t segmentStarts[SG_MAX_FILEPATH / 2];
+		uint32_t segmentCount = 0;
+		// leading ".." segments, there is nothing left to fold them into
+		uint32_t fixedSegmentCount = 0;
+		uint32_t length = 0;
+		if (*path == '/' || *path == '\\')
+			pOut[length++] = '/';
+		const uint32_t rootLength = length;
+
+		const char* pSegment = path;
+		while (*pSegment)
 		{
-			TextureLoadDesc updateDesc = *pTextureDesc;
-			queue_texture_load(pResourceLoader, &updateDesc, token);
-			if (pResourceLoader->desc.singleThreaded)
+			const char* pEnd = pSegment;
+			while (*pEnd && *pEnd != '/' && *pEnd != '\\')
+				++pEnd;
+			const uint32_t segmentLength = (uint32_t)(pEnd - pSegment);
+			const bool parent = segmentLength == 2 && pSegment[0] == '.' && pSegment[1] == '.';
+
+			if (parent && segmentCount > fixedSegmentCount)
 			{
-				streamer_thread_func(pResourceLoader);
+				length = segmentStarts[--segmentCount];
+			}
+			else if (segmentLength && !(segmentLength == 1 && pSegment[0] == '.') && length + segmentLength + 1 < SG_MAX_FILEPATH)
+			{
+				segmentStarts[segmentCount++] = length;
+				if (length > rootLength)
+					pOut[length++] = '/';
+				memcpy(pOut + length, pSegment, segmentLength);
+				length += segmentLength;
+				if (parent)
+					fixedSegmentCount = segmentCount;
 			}
+			pSegment = *pEnd ? pEnd + 1 : pEnd;
 		}
+		pOut[length] = '\0';
 	}
 
-	void add_resource(GeometryLoadDesc* pDesc, SyncToken* token)
+	static eastl::string util_get_texture_cache_key(const TextureLoadDesc* pDesc)
 	{
-		ASSERT(pDesc->ppGeometry);
+		char path[SG_MAX_FILEPATH];
+		util_normalize_resource_path(pDesc->fileName, path);
 
-		GeometryLoadDesc updateDesc = *pDesc;
-		updateDesc.fileName = pDesc->fileName;
-		updateDesc.pVertexLayout = (VertexLayout*)sg_calloc(1, sizeof(VertexLayout));
-		memcpy(updateDesc.pVertexLayout, pDesc->pVertexLayout, sizeof(VertexLayout));
-		queue_geometry_load(pResourceLoader, &updateDesc, token);
-		if (pResourceLoader->desc.singleThreaded)
-		{
-			streamer_thread_func(pResourceLoader);
-		}
+		eastl::string key;
+		key.sprintf("texture|%s|%u|%u|%u|%u|%u", path, (uint32_t)pDesc->container, (uint32_t)pDesc->creationFlag, pDesc->nodeIndex,
+			(uint32_t)pDesc->mipFilter, (uint32_t)pDesc->mipFlags);
+		return key;
 	}
 
-	void remove_resource(Buffer* pBuffer)
+	static eastl::string util_get_geometry_cache_key(const GeometryLoadDesc* pDesc)
 	{
-		remove_buffer(pResourceLoader->pRenderer, pBuffer);
-	}
+		char path[SG_MAX_FILEPATH];
+		util_normalize_resource_path(pDesc->fileName, path);
 
-	void remove_resource(Texture* pTexture)
-	{
-		remove_texture(pResourceLoader->pRenderer, pTexture);
+		// the layout hash covers the vertex layout, the optimizations and the LODs
+		eastl::string key;
+		key.sprintf("geometry|%s|%llx|%u|%u", path, (unsigned long long)util_hash_cooked_geometry_layout(pDesc), (uint32_t)pDesc->flags, pDesc->nodeIndex);
+		return key;
 	}
 
-	void remove_resource(Geometry* pGeom)
+	/// Take a reference to the entry of key (call inside resourceCacheMutex). The resource is written to *ppResource right away if its load
+	/// was recorded already and when the load is recorded otherwise, token receives the token of the load. Returns false on a cache miss
+	static bool join_cached_resource(ResourceLoader* pLoader, const eastl::string& key, void** ppResource, SyncToken* token)
 	{
-		remove_resource(pGeom->pIndexBuffer);
-
-		for (uint32_t i = 0; i < pGeom->vertexBufferCount; ++i)
-			remove_resource(pGeom->pVertexBuffers[i]);
+		auto iter = pLoader->resourceCache.find(key);
+		if (iter == pLoader->resourceCache.end())
+			return false;
 
-		sg_free(pGeom);
+		CachedResource* pCached = iter->second;
+		++pCached->refCount;
+		++pLoader->resourceCacheHits;
+		if (pCached->pResource)
+			*ppResource = pCached->pResource;
+		else
+			pCached->waiters.push_back(ppResource);
+		if (token) util_merge_token(pLoader, token, pCached->token);
+		return true;
 	}
 
-	void begin_update_resource(BufferUpdateDesc* pBufferUpdate)
+	/// Entry for a load which is about to be queued (call inside resourceCacheMutex)
+	static CachedResource* add_cached_resource(ResourceLoader* pLoader, const eastl::string& key)
 	{
-		Buffer* pBuffer = pBufferUpdate->pBuffer;
-		ASSERT(pBuffer);
-
-		uint64_t size = pBufferUpdate->size > 0 ? pBufferUpdate->size : (pBufferUpdate->pBuffer->size - pBufferUpdate->dstOffset);
-		ASSERT(pBufferUpdate->dstOffset + size <= pBuffer->size);
+		CachedResource* pCached = sg_new(CachedResource);
+		pCached->key = key;
+		pCached->refCount = 1;
+		pLoader->resourceCache[key] = pCached;
+		return pCached;
+	}
 
-		ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->memoryUsage;
-		if (UMA || memoryUsage != SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
+	/// Hand the loaded resource to the add_resource calls that joined the load, a failed or cancelled load (null pResource) drops the entry
+	static void resolve_cached_resource(ResourceLoader* pLoader, CachedResource* pCached, void* pResource)
+	{
+		MutexLock lck(pLoader->resourceCacheMutex);
+		if (!pResource)
 		{
-			bool map = !pBuffer->pCpuMappedAddress;
-			if (map)
-			{
-				map_buffer(pResourceLoader->pRenderer, pBuffer, nullptr);
-			}
-
-			pBufferUpdate->mInternal.mappedRange = { (uint8_t*)pBuffer->pCpuMappedAddress + pBufferUpdate->dstOffset, pBuffer };
-			pBufferUpdate->pMappedData = pBufferUpdate->mInternal.mappedRange.pData;
-			pBufferUpdate->mInternal.mappedRange.flags = map ? MAPPED_RANGE_FLAG_UNMAP_BUFFER : 0;
+			pLoader->resourceCache.erase(pCached->key);
+			sg_delete(pCached);
+			return;
 		}
-		else
-		{
-			// we need to use a staging buffer.
-			MappedMemoryRange range = allocate_upload_memory(pResourceLoader->pRenderer, size, SG_RESOURCE_BUFFER_ALIGNMENT);
-			pBufferUpdate->pMappedData = range.pData;
 
-			pBufferUpdate->mInternal.mappedRange = range;
-			pBufferUpdate->mInternal.mappedRange.flags = MAPPED_RANGE_FLAG_TEMP_BUFFER;
-		}
+		pCached->pResource = pResource;
+		for (void** ppResource : pCached->waiters)
+			*ppResource = pResource;
+		pCached->waiters.clear();
+		pLoader->cachedResources[pResource] = pCached;
 	}
 
-	void end_update_resource(BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+	/// Drop a reference to a cached resource, returns true if other add_resource calls still hold it.
+	/// Resources which are not in the cache are not referenced by anyone else
+	static bool release_cached_resource(ResourceLoader* pLoader, void* pResource)
 	{
-		if (pBufferUpdate->mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_UNMAP_BUFFER)
-		{
-			unmap_buffer(pResourceLoader->pRenderer, pBufferUpdate->pBuffer);
-		}
+		if (!pLoader->desc.enableResourceCache)
+			return false;
 
-		ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->memoryUsage;
-		if (!UMA && memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
-		{
-			queue_buffer_update(pResourceLoader, pBufferUpdate, token);
-		}
+		MutexLock lck(pLoader->resourceCacheMutex);
+		auto iter = pLoader->cachedResources.find(pResource);
+		if (iter == pLoader->cachedResources.end())
+			return false;
 
-		// Restore the state to before the beginUpdateResource call.
-		pBufferUpdate->pMappedData = nullptr;
-		pBufferUpdate->mInternal = {};
-		if (pResourceLoader->desc.singleThreaded)
-		{
-			streamer_thread_func(pResourceLoader);
-		}
+		CachedResource* pCached = iter->second;
+		if (--pCached->refCount > 0)
+			return true;
+
+		pLoader->cachedResources.erase(iter);
+		pLoader->resourceCache.erase(pCached->key);
+		sg_delete(pCached);
+		return false;
 	}
 
-	void begin_update_resource(TextureUpdateDesc* pTextureUpdate)
+	// Buffer pools
+	// a pool owns a list of large buffers (blocks) with a range allocator each, its buffers are Buffer structs pointing at a range of a block
+
+	typedef struct BufferPoolBlock
 	{
-		const Texture* texture = pTextureUpdate->pTexture;
-		const TinyImageFormat fmt = (TinyImageFormat)texture->format;
-		const uint32_t alignment = util_get_texture_subresource_alignment(pResourceLoader->pRenderer, fmt);
+		Buffer*         pBuffer;
+		RangeAllocator* pAllocator;
+		uint32_t        allocationCount;
+	} BufferPoolBlock;
 
-		bool success = util_get_surface_info(
-			SG_MIP_REDUCE(texture->width, pTextureUpdate->mipLevel),
-			SG_MIP_REDUCE(texture->height, pTextureUpdate->mipLevel),
-			fmt,
-			&pTextureUpdate->srcSliceStride,
-			&pTextureUpdate->srcRowStride,
-			&pTextureUpdate->rowCount);
-		ASSERT(success);
-		UNREF_PARAM(success);
+	struct BufferPool
+	{
+		BufferPoolDesc                 desc;
+		/// every range starts at a multiple of it, so descriptors and dynamic offsets can use any of them
+		uint64_t                       alignment;
+		Mutex                          mutex;
+		eastl::vector<BufferPoolBlock> blocks;
+	};
 
-		pTextureUpdate->dstRowStride = round_up(pTextureUpdate->srcRowStride, util_get_texture_row_alignment(pResourceLoader->pRenderer));
-		pTextureUpdate->dstSliceStride = round_up(pTextureUpdate->dstRowStride * pTextureUpdate->rowCount, alignment);
+	/// The Buffer comes first, so remove_resource(Buffer*) finds the range of a pooled buffer again
+	typedef struct PooledBuffer
+	{
+		Buffer          buffer;
+		BufferPool*     pPool;
+		RangeAllocator* pAllocator;
+		RangeAllocation allocation;
+	} PooledBuffer;
 
-		const ssize_t requiredSize = round_up(
-			SG_MIP_REDUCE(texture->depth, pTextureUpdate->mipLevel) * pTextureUpdate->dstRowStride * pTextureUpdate->rowCount,
-			alignment);
+	static void util_add_buffer_pool_block(Renderer* pRenderer, BufferPool* pPool, uint64_t size)
+	{
+		BufferCreateDesc desc = {};
+		desc.size = size;
+		desc.descriptors = pPool->desc.descriptors;
+		desc.memoryUsage = pPool->desc.memoryUsage;
+		desc.flags = pPool->desc.flags;
+		if (desc.memoryUsage != SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
+			desc.flags |= SG_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+		desc.nodeIndex = pPool->desc.nodeIndex;
+		desc.name = pPool->desc.name;
+		desc.startState = util_determine_resource_start_state(&desc);
+
+		BufferPoolBlock block = {};
+		add_buffer(pRenderer, &desc, &block.pBuffer);
+		add_range_allocator(size, pPool->alignment, &block.pAllocator);
+		pPool->blocks.push_back(block);
+	}
 
-		// We need to use a staging buffer.
-		pTextureUpdate->mInternal.mappedRange = allocate_upload_memory(pResourceLoader->pRenderer, requiredSize, alignment);
-		pTextureUpdate->mInternal.mappedRange.flags = MAPPED_RANGE_FLAG_TEMP_BUFFER;
-		pTextureUpdate->pMappedData = pTextureUpdate->mInternal.mappedRange.pData;
+	static void util_remove_buffer_pool_block(Renderer* pRenderer, BufferPoolBlock* pBlock)
+	{
+		ASSERT(!pBlock->allocationCount && "Buffers of the pool are still alive");
+		remove_buffer(pRenderer, pBlock->pBuffer);
+		remove_range_allocator(pBlock->pAllocator);
 	}
 
-	void end_update_resource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
+	/// Returns false if the pool could not take the buffer, the caller creates a regular buffer for it then
+	static bool util_add_pooled_buffer(Renderer* pRenderer, BufferPool* pPool, const BufferCreateDesc* pDesc, Buffer** ppBuffer)
 	{
-		TextureUpdateDescInternal desc = {};
-		desc.pTexture = pTextureUpdate->pTexture;
-		desc.range = pTextureUpdate->mInternal.mappedRange;
-		desc.baseMipLevel = pTextureUpdate->mipLevel;
-		desc.mipLevels = 1;
-		desc.baseArrayLayer = pTextureUpdate->arrayLayer;
-		desc.layerCount = 1;
-		queue_texture_update(pResourceLoader, &desc, token);
+		ASSERT(pDesc->size > 0);
+		ASSERT(pDesc->memoryUsage == pPool->desc.memoryUsage && pDesc->nodeIndex == pPool->desc.nodeIndex);
+		ASSERT(!(pDesc->descriptors & ~pPool->desc.descriptors) && "The usage class of the pool does not cover the buffer");
+		ASSERT(pDesc->format == TinyImageFormat_UNDEFINED && !pDesc->firstElement && "Pooled buffers have no texel views and start at their first element");
 
-		// Restore the state to before the beginUpdateResource call.
-		pTextureUpdate->pMappedData = NULL;
-		pTextureUpdate->mInternal = {};
-		if (pResourceLoader->desc.singleThreaded)
+		PooledBuffer* pPooled = (PooledBuffer*)sg_calloc_memalign(1, alignof(PooledBuffer), sizeof(PooledBuffer));
+		pPooled->pPool = pPool;
+
+		MutexLock lck(pPool->mutex);
+		BufferPoolBlock* pBlock = nullptr;
+		for (BufferPoolBlock& block : pPool->blocks)
 		{
-			streamer_thread_func(pResourceLoader);
+			if (allocate_range(block.pAllocator, pDesc->size, &pPooled->allocation))
+			{
+				pBlock = &block;
+				break;
+			}
+		}
+		if (!pBlock)
+		{
+			// a buffer larger than the blocks gets a block of its own size, which is released again with it
+			util_add_buffer_pool_block(pRenderer, pPool, eastl::max(pPool->desc.blockSize, round_up_64(pDesc->size, pPool->alignment)));
+			pBlock = &pPool->blocks.back();
+			if (!allocate_range(pBlock->pAllocator, pDesc->size, &pPooled->allocation))
+			{
+				SG_LOG_WARNING("Buffer pool (%s) could not place a buffer of %llu bytes, creating it outside of the pool",
+					pPool->desc.name ? pPool->desc.name : "", (unsigned long long)pDesc->size);
+				util_remove_buffer_pool_block(pRenderer, pBlock);
+				pPool->blocks.pop_back();
+				sg_free(pPooled);
+				return false;
+			}
 		}
+		++pBlock->allocationCount;
+		pPooled->pAllocator = pBlock->pAllocator;
+
+		const Buffer* pShared = pBlock->pBuffer;
+		Buffer* pBuffer = &pPooled->buffer;
+		pBuffer->pCpuMappedAddress = pShared->pCpuMappedAddress ? (uint8_t*)pShared->pCpuMappedAddress + pPooled->allocation.offset : nullptr;
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		pBuffer->pVkBuffer = pShared->pVkBuffer;
+		pBuffer->offset = pPooled->allocation.offset;
+	#endif
+		pBuffer->size = pDesc->size;
+		pBuffer->descriptors = pDesc->descriptors;
+		pBuffer->memoryUsage = pDesc->memoryUsage;
+		pBuffer->nodeIndex = pDesc->nodeIndex;
+		pBuffer->pooled = 1;
+		*ppBuffer = pBuffer;
+		return true;
 	}
 
-	SyncToken get_last_token_completed()
+	static void util_remove_pooled_buffer(Renderer* pRenderer, PooledBuffer* pPooled)
 	{
-		return sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted);
+		BufferPool* pPool = pPooled->pPool;
+		{
+			MutexLock lck(pPool->mutex);
+			for (uint32_t i = 0; i < (uint32_t)pPool->blocks.size(); ++i)
+			{
+				BufferPoolBlock& block = pPool->blocks[i];
+				if (block.pAllocator != pPooled->pAllocator)
+					continue;
+
+				free_range(block.pAllocator, &pPooled->allocation);
+				// the first block stays for the next buffers, the others go once they are empty
+				if (!--block.allocationCount && i > 0)
+				{
+					util_remove_buffer_pool_block(pRenderer, &block);
+					pPool->blocks.erase(pPool->blocks.begin() + i);
+				}
+				break;
+			}
+		}
+		sg_free(pPooled);
 	}
 
-	bool is_token_completed(const SyncToken* token)
+	// Batched load stages
+	// the stages of a load that only touch CPU memory (decode, fill) are spread over the loader's ThreadSystem,
+	// everything that talks to the GPU (creating objects, reserving staging memory, recording commands) stays on the loader thread
+
+	static void decode_load_task(uintptr_t index, void* pUserData)
 	{
-		return *token <= sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted);
+		LoadTask* pTask = (LoadTask*)pUserData + index;
+		if (SG_UPDATE_REQUEST_LOAD_TEXTURE == pTask->pRequest->type)
+			pTask->result = decode_texture(&pTask->pRequest->texLoadDesc, pTask->pTextureState);
+		else
+			pTask->result = decode_geometry(&pTask->pRequest->geomLoadDesc, pTask->pGeometryState);
 	}
 
-	void wait_for_token(const SyncToken* token)
+	static void reserve_load_task(Renderer* pRenderer, LoadTask* pTask)
 	{
-		wait_for_token(pResourceLoader, token);
+		if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED != pTask->result)
+			return;
+
+		if (SG_UPDATE_REQUEST_LOAD_TEXTURE == pTask->pRequest->type)
+			reserve_texture(pRenderer, &pTask->pRequest->texLoadDesc, pTask->pTextureState);
+		else
+			reserve_geometry(pRenderer, &pTask->pRequest->geomLoadDesc, pTask->pGeometryState);
 	}
 
-	bool all_resource_loads_completed()
+	static void fill_load_task(uintptr_t index, void* pUserData)
 	{
-		SyncToken token = sg_atomic64_load_relaxed(&pResourceLoader->tokenCounter);
-		return token <= sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted);
+		LoadTask* pTask = (LoadTask*)pUserData + index;
+		if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED != pTask->result)
+			return;
+
+		if (SG_UPDATE_REQUEST_LOAD_TEXTURE == pTask->pRequest->type)
+			pTask->result = fill_texture(pResourceLoader->pRenderer, pTask->pTextureState);
+		else
+			fill_geometry(&pTask->pRequest->geomLoadDesc, pTask->pGeometryState);
 	}
 
-	void wait_for_all_resource_loads()
+	static UploadFunctionResult record_load_task(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, LoadTask* pTask)
 	{
-		SyncToken token = sg_atomic64_load_relaxed(&pResourceLoader->tokenCounter);
-		wait_for_token(pResourceLoader, &token);
-	}
+		UploadFunctionResult result = pTask->result;
+		void* pResource = nullptr;
+		if (SG_UPDATE_REQUEST_LOAD_TEXTURE == pTask->pRequest->type)
+		{
+			if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED == result)
+				result = load_texture(pRenderer, pCopyEngine, activeSet, &pTask->pRequest->texLoadDesc, pTask->pTextureState);
+			if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED == result)
+				pResource = *pTask->pRequest->texLoadDesc.ppTexture;
+			sg_delete(pTask->pTextureState);
+		}
+		else
+		{
+			if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED == result)
+				result = load_geometry(pRenderer, pCopyEngine, activeSet, &pTask->pRequest->geomLoadDesc, pTask->pGeometryState);
+			if (SG_UPLOAD_FUNCTION_RESULT_COMPLETED == result)
+				pResource = *pTask->pRequest->geomLoadDesc.ppGeometry;
+			sg_delete(pTask->pGeometryState);
+		}
 
-#pragma endregion (Interface Implemetation)
+		// the resource is recorded before the token of the load completes, so everyone who joined it has it in time
+		if (pTask->pRequest->pCachedResource)
+			resolve_cached_resource(pResourceLoader, pTask->pRequest->pCachedResource, pResource);
+		pTask->pRequest = nullptr;
+		return result;
+	}
 
-	// Shader loading
-	#if defined(__ANDROID__) && defined(SG_GRAPHIC_API_VULKAN)
-	// Translate Vulkan Shader Type to shaderc shader type
-	shaderc_shader_kind getShadercShaderType(ShaderStage type)
+	/// Run one CPU stage over all the load tasks of the batch.
+	/// The loader thread helps out with the tasks instead of sleeping and returns once every task of the stage is done.
+	static void run_load_stage(ResourceLoader* pLoader, eastl::vector<LoadTask>& loadTasks, TaskFunc pStageFunc)
 	{
-		switch (type)
+		if (loadTasks.empty())
+			return;
+
+		if (!pLoader->pThreadSystem || loadTasks.size() == 1)
 		{
-		case ShaderStage::SHADER_STAGE_VERT: return shaderc_glsl_vertex_shader;
-		case ShaderStage::SHADER_STAGE_FRAG: return shaderc_glsl_fragment_shader;
-		case ShaderStage::SHADER_STAGE_TESC: return shaderc_glsl_tess_control_shader;
-		case ShaderStage::SHADER_STAGE_TESE: return shaderc_glsl_tess_evaluation_shader;
-		case ShaderStage::SHADER_STAGE_GEOM: return shaderc_glsl_geometry_shader;
-		case ShaderStage::SHADER_STAGE_COMP: return shaderc_glsl_compute_shader;
-		default: break;
+			for (size_t i = 0; i < loadTasks.size(); ++i)
+				pStageFunc(i, loadTasks.data());
+			return;
 		}
 
-		ASSERT(false);
-		return static_cast<shaderc_shader_kind>(-1);
+		add_thread_system_range_task(pLoader->pThreadSystem, pStageFunc, loadTasks.data(), loadTasks.size());
+		while (assist_thread_system(pLoader->pThreadSystem))
+			;
+		wait_thread_system_idle(pLoader->pThreadSystem);
 	}
-	#endif
 
-	#if defined(SG_GRAPHIC_API_VULKAN)
-		#if defined(__ANDROID__)
-		// Android:
-		// Use shaderc to compile glsl to spirV
-		void vk_compileShader(
-			Renderer* pRenderer, ShaderStage stage, uint32_t codeSize, const char* code, const char* outFile, uint32_t macroCount,
-			ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
+	/// Decode and fill every texture and geometry load of the batch, so that only the recording is left for the streamer loop
+	static void prepare_load_tasks(ResourceLoader* pLoader, eastl::vector<UpdateRequest>& activeQueue, eastl::vector<LoadTask>& loadTasks)
+	{
+		for (UpdateRequest& request : activeQueue)
 		{
-			// compile into spir-V shader
-			shaderc_compiler_t           compiler = shaderc_compiler_initialize();
-			shaderc_compile_options_t	 options = shaderc_compile_options_initialize();
-			for (uint32_t i = 0; i < macroCount; ++i)
+			LoadTask task = {};
+			task.pRequest = &request;
+			task.result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+			if (SG_UPDATE_REQUEST_LOAD_TEXTURE == request.type)
 			{
-				shaderc_compile_options_add_macro_definition(options, pMacros[i].definition, strlen(pMacros[i].definition),
-					pMacros[i].value, strlen(pMacros[i].value));
+				task.pTextureState = sg_new(TextureLoadState);
+				task.pTextureState->pStreamed = request.pStreamedTexture;
 			}
+			else if (SG_UPDATE_REQUEST_LOAD_GEOMETRY == request.type)
+				task.pGeometryState = sg_new(GeometryLoadState);
+			else
+				continue;
+			loadTasks.push_back(task);
+		}
 
-			eastl::string android_definition = "TARGET_ANDROID";
-			shaderc_compile_options_add_macro_definition(options, android_definition.c_str(), android_definition.size(), "1", 1);
-
-			shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+		run_load_stage(pLoader, loadTasks, decode_load_task);
+		for (LoadTask& task : loadTasks)
+			reserve_load_task(pLoader->pRenderer, &task);
+		run_load_stage(pLoader, loadTasks, fill_load_task);
+	}
 
-			shaderc_compilation_result_t spvShader =
-				shaderc_compile_into_spv(compiler, code, codeSize, getShadercShaderType(stage), "shaderc_error", pEntryPoint ? pEntryPoint : "main", options);
-			shaderc_compilation_status spvStatus = shaderc_result_get_compilation_status(spvShader);
-			if (spvStatus != shaderc_compilation_status_success)
+	// internal Resource Loader Implementation
+	// to check if there are some loading operation is functioning
+	static bool are_tasks_available(ResourceLoader* pLoader)
+	{
+		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
+		{
+			for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
 			{
-				const char* errorMessage = shaderc_result_get_error_message(spvShader);
-				LOGF(LogLevel::eERROR, "Shader compiling failed! with status %s", errorMessage);
-				abort();
+				if (!pLoader->requestQueue[i][priority].empty())
+				{
+					return true;
+				}
 			}
-
-			// Resize the byteCode block based on the compiled shader size
-			pOut->mByteCodeSize = shaderc_result_get_length(spvShader);
-			pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
-			memcpy(pOut->pByteCode, shaderc_result_get_bytes(spvShader), pOut->mByteCodeSize);
-
-			// Release resources
-			shaderc_result_release(spvShader);
-			shaderc_compiler_release(compiler);
 		}
-		#else
-		// PC:
-		// Vulkan has no builtin functions to compile source to spirv
-		// So we call the glslangValidator tool located inside VulkanSDK on user machine to compile the glsl code to spirv
-		// This code is not added to Vulkan.cpp since it calls no Vulkan specific functions
-		void vk_compile_shader(
-			Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, const char* outFile, uint32_t macroCount,
-			ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
-		{
-			eastl::string commandLine;
-			char filePath[SG_MAX_FILEPATH] = { 0 };
-			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_SOURCES), fileName, filePath);
-			char outFilePath[SG_MAX_FILEPATH] = { 0 };
-			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_BINARIES), outFile, outFilePath);
-
-			// if there is a config file located in the shader source directory use it to specify the limits
-			FileStream confStream = {};
-			if (sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, "config.conf", SG_FM_READ, &confStream))
-			{
-				sgfs_close_stream(&confStream);
-				char configFilePath[SG_MAX_FILEPATH] = { 0 };
-				sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_SOURCES), "config.conf", configFilePath);
+		return false;
+	}
 
-				// dd command to compile from Vulkan GLSL to Spirv
-				commandLine.append_sprintf(
-					"\"%s\" -V \"%s\" -o \"%s\"",
-					configFilePath,
-					filePath,
-					outFilePath);
-			}
-			else
+	/// Lowest token still waiting in any queue, 0 if the queues are empty (call inside queueMutex)
+	static SyncToken get_lowest_pending_token(ResourceLoader* pLoader)
+	{
+		SyncToken lowest = 0;
+		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
+		{
+			for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
 			{
-				commandLine.append_sprintf("-V \"%s\" -o \"%s\"",
-					filePath,
-					outFilePath);
+				const eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[i][priority];
+				// queues are sorted by token
+				if (!queue.empty() && (!lowest || queue.front().waitIndex < lowest))
+				{
+					lowest = queue.front().waitIndex;
+				}
 			}
+		}
+		return lowest;
+	}
 
-			if (target >= SG_SHADER_TARGET_6_0)
-				commandLine += " --target-env vulkan1.1 ";
-			//commandLine += " \"-D" + eastl::string("VULKAN") + "=" + "1" + "\"";
+	/// Move the requests the next batch works on out of the queues (call inside queueMutex).
+	/// All immediate requests are taken, visible and prefetch requests only up to the streaming budget of a batch,
+	/// the rest stays queued so requests of a higher priority coming in meanwhile get ahead of them.
+	static void acquire_request_batch(ResourceLoader* pLoader, uint32_t nodeIndex, eastl::vector<UpdateRequest>& activeQueue)
+	{
+		eastl::vector<UpdateRequest>* queues = pLoader->requestQueue[nodeIndex];
+		for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
+		{
+			pLoader->peakQueueDepth[priority] = eastl::max(pLoader->peakQueueDepth[priority], (uint32_t)queues[priority].size());
+		}
 
-			if (pEntryPoint != nullptr)
-				commandLine.append_sprintf(" -e %s", pEntryPoint);
+		eastl::swap(queues[SG_LOAD_PRIORITY_IMMEDIATE], activeQueue);
 
-			// add platform macro
-		#ifdef SG_PLATFORM_WINDOWS
-			commandLine += " \"-D WINDOWS\"";
-		#elif defined(__ANDROID__)
-			commandLine += " \"-D ANDROID\"";
-		#elif defined(__linux__)
-			commandLine += " \"-D LINUX\"";
-		#endif
+		size_t budget = pLoader->pThreadSystem ? get_thread_system_thread_count(pLoader->pThreadSystem) * SG_STREAMING_LOADS_PER_WORKER : SG_STREAMING_LOADS_PER_WORKER;
+		for (uint32_t priority = SG_LOAD_PRIORITY_IMMEDIATE + 1; priority < SG_LOAD_PRIORITY_COUNT && budget; ++priority)
+		{
+			eastl::vector<UpdateRequest>& queue = queues[priority];
+			size_t count = eastl::min(budget, queue.size());
+			activeQueue.insert(activeQueue.end(), queue.begin(), queue.begin() + count);
+			queue.erase(queue.begin(), queue.begin() + count);
+			budget -= count;
+		}
+	}
 
-			// add user defined macros to the command line
-			for (uint32_t i = 0; i < macroCount; ++i)
+	/// Run the worker callbacks until none is left
+	static void run_load_callbacks_task(uintptr_t, void* pUserData)
+	{
+		ResourceLoader* pLoader = (ResourceLoader*)pUserData;
+		for (;;)
+		{
+			LoadCallback callback = {};
 			{
-				commandLine += " \"-D" + eastl::string(pMacros[i].definition) + "=" + pMacros[i].value + "\"";
+				MutexLock lck(pLoader->tokenMutex);
+				if (pLoader->nextWorkerCallback == (uint32_t)pLoader->workerCallbacks.size())
+				{
+					pLoader->workerCallbacks.clear();
+					pLoader->nextWorkerCallback = 0;
+					--pLoader->workerCallbackTaskCount;
+					return;
+				}
+				callback = pLoader->workerCallbacks[pLoader->nextWorkerCallback++];
 			}
+			callback.pFunc(callback.pUserData);
+		}
+	}
 
-			eastl::string glslangValidator = ::getenv("VULKAN_SDK");
-			if (glslangValidator.size())
-				glslangValidator += "/Bin/glslangValidator";
-			else
-				glslangValidator = "/usr/Bin/glslangValidator";
-			
-			const char* args[1] = { commandLine.c_str() };
+	/// Queue a worker callback and start a task for it unless enough of them are draining the queue already (call inside tokenMutex)
+	static bool util_queue_worker_callback(ResourceLoader* pLoader, const LoadCallback& callback)
+	{
+		pLoader->workerCallbacks.push_back(callback);
+		if (pLoader->workerCallbackTaskCount >= SG_LOAD_CALLBACK_THREAD_COUNT)
+			return false;
+		++pLoader->workerCallbackTaskCount;
+		return true;
+	}
 
-			char logFileName[SG_MAX_FILEPATH] = { 0 };
-			sgfs_get_path_file_name(outFile, logFileName);
-			strcat(logFileName, "_compile.log");
+	/// Publish tokens whose own work is done: complete the ones that wait for nothing else any more, wake the threads waiting
+	/// for them and hand out the callbacks they complete
+	static void signal_completed_tokens(ResourceLoader* pLoader, const PendingToken* pTokens, uint32_t count)
+	{
+		uint32_t taskCount = 0;
+		{
+			MutexLock lck(pLoader->tokenMutex);
+			pLoader->pendingTokens.insert(pLoader->pendingTokens.end(), pTokens, pTokens + count);
+			if (pLoader->pendingTokens.empty())
+				return;
 
-			char logFilePath[SG_MAX_FILEPATH] = { 0 };
-			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_BINARIES), logFileName, logFilePath);
+			// a token only waits for lower ones, so in order a single pass completes the chains
+			eastl::sort(pLoader->pendingTokens.begin(), pLoader->pendingTokens.end(),
+				[](const PendingToken& a, const PendingToken& b) { return a.token < b.token; });
+			uint32_t blocked = 0;
+			for (const PendingToken& pending : pLoader->pendingTokens)
+			{
+				if ((pending.waitFor[0] && !util_is_token_completed(pLoader, pending.waitFor[0])) ||
+					(pending.waitFor[1] && !util_is_token_completed(pLoader, pending.waitFor[1])))
+				{
+					pLoader->pendingTokens[blocked++] = pending;
+					continue;
+				}
+				eastl::vector<SyncToken>& completed = pLoader->completedTokens;
+				completed.insert(eastl::upper_bound(completed.begin(), completed.end(), pending.token), pending.token);
+			}
+			pLoader->pendingTokens.resize(blocked);
 
-			if (system_run(glslangValidator.c_str(), args, 1, logFilePath) == 0)
+			// move the watermark over the completed tokens that are contiguous with it
+			SyncToken watermark = sg_atomic64_load_relaxed(&pLoader->tokenCompleted);
+			uint32_t contiguous = 0;
+			for (SyncToken token : pLoader->completedTokens)
 			{
-				FileStream fh = {};
-				bool success = sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, outFile, SG_FM_READ_BINARY, &fh);
-				//Check if the File Handle exists
-				ASSERT(success);
-				pOut->byteCodeSize = (uint32_t)sgfs_get_stream_file_size(&fh);
-				pOut->pByteCode = sg_malloc(pOut->byteCodeSize);
-				sgfs_read_from_stream(&fh, pOut->pByteCode, pOut->byteCodeSize);
-				sgfs_close_stream(&fh);
+				if (token > watermark + 1)
+					break;
+				watermark = eastl::max(watermark, token);
+				++contiguous;
 			}
-			else
+			pLoader->completedTokens.erase(pLoader->completedTokens.begin(), pLoader->completedTokens.begin() + contiguous);
+			sg_atomic64_store_release(&pLoader->tokenCompleted, watermark);
+
+			for (uint32_t i = 0; i < (uint32_t)pLoader->tokenWaiters.size();)
 			{
-				FileStream fh = {};
-				// If for some reason the error file could not be created just log error msg
-				if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, logFileName, SG_FM_READ_BINARY, &fh))
+				TokenWaiter* pWaiter = pLoader->tokenWaiters[i];
+				if (util_is_token_completed(pLoader, pWaiter->token))
+				{
+					pWaiter->cv.WakeAll();
+					pLoader->tokenWaiters.erase_unsorted(pLoader->tokenWaiters.begin() + i);
+					continue;
+				}
+				++i;
+			}
+
+			// keep the remaining callbacks in the order they were added
+			uint32_t remaining = 0;
+			for (LoadCallback& callback : pLoader->loadCallbacks)
+			{
+				if (!util_is_token_completed(pLoader, callback.token))
 				{
-					SG_LOG_ERROR("Failed to compile shader %s", filePath);
+					pLoader->loadCallbacks[remaining++] = callback;
+				}
+				else if (SG_LOAD_CALLBACK_DISPATCH_WORKER == callback.dispatch && pLoader->pCallbackThreadSystem)
+				{
+					taskCount += util_queue_worker_callback(pLoader, callback) ? 1 : 0;
 				}
 				else
 				{
-					size_t size = sgfs_get_stream_file_size(&fh);
-					if (size)
-					{
-						char* errorLog = (char*)sg_malloc(size + 1);
-						errorLog[size] = 0;
-						sgfs_read_from_stream(&fh, errorLog, size);
-						SG_LOG_ERROR("Failed to compile shader %s with error\n%s", filePath, errorLog);
-					}
-					sgfs_close_stream(&fh);
+					pLoader->readyCallbacks.push_back(callback);
 				}
 			}
+			pLoader->loadCallbacks.resize(remaining);
 		}
-		#endif
-		#elif defined(SG_GRAPHIC_API_METAL)
-		// On Metal, on the other hand, we can compile from code into a MTLLibrary, but cannot save this
-		// object's bytecode to disk. We instead use the xcbuild bash tool to compile the shaders.
-		void mtl_compileShader(
-			Renderer* pRenderer, const char* fileName, const char* outFile, uint32_t macroCount, ShaderMacro* pMacros,
-			BinaryShaderStageDesc* pOut, const char* /*pEntryPoint*/)
-		{
-			char filePath[FS_MAX_PATH] = {};
-			fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_SOURCES), fileName, filePath);
-			char outFilePath[FS_MAX_PATH] = {};
-			fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_BINARIES), outFile, outFilePath);
-			char intermediateFilePath[FS_MAX_PATH] = {};
-			fsAppendPathExtension(outFilePath, "air", intermediateFilePath);
 
-			const char* xcrun = "/usr/bin/xcrun";
-			eastl::vector<eastl::string> args;
-			eastl::string tmpArg = "";
+		if (taskCount)
+		{
+			add_thread_system_range_task(pLoader->pCallbackThreadSystem, run_load_callbacks_task, pLoader, taskCount);
+		}
+	}
 
-			// Compile the source into a temporary .air file.
-			args.push_back("-sdk");
-			args.push_back("macosx");
-			args.push_back("metal");
-			args.push_back("-c");
-			args.push_back(filePath);
-			args.push_back("-o");
-			args.push_back(intermediateFilePath);
+	static void streamer_thread_func(void* pThreadData)
+	{
+		Thread::set_curr_thread_name("ResourceLoading");
+		SG_LOG_DEBUG("Thread ID: %ul is loading resourece", Thread::get_curr_thread_id());
 
-			//enable the 2 below for shader debugging on xcode
-			//args.push_back("-MO");
-			//args.push_back("-gline-tables-only");
-			args.push_back("-D");
-			args.push_back("MTL_SHADER=1");    // Add MTL_SHADER macro to differentiate structs in headers shared by app/shader code.
+		ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
+		ASSERT(pLoader);
 
-			// Add user defined macros to the command line
-			for (uint32_t i = 0; i < macroCount; ++i)
-			{
-				args.push_back("-D");
-				args.push_back(eastl::string(pMacros[i].definition) + "=" + pMacros[i].value);
-			}
+	#if defined(SG_GRAPHIC_API_GLES)
+		GLContext localContext;
+		if (!pLoader->desc.mSingleThreaded)
+			initGLContext(pLoader->pRenderer->pConfig, &localContext, pLoader->pRenderer->pContext);
+	#endif
 
-			eastl::vector<const char*> cArgs;
-			for (eastl::string& arg : args) {
-				cArgs.push_back(arg.c_str());
-			}
+		uint32_t linkedGPUCount = pLoader->pRenderer->linkedNodeCount;
 
-			if (system_run(xcrun, &cArgs[0], cArgs.size(), NULL) == 0)
+		while (pLoader->run)
+		{
 			{
-				// Create a .metallib file from the .air file.
-				args.clear();
-				tmpArg = "";
-				args.push_back("-sdk");
-				args.push_back("macosx");
-				args.push_back("metallib");
-				args.push_back(intermediateFilePath);
-				args.push_back("-o");
-				tmpArg = eastl::string().sprintf(
-					""
-					"%s"
-					"",
-					outFilePath);
-				args.push_back(tmpArg);
+				MutexLock lck(pLoader->queueMutex);
+				//pLoader->queueMutex.Acquire();
 
-				cArgs.clear();
-				for (eastl::string& arg : args) {
-					cArgs.push_back(arg.c_str());
+				// check for pending tokens
+				// safe to use tokenCounter as we are inside critical section
+
+				// we are in the beginning of a new round
+				bool allTokensSignaled = (pLoader->tokenCompleted == sg_atomic64_load_relaxed(&pLoader->tokenCounter));
+
+				while (!are_tasks_available(pLoader) && allTokensSignaled && pLoader->run)
+				{
+					// no waiting if not running dedicated resource loader thread.
+					if (pLoader->desc.singleThreaded)
+					{
+						return;
+					}
+					// sleep until someone adds an update request to the queue
+					pLoader->queueCv.Wait(pLoader->queueMutex);
+				}
+				// copies are still in flight, poll them again after a short sleep (or a new request) instead of blocking on the GPU
+				if (!are_tasks_available(pLoader) && !allTokensSignaled && pLoader->run && !pLoader->desc.singleThreaded)
+				{
+					pLoader->queueCv.Wait(pLoader->queueMutex, SG_COPY_ENGINE_POLL_INTERVAL);
 				}
+				//pLoader->queueMutex.Release();
+			}
 
-				if (systemRun(xcrun, &cArgs[0], cArgs.size(), NULL) == 0)
+			// signal the tokens of the sets the copy queues are done with
+			for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+			{
+				poll_copy_engine_sets(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex]);
+			}
+			const uint32_t setCount = (uint32_t)pLoader->setTokens.size();
+			uint32_t freeSet = UINT32_MAX;
+			for (uint32_t i = 1; i <= setCount; ++i)
+			{
+				const uint32_t set = (pLoader->nextSet + i) % setCount;
+				bool inFlight = false;
+				for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
 				{
-					// Remove the temp .air file.
-					const char* nativePath = intermediateFilePath;
-					systemRun("rm", &nativePath, 1, NULL);
+					inFlight |= pLoader->pCopyEngines[nodeIndex].resourceSets[set].submitted;
+				}
+				if (inFlight)
+					continue;
 
-					// Store the compiled bytecode.
-					FileStream fHandle = {};
-					if (fsOpenStreamFromPath(RD_SHADER_BINARIES, outFile, FM_READ_BINARY, &fHandle))
+				eastl::vector<PendingToken>& setTokens = pLoader->setTokens[set];
+				signal_completed_tokens(pLoader, setTokens.data(), (uint32_t)setTokens.size());
+				setTokens.clear();
+				if (UINT32_MAX == freeSet)
+					freeSet = set;
+			}
+
+			// record into the next set that is not in flight, when the copy queues are behind on all of them a new one is added
+			if (UINT32_MAX == freeSet)
+			{
+				freeSet = setCount;
+				for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+				{
+					add_copy_engine_set(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex]);
+				}
+				pLoader->setTokens.push_back();
+			}
+			pLoader->nextSet = freeSet;
+			for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+			{
+				reset_copy_engine_set(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
+			}
+			eastl::vector<PendingToken>& setTokens = pLoader->setTokens[pLoader->nextSet];
+
+			for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+			{
+				uint64_t completionMask = 0;
+
+				CopyEngine& copyEngine = pLoader->pCopyEngines[nodeIndex];
+				eastl::vector<UpdateRequest> activeQueue;
+
+				pLoader->queueMutex.Acquire();
+				acquire_request_batch(pLoader, nodeIndex, activeQueue);
+				pLoader->queueMutex.Release();
+
+				if (activeQueue.empty()) // no job to do
+				{
+					continue;
+				}
+
+				// parse and decode all the loads of this batch in parallel and pack them into staging memory,
+				// the loop below only has to record the copies
+				eastl::vector<LoadTask> loadTasks;
+				prepare_load_tasks(pLoader, activeQueue, loadTasks);
+				LoadTask* pNextLoadTask = loadTasks.data();
+
+				size_t requestCount = activeQueue.size();
+				for (size_t j = 0; j < requestCount; ++j)
+				{
+					UpdateRequest updateState = activeQueue[j];
+					// each request completes on its own, an urgent one does not wait for the older ones still queued
+					setTokens.push_back({ updateState.waitIndex, { 0, 0 } });
+
+					UploadFunctionResult result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+					switch (updateState.type)
 					{
-						pOut->mByteCodeSize = (uint32_t)fsGetStreamFileSize(&fHandle);
-						pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
-						fsReadFromStream(&fHandle, pOut->pByteCode, pOut->mByteCodeSize);
-						fsCloseStream(&fHandle);
+					case SG_UPDATE_REQUEST_UPDATE_BUFFER:
+						result = update_buffer(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState.bufferUpdateDesc);
+						break;
+					case SG_UPDATE_REQUEST_UPDATE_TEXTURE:
+						result = update_texture(pLoader->pRenderer, &copyEngine, pLoader->nextSet, updateState.texUpdateDesc);
+						break;
+					case SG_UPDATE_REQUEST_BUFFER_BARRIER:
+						util_hand_over_buffer(&copyEngine, pLoader->nextSet, updateState.bufferBarrier);
+						result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+						break;
+					case SG_UPDATE_REQUEST_TEXTURE_BARRIER:
+						util_hand_over_texture(&copyEngine, pLoader->nextSet, updateState.textureBarrier);
+						result = SG_UPLOAD_FUNCTION_RESULT_COMPLETED;
+						break;
+					case SG_UPDATE_REQUEST_LOAD_TEXTURE:
+					case SG_UPDATE_REQUEST_LOAD_GEOMETRY:
+						ASSERT(pNextLoadTask->pRequest == &activeQueue[j]);
+						result = record_load_task(pLoader->pRenderer, &copyEngine, pLoader->nextSet, pNextLoadTask++);
+						break;
+					case SG_UPDATE_REQUEST_INVALID:
+						break;
+					}
+
+					if (updateState.pUploadBuffer)
+					{
+						// the copy is recorded in this batch, the range retires with it
+						release_staging_memory(&copyEngine, updateState.pUploadBuffer, true);
 					}
+
+					bool completed = result == SG_UPLOAD_FUNCTION_RESULT_COMPLETED || result == SG_UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+
+					completionMask |= completed << nodeIndex;
+
+					ASSERT(result != SG_UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
 				}
-				else
+
+				if (completionMask != 0)
 				{
-					LOGF(eERROR, "Failed to assemble shader's %s .metallib file", outFile);
+					for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+					{
+						// commands recording complete
+						flush_cmd(&pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
+					}
 				}
 			}
-			else
+
+			// requests are processed by priority, not in token order, so every request with a lower token
+			// has to be recorded or cancelled before a token counts as submitted
+			pLoader->queueMutex.Acquire();
+			SyncToken lowestPending = get_lowest_pending_token(pLoader);
+			SyncToken submittedToken = lowestPending ? lowestPending - 1 : sg_atomic64_load_relaxed(&pLoader->tokenCounter);
+			pLoader->queueMutex.Release();
+
+			submittedToken = eastl::max(submittedToken, get_last_token_completed());
+			// the batches are submitted, with timeline semaphores the graphics queue can wait for them on the GPU
+			sg_atomic64_store_release(&pLoader->tokenSubmitted, submittedToken);
+			if (pResourceLoader->desc.singleThreaded)
 			{
-				LOGF(eERROR, "Failed to compile shader %s", filePath);
+				return;
 			}
 		}
-		#endif
-		#if (defined(SG_GRAPHIC_API_D3D12) || defined(SG_GRAPHIC_API_D3D11))
-		extern void compileShader(
-			Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
-			bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
-		#endif
-		#if defined(ORBIS)
-		extern bool orbis_compileShader(
-			Renderer* pRenderer,
-			ShaderStage stage, ShaderStage allStages,
-			const char* srcFileName,
-			const char* outFileName,
-			uint32_t macroCount, ShaderMacro* pMacros,
-			BinaryShaderStageDesc* pOut,
-			const char* pEntryPoint);
-		#endif
-		#if defined(PROSPERO)
-		extern bool prospero_compileShader(
-			Renderer* pRenderer,
-			ShaderStage stage, ShaderStage allStages,
-			const char* srcFileName,
-			const char* outFileName,
-			uint32_t macroCount, ShaderMacro* pMacros,
-			BinaryShaderStageDesc* pOut,
-			const char* pEntryPoint);
-		#endif
-		#if defined(SG_GRAPHIC_API_GLES)
-		extern void gl_compileShader(Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
-			bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
+
+		free_all_upload_memory();
+
+		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+		{
+			flush_cmd(&pLoader->pCopyEngines[nodeIndex], pLoader->nextSet);
+	#if !defined(SG_GRAPHIC_API_D3D11) && !defined(SG_GRAPHIC_API_GLES)
+			wait_queue_idle(pLoader->pCopyEngines[nodeIndex].pQueue);
+	#endif
+			cleanup_copy_engine(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex]);
+		}
+
+	#if defined(GLES)
+		if (!pResourceLoader->desc.mSingleThreaded)
+			removeGLContext(&localContext);
+	#endif
+	}
+
+	// init function
+#if defined(SG_GRAPHIC_API_VULKAN) && !defined(__ANDROID__)
+	// the first shader compiled in process loads the shader compiler library, see Shader loading
+	static void util_unload_shaderc();
+	static void util_unload_spirv_tools();
+#endif
+
+	static void add_resource_loader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, ResourceLoader** ppLoader)
+	{
+		ResourceLoader* pLoader = sg_new(ResourceLoader);
+		pLoader->pRenderer = pRenderer;
+
+		pLoader->run = true;
+		pLoader->desc = pDesc ? *pDesc : gDefaultResourceLoaderDesc;
+
+		pLoader->queueMutex.Init();
+		pLoader->tokenMutex.Init();
+		pLoader->queueCv.Init();
+
+		pLoader->tokenCounter = 0;
+		pLoader->tokenCompleted = 0;
+		pLoader->tokenSubmitted = 0;
+		pLoader->cancelledCount = 0;
+
+		pLoader->desc.bufferCount = eastl::max(1U, pLoader->desc.bufferCount);
+		pLoader->setTokens.resize(pLoader->desc.bufferCount);
+		pLoader->nextSet = 0;
+
+		pLoader->streamingMutex.Init();
+		pLoader->streamingFrame = 0;
+
+		pLoader->resourceCacheMutex.Init();
+		pLoader->resourceCacheHits = 0;
+		pLoader->shaderCompilerMutex.Init();
+		pLoader->directUploadBytes = 0;
+
+		uint32_t linkedGPUCount = pLoader->pRenderer->linkedNodeCount;
+		for (uint32_t i = 0; i < linkedGPUCount; ++i)
+		{
+			setup_copy_engine(pLoader->pRenderer, &pLoader->pCopyEngines[i], i, pLoader->desc.bufferSize, pLoader->desc.bufferCount,
+				pLoader->desc.queueOwnershipTransfer);
+		}
+
+		pLoader->threadDesc.pFunc = streamer_thread_func;
+		pLoader->threadDesc.pData = pLoader;
+
+	#if defined(NX64)
+		pLoader->mThreadDesc.pThreadStack = aligned_alloc(THREAD_STACK_ALIGNMENT_NX, ALIGNED_THREAD_STACK_SIZE_NX);
+		pLoader->mThreadDesc.hThread = &pLoader->mThreadType;
+		pLoader->mThreadDesc.pThreadName = "ResourceLoaderTask";
+		pLoader->mThreadDesc.preferredCore = 1;
+	#endif
+
+	#if defined(SG_GRAPHIC_API_D3D11)
+		pLoader->desc.singleThreaded = true;
+	#endif
+
+		// create dedicated resource loader thread and the workers that decode for it.
+		pLoader->pThreadSystem = nullptr;
+		pLoader->pShaderThreadSystem = nullptr;
+		pLoader->pCallbackThreadSystem = nullptr;
+		pLoader->nextWorkerCallback = 0;
+		pLoader->workerCallbackTaskCount = 0;
+		if (!pLoader->desc.singleThreaded)
+		{
+			uint32_t decodeThreadCount = pLoader->desc.decodeThreadCount ? pLoader->desc.decodeThreadCount : SG_MAX_LOAD_THREADS;
+			init_thread_system(&pLoader->pThreadSystem, decodeThreadCount, 0, true, "ResourceDecoding");
+			// separate from the decoding workers, so add_shaders called from a worker load callback cannot wait on itself
+			init_thread_system(&pLoader->pShaderThreadSystem, SG_MAX_LOAD_THREADS, 0, true, "ShaderCompile");
+			// callbacks may wait on other loads, they never run on the workers the loader thread waits for
+			init_thread_system(&pLoader->pCallbackThreadSystem, SG_LOAD_CALLBACK_THREAD_COUNT, 0, true, "LoadCallback");
+			pLoader->mThread = create_thread(&pLoader->threadDesc);
+		}
+
+		*ppLoader = pLoader;
+	}
+
+	// exit function
+	static void remove_resource_loader(ResourceLoader* pLoader)
+	{
+		pLoader->run = false;
+
+		if (pLoader->desc.singleThreaded)
+		{
+			streamer_thread_func(pLoader);
+		}
+		else
+		{
+			pLoader->queueCv.WakeOne();
+			destroy_thread(pLoader->mThread);
+		}
+
+		if (pLoader->pCallbackThreadSystem)
+		{
+			// let the worker callbacks that were already handed out finish
+			wait_thread_system_idle(pLoader->pCallbackThreadSystem);
+			exit_thread_system(pLoader->pCallbackThreadSystem);
+		}
+		if (pLoader->pThreadSystem)
+		{
+			wait_thread_system_idle(pLoader->pThreadSystem);
+			exit_thread_system(pLoader->pThreadSystem);
+		}
+		if (pLoader->pShaderThreadSystem)
+		{
+			exit_thread_system(pLoader->pShaderThreadSystem);
+		}
+#if defined(SG_GRAPHIC_API_VULKAN) && !defined(__ANDROID__)
+		util_unload_shaderc();
+		util_unload_spirv_tools();
+#endif
+
+		if (!pLoader->loadCallbacks.empty() || !pLoader->readyCallbacks.empty())
+		{
+			SG_LOG_WARNING("Resource loader exits with %u load callbacks that never ran", (uint32_t)(pLoader->loadCallbacks.size() + pLoader->readyCallbacks.size()));
+		}
+
+		// the loader thread is gone, every pending mip chain is either created or was never going to be
+		for (StreamedTexture* pStreamed : pLoader->streamedTextures)
+		{
+			if (pStreamed->pPendingTexture)
+				remove_texture(pLoader->pRenderer, pStreamed->pPendingTexture);
+			sg_delete(pStreamed);
+		}
+		for (eastl::pair<Texture*, uint64_t>& retired : pLoader->retiredTextures)
+		{
+			remove_texture(pLoader->pRenderer, retired.first);
+		}
+
+		// the cached resources themselves belong to the add_resource callers, only the entries go away with the loader
+		if (!pLoader->resourceCache.empty())
+		{
+			SG_LOG_WARNING("Resource loader exits with %u cached resources that were not removed", (uint32_t)pLoader->resourceCache.size());
+		}
+		for (eastl::pair<const eastl::string, CachedResource*>& cached : pLoader->resourceCache)
+		{
+			sg_delete(cached.second);
+		}
+		pLoader->resourceCache.clear();
+		pLoader->cachedResources.clear();
+
+		pLoader->queueCv.Destroy();
+		pLoader->queueMutex.Destroy();
+		pLoader->tokenMutex.Destroy();
+		pLoader->streamingMutex.Destroy();
+		pLoader->resourceCacheMutex.Destroy();
+		pLoader->shaderCompilerMutex.Destroy();
+
+		sg_delete(pLoader);
+		pLoader = nullptr;
+	}
+
+	static void queue_buffer_update(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+	{
+		uint32_t nodeIndex = pBufferUpdate->pBuffer->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		// add one
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][SG_LOAD_PRIORITY_IMMEDIATE];
+		queue.emplace_back(UpdateRequest(*pBufferUpdate));
+		queue.back().waitIndex = t;
+		queue.back().pUploadBuffer =
+			(pBufferUpdate->mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_STAGING_RING) ? pBufferUpdate->mInternal.mappedRange.pBuffer
+			: nullptr;
+
+		pLoader->queueMutex.Release();
+		// update finish, one thread can go and get the job
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void queue_texture_load(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token, StreamedTexture* pStreamed = nullptr,
+		CachedResource* pCached = nullptr)
+	{
+		uint32_t nodeIndex = pTextureUpdate->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		ASSERT(pTextureUpdate->priority < SG_LOAD_PRIORITY_COUNT);
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][pTextureUpdate->priority];
+		queue.emplace_back(UpdateRequest(*pTextureUpdate));
+		queue.back().waitIndex = t;
+		queue.back().pStreamedTexture = pStreamed;
+		queue.back().pCachedResource = pCached;
+		pLoader->queueMutex.Release();
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void queue_geometry_load(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token, CachedResource* pCached = nullptr)
+	{
+		uint32_t nodeIndex = pGeometryLoad->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		ASSERT(pGeometryLoad->priority < SG_LOAD_PRIORITY_COUNT);
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][pGeometryLoad->priority];
+		queue.emplace_back(UpdateRequest(*pGeometryLoad));
+		queue.back().waitIndex = t;
+		queue.back().pCachedResource = pCached;
+		pLoader->queueMutex.Release();
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void queue_texture_update(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, SyncToken* token)
+	{
+		ASSERT(pTextureUpdate->range.pBuffer);
+
+		uint32_t nodeIndex = pTextureUpdate->pTexture->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][SG_LOAD_PRIORITY_IMMEDIATE];
+		queue.emplace_back(UpdateRequest(*pTextureUpdate));
+		queue.back().waitIndex = t;
+		queue.back().pUploadBuffer =
+			(pTextureUpdate->range.flags & MAPPED_RANGE_FLAG_STAGING_RING) ? pTextureUpdate->range.pBuffer : nullptr;
+		pLoader->queueMutex.Release();
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void queue_buffer_barrier(ResourceLoader* pLoader, Buffer* pBuffer, ResourceState state, SyncToken* token)
+	{
+		uint32_t nodeIndex = pBuffer->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][SG_LOAD_PRIORITY_IMMEDIATE];
+		queue.emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, SG_RESOURCE_STATE_UNDEFINED, state } });
+		queue.back().waitIndex = t;
+		pLoader->queueMutex.Release();
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void queue_texture_barrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
+	{
+		uint32_t nodeIndex = pTexture->nodeIndex;
+		pLoader->queueMutex.Acquire();
+
+		SyncToken t = sg_atomic64_add_relaxed(&pLoader->tokenCounter, 1) + 1;
+
+		eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[nodeIndex][SG_LOAD_PRIORITY_IMMEDIATE];
+		queue.emplace_back(UpdateRequest{ TextureBarrier{ pTexture, SG_RESOURCE_STATE_UNDEFINED, state } });
+		queue.back().waitIndex = t;
+		pLoader->queueMutex.Release();
+		pLoader->queueCv.WakeOne();
+		if (token) util_merge_token(pLoader, token, t);
+	}
+
+	static void wait_for_token(ResourceLoader* pLoader, const SyncToken* token)
+	{
+		if (pLoader->desc.singleThreaded)
+		{
+			return;
+		}
+		MutexLock lck(pLoader->tokenMutex);
+		if (util_is_token_completed(pLoader, *token))
+		{
+			return;
+		}
+
+		TokenWaiter waiter = {};
+		waiter.token = *token;
+		waiter.cv.Init();
+		pLoader->tokenWaiters.push_back(&waiter);
+		// signal_completed_tokens removes the waiter from the list before it wakes it up
+		while (!util_is_token_completed(pLoader, *token))
+		{
+			waiter.cv.Wait(pLoader->tokenMutex);
+		}
+		waiter.cv.Destroy();
+	}
+
+	/// Find the queued request of a token (call inside queueMutex)
+	static bool find_queued_request(ResourceLoader* pLoader, SyncToken token, eastl::vector<UpdateRequest>** ppQueue, UpdateRequest** ppRequest)
+	{
+		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
+		{
+			for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
+			{
+				eastl::vector<UpdateRequest>& queue = pLoader->requestQueue[i][priority];
+				UpdateRequest* pRequest = eastl::lower_bound(queue.begin(), queue.end(), token,
+					[](const UpdateRequest& request, SyncToken t) { return request.waitIndex < t; });
+				if (pRequest != queue.end() && pRequest->waitIndex == token)
+				{
+					*ppQueue = &queue;
+					*ppRequest = pRequest;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Texture streaming helpers, only used from update_texture_streaming
+
+	/// GPU memory of the chain starting at baseMip
+	static uint64_t util_get_streamed_texture_size(const StreamedTexture* pStreamed, uint32_t baseMip)
+	{
+		return util_get_surface_size((TinyImageFormat)pStreamed->format, pStreamed->width, pStreamed->height, pStreamed->depth,
+			1, 1, baseMip, pStreamed->mipLevels - baseMip, 0, pStreamed->arraySize);
+	}
+
+	/// Smallest mip that still covers the screen size of the texture, never above the resident tail
+	static uint32_t util_get_streamed_texture_wanted_mip(const StreamedTexture* pStreamed)
+	{
+		const uint32_t tailMip = pStreamed->mipLevels - eastl::min(pStreamed->minResidentMips, pStreamed->mipLevels);
+		const uint32_t extent = eastl::max(pStreamed->width, pStreamed->height);
+
+		uint32_t mip = tailMip;
+		while (mip > 0 && (float)SG_MIP_REDUCE(extent, mip) < pStreamed->screenSize)
+			--mip;
+		return mip;
+	}
+
+	/// How magnified the resident chain is on screen, the most magnified textures get their mips first and lose them last
+	static float util_get_streamed_texture_priority(const StreamedTexture* pStreamed)
+	{
+		return pStreamed->screenSize / (float)SG_MIP_REDUCE(eastl::max(pStreamed->width, pStreamed->height), pStreamed->residentMip);
+	}
+
+	static void request_streamed_texture_mips(ResourceLoader* pLoader, StreamedTexture* pStreamed, uint32_t mip)
+	{
+		pStreamed->pendingMip = mip;
+		pStreamed->pPendingTexture = nullptr;
+		pStreamed->pendingToken = 0;
+
+		TextureLoadDesc loadDesc = {};
+		loadDesc.ppTexture = &pStreamed->pPendingTexture;
+		loadDesc.fileName = pStreamed->fileName;
+		loadDesc.container = pStreamed->container;
+		loadDesc.creationFlag = pStreamed->creationFlag;
+		loadDesc.nodeIndex = pStreamed->nodeIndex;
+		loadDesc.priority = pStreamed->screenSize > 0.0f ? SG_LOAD_PRIORITY_VISIBLE : SG_LOAD_PRIORITY_PREFETCH;
+		queue_texture_load(pLoader, &loadDesc, &pStreamed->pendingToken, pStreamed);
+	}
+
+#pragma region (Interface Implemetation)
+
+	void init_resource_loader_interface(Renderer* pRenderer, ResourceLoaderDesc* pDesc)
+	{
+		add_resource_loader(pRenderer, pDesc, &pResourceLoader);
+	}
+
+	void exit_resource_loader_interface(Renderer* pRenderer)
+	{
+		remove_resource_loader(pResourceLoader);
+	}
+
+	void add_resource(BufferLoadDesc* pBufferDesc, SyncToken* token)
+	{
+		uint64_t stagingBufferSize = pResourceLoader->pCopyEngines[0].bufferSize;
+		bool update = pBufferDesc->pData || pBufferDesc->forceReset;
+
+		ASSERT(stagingBufferSize > 0);
+		if (SG_RESOURCE_MEMORY_USAGE_GPU_ONLY == pBufferDesc->desc.memoryUsage && !pBufferDesc->desc.startState && !update)
+		{
+			pBufferDesc->desc.startState = util_determine_resource_start_state(&pBufferDesc->desc);
+			SG_LOG_WARNING("Buffer start state not provided. Determined the start state as (%u) based on the provided BufferCreateDesc",
+				(uint32_t)pBufferDesc->desc.startState);
+		}
+
+		if (pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY && update)
+		{
+			pBufferDesc->desc.startState = SG_RESOURCE_STATE_COMMON;
+		}
+		if (!pBufferDesc->pPool || !util_add_pooled_buffer(pResourceLoader->pRenderer, pBufferDesc->pPool, &pBufferDesc->desc, pBufferDesc->ppBuffer))
+			add_buffer(pResourceLoader->pRenderer, &pBufferDesc->desc, pBufferDesc->ppBuffer);
+
+		if (update)
+		{
+			if (pBufferDesc->desc.size > stagingBufferSize &&
+				pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
+			{
+				// the data is too large for a single staging buffer copy, so perform it in stages.
+				// save the data parameter so we can restore it later.
+				const void* data = pBufferDesc->pData;
+
+				BufferUpdateDesc updateDesc = {};
+				updateDesc.pBuffer = *pBufferDesc->ppBuffer;
+				for (uint64_t offset = 0; offset < pBufferDesc->desc.size; offset += stagingBufferSize)
+				{
+					size_t chunkSize = (size_t)eastl::min(stagingBufferSize, pBufferDesc->desc.size - offset);
+					updateDesc.size = chunkSize;
+					updateDesc.dstOffset = offset;
+					begin_update_resource(&updateDesc);
+					if (pBufferDesc->forceReset)
+					{
+						memset(updateDesc.pMappedData, 0, chunkSize);
+					}
+					else
+					{
+						memcpy(updateDesc.pMappedData, (char*)data + offset, chunkSize);
+					}
+					end_update_resource(&updateDesc, token);
+				}
+			}
+			else
+			{
+				BufferUpdateDesc updateDesc = {};
+				updateDesc.pBuffer = *pBufferDesc->ppBuffer;
+				begin_update_resource(&updateDesc);
+				if (pBufferDesc->forceReset)
+				{
+					memset(updateDesc.pMappedData, 0, (size_t)pBufferDesc->desc.size);
+				}
+				else
+				{
+					memcpy(updateDesc.pMappedData, pBufferDesc->pData, (size_t)pBufferDesc->desc.size);
+				}
+				end_update_resource(&updateDesc, token);
+			}
+		}
+		else
+		{
+			// transition GPU buffer to desired state for Vulkan since all Vulkan resources are created in undefined state
+			if (pResourceLoader->pRenderer->api == SG_RENDERER_API_VULKAN &&
+				pBufferDesc->desc.memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY &&
+				// check whether this is required (user specified a state other than undefined / common)
+				(pBufferDesc->desc.startState != SG_RESOURCE_STATE_UNDEFINED && pBufferDesc->desc.startState != SG_RESOURCE_STATE_COMMON))
+				queue_buffer_barrier(pResourceLoader, *pBufferDesc->ppBuffer, pBufferDesc->desc.startState, token);
+		}
+	}
+
+	void add_resource(TextureLoadDesc* pTextureDesc, SyncToken* token)
+	{
+		ASSERT(pTextureDesc->ppTexture);
+
+		if (!pTextureDesc->fileName && pTextureDesc->desc)
+		{
+			ASSERT(pTextureDesc->desc->startState);
+
+			// If texture is supposed to be filled later (UAV / Update later / ...) proceed with the startState provided by the user in the texture description
+			add_texture(pResourceLoader->pRenderer, pTextureDesc->desc, pTextureDesc->ppTexture);
+
+			// Transition texture to desired state for Vulkan since all Vulkan resources are created in undefined state
+			if (pResourceLoader->pRenderer->api == SG_RENDERER_API_VULKAN)
+			{
+				ResourceState startState = pTextureDesc->desc->startState;
+				// Check whether this is required (user specified a state other than undefined / common)
+				if (startState == SG_RESOURCE_STATE_UNDEFINED || startState == SG_RESOURCE_STATE_COMMON)
+				{
+					startState = util_determine_resource_start_state(pTextureDesc->desc->descriptors & SG_DESCRIPTOR_TYPE_RW_TEXTURE);
+				}
+				queue_texture_barrier(pResourceLoader, *pTextureDesc->ppTexture, startState, token);
+			}
+		}
+		else if (pTextureDesc->minResidentMips && pTextureDesc->fileName)
+		{
+			StreamedTexture* pStreamed = sg_new(StreamedTexture);
+			*pStreamed = {};
+			strncpy(pStreamed->fileName, pTextureDesc->fileName, SG_MAX_FILEPATH - 1);
+			pStreamed->container = pTextureDesc->container;
+			pStreamed->creationFlag = pTextureDesc->creationFlag;
+			pStreamed->nodeIndex = pTextureDesc->nodeIndex;
+			pStreamed->minResidentMips = pTextureDesc->minResidentMips;
+			pStreamed->residentMip = UINT32_MAX;
+			pStreamed->pendingMip = UINT32_MAX;
+			{
+				MutexLock lck(pResourceLoader->streamingMutex);
+				pResourceLoader->streamedTextures.push_back(pStreamed);
+			}
+
+			TextureLoadDesc updateDesc = *pTextureDesc;
+			queue_texture_load(pResourceLoader, &updateDesc, &pStreamed->pendingToken, pStreamed);
+			if (token) util_merge_token(pResourceLoader, token, pStreamed->pendingToken);
+			if (pResourceLoader->desc.singleThreaded)
+			{
+				streamer_thread_func(pResourceLoader);
+			}
+		}
+		else if (pResourceLoader->desc.enableResourceCache && pTextureDesc->fileName)
+		{
+			{
+				const eastl::string key = util_get_texture_cache_key(pTextureDesc);
+				// queue the load inside the cache lock, so nobody joins it before its token is known
+				MutexLock lck(pResourceLoader->resourceCacheMutex);
+				if (join_cached_resource(pResourceLoader, key, (void**)pTextureDesc->ppTexture, token))
+					return;
+
+				CachedResource* pCached = add_cached_resource(pResourceLoader, key);
+				TextureLoadDesc updateDesc = *pTextureDesc;
+				queue_texture_load(pResourceLoader, &updateDesc, &pCached->token, nullptr, pCached);
+				if (token) util_merge_token(pResourceLoader, token, pCached->token);
+			}
+			if (pResourceLoader->desc.singleThreaded)
+			{
+				streamer_thread_func(pResourceLoader);
+			}
+		}
+		else
+		{
+			TextureLoadDesc updateDesc = *pTextureDesc;
+			queue_texture_load(pResourceLoader, &updateDesc, token);
+			if (pResourceLoader->desc.singleThreaded)
+			{
+				streamer_thread_func(pResourceLoader);
+			}
+		}
+	}
+
+	void add_resource(GeometryLoadDesc* pDesc, SyncToken* token)
+	{
+		ASSERT(pDesc->ppGeometry);
+
+		GeometryLoadDesc updateDesc = *pDesc;
+		updateDesc.fileName = pDesc->fileName;
+		updateDesc.pVertexLayout = (VertexLayout*)sg_calloc(1, sizeof(VertexLayout));
+		memcpy(updateDesc.pVertexLayout, pDesc->pVertexLayout, sizeof(VertexLayout));
+		if (pResourceLoader->desc.enableResourceCache)
+		{
+			const eastl::string key = util_get_geometry_cache_key(pDesc);
+			// queue the load inside the cache lock, so nobody joins it before its token is known
+			MutexLock lck(pResourceLoader->resourceCacheMutex);
+			if (join_cached_resource(pResourceLoader, key, (void**)pDesc->ppGeometry, token))
+			{
+				sg_free(updateDesc.pVertexLayout);
+				return;
+			}
+
+			CachedResource* pCached = add_cached_resource(pResourceLoader, key);
+			queue_geometry_load(pResourceLoader, &updateDesc, &pCached->token, pCached);
+			if (token) util_merge_token(pResourceLoader, token, pCached->token);
+		}
+		else
+		{
+			queue_geometry_load(pResourceLoader, &updateDesc, token);
+		}
+		if (pResourceLoader->desc.singleThreaded)
+		{
+			streamer_thread_func(pResourceLoader);
+		}
+	}
+
+	void add_buffer_pool(const BufferPoolDesc* pDesc, BufferPool** ppPool)
+	{
+		ASSERT(pResourceLoader);
+		ASSERT(pDesc && pDesc->blockSize > 0);
+		ASSERT(ppPool);
+
+		Renderer* pRenderer = pResourceLoader->pRenderer;
+		BufferPool* pPool = sg_new(BufferPool);
+		pPool->desc = *pDesc;
+		pPool->alignment = 16;
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		const VkPhysicalDeviceLimits& limits = pRenderer->pVkActiveGPUProperties->properties.limits;
+		if (pDesc->descriptors & SG_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			pPool->alignment = eastl::max(pPool->alignment, (uint64_t)limits.minUniformBufferOffsetAlignment);
+		if (pDesc->descriptors & (SG_DESCRIPTOR_TYPE_BUFFER | SG_DESCRIPTOR_TYPE_RW_BUFFER))
+			pPool->alignment = eastl::max(pPool->alignment, (uint64_t)limits.minStorageBufferOffsetAlignment);
+	#endif
+		pPool->mutex.Init();
+		util_add_buffer_pool_block(pRenderer, pPool, pDesc->blockSize);
+
+		*ppPool = pPool;
+	}
+
+	void remove_buffer_pool(BufferPool* pPool)
+	{
+		ASSERT(pPool);
+		for (BufferPoolBlock& block : pPool->blocks)
+			util_remove_buffer_pool_block(pResourceLoader->pRenderer, &block);
+		pPool->mutex.Destroy();
+		sg_delete(pPool);
+	}
+
+	void remove_resource(Buffer* pBuffer)
+	{
+		if (pBuffer->pooled)
+		{
+			util_remove_pooled_buffer(pResourceLoader->pRenderer, (PooledBuffer*)pBuffer);
+			return;
+		}
+		remove_buffer(pResourceLoader->pRenderer, pBuffer);
+	}
+
+	void remove_resource(Texture* pTexture)
+	{
+		if (release_cached_resource(pResourceLoader, pTexture))
+			return;
+
+		StreamedTexture* pStreamed = nullptr;
+		{
+			MutexLock lck(pResourceLoader->streamingMutex);
+			auto iter = pResourceLoader->streamedTextureMap.find(pTexture);
+			if (iter != pResourceLoader->streamedTextureMap.end())
+			{
+				pStreamed = iter->second;
+				pResourceLoader->streamedTextureMap.erase(iter);
+				pResourceLoader->streamedTextures.erase(eastl::find(pResourceLoader->streamedTextures.begin(), pResourceLoader->streamedTextures.end(), pStreamed));
+			}
+		}
+
+		if (pStreamed)
+		{
+			// a mip chain still being loaded has to land before it can be freed
+			if (!is_token_completed(&pStreamed->pendingToken))
+				wait_for_token(&pStreamed->pendingToken);
+			if (pStreamed->pPendingTexture)
+				remove_texture(pResourceLoader->pRenderer, pStreamed->pPendingTexture);
+			sg_delete(pStreamed);
+		}
+
+		remove_texture(pResourceLoader->pRenderer, pTexture);
+	}
+
+	void remove_resource(Geometry* pGeom)
+	{
+		if (release_cached_resource(pResourceLoader, pGeom))
+			return;
+
+		remove_resource(pGeom->pIndexBuffer);
+
+		for (uint32_t i = 0; i < pGeom->vertexBufferCount; ++i)
+			remove_resource(pGeom->pVertexBuffers[i]);
+
+		sg_free(pGeom->pMeshlets);
+		sg_free(pGeom);
+	}
+
+	void begin_update_resource(BufferUpdateDesc* pBufferUpdate)
+	{
+		Buffer* pBuffer = pBufferUpdate->pBuffer;
+		ASSERT(pBuffer);
+
+		uint64_t size = pBufferUpdate->size > 0 ? pBufferUpdate->size : (pBufferUpdate->pBuffer->size - pBufferUpdate->dstOffset);
+		ASSERT(pBufferUpdate->dstOffset + size <= pBuffer->size);
+
+		ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->memoryUsage;
+		if (UMA || memoryUsage != SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
+		{
+			bool map = !pBuffer->pCpuMappedAddress;
+			if (map)
+			{
+				map_buffer(pResourceLoader->pRenderer, pBuffer, nullptr);
+			}
+
+			pBufferUpdate->mInternal.mappedRange = { (uint8_t*)pBuffer->pCpuMappedAddress + pBufferUpdate->dstOffset, pBuffer };
+			pBufferUpdate->pMappedData = pBufferUpdate->mInternal.mappedRange.pData;
+			pBufferUpdate->mInternal.mappedRange.flags = map ? MAPPED_RANGE_FLAG_UNMAP_BUFFER : 0;
+		}
+		else
+		{
+			// we need to use a staging buffer, the range stays reserved until the update is recorded
+			MappedMemoryRange range = allocate_staging_memory(&pResourceLoader->pCopyEngines[pBuffer->nodeIndex], size, SG_RESOURCE_BUFFER_ALIGNMENT, true);
+			pBufferUpdate->pMappedData = range.pData;
+
+			pBufferUpdate->mInternal.mappedRange = range;
+		}
+	}
+
+	void end_update_resource(BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+	{
+		if (pBufferUpdate->mInternal.mappedRange.flags & MAPPED_RANGE_FLAG_UNMAP_BUFFER)
+		{
+			unmap_buffer(pResourceLoader->pRenderer, pBufferUpdate->pBuffer);
+		}
+
+		ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->memoryUsage;
+		if (!UMA && memoryUsage == SG_RESOURCE_MEMORY_USAGE_GPU_ONLY)
+		{
+			queue_buffer_update(pResourceLoader, pBufferUpdate, token);
+		}
+
+		// Restore the state to before the beginUpdateResource call.
+		pBufferUpdate->pMappedData = nullptr;
+		pBufferUpdate->mInternal = {};
+		if (pResourceLoader->desc.singleThreaded)
+		{
+			streamer_thread_func(pResourceLoader);
+		}
+	}
+
+	void begin_update_resource(TextureUpdateDesc* pTextureUpdate)
+	{
+		const Texture* texture = pTextureUpdate->pTexture;
+		const TinyImageFormat fmt = (TinyImageFormat)texture->format;
+		const uint32_t alignment = util_get_texture_subresource_alignment(pResourceLoader->pRenderer, fmt);
+
+		bool success = util_get_surface_info(
+			SG_MIP_REDUCE(texture->width, pTextureUpdate->mipLevel),
+			SG_MIP_REDUCE(texture->height, pTextureUpdate->mipLevel),
+			fmt,
+			&pTextureUpdate->srcSliceStride,
+			&pTextureUpdate->srcRowStride,
+			&pTextureUpdate->rowCount);
+		ASSERT(success);
+		UNREF_PARAM(success);
+
+		pTextureUpdate->dstRowStride = round_up(pTextureUpdate->srcRowStride, util_get_texture_row_alignment(pResourceLoader->pRenderer));
+		pTextureUpdate->dstSliceStride = round_up(pTextureUpdate->dstRowStride * pTextureUpdate->rowCount, alignment);
+
+		const ssize_t requiredSize = round_up(
+			SG_MIP_REDUCE(texture->depth, pTextureUpdate->mipLevel) * pTextureUpdate->dstRowStride * pTextureUpdate->rowCount,
+			alignment);
+
+		// We need to use a staging buffer.
+		pTextureUpdate->mInternal.mappedRange = allocate_staging_memory(&pResourceLoader->pCopyEngines[texture->nodeIndex], requiredSize, alignment, true);
+		pTextureUpdate->pMappedData = pTextureUpdate->mInternal.mappedRange.pData;
+	}
+
+	void end_update_resource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
+	{
+		TextureUpdateDescInternal desc = {};
+		desc.pTexture = pTextureUpdate->pTexture;
+		desc.range = pTextureUpdate->mInternal.mappedRange;
+		desc.baseMipLevel = pTextureUpdate->mipLevel;
+		desc.mipLevels = 1;
+		desc.baseArrayLayer = pTextureUpdate->arrayLayer;
+		desc.layerCount = 1;
+		queue_texture_update(pResourceLoader, &desc, token);
+
+		// Restore the state to before the beginUpdateResource call.
+		pTextureUpdate->pMappedData = NULL;
+		pTextureUpdate->mInternal = {};
+		if (pResourceLoader->desc.singleThreaded)
+		{
+			streamer_thread_func(pResourceLoader);
+		}
+	}
+
+	SyncToken get_last_token_completed()
+	{
+		return sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted);
+	}
+
+	bool is_token_completed(const SyncToken* token)
+	{
+		if (*token <= sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted))
+			return true;
+		MutexLock lck(pResourceLoader->tokenMutex);
+		return util_is_token_completed(pResourceLoader, *token);
+	}
+
+	SyncToken get_last_token_submitted()
+	{
+		return sg_atomic64_load_acquire(&pResourceLoader->tokenSubmitted);
+	}
+
+	bool is_token_submitted(const SyncToken* token)
+	{
+		return *token <= sg_atomic64_load_acquire(&pResourceLoader->tokenSubmitted) || is_token_completed(token);
+	}
+
+	void cmd_acquire_loaded_resources(Cmd* pCmd, Semaphore** ppWaitSemaphore, uint64_t* pWaitValue)
+	{
+		ASSERT(pCmd);
+		CopyEngine& copyEngine = pResourceLoader->pCopyEngines[pCmd->nodeIndex];
+		*ppWaitSemaphore = nullptr;
+		*pWaitValue = 0;
+
+		MutexLock lck(copyEngine.acquireMutex);
+		if (copyEngine.ownershipTransfer && (!copyEngine.bufferAcquires.empty() || !copyEngine.textureAcquires.empty()))
+		{
+			cmd_resource_barrier(pCmd, (uint32_t)copyEngine.bufferAcquires.size(), copyEngine.bufferAcquires.data(),
+				(uint32_t)copyEngine.textureAcquires.size(), copyEngine.textureAcquires.data(), 0, nullptr);
+			copyEngine.bufferAcquires.clear();
+			copyEngine.textureAcquires.clear();
+		}
+
+		// the frame waits for the copies on the GPU, not on the loader thread
+		if (copyEngine.pTimelineSemaphore && copyEngine.acquireValue)
+		{
+			*ppWaitSemaphore = copyEngine.pTimelineSemaphore;
+			*pWaitValue = copyEngine.acquireValue;
+		}
+	}
+
+	void wait_for_token(const SyncToken* token)
+	{
+		wait_for_token(pResourceLoader, token);
+	}
+
+	void add_sync_token_to_group(SyncTokenGroup* pGroup, const SyncToken* token)
+	{
+		util_merge_token(pResourceLoader, &pGroup->token, *token);
+		++pGroup->count;
+	}
+
+	bool is_token_group_completed(const SyncTokenGroup* pGroup)
+	{
+		return is_token_completed(&pGroup->token);
+	}
+
+	void wait_for_token_group(const SyncTokenGroup* pGroup)
+	{
+		wait_for_token(pResourceLoader, &pGroup->token);
+	}
+
+	void add_resource_load_callback(const SyncToken* token, LoadCompletedFunc pFunc, void* pUserData, LoadCallbackDispatch dispatch)
+	{
+		ASSERT(pFunc);
+		LoadCallback callback = { *token, pFunc, pUserData, dispatch };
+		{
+			MutexLock lck(pResourceLoader->tokenMutex);
+			if (!util_is_token_completed(pResourceLoader, *token))
+			{
+				pResourceLoader->loadCallbacks.push_back(callback);
+				return;
+			}
+			if (SG_LOAD_CALLBACK_DISPATCH_MAIN_THREAD == dispatch || !pResourceLoader->pCallbackThreadSystem)
+			{
+				pResourceLoader->readyCallbacks.push_back(callback);
+				return;
+			}
+			if (!util_queue_worker_callback(pResourceLoader, callback))
+				return;
+		}
+
+		add_thread_system_task(pResourceLoader->pCallbackThreadSystem, run_load_callbacks_task, pResourceLoader, 0);
+	}
+
+	void add_token_group_callback(const SyncTokenGroup* pGroup, LoadCompletedFunc pFunc, void* pUserData, LoadCallbackDispatch dispatch)
+	{
+		add_resource_load_callback(&pGroup->token, pFunc, pUserData, dispatch);
+	}
+
+	uint32_t dispatch_resource_load_callbacks()
+	{
+		eastl::vector<LoadCallback> callbacks;
+		{
+			MutexLock lck(pResourceLoader->tokenMutex);
+			callbacks.swap(pResourceLoader->readyCallbacks);
+		}
+
+		for (LoadCallback& callback : callbacks)
+		{
+			callback.pFunc(callback.pUserData);
+		}
+		return (uint32_t)callbacks.size();
+	}
+
+	bool all_resource_loads_completed()
+	{
+		SyncToken token = sg_atomic64_load_relaxed(&pResourceLoader->tokenCounter);
+		return token <= sg_atomic64_load_acquire(&pResourceLoader->tokenCompleted);
+	}
+
+	void wait_for_all_resource_loads()
+	{
+		SyncToken token = sg_atomic64_load_relaxed(&pResourceLoader->tokenCounter);
+		wait_for_token(pResourceLoader, &token);
+	}
+
+	bool set_resource_load_priority(const SyncToken* token, LoadPriority priority)
+	{
+		ASSERT(priority < SG_LOAD_PRIORITY_COUNT);
+		MutexLock lck(pResourceLoader->queueMutex);
+
+		eastl::vector<UpdateRequest>* pQueue = nullptr;
+		UpdateRequest* pRequest = nullptr;
+		if (!find_queued_request(pResourceLoader, *token, &pQueue, &pRequest))
+		{
+			return false;
+		}
+
+		// updates and barriers are tied to the order they were issued in
+		if (pRequest->type != SG_UPDATE_REQUEST_LOAD_TEXTURE && pRequest->type != SG_UPDATE_REQUEST_LOAD_GEOMETRY)
+		{
+			return false;
+		}
+
+		uint32_t nodeIndex = pRequest->type == SG_UPDATE_REQUEST_LOAD_TEXTURE ? pRequest->texLoadDesc.nodeIndex : pRequest->geomLoadDesc.nodeIndex;
+		eastl::vector<UpdateRequest>& dstQueue = pResourceLoader->requestQueue[nodeIndex][priority];
+		if (&dstQueue == pQueue)
+		{
+			return true;
+		}
+
+		UpdateRequest request = *pRequest;
+		pQueue->erase(pRequest);
+		// keep the destination queue sorted by token
+		UpdateRequest* pPos = eastl::lower_bound(dstQueue.begin(), dstQueue.end(), request.waitIndex,
+			[](const UpdateRequest& r, SyncToken t) { return r.waitIndex < t; });
+		dstQueue.insert(pPos, request);
+		return true;
+	}
+
+	bool cancel_resource_load(const SyncToken* token)
+	{
+		CachedResource* pCached = nullptr;
+		{
+			MutexLock lck(pResourceLoader->queueMutex);
+
+			eastl::vector<UpdateRequest>* pQueue = nullptr;
+			UpdateRequest* pRequest = nullptr;
+			if (!find_queued_request(pResourceLoader, *token, &pQueue, &pRequest))
+			{
+				return false;
+			}
+
+			pCached = pRequest->pCachedResource;
+			release_update_request(pResourceLoader, *pRequest);
+			pQueue->erase(pRequest);
+			++pResourceLoader->cancelledCount;
+		}
+
+		// outside of queueMutex, the cache lock is always taken first
+		if (pCached)
+			resolve_cached_resource(pResourceLoader, pCached, nullptr);
+
+		// nothing to wait for, the token completes right away
+		const PendingToken cancelled = { *token, { 0, 0 } };
+		signal_completed_tokens(pResourceLoader, &cancelled, 1);
+		return true;
+	}
+
+	void get_resource_loader_stats(ResourceLoaderStats* pOutStats)
+	{
+		*pOutStats = {};
+		{
+			MutexLock cacheLck(pResourceLoader->resourceCacheMutex);
+			pOutStats->cachedResourceCount = (uint32_t)pResourceLoader->resourceCache.size();
+			pOutStats->resourceCacheHits = pResourceLoader->resourceCacheHits;
+		}
+		pOutStats->directUploadBytes = sg_atomic64_load_relaxed(&pResourceLoader->directUploadBytes);
+
+		MutexLock lck(pResourceLoader->queueMutex);
+		for (size_t i = 0; i < SG_MAX_LINKED_GPUS; ++i)
+		{
+			for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
+			{
+				pOutStats->queueDepth[priority] += (uint32_t)pResourceLoader->requestQueue[i][priority].size();
+			}
+		}
+		for (uint32_t priority = 0; priority < SG_LOAD_PRIORITY_COUNT; ++priority)
+		{
+			pOutStats->peakQueueDepth[priority] = eastl::max(pResourceLoader->peakQueueDepth[priority], pOutStats->queueDepth[priority]);
+		}
+		pOutStats->cancelledCount = pResourceLoader->cancelledCount;
+
+		MutexLock streamingLck(pResourceLoader->streamingMutex);
+		pOutStats->streamedTextureCount = (uint32_t)pResourceLoader->streamedTextures.size();
+		for (const StreamedTexture* pStreamed : pResourceLoader->streamedTextures)
+		{
+			pOutStats->streamedTextureMemory += pStreamed->residentSize;
+		}
+	}
+
+	void set_texture_screen_size(Texture* pTexture, float screenSize)
+	{
+		MutexLock lck(pResourceLoader->streamingMutex);
+		auto iter = pResourceLoader->streamedTextureMap.find(pTexture);
+		if (iter != pResourceLoader->streamedTextureMap.end())
+		{
+			iter->second->screenSize = screenSize;
+		}
+	}
+
+	uint32_t get_texture_resident_mip(Texture* pTexture)
+	{
+		MutexLock lck(pResourceLoader->streamingMutex);
+		auto iter = pResourceLoader->streamedTextureMap.find(pTexture);
+		if (iter == pResourceLoader->streamedTextureMap.end() || UINT32_MAX == iter->second->residentMip)
+		{
+			return 0;
+		}
+		return iter->second->residentMip;
+	}
+
+	void update_texture_streaming(TextureStreamingUpdateDesc* pDesc)
+	{
+		ASSERT(pDesc);
+		ResourceLoader* pLoader = pResourceLoader;
+		pDesc->changedTextureCount = 0;
+
+		MutexLock lck(pLoader->streamingMutex);
+		++pLoader->streamingFrame;
+
+		// old chains are released once no frame in flight can sample them anymore
+		for (uint32_t i = 0; i < (uint32_t)pLoader->retiredTextures.size();)
+		{
+			if (pLoader->retiredTextures[i].second + MAX_FRAMES <= pLoader->streamingFrame)
+			{
+				remove_texture(pLoader->pRenderer, pLoader->retiredTextures[i].first);
+				pLoader->retiredTextures.erase_unsorted(pLoader->retiredTextures.begin() + i);
+				continue;
+			}
+			++i;
+		}
+
+		uint64_t projectedSize = 0;
+		eastl::vector<StreamedTexture*> upgrades;
+		eastl::vector<StreamedTexture*> victims;
+		for (uint32_t i = 0; i < (uint32_t)pLoader->streamedTextures.size();)
+		{
+			StreamedTexture* pStreamed = pLoader->streamedTextures[i];
+			if (pStreamed->pendingToken && is_token_completed(&pStreamed->pendingToken))
+			{
+				if (UINT32_MAX == pStreamed->residentMip)
+				{
+					// first load, the tail went straight into the user's texture
+					if (!pStreamed->pTexture)
+					{
+						SG_LOG_ERROR("Failed to load streamed texture %s", pStreamed->fileName);
+						pLoader->streamedTextures.erase_unsorted(pLoader->streamedTextures.begin() + i);
+						sg_delete(pStreamed);
+						continue;
+					}
+					pStreamed->residentMip = pStreamed->pendingMip;
+					pStreamed->residentSize = util_get_streamed_texture_size(pStreamed, pStreamed->residentMip);
+					pStreamed->pendingToken = 0;
+				}
+				else if (!pStreamed->pPendingTexture)
+				{
+					SG_LOG_WARNING("Failed to stream mip %u of %s, keeping the resident mips", pStreamed->pendingMip, pStreamed->fileName);
+					pStreamed->failed = true;
+					pStreamed->pendingToken = 0;
+				}
+				else if (pDesc->changedTextureCount < pDesc->changedTextureCapacity)
+				{
+					// swap the new chain into the user's texture, the old one is released a few updates later
+					Texture oldTexture = *pStreamed->pTexture;
+					*pStreamed->pTexture = *pStreamed->pPendingTexture;
+					*pStreamed->pPendingTexture = oldTexture;
+					pLoader->retiredTextures.push_back({ pStreamed->pPendingTexture, pLoader->streamingFrame });
+
+					pStreamed->pPendingTexture = nullptr;
+					pStreamed->pendingToken = 0;
+					pStreamed->residentMip = pStreamed->pendingMip;
+					pStreamed->residentSize = util_get_streamed_texture_size(pStreamed, pStreamed->residentMip);
+					pDesc->ppChangedTextures[pDesc->changedTextureCount++] = pStreamed->pTexture;
+				}
+			}
+			++i;
+
+			if (UINT32_MAX == pStreamed->residentMip)
+			{
+				continue;
+			}
+
+			// a chain in flight is accounted with the size it will have
+			if (pStreamed->pendingToken)
+			{
+				projectedSize += eastl::max(pStreamed->residentSize, util_get_streamed_texture_size(pStreamed, pStreamed->pendingMip));
+				continue;
+			}
+			projectedSize += pStreamed->residentSize;
+
+			if (pStreamed->failed)
+			{
+				continue;
+			}
+
+			const uint32_t tailMip = pStreamed->mipLevels - eastl::min(pStreamed->minResidentMips, pStreamed->mipLevels);
+			if (util_get_streamed_texture_wanted_mip(pStreamed) < pStreamed->residentMip)
+				upgrades.push_back(pStreamed);
+			if (pStreamed->residentMip < tailMip)
+				victims.push_back(pStreamed);
+		}
+
+		eastl::sort(upgrades.begin(), upgrades.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return util_get_streamed_texture_priority(a) > util_get_streamed_texture_priority(b);
+		});
+		eastl::sort(victims.begin(), victims.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return util_get_streamed_texture_priority(a) < util_get_streamed_texture_priority(b);
+		});
+
+		const uint64_t budget = pDesc->memoryBudget ? pDesc->memoryBudget : UINT64_MAX;
+		const uint32_t maxLoadCount = pDesc->maxLoadCount ? pDesc->maxLoadCount : UINT32_MAX;
+		uint32_t loadCount = 0;
+		uint32_t nextVictim = 0;
+
+		// drop mips from the least important textures until the budget holds again
+		auto evict = [&](float priority, uint64_t requiredSize)
+		{
+			while (projectedSize + requiredSize > budget && nextVictim < (uint32_t)victims.size() && loadCount < maxLoadCount)
+			{
+				StreamedTexture* pVictim = victims[nextVictim];
+				if (util_get_streamed_texture_priority(pVictim) >= priority)
+					return;
+				++nextVictim;
+				if (pVictim->pendingToken)
+					continue;
+
+				uint32_t mip = eastl::max(util_get_streamed_texture_wanted_mip(pVictim), pVictim->residentMip + 1);
+				uint64_t size = util_get_streamed_texture_size(pVictim, mip);
+				projectedSize -= pVictim->residentSize - size;
+				request_streamed_texture_mips(pLoader, pVictim, mip);
+				++loadCount;
+			}
+		};
+
+		evict(FLT_MAX, 0);
+
+		for (StreamedTexture* pStreamed : upgrades)
+		{
+			if (loadCount >= maxLoadCount)
+				break;
+
+			uint32_t mip = util_get_streamed_texture_wanted_mip(pStreamed);
+			uint64_t growth = util_get_streamed_texture_size(pStreamed, mip) - pStreamed->residentSize;
+			evict(util_get_streamed_texture_priority(pStreamed), growth);
+			if (projectedSize + growth > budget || loadCount >= maxLoadCount)
+				break;
+
+			projectedSize += growth;
+			request_streamed_texture_mips(pLoader, pStreamed, mip);
+			++loadCount;
+		}
+
+		if (loadCount && pLoader->desc.singleThreaded)
+		{
+			pLoader->streamingMutex.Release();
+			streamer_thread_func(pLoader);
+			pLoader->streamingMutex.Acquire();
+		}
+	}
+
+#pragma endregion (Interface Implemetation)
+
+	// Shader loading
+	#if defined(__ANDROID__) && defined(SG_GRAPHIC_API_VULKAN)
+	// Translate Vulkan Shader Type to shaderc shader type
+	shaderc_shader_kind getShadercShaderType(ShaderStage type)
+	{
+		switch (type)
+		{
+		case ShaderStage::SHADER_STAGE_VERT: return shaderc_glsl_vertex_shader;
+		case ShaderStage::SHADER_STAGE_FRAG: return shaderc_glsl_fragment_shader;
+		case ShaderStage::SHADER_STAGE_TESC: return shaderc_glsl_tess_control_shader;
+		case ShaderStage::SHADER_STAGE_TESE: return shaderc_glsl_tess_evaluation_shader;
+		case ShaderStage::SHADER_STAGE_GEOM: return shaderc_glsl_geometry_shader;
+		case ShaderStage::SHADER_STAGE_COMP: return shaderc_glsl_compute_shader;
+		default: break;
+		}
+
+		ASSERT(false);
+		return static_cast<shaderc_shader_kind>(-1);
+	}
+	#endif
+
+	// Errors of the shader stage a thread is loading also go to the errors of its load task, so the shader reload can show them
+	static thread_local eastl::string* tpShaderErrors = nullptr;
+
+	static void util_report_shader_error(const eastl::string& message)
+	{
+		SG_LOG_ERROR("%s", message.c_str());
+		if (tpShaderErrors)
+		{
+			*tpShaderErrors += message;
+			*tpShaderErrors += "\n";
+		}
+	}
+
+	// Shader sources read while loading one batch of shaders. Every include is read from disk once no matter how many
+	// stages and variants of the batch use it, the binary cache key and the compiler both take it from memory.
+	typedef struct ShaderInclude
+	{
+		eastl::string path;
+		eastl::string code;
+		/// What process_source_file appends to the code of the file including this one
+		eastl::string processedCode;
+		/// Hash of the code of the file and of everything it includes
+		Hash128       hash;
+	} ShaderInclude;
+
+	typedef struct ShaderIncludeCache
+	{
+		const char*                                         pAppName;
+		Mutex                                               mutex;
+		eastl::unordered_map<eastl::string, ShaderInclude*> includes;
+	} ShaderIncludeCache;
+
+	static void util_init_shader_include_cache(ShaderIncludeCache* pCache, const char* pAppName)
+	{
+		pCache->pAppName = pAppName;
+		pCache->mutex.Init();
+	}
+
+	static void util_exit_shader_include_cache(ShaderIncludeCache* pCache)
+	{
+		for (eastl::pair<const eastl::string, ShaderInclude*>& include : pCache->includes)
+			sg_delete(include.second);
+		pCache->includes.clear();
+		pCache->mutex.Destroy();
+	}
+
+	#if !defined(NX64)
+	/// Null if the file does not exist, the include stays valid until the cache is destroyed
+	static const ShaderInclude* util_get_shader_include(ShaderIncludeCache* pCache, const char* filePath);
+	#endif
+
+	#if defined(SG_GRAPHIC_API_VULKAN)
+		#if defined(__ANDROID__)
+		// Android:
+		// Use shaderc to compile glsl to spirV
+		void vk_compileShader(
+			Renderer* pRenderer, ShaderStage stage, uint32_t codeSize, const char* code, const char* outFile, uint32_t macroCount,
+			ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
+		{
+			// compile into spir-V shader
+			shaderc_compiler_t           compiler = shaderc_compiler_initialize();
+			shaderc_compile_options_t	 options = shaderc_compile_options_initialize();
+			for (uint32_t i = 0; i < macroCount; ++i)
+			{
+				shaderc_compile_options_add_macro_definition(options, pMacros[i].definition, strlen(pMacros[i].definition),
+					pMacros[i].value, strlen(pMacros[i].value));
+			}
+
+			eastl::string android_definition = "TARGET_ANDROID";
+			shaderc_compile_options_add_macro_definition(options, android_definition.c_str(), android_definition.size(), "1", 1);
+
+			shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+
+			shaderc_compilation_result_t spvShader =
+				shaderc_compile_into_spv(compiler, code, codeSize, getShadercShaderType(stage), "shaderc_error", pEntryPoint ? pEntryPoint : "main", options);
+			shaderc_compilation_status spvStatus = shaderc_result_get_compilation_status(spvShader);
+			if (spvStatus != shaderc_compilation_status_success)
+			{
+				const char* errorMessage = shaderc_result_get_error_message(spvShader);
+				LOGF(LogLevel::eERROR, "Shader compiling failed! with status %s", errorMessage);
+				abort();
+			}
+
+			// Resize the byteCode block based on the compiled shader size
+			pOut->mByteCodeSize = shaderc_result_get_length(spvShader);
+			pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
+			memcpy(pOut->pByteCode, shaderc_result_get_bytes(spvShader), pOut->mByteCodeSize);
+
+			// Release resources
+			shaderc_result_release(spvShader);
+			shaderc_compiler_release(compiler);
+		}
+		#else
+		// PC:
+		// The Vulkan SDK ships shaderc as a shared library. It is loaded at runtime, so it stays an optional dependency,
+		// and compiles the shaders in process with the includes served from the include cache of the batch.
+		// Without it (or with a config.conf that only glslangValidator understands) the shaders go through glslangValidator.
+
+		// Values of the shaderc C interface (shaderc/shaderc.h) that we use
+		enum
+		{
+			SG_SHADERC_VERTEX_SHADER = 0,
+			SG_SHADERC_FRAGMENT_SHADER = 1,
+			SG_SHADERC_COMPUTE_SHADER = 2,
+			SG_SHADERC_GEOMETRY_SHADER = 3,
+			SG_SHADERC_TESS_CONTROL_SHADER = 4,
+			SG_SHADERC_TESS_EVALUATION_SHADER = 5,
+			SG_SHADERC_RAYGEN_SHADER = 14,
+			SG_SHADERC_ANYHIT_SHADER = 15,
+			SG_SHADERC_CLOSESTHIT_SHADER = 16,
+			SG_SHADERC_MISS_SHADER = 17,
+			SG_SHADERC_INTERSECTION_SHADER = 18,
+			SG_SHADERC_CALLABLE_SHADER = 19,
+
+			SG_SHADERC_TARGET_ENV_VULKAN = 0,
+			SG_SHADERC_INCLUDE_TYPE_RELATIVE = 0,
+			SG_SHADERC_COMPILATION_STATUS_SUCCESS = 0,
+		};
+
+		#define SG_SHADERC_ENV_VERSION_VULKAN_1_0 (1u << 22)
+		#define SG_SHADERC_ENV_VERSION_VULKAN_1_1 ((1u << 22) | (1u << 12))
+
+		typedef struct ShadercIncludeResult
+		{
+			const char* sourceName;
+			size_t      sourceNameLength;
+			const char* content;
+			size_t      contentLength;
+			void*       pUserData;
+		} ShadercIncludeResult;
+
+		typedef ShadercIncludeResult* (*ShadercIncludeResolveFunc)(void* pUserData, const char* requestedSource, int type, const char* requestingSource, size_t includeDepth);
+		typedef void (*ShadercIncludeReleaseFunc)(void* pUserData, ShadercIncludeResult* pResult);
+
+		typedef struct ShadercLibrary
+		{
+			void* pLibrary;
+			bool  searched;
+
+			void*       (*compiler_initialize)();
+			void        (*compiler_release)(void* pCompiler);
+			void*       (*compile_options_initialize)();
+			void        (*compile_options_release)(void* pOptions);
+			void        (*compile_options_add_macro_definition)(void* pOptions, const char* name, size_t nameLength, const char* value, size_t valueLength);
+			void        (*compile_options_set_target_env)(void* pOptions, int target, uint32_t version);
+			void        (*compile_options_set_include_callbacks)(void* pOptions, ShadercIncludeResolveFunc resolver, ShadercIncludeReleaseFunc releaser, void* pUserData);
+			void*       (*compile_into_spv)(const void* pCompiler, const char* sourceText, size_t sourceTextSize, int shaderKind, const char* inputFileName, const char* entryPointName, const void* pOptions);
+			int         (*result_get_compilation_status)(const void* pResult);
+			size_t      (*result_get_length)(const void* pResult);
+			const char* (*result_get_bytes)(const void* pResult);
+			const char* (*result_get_error_message)(const void* pResult);
+			void        (*result_release)(void* pResult);
+		} ShadercLibrary;
+
+		static ShadercLibrary gShaderc = {};
+
+		static void* util_open_shared_library(const char* path)
+		{
+		#if defined(SG_PLATFORM_WINDOWS)
+			return (void*)LoadLibraryA(path);
+		#else
+			return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+		#endif
+		}
+
+		static void* util_get_shared_library_function(void* pLibrary, const char* name)
+		{
+		#if defined(SG_PLATFORM_WINDOWS)
+			return (void*)GetProcAddress((HMODULE)pLibrary, name);
+		#else
+			return dlsym(pLibrary, name);
+		#endif
+		}
+
+		static void util_close_shared_library(void* pLibrary)
+		{
+		#if defined(SG_PLATFORM_WINDOWS)
+			FreeLibrary((HMODULE)pLibrary);
+		#else
+			dlclose(pLibrary);
+		#endif
+		}
+
+		/// Null if shaderc can not be used, it is looked for once per resource loader
+		static const ShadercLibrary* util_get_shaderc()
+		{
+			// the library is unloaded with the resource loader, without one there is no shaderc
+			if (!pResourceLoader)
+				return nullptr;
+
+			MutexLock lck(pResourceLoader->shaderCompilerMutex);
+			if (gShaderc.searched)
+				return gShaderc.pLibrary ? &gShaderc : nullptr;
+			gShaderc.searched = true;
+
+			// the resource limits of config.conf are only understood by glslangValidator
+			FileStream confStream = {};
+			if (sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, "config.conf", SG_FM_READ, &confStream))
+			{
+				sgfs_close_stream(&confStream);
+				SG_LOG_INFO("Shader config.conf found, compiling shaders with glslangValidator");
+				return nullptr;
+			}
+
+		#if defined(SG_PLATFORM_WINDOWS)
+			const char* libraryName = "shaderc_shared.dll";
+			const char* sdkDirectory = "/Bin/";
+		#else
+			const char* libraryName = "libshaderc_shared.so";
+			const char* sdkDirectory = "/lib/";
+		#endif
+			const char* vulkanSdk = ::getenv("VULKAN_SDK");
+			if (vulkanSdk)
+				gShaderc.pLibrary = util_open_shared_library((eastl::string(vulkanSdk) + sdkDirectory + libraryName).c_str());
+			if (!gShaderc.pLibrary)
+				gShaderc.pLibrary = util_open_shared_library(libraryName);
+			if (!gShaderc.pLibrary)
+			{
+				SG_LOG_INFO("%s not found, compiling shaders with glslangValidator", libraryName);
+				return nullptr;
+			}
+
+			bool found = true;
+		#define SG_LOAD_SHADERC_FUNCTION(name) \
+			gShaderc.name = (decltype(gShaderc.name))util_get_shared_library_function(gShaderc.pLibrary, "shaderc_" #name); \
+			found = found && gShaderc.name
+			SG_LOAD_SHADERC_FUNCTION(compiler_initialize);
+			SG_LOAD_SHADERC_FUNCTION(compiler_release);
+			SG_LOAD_SHADERC_FUNCTION(compile_options_initialize);
+			SG_LOAD_SHADERC_FUNCTION(compile_options_release);
+			SG_LOAD_SHADERC_FUNCTION(compile_options_add_macro_definition);
+			SG_LOAD_SHADERC_FUNCTION(compile_options_set_target_env);
+			SG_LOAD_SHADERC_FUNCTION(compile_options_set_include_callbacks);
+			SG_LOAD_SHADERC_FUNCTION(compile_into_spv);
+			SG_LOAD_SHADERC_FUNCTION(result_get_compilation_status);
+			SG_LOAD_SHADERC_FUNCTION(result_get_length);
+			SG_LOAD_SHADERC_FUNCTION(result_get_bytes);
+			SG_LOAD_SHADERC_FUNCTION(result_get_error_message);
+			SG_LOAD_SHADERC_FUNCTION(result_release);
+		#undef SG_LOAD_SHADERC_FUNCTION
+
+			if (!found)
+			{
+				SG_LOG_WARNING("%s lacks functions we need, compiling shaders with glslangValidator", libraryName);
+				util_close_shared_library(gShaderc.pLibrary);
+				gShaderc.pLibrary = nullptr;
+				return nullptr;
+			}
+			return &gShaderc;
+		}
+
+		static void util_unload_shaderc()
+		{
+			if (gShaderc.pLibrary)
+				util_close_shared_library(gShaderc.pLibrary);
+			gShaderc = {};
+		}
+
+		static int util_get_shaderc_shader_kind(const char* extension)
+		{
+			static const char* extensions[] = { "vert", "frag", "comp", "geom", "tesc", "tese", "rgen", "rahit", "rchit", "rmiss", "rint", "rcall" };
+			static const int kinds[] = {
+				SG_SHADERC_VERTEX_SHADER, SG_SHADERC_FRAGMENT_SHADER, SG_SHADERC_COMPUTE_SHADER, SG_SHADERC_GEOMETRY_SHADER,
+				SG_SHADERC_TESS_CONTROL_SHADER, SG_SHADERC_TESS_EVALUATION_SHADER, SG_SHADERC_RAYGEN_SHADER, SG_SHADERC_ANYHIT_SHADER,
+				SG_SHADERC_CLOSESTHIT_SHADER, SG_SHADERC_MISS_SHADER, SG_SHADERC_INTERSECTION_SHADER, SG_SHADERC_CALLABLE_SHADER };
+			for (uint32_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); ++i)
+			{
+				if (stricmp(extension, extensions[i]) == 0)
+					return kinds[i];
+			}
+			return -1;
+		}
+
+		static ShadercIncludeResult* util_resolve_shaderc_include(void* pUserData, const char* requestedSource, int type, const char* requestingSource, size_t includeDepth)
+		{
+			UNREF_PARAM(includeDepth);
+
+			// relative includes are looked up next to the file including them, like process_source_file does
+			char includePath[SG_MAX_FILEPATH] = {};
+			if (SG_SHADERC_INCLUDE_TYPE_RELATIVE == type)
+			{
+				char parentPath[SG_MAX_FILEPATH] = {};
+				sgfs_get_parent_path(requestingSource, parentPath);
+				sgfs_append_path_component(parentPath, requestedSource, includePath);
+			}
+			else
+			{
+				strncpy(includePath, requestedSource, SG_MAX_FILEPATH - 1);
+			}
+
+			const ShaderInclude* pInclude = util_get_shader_include((ShaderIncludeCache*)pUserData, includePath);
+			ShadercIncludeResult* pResult = sg_new(ShadercIncludeResult);
+			if (pInclude)
+			{
+				pResult->sourceName = pInclude->path.c_str();
+				pResult->sourceNameLength = pInclude->path.size();
+				pResult->content = pInclude->code.c_str();
+				pResult->contentLength = pInclude->code.size();
+			}
+			else
+			{
+				// an empty source name tells shaderc that the include failed, the content is the error
+				pResult->sourceName = "";
+				pResult->content = "Cannot open #include file";
+				pResult->contentLength = strlen(pResult->content);
+			}
+			return pResult;
+		}
+
+		static void util_release_shaderc_include(void* pUserData, ShadercIncludeResult* pResult)
+		{
+			UNREF_PARAM(pUserData);
+			// the code belongs to the include cache
+			sg_delete(pResult);
+		}
+
+		/// Returns false if shaderc is not available, compile errors are logged and leave pOut empty
+		bool vk_compile_shader_in_process(
+			Renderer* pRenderer, ShaderTarget target, const char* fileName, const eastl::string& code, ShaderIncludeCache* pIncludeCache,
+			uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
+		{
+			UNREF_PARAM(pRenderer);
+
+			const ShadercLibrary* pShaderc = util_get_shaderc();
+			if (!pShaderc)
+				return false;
+
+			char extension[SG_MAX_FILEPATH] = { 0 };
+			sgfs_get_path_extension(fileName, extension);
+			int shaderKind = util_get_shaderc_shader_kind(extension);
+			if (shaderKind < 0)
+				return false;
+
+			void* pCompiler = pShaderc->compiler_initialize();
+			void* pOptions = pShaderc->compile_options_initialize();
+			pShaderc->compile_options_set_target_env(pOptions, SG_SHADERC_TARGET_ENV_VULKAN,
+				target >= SG_SHADER_TARGET_6_0 ? SG_SHADERC_ENV_VERSION_VULKAN_1_1 : SG_SHADERC_ENV_VERSION_VULKAN_1_0);
+			pShaderc->compile_options_set_include_callbacks(pOptions, util_resolve_shaderc_include, util_release_shaderc_include, pIncludeCache);
+
+			// same platform macro as on the glslangValidator command line
+		#ifdef SG_PLATFORM_WINDOWS
+			const char* platformMacro = "WINDOWS";
+		#elif defined(__linux__)
+			const char* platformMacro = "LINUX";
+		#else
+			const char* platformMacro = nullptr;
+		#endif
+			if (platformMacro)
+				pShaderc->compile_options_add_macro_definition(pOptions, platformMacro, strlen(platformMacro), nullptr, 0);
+			for (uint32_t i = 0; i < macroCount; ++i)
+			{
+				pShaderc->compile_options_add_macro_definition(pOptions, pMacros[i].definition, strlen(pMacros[i].definition),
+					pMacros[i].value, strlen(pMacros[i].value));
+			}
+
+			void* pResult = pShaderc->compile_into_spv(pCompiler, code.c_str(), code.size(), shaderKind, fileName,
+				pEntryPoint ? pEntryPoint : "main", pOptions);
+			if (SG_SHADERC_COMPILATION_STATUS_SUCCESS == pShaderc->result_get_compilation_status(pResult))
+			{
+				pOut->byteCodeSize = (uint32_t)pShaderc->result_get_length(pResult);
+				pOut->pByteCode = sg_malloc(pOut->byteCodeSize);
+				memcpy(pOut->pByteCode, pShaderc->result_get_bytes(pResult), pOut->byteCodeSize);
+			}
+			else
+			{
+				util_report_shader_error(eastl::string().sprintf("Failed to compile shader %s with error\n%s", fileName, pShaderc->result_get_error_message(pResult)));
+			}
+
+			pShaderc->result_release(pResult);
+			pShaderc->compile_options_release(pOptions);
+			pShaderc->compiler_release(pCompiler);
+			return true;
+		}
+
+		// Release builds run the performance passes of spirv-opt over the compiled bytecode. The optimizer is the SPIRV-Tools
+		// shared library of the Vulkan SDK, loaded at runtime like shaderc, without it the bytecode is only stripped.
+
+		// Values of the SPIRV-Tools C interface (spirv-tools/libspirv.h) that we use
+		enum
+		{
+			SG_SPV_ENV_VULKAN_1_0 = 1,
+			SG_SPV_ENV_VULKAN_1_1 = 18,
+			SG_SPV_SUCCESS = 0,
+		};
+
+		typedef struct SpirvBinary
+		{
+			uint32_t* pCode;
+			size_t    wordCount;
+		} SpirvBinary;
+
+		typedef struct SpirvToolsLibrary
+		{
+			void* pLibrary;
+			bool  searched;
+
+			void* (*optimizer_create)(int env);
+			void  (*optimizer_destroy)(void* pOptimizer);
+			void  (*optimizer_register_performance_passes)(void* pOptimizer);
+			int   (*optimizer_run)(void* pOptimizer, const uint32_t* pBinary, size_t wordCount, SpirvBinary** ppOptimizedBinary, const void* pOptions);
+			void* (*optimizer_options_create)();
+			void  (*optimizer_options_destroy)(void* pOptions);
+			void  (*optimizer_options_set_run_validator)(void* pOptions, bool run);
+			void  (*optimizer_options_set_preserve_bindings)(void* pOptions, bool preserve);
+			void  (*binary_destroy)(SpirvBinary* pBinary);
+		} SpirvToolsLibrary;
+
+		static SpirvToolsLibrary gSpirvTools = {};
+
+		/// Null if the optimizer can not be used, it is looked for once per resource loader
+		static const SpirvToolsLibrary* util_get_spirv_tools()
+		{
+			if (!pResourceLoader)
+				return nullptr;
+
+			MutexLock lck(pResourceLoader->shaderCompilerMutex);
+			if (gSpirvTools.searched)
+				return gSpirvTools.pLibrary ? &gSpirvTools : nullptr;
+			gSpirvTools.searched = true;
+
+		#if defined(SG_PLATFORM_WINDOWS)
+			const char* libraryName = "SPIRV-Tools-shared.dll";
+			const char* sdkDirectory = "/Bin/";
+		#else
+			const char* libraryName = "libSPIRV-Tools-shared.so";
+			const char* sdkDirectory = "/lib/";
+		#endif
+			const char* vulkanSdk = ::getenv("VULKAN_SDK");
+			if (vulkanSdk)
+				gSpirvTools.pLibrary = util_open_shared_library((eastl::string(vulkanSdk) + sdkDirectory + libraryName).c_str());
+			if (!gSpirvTools.pLibrary)
+				gSpirvTools.pLibrary = util_open_shared_library(libraryName);
+			if (!gSpirvTools.pLibrary)
+			{
+				SG_LOG_INFO("%s not found, release shaders are not optimized", libraryName);
+				return nullptr;
+			}
+
+			bool found = true;
+		#define SG_LOAD_SPIRV_TOOLS_FUNCTION(name, function) \
+			gSpirvTools.name = (decltype(gSpirvTools.name))util_get_shared_library_function(gSpirvTools.pLibrary, function); \
+			found = found && gSpirvTools.name
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_create, "spvOptimizerCreate");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_destroy, "spvOptimizerDestroy");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_register_performance_passes, "spvOptimizerRegisterPerformancePasses");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_run, "spvOptimizerRun");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_options_create, "spvOptimizerOptionsCreate");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_options_destroy, "spvOptimizerOptionsDestroy");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_options_set_run_validator, "spvOptimizerOptionsSetRunValidator");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(optimizer_options_set_preserve_bindings, "spvOptimizerOptionsSetPreserveBindings");
+			SG_LOAD_SPIRV_TOOLS_FUNCTION(binary_destroy, "spvBinaryDestroy");
+		#undef SG_LOAD_SPIRV_TOOLS_FUNCTION
+
+			if (!found)
+			{
+				SG_LOG_WARNING("%s lacks functions we need, release shaders are not optimized", libraryName);
+				util_close_shared_library(gSpirvTools.pLibrary);
+				gSpirvTools.pLibrary = nullptr;
+				return nullptr;
+			}
+			return &gSpirvTools;
+		}
+
+		static void util_unload_spirv_tools()
+		{
+			if (gSpirvTools.pLibrary)
+				util_close_shared_library(gSpirvTools.pLibrary);
+			gSpirvTools = {};
+		}
+
+		/// Runs the performance passes of spirv-opt (inlining, dead code elimination, scalar replacement, loop unrolling where
+		/// the shader asks for it, ...) over the bytecode. Returns false and leaves the bytecode as it is if the optimizer is
+		/// not available or fails
+		bool vk_optimize_shader(ShaderTarget target, const char* fileName, BinaryShaderStageDesc* pStage)
+		{
+			const SpirvToolsLibrary* pSpirvTools = util_get_spirv_tools();
+			if (!pSpirvTools)
+				return false;
+
+			void* pOptimizer = pSpirvTools->optimizer_create(target >= SG_SHADER_TARGET_6_0 ? SG_SPV_ENV_VULKAN_1_1 : SG_SPV_ENV_VULKAN_1_0);
+			pSpirvTools->optimizer_register_performance_passes(pOptimizer);
+			void* pOptions = pSpirvTools->optimizer_options_create();
+			// the compiler validated the bytecode already. Unused resources keep their bindings, so the root signatures
+			// and the names the app updates are the same in every build
+			pSpirvTools->optimizer_options_set_run_validator(pOptions, false);
+			pSpirvTools->optimizer_options_set_preserve_bindings(pOptions, true);
+
+			SpirvBinary* pBinary = nullptr;
+			const bool result = SG_SPV_SUCCESS == pSpirvTools->optimizer_run(pOptimizer, (const uint32_t*)pStage->pByteCode,
+				pStage->byteCodeSize / sizeof(uint32_t), &pBinary, pOptions) && pBinary && pBinary->wordCount;
+			if (result)
+			{
+				sg_free(pStage->pByteCode);
+				pStage->byteCodeSize = (uint32_t)(pBinary->wordCount * sizeof(uint32_t));
+				pStage->pByteCode = sg_malloc(pStage->byteCodeSize);
+				memcpy(pStage->pByteCode, pBinary->pCode, pStage->byteCodeSize);
+			}
+			else
+			{
+				SG_LOG_WARNING("Failed to optimize shader %s, it is saved unoptimized", fileName);
+			}
+
+			if (pBinary)
+				pSpirvTools->binary_destroy(pBinary);
+			pSpirvTools->optimizer_options_destroy(pOptions);
+			pSpirvTools->optimizer_destroy(pOptimizer);
+			return result;
+		}
+
+		// Vulkan has no builtin functions to compile source to spirv
+		// So we call the glslangValidator tool located inside VulkanSDK on user machine to compile the glsl code to spirv
+		// This code is not added to Vulkan.cpp since it calls no Vulkan specific functions
+		void vk_compile_shader(
+			Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, const char* outFile, uint32_t macroCount,
+			ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
+		{
+			eastl::string commandLine;
+			char filePath[SG_MAX_FILEPATH] = { 0 };
+			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_SOURCES), fileName, filePath);
+			char outFilePath[SG_MAX_FILEPATH] = { 0 };
+			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_BINARIES), outFile, outFilePath);
+
+			// if there is a config file located in the shader source directory use it to specify the limits
+			FileStream confStream = {};
+			if (sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, "config.conf", SG_FM_READ, &confStream))
+			{
+				sgfs_close_stream(&confStream);
+				char configFilePath[SG_MAX_FILEPATH] = { 0 };
+				sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_SOURCES), "config.conf", configFilePath);
+
+				// dd command to compile from Vulkan GLSL to Spirv
+				commandLine.append_sprintf(
+					"\"%s\" -V \"%s\" -o \"%s\"",
+					configFilePath,
+					filePath,
+					outFilePath);
+			}
+			else
+			{
+				commandLine.append_sprintf("-V \"%s\" -o \"%s\"",
+					filePath,
+					outFilePath);
+			}
+
+			if (target >= SG_SHADER_TARGET_6_0)
+				commandLine += " --target-env vulkan1.1 ";
+			//commandLine += " \"-D" + eastl::string("VULKAN") + "=" + "1" + "\"";
+
+			if (pEntryPoint != nullptr)
+				commandLine.append_sprintf(" -e %s", pEntryPoint);
+
+			// add platform macro
+		#ifdef SG_PLATFORM_WINDOWS
+			commandLine += " \"-D WINDOWS\"";
+		#elif defined(__ANDROID__)
+			commandLine += " \"-D ANDROID\"";
+		#elif defined(__linux__)
+			commandLine += " \"-D LINUX\"";
+		#endif
+
+			// add user defined macros to the command line
+			for (uint32_t i = 0; i < macroCount; ++i)
+			{
+				commandLine += " \"-D" + eastl::string(pMacros[i].definition) + "=" + pMacros[i].value + "\"";
+			}
+
+			eastl::string glslangValidator = ::getenv("VULKAN_SDK");
+			if (glslangValidator.size())
+				glslangValidator += "/Bin/glslangValidator";
+			else
+				glslangValidator = "/usr/Bin/glslangValidator";
+			
+			const char* args[1] = { commandLine.c_str() };
+
+			char logFileName[SG_MAX_FILEPATH] = { 0 };
+			sgfs_get_path_file_name(outFile, logFileName);
+			strcat(logFileName, "_compile.log");
+
+			char logFilePath[SG_MAX_FILEPATH] = { 0 };
+			sgfs_append_path_component(sgfs_get_resource_directory(SG_RD_SHADER_BINARIES), logFileName, logFilePath);
+
+			if (system_run(glslangValidator.c_str(), args, 1, logFilePath) == 0)
+			{
+				FileStream fh = {};
+				bool success = sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, outFile, SG_FM_READ_BINARY, &fh);
+				//Check if the File Handle exists
+				ASSERT(success);
+				pOut->byteCodeSize = (uint32_t)sgfs_get_stream_file_size(&fh);
+				pOut->pByteCode = sg_malloc(pOut->byteCodeSize);
+				sgfs_read_from_stream(&fh, pOut->pByteCode, pOut->byteCodeSize);
+				sgfs_close_stream(&fh);
+			}
+			else
+			{
+				FileStream fh = {};
+				// If for some reason the error file could not be created just log error msg
+				if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, logFileName, SG_FM_READ_BINARY, &fh))
+				{
+					util_report_shader_error(eastl::string().sprintf("Failed to compile shader %s", filePath));
+				}
+				else
+				{
+					size_t size = sgfs_get_stream_file_size(&fh);
+					if (size)
+					{
+						char* errorLog = (char*)sg_malloc(size + 1);
+						errorLog[size] = 0;
+						sgfs_read_from_stream(&fh, errorLog, size);
+						util_report_shader_error(eastl::string().sprintf("Failed to compile shader %s with error\n%s", filePath, errorLog));
+						sg_free(errorLog);
+					}
+					sgfs_close_stream(&fh);
+				}
+			}
+		}
+		#endif
+		#elif defined(SG_GRAPHIC_API_METAL)
+		// On Metal, on the other hand, we can compile from code into a MTLLibrary, but cannot save this
+		// object's bytecode to disk. We instead use the xcbuild bash tool to compile the shaders.
+		void mtl_compileShader(
+			Renderer* pRenderer, const char* fileName, const char* outFile, uint32_t macroCount, ShaderMacro* pMacros,
+			BinaryShaderStageDesc* pOut, const char* /*pEntryPoint*/)
+		{
+			char filePath[FS_MAX_PATH] = {};
+			fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_SOURCES), fileName, filePath);
+			char outFilePath[FS_MAX_PATH] = {};
+			fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_BINARIES), outFile, outFilePath);
+			char intermediateFilePath[FS_MAX_PATH] = {};
+			fsAppendPathExtension(outFilePath, "air", intermediateFilePath);
+
+			const char* xcrun = "/usr/bin/xcrun";
+			eastl::vector<eastl::string> args;
+			eastl::string tmpArg = "";
+
+			// Compile the source into a temporary .air file.
+			args.push_back("-sdk");
+			args.push_back("macosx");
+			args.push_back("metal");
+			args.push_back("-c");
+			args.push_back(filePath);
+			args.push_back("-o");
+			args.push_back(intermediateFilePath);
+
+			//enable the 2 below for shader debugging on xcode
+			//args.push_back("-MO");
+			//args.push_back("-gline-tables-only");
+			args.push_back("-D");
+			args.push_back("MTL_SHADER=1");    // Add MTL_SHADER macro to differentiate structs in headers shared by app/shader code.
+
+			// Add user defined macros to the command line
+			for (uint32_t i = 0; i < macroCount; ++i)
+			{
+				args.push_back("-D");
+				args.push_back(eastl::string(pMacros[i].definition) + "=" + pMacros[i].value);
+			}
+
+			eastl::vector<const char*> cArgs;
+			for (eastl::string& arg : args) {
+				cArgs.push_back(arg.c_str());
+			}
+
+			if (system_run(xcrun, &cArgs[0], cArgs.size(), NULL) == 0)
+			{
+				// Create a .metallib file from the .air file.
+				args.clear();
+				tmpArg = "";
+				args.push_back("-sdk");
+				args.push_back("macosx");
+				args.push_back("metallib");
+				args.push_back(intermediateFilePath);
+				args.push_back("-o");
+				tmpArg = eastl::string().sprintf(
+					""
+					"%s"
+					"",
+					outFilePath);
+				args.push_back(tmpArg);
+
+				cArgs.clear();
+				for (eastl::string& arg : args) {
+					cArgs.push_back(arg.c_str());
+				}
+
+				if (systemRun(xcrun, &cArgs[0], cArgs.size(), NULL) == 0)
+				{
+					// Remove the temp .air file.
+					const char* nativePath = intermediateFilePath;
+					systemRun("rm", &nativePath, 1, NULL);
+
+					// Store the compiled bytecode.
+					FileStream fHandle = {};
+					if (fsOpenStreamFromPath(RD_SHADER_BINARIES, outFile, FM_READ_BINARY, &fHandle))
+					{
+						pOut->mByteCodeSize = (uint32_t)fsGetStreamFileSize(&fHandle);
+						pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
+						fsReadFromStream(&fHandle, pOut->pByteCode, pOut->mByteCodeSize);
+						fsCloseStream(&fHandle);
+					}
+				}
+				else
+				{
+					LOGF(eERROR, "Failed to assemble shader's %s .metallib file", outFile);
+				}
+			}
+			else
+			{
+				LOGF(eERROR, "Failed to compile shader %s", filePath);
+			}
+		}
+		#endif
+		#if (defined(SG_GRAPHIC_API_D3D12) || defined(SG_GRAPHIC_API_D3D11))
+		extern void compileShader(
+			Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
+			bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
+		#endif
+		#if defined(ORBIS)
+		extern bool orbis_compileShader(
+			Renderer* pRenderer,
+			ShaderStage stage, ShaderStage allStages,
+			const char* srcFileName,
+			const char* outFileName,
+			uint32_t macroCount, ShaderMacro* pMacros,
+			BinaryShaderStageDesc* pOut,
+			const char* pEntryPoint);
+		#endif
+		#if defined(PROSPERO)
+		extern bool prospero_compileShader(
+			Renderer* pRenderer,
+			ShaderStage stage, ShaderStage allStages,
+			const char* srcFileName,
+			const char* outFileName,
+			uint32_t macroCount, ShaderMacro* pMacros,
+			BinaryShaderStageDesc* pOut,
+			const char* pEntryPoint);
+		#endif
+		#if defined(SG_GRAPHIC_API_GLES)
+		extern void gl_compileShader(Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
+			bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
+	#endif
+
+	static eastl::string sgfs_read_from_stream_stl_line(FileStream* stream)
+	{
+		eastl::string result;
+
+		while (!sgfs_is_stream_at_end(stream))
+		{
+			char nextChar = 0;
+			sgfs_read_from_stream(stream, &nextChar, sizeof(nextChar));
+			if (nextChar == 0 || nextChar == '\n')
+			{
+				break;
+			}
+			if (nextChar == '\r')
+			{
+				char newLine = 0;
+				sgfs_read_from_stream(stream, &newLine, sizeof(newLine));
+				if (newLine == '\n')
+				{
+					break;
+				}
+				else
+				{
+					// We're not looking at a "\r\n" sequence, so add the '\r' to the buffer.
+					sgfs_seek_stream(stream, SG_SBO_CURRENT_POSITION, -1);
+				}
+			}
+			result.push_back(nextChar);
+		}
+		return result;
+	}
+
+	// function to collect the hashes of the files this shader source file includes, the hash of an include covers its own includes
+	#if !defined(NX64)
+	// with an include cache the includes are scanned once per batch and their hash and code come from the cache,
+	// without one (where the binaries are not cached) no hashes are collected
+	static bool process_source_file(const char* pAppName, FileStream* original, const char* filePath, FileStream* file, ShaderIncludeCache* pIncludeCache,
+		eastl::vector<Hash128>& outIncludeHashes, eastl::string& outCode)
+	{
+		if (!file)
+		{
+			return true; // The source file is missing, but we may still be able to use the shader binary.
+		}
+
+		const eastl::string pIncludeDirective = "#include";
+		while (!sgfs_is_stream_at_end(file))
+		{
+			eastl::string line = sgfs_read_from_stream_stl_line(file);
+
+			size_t filePos = line.find(pIncludeDirective, 0);
+			const size_t  commentPosCpp = line.find("//", 0);
+			const size_t  commentPosC = line.find("/*", 0);
+
+			// if we have an "#include \"" in our current line
+			const bool bLineHasIncludeDirective = filePos != eastl::string::npos;
+			const bool bLineIsCommentedOut = (commentPosCpp != eastl::string::npos && commentPosCpp < filePos) ||
+				(commentPosC != eastl::string::npos && commentPosC < filePos);
+
+			if (bLineHasIncludeDirective && !bLineIsCommentedOut)
+			{
+				// get the include file name
+				size_t        currentPos = filePos + pIncludeDirective.length();
+				eastl::string fileName;
+				while (line.at(currentPos++) == ' ')
+					;    // skip empty spaces
+				if (currentPos >= line.size())
+					continue;
+				if (line.at(currentPos - 1) != '\"')
+					continue;
+				else
+				{
+					// read char by char until we have the include file name
+					while (line.at(currentPos) != '\"')
+					{
+						fileName.push_back(line.at(currentPos));
+						++currentPos;
+					}
+				}
+
+				// get the include file path
+				//TODO: remove Comments
+				if (fileName.at(0) == '<')    // disregard bracketsauthop
+					continue;
+
+				// open the include file
+				char includePath[SG_MAX_FILEPATH] = {};
+				{
+					char parentPath[SG_MAX_FILEPATH] = {};
+					sgfs_get_parent_path(filePath, parentPath);
+					sgfs_append_path_component(parentPath, fileName.c_str(), includePath);
+				}
+				if (pIncludeCache)
+				{
+					const ShaderInclude* pInclude = util_get_shader_include(pIncludeCache, includePath);
+					if (!pInclude)
+					{
+						util_report_shader_error(eastl::string().sprintf("Cannot open #include file: %s", includePath));
+						continue;
+					}
+
+					outIncludeHashes.push_back(pInclude->hash);
+					outCode += pInclude->processedCode;
+				}
+				else
+				{
+					FileStream fHandle = {};
+					if (!sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, includePath, SG_FM_READ_BINARY, &fHandle))
+					{
+						util_report_shader_error(eastl::string().sprintf("Cannot open #include file: %s", includePath));
+						continue;
+					}
+
+					// add the include file into the current code recursively
+					if (!process_source_file(pAppName, original, includePath, &fHandle, nullptr, outIncludeHashes, outCode))
+					{
+						sgfs_close_stream(&fHandle);
+						return false;
+					}
+
+					sgfs_close_stream(&fHandle);
+				}
+			}
+
+	#if defined(TARGET_IOS) || defined(ANDROID)
+			// iOS doesn't have support for resolving user header includes in shader code
+			// when compiling with shader source using Metal runtime.
+			// https://developer.apple.com/library/archive/documentation/3DDrawing/Conceptual/MTLBestPracticesGuide/FunctionsandLibraries.html
+			//
+			// Here we write out the contents of the header include into the original source
+			// where its included from -- we're expanding the headers as the pre-processor
+			// would do.
+			//
+			//const bool bAreWeProcessingAnIncludedHeader = file != original;
+			if (!bLineHasIncludeDirective)
+			{
+				outCode += line + "\n";
+			}
+	#else
+			// simply write out the current line if we are not in a header file
+			const bool bAreWeProcessingTheShaderSource = file == original;
+			if (bAreWeProcessingTheShaderSource)
+			{
+				outCode += line + "\n";
+			}
+	#endif
+		}
+		return true;
+	}
+
+	static const ShaderInclude* util_get_shader_include(ShaderIncludeCache* pCache, const char* filePath)
+	{
+		{
+			MutexLock lck(pCache->mutex);
+			eastl::unordered_map<eastl::string, ShaderInclude*>::iterator it = pCache->includes.find(filePath);
+			if (it != pCache->includes.end())
+				return it->second;
+		}
+
+		// read outside of the lock, when two stages ask for the same file at once both read it and the first one is kept
+		FileStream fh = {};
+		if (!sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, filePath, SG_FM_READ_BINARY, &fh))
+			return nullptr;
+
+		ShaderInclude* pInclude = sg_new(ShaderInclude);
+		pInclude->path = filePath;
+		size_t size = (size_t)sgfs_get_stream_file_size(&fh);
+		pInclude->code.resize(size);
+		sgfs_read_from_stream(&fh, &pInclude->code[0], size);
+		sgfs_close_stream(&fh);
+
+		// scan the includes of the include from memory, nothing is the original source here
+		FileStream codeStream = {};
+		eastl::vector<Hash128> includeHashes;
+		sgfs_open_stream_from_memory(pInclude->code.data(), size, SG_FM_READ_BINARY, false, &codeStream);
+		bool result = process_source_file(pCache->pAppName, nullptr, filePath, &codeStream, pCache, includeHashes, pInclude->processedCode);
+		sgfs_close_stream(&codeStream);
+		if (!result)
+		{
+			sg_delete(pInclude);
+			return nullptr;
+		}
+
+		includeHashes.push_back(hash_128(pInclude->code.data(), pInclude->code.size()));
+		pInclude->hash = hash_128(includeHashes.data(), includeHashes.size() * sizeof(Hash128));
+
+		MutexLock lck(pCache->mutex);
+		eastl::pair<eastl::unordered_map<eastl::string, ShaderInclude*>::iterator, bool> inserted =
+			pCache->includes.insert(eastl::make_pair(pInclude->path, pInclude));
+		if (!inserted.second)
+		{
+			sg_delete(pInclude);
+			return inserted.first->second;
+		}
+		return pInclude;
+	}
+	#endif
+
+	// Shader binaries start with a header holding the key of everything the bytecode was compiled from: the source with
+	// every include, the macros, the entry point, the target and the compiler. A binary with another key gets compiled again,
+	// so touching a file costs nothing and a new compiler recompiles everything.
+	// The serialized reflection of the bytecode follows it, so a binary is loaded with a single read and never reflected again.
+	#define SG_SHADER_BINARY_MAGIC 0x42534753u // "SGSB"
+	#define SG_SHADER_BINARY_VERSION 2
+	/// Bump when the way the shaders are compiled changes without the key seeing it
+	#define SG_SHADER_COMPILER_VERSION 2
+
+	typedef struct ShaderBinaryHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		Hash128  key;
+		uint32_t byteCodeSize;
+		/// size of the serialized reflection behind the bytecode, 0 if the binary has none
+		uint32_t reflectionSize;
+	} ShaderBinaryHeader;
+
+	/// Identifies the compiler in the binary keys
+	static const char* util_get_shader_compiler_version()
+	{
+		// shaderc and glslangValidator both come with the Vulkan SDK, which has its version in its path
+		static const eastl::string version = eastl::string().sprintf("%u %s", SG_SHADER_COMPILER_VERSION, ::getenv("VULKAN_SDK") ? ::getenv("VULKAN_SDK") : "");
+		return version.c_str();
+	}
+
+	// loads the bytecode and its reflection from file if the binary shader file was compiled with the key, any binary is used without a key
+	bool check_for_byte_code(Renderer* pRenderer, const char* binaryShaderPath, const Hash128* pKey, BinaryShaderStageDesc* pOut)
+	{
+		// a missing binary is the normal case before the first compile
+		FileStream fh = {};
+		if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, binaryShaderPath, SG_FM_READ_BINARY, &fh))
+			return false;
+
+		ShaderBinaryHeader header = {};
+		ssize_t size = sgfs_get_stream_file_size(&fh);
+		if (size <= (ssize_t)sizeof(header) || sgfs_read_from_stream(&fh, &header, sizeof(header)) != sizeof(header) ||
+			header.magic != SG_SHADER_BINARY_MAGIC || header.version != SG_SHADER_BINARY_VERSION ||
+			(uint64_t)header.byteCodeSize + header.reflectionSize != (uint64_t)(size - sizeof(header)) || (pKey && header.key != *pKey))
+		{
+			sgfs_close_stream(&fh);
+			return false;
+		}
+
+	#if defined(PROSPERO)
+		extern void prospero_loadByteCode(Renderer*, FileStream*, BinaryShaderStageDesc*);
+		prospero_loadByteCode(pRenderer, &fh, pOut);
+	#else
+		// the reflection shares the allocation of the bytecode
+		pOut->byteCodeSize = header.byteCodeSize;
+		//pOut->pByteCode = sg_memalign(256, size);
+		pOut->pByteCode = sg_malloc(header.byteCodeSize + header.reflectionSize);
+		ASSERT(pOut->pByteCode);
+
+		sgfs_read_from_stream(&fh, (void*)pOut->pByteCode, header.byteCodeSize + header.reflectionSize);
+		pOut->pReflection = header.reflectionSize ? (uint8_t*)pOut->pByteCode + header.byteCodeSize : nullptr;
+		pOut->reflectionSize = header.reflectionSize;
+	#endif
+		sgfs_close_stream(&fh);
+
+		return true;
+	}
+
+	// saves bytecode and its reflection to a file, behind the header with its key
+	bool save_byte_code(const char* binaryShaderPath, const Hash128& key, const BinaryShaderStageDesc* pStage)
+	{
+		if (!pStage->byteCodeSize)
+			return false;
+
+		FileStream fh = {};
+		if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, binaryShaderPath, SG_FM_WRITE_BINARY, &fh))
+			return false;
+
+		ShaderBinaryHeader header = {};
+		header.magic = SG_SHADER_BINARY_MAGIC;
+		header.version = SG_SHADER_BINARY_VERSION;
+		header.key = key;
+		header.byteCodeSize = pStage->byteCodeSize;
+		header.reflectionSize = pStage->reflectionSize;
+		sgfs_write_to_stream(&fh, &header, sizeof(header));
+		sgfs_write_to_stream(&fh, pStage->pByteCode, pStage->byteCodeSize);
+		if (pStage->reflectionSize)
+			sgfs_write_to_stream(&fh, pStage->pReflection, pStage->reflectionSize);
+		sgfs_close_stream(&fh);
+		return true;
+	}
+
+	#if defined(SG_GRAPHIC_API_VULKAN)
+	/// Reflect freshly compiled bytecode and append the serialized reflection to its allocation, to be saved with it
+	static void util_append_shader_reflection(ShaderStage stage, BinaryShaderStageDesc* pStage)
+	{
+		ShaderReflection reflection = {};
+		vk_create_shader_reflection((const uint8_t*)pStage->pByteCode, pStage->byteCodeSize, stage, &reflection);
+
+		const uint32_t reflectionSize = get_shader_reflection_blob_size(&reflection);
+		pStage->pByteCode = sg_realloc(pStage->pByteCode, pStage->byteCodeSize + reflectionSize);
+		serialize_shader_reflection(&reflection, (uint8_t*)pStage->pByteCode + pStage->byteCodeSize);
+		pStage->pReflection = (uint8_t*)pStage->pByteCode + pStage->byteCodeSize;
+		pStage->reflectionSize = reflectionSize;
+		destroy_shader_reflection(&reflection);
+	}
+
+	// SPIR-V opcodes that only carry debug information, see the SPIR-V specification
+	enum
+	{
+		SG_SPIRV_MAGIC = 0x07230203u,
+		SG_SPIRV_HEADER_WORD_COUNT = 5,
+		SG_SPIRV_OP_SOURCE_CONTINUED = 2,
+		SG_SPIRV_OP_SOURCE = 3,
+		SG_SPIRV_OP_SOURCE_EXTENSION = 4,
+		SG_SPIRV_OP_NAME = 5,
+		SG_SPIRV_OP_MEMBER_NAME = 6,
+		SG_SPIRV_OP_STRING = 7,
+		SG_SPIRV_OP_LINE = 8,
+		SG_SPIRV_OP_EXT_INST_IMPORT = 11,
+		SG_SPIRV_OP_NO_LINE = 317,
+		SG_SPIRV_OP_MODULE_PROCESSED = 330,
+	};
+
+	/// Number of instructions of the bytecode, 0 if it is not SPIR-V
+	static uint32_t util_get_spirv_instruction_count(const void* pByteCode, uint32_t byteCodeSize)
+	{
+		const uint32_t* pWords = (const uint32_t*)pByteCode;
+		const uint32_t wordCount = byteCodeSize / sizeof(uint32_t);
+		if (wordCount < SG_SPIRV_HEADER_WORD_COUNT || pWords[0] != SG_SPIRV_MAGIC)
+			return 0;
+
+		uint32_t instructionCount = 0;
+		for (uint32_t i = SG_SPIRV_HEADER_WORD_COUNT; i < wordCount; i += pWords[i] >> 16)
+		{
+			if (!(pWords[i] >> 16) || i + (pWords[i] >> 16) > wordCount)
+				return 0;
+			++instructionCount;
+		}
+		return instructionCount;
+	}
+
+	/// Remove the names, the source and the line information from the bytecode, in place. The reflection behind the
+	/// bytecode moves down with it, it has to be captured before since it finds the resources by their names
+	static void util_strip_spirv_debug_info(BinaryShaderStageDesc* pStage)
+	{
+		uint32_t* pWords = (uint32_t*)pStage->pByteCode;
+		const uint32_t wordCount = pStage->byteCodeSize / sizeof(uint32_t);
+		if (!util_get_spirv_instruction_count(pStage->pByteCode, pStage->byteCodeSize))
+			return;
+
+		// the non-semantic debug info refers to the strings
+		bool keepStrings = false;
+		for (uint32_t i = SG_SPIRV_HEADER_WORD_COUNT; i < wordCount; i += pWords[i] >> 16)
+		{
+			if ((pWords[i] & 0xffff) == SG_SPIRV_OP_EXT_INST_IMPORT && (pWords[i] >> 16) > 2 &&
+				strncmp((const char*)&pWords[i + 2], "NonSemantic.", 12) == 0)
+				keepStrings = true;
+		}
+
+		uint32_t newWordCount = SG_SPIRV_HEADER_WORD_COUNT;
+		for (uint32_t i = SG_SPIRV_HEADER_WORD_COUNT; i < wordCount;)
+		{
+			const uint32_t opcode = pWords[i] & 0xffff;
+			const uint32_t instructionWordCount = pWords[i] >> 16;
+			const bool strip = opcode == SG_SPIRV_OP_SOURCE_CONTINUED || opcode == SG_SPIRV_OP_SOURCE || opcode == SG_SPIRV_OP_SOURCE_EXTENSION ||
+				opcode == SG_SPIRV_OP_NAME || opcode == SG_SPIRV_OP_MEMBER_NAME || opcode == SG_SPIRV_OP_LINE || opcode == SG_SPIRV_OP_NO_LINE ||
+				opcode == SG_SPIRV_OP_MODULE_PROCESSED || (opcode == SG_SPIRV_OP_STRING && !keepStrings);
+			if (!strip)
+			{
+				memmove(&pWords[newWordCount], &pWords[i], instructionWordCount * sizeof(uint32_t));
+				newWordCount += instructionWordCount;
+			}
+			i += instructionWordCount;
+		}
+
+		pStage->byteCodeSize = newWordCount * sizeof(uint32_t);
+		if (pStage->reflectionSize)
+		{
+			memmove((uint8_t*)pStage->pByteCode + pStage->byteCodeSize, pStage->pReflection, pStage->reflectionSize);
+			pStage->pReflection = (uint8_t*)pStage->pByteCode + pStage->byteCodeSize;
+		}
+	}
+	#endif
+
+	/// Size of the bytecode of a stage as the compiler produced it and as it was saved
+	typedef struct ShaderStageSizeStats
+	{
+		uint32_t compiledByteCodeSize;
+		uint32_t compiledInstructionCount;
+		uint32_t savedByteCodeSize;
+		uint32_t savedInstructionCount;
+	} ShaderStageSizeStats;
+
+	bool load_shader_stage_byte_code(
+		Renderer* pRenderer, ShaderTarget target, ShaderStage stage, ShaderStage allStages, const ShaderStageLoadDesc& loadDesc, uint32_t macroCount,
+		ShaderMacro* pMacros, ShaderIncludeCache* pIncludeCache, BinaryShaderStageDesc* pOut, bool* pOutCompiled, ShaderStageSizeStats* pOutSizes)
+	{
+		UNREF_PARAM(loadDesc.flags);
+
+		eastl::string code;
+	#if !defined(NX64)
+		eastl::vector<Hash128> includeHashes;
+	#endif
+
+	#if !defined(SG_GRAPHIC_API_METAL) && !defined(NX64)
+		FileStream sourceFileStream = {};
+		// a missing source is reported below if there is no binary either
+		bool sourceExists = sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, loadDesc.fileName, SG_FM_READ_BINARY, &sourceFileStream);
+
+		if (!process_source_file(pRenderer->name, &sourceFileStream, loadDesc.fileName, &sourceFileStream, pIncludeCache, includeHashes, code))
+		{
+			sgfs_close_stream(&sourceFileStream);
+			return false;
+		}
+	#elif defined(NX64)
+		eastl::string shaderDefines;
+		for (uint32_t i = 0; i < macroCount; ++i)
+		{
+			shaderDefines += (eastl::string(pMacros[i].definition) + pMacros[i].value);
+		}
+
+		uint32_t hash = 0;
+		MurmurHash3_x86_32(shaderDefines.c_str(), shaderDefines.size(), 0, &hash);
+
+		char hashStringBuffer[14];
+		sprintf(&hashStringBuffer[0], "%zu.%s", (size_t)hash, "spv");
+
+		char nxShaderPath[FS_MAX_PATH] = {};
+		fsAppendPathExtension(loadDesc.pFileName, hashStringBuffer, nxShaderPath);
+		FileStream sourceFileStream = {};
+		bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, nxShaderPath, FM_READ_BINARY, &sourceFileStream);
+		ASSERT(sourceExists);
+
+		if (sourceExists)
+		{
+			pOut->mByteCodeSize = (uint32_t)fsGetStreamFileSize(&sourceFileStream);
+			pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
+			fsReadFromStream(&sourceFileStream, pOut->pByteCode, pOut->mByteCodeSize);
+
+			LOGF(LogLevel::eINFO, "Shader loaded: '%s' with macro string '%s'", nxShaderPath, shaderDefines.c_str());
+			fsCloseStream(&sourceFileStream);
+			return true;
+		}
+		else
+		{
+			LOGF(LogLevel::eERROR, "Failed to load shader: '%s' with macro string '%s'", nxShaderPath, shaderDefines.c_str());
+			return false;
+		}
+
+	#else
+		char metalShaderPath[FS_MAX_PATH] = {};
+		fsAppendPathExtension(loadDesc.pFileName, "metal", metalShaderPath);
+		FileStream sourceFileStream = {};
+		bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, metalShaderPath, FM_READ_BINARY, &sourceFileStream);
+		ASSERT(sourceExists);
+		if (!process_source_file(pRenderer->pName, &sourceFileStream, metalShaderPath, &sourceFileStream, pIncludeCache, includeHashes, code))
+		{
+			fsCloseStream(&sourceFileStream);
+			return false;
+		}
+	#endif
+
+	#ifndef NX64
+		eastl::string shaderDefines;
+		// apply user specified macros
+		for (uint32_t i = 0; i < macroCount; ++i)
+		{
+			shaderDefines.append_sprintf("%s=%s\n", pMacros[i].definition, pMacros[i].value);
+		}
+		shaderDefines.append_sprintf("entry=%s\n", loadDesc.entryPointName ? loadDesc.entryPointName : "main");
+	#ifdef _DEBUG
+		shaderDefines += "_DEBUG";
+	#else
+		shaderDefines += "NDEBUG";
+	#endif
+
+		eastl::string rendererApi;
+		switch (pRenderer->api)
+		{
+			case SG_RENDERER_API_D3D12:
+			//case SG_RENDERER_API_XBOX_D3D12: rendererApi = "D3D12"; break;
+			//case SG_RENDERER_API_D3D11: rendererApi = "D3D11"; break;
+			case SG_RENDERER_API_VULKAN: rendererApi = "Vulkan"; break;
+			//case SG_RENDERER_API_METAL: rendererApi = "Metal"; break;
+			case SG_RENDERER_API_GLES: rendererApi = "GLES"; break;
+			default: break;
+		}
+		char extension[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_extension(loadDesc.fileName, extension);
+
+		char fileName[SG_MAX_FILEPATH] = { 0 };
+		sgfs_get_path_file_name(loadDesc.fileName, fileName);
+
+		eastl::string appName(pRenderer->name);
+	#ifdef __linux__
+		appName.make_lower();
+		appName = appName != pRenderer->pName ? appName : appName + "_";
+	#endif
+		eastl::string binaryShaderComponent = fileName +
+			eastl::string().sprintf("_%016llx", (unsigned long long)hash_128(shaderDefines.data(), shaderDefines.size()).value[0]) + extension +
+			eastl::string().sprintf("%u", target) +
+	#ifdef SG_GRAPHIC_API_D3D11
+			eastl::string().sprintf("%u", pRenderer->mFeatureLevel) +
+	#endif
+			".bin";
+
+		SG_LOG_DEBUG("binary shader component: %s", binaryShaderComponent.c_str());
+
+		// the key covers the code and not the file times, the includes were hashed when the batch read them
+		eastl::string keyData = code;
+		keyData.push_back('\0');
+		keyData.append((const char*)includeHashes.data(), includeHashes.size() * sizeof(Hash128));
+		keyData.append_sprintf("%s\n%u %u %s", shaderDefines.c_str(), (uint32_t)target, (uint32_t)pRenderer->api, util_get_shader_compiler_version());
+		const Hash128 key = hash_128(keyData.data(), keyData.size());
+
+		// without the source whatever binary there is gets used
+		if (!check_for_byte_code(pRenderer, binaryShaderComponent.c_str(), sourceExists ? &key : nullptr, pOut))
+		{
+			if (!sourceExists)
+			{
+				util_report_shader_error(eastl::string().sprintf("No source shader or precompiled binary present for file %s", fileName));
+				return false;
+			}
+			if (pOutCompiled)
+				*pOutCompiled = true;
+	#if defined(ORBIS)
+			orbis_compileShader(pRenderer,
+				stage, allStages,
+				loadDesc.pFileName,
+				binaryShaderComponent.c_str(),
+				macroCount, pMacros,
+				pOut,
+				loadDesc.pEntryPointName);
+	#elif defined(PROSPERO)
+			prospero_compileShader(pRenderer,
+				stage, allStages,
+				loadDesc.pFileName,
+				binaryShaderComponent.c_str(),
+				macroCount, pMacros,
+				pOut,
+				loadDesc.pEntryPointName);
+	#else
+			if (pRenderer->api == SG_RENDERER_API_VULKAN || pRenderer->api == SG_RENDERER_API_GLES)
+			{
+#if defined(SG_GRAPHIC_API_VULKAN)
+		#if defined(__ANDROID__)
+					vk_compileShader(pRenderer, stage, (uint32_t)code.size(), code.c_str(), binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
+		#else
+				if (!vk_compile_shader_in_process(pRenderer, target, loadDesc.fileName, code, pIncludeCache, macroCount, pMacros, pOut, loadDesc.entryPointName))
+				{
+					vk_compile_shader(pRenderer, target, stage, loadDesc.fileName, binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
+				}
+		#endif
+#elif defined(SG_GRAPHIC_API_METAL)
+				mtl_compileShader(pRenderer, metalShaderPath, binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
+#elif defined(SG_GRAPHIC_API_GLES)
+				gl_compileShader(pRenderer, target, stage, loadDesc.pFileName, (uint32_t)code.size(), code.c_str(), binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
+#endif
+			}
+			else
+			{
+	#if defined(SG_RENDERER_API_D3D12) || defined(SG_RENDERER_API_D3D11)
+				compileShader(
+					pRenderer, target, stage, loadDesc.pFileName, (uint32_t)code.size(), code.c_str(),
+					loadDesc.flags & SHADER_STAGE_LOAD_FLAG_ENABLE_PS_PRIMITIVEID,
+					macroCount, pMacros,
+					pOut, loadDesc.pEntryPointName);
+	#endif
+			}
+
+			if (!pOut->pByteCode)
+			{
+				// a shader that does not compile is an error of the app's shaders, not of the engine, the caller decides what to do
+				util_report_shader_error(eastl::string().sprintf("Error while generating bytecode for shader %s", loadDesc.fileName));
+				sgfs_close_stream(&sourceFileStream);
+				return false;
+			}
+
+	#if defined(SG_GRAPHIC_API_VULKAN)
+			ShaderStageSizeStats sizes = {};
+			sizes.compiledByteCodeSize = pOut->byteCodeSize;
+			sizes.compiledInstructionCount = util_get_spirv_instruction_count(pOut->pByteCode, pOut->byteCodeSize);
+		#if !defined(_DEBUG)
+			#if !defined(__ANDROID__)
+			vk_optimize_shader(target, loadDesc.fileName, pOut);
+			#endif
+		#endif
+			// spirv-cross only runs on a cache miss, on the optimized bytecode that still has its names
+			util_append_shader_reflection(stage, pOut);
+		#if !defined(_DEBUG)
+			// debug builds keep the names and lines for the graphics debuggers
+			util_strip_spirv_debug_info(pOut);
+		#endif
+			sizes.savedByteCodeSize = pOut->byteCodeSize;
+			sizes.savedInstructionCount = util_get_spirv_instruction_count(pOut->pByteCode, pOut->byteCodeSize);
+			if (sizes.savedByteCodeSize != sizes.compiledByteCodeSize)
+			{
+				SG_LOG_INFO("Shader %s: %u -> %u bytes, %u -> %u instructions", loadDesc.fileName, sizes.compiledByteCodeSize, sizes.savedByteCodeSize,
+					sizes.compiledInstructionCount, sizes.savedInstructionCount);
+			}
+			if (pOutSizes)
+				*pOutSizes = sizes;
+	#endif
+
+			// glslangValidator wrote the plain bytecode to the same file, the header goes in front of it
+			if (!save_byte_code(binaryShaderComponent.c_str(), key, pOut))
+			{
+				SG_LOG_WARNING("Failed to save byte code for file %s", loadDesc.fileName);
+			}
+	#endif
+		}
+	#else
+	#endif
+
+		sgfs_close_stream(&sourceFileStream);
+		return true;
+	}
+
+	#ifdef TARGET_IOS
+	bool find_shader_stage(const char* fileName, ShaderDesc* pDesc, ShaderStageDesc** pOutStage, ShaderStage* pStage)
+	{
+		char extension[FS_MAX_PATH] = { 0 };
+		fsGetPathExtension(fileName, extension);
+		if (stricmp(extension, "vert") == 0)
+		{
+			*pOutStage = &pDesc->mVert;
+			*pStage = SHADER_STAGE_VERT;
+		}
+		else if (stricmp(extension, "frag") == 0)
+		{
+			*pOutStage = &pDesc->mFrag;
+			*pStage = SHADER_STAGE_FRAG;
+		}
+		else if (stricmp(extension, "comp") == 0)
+		{
+			*pOutStage = &pDesc->mComp;
+			*pStage = SHADER_STAGE_COMP;
+		}
+		else if ((stricmp(extension, "rgen") == 0) ||
+			(stricmp(extension, "rmiss") == 0) ||
+			(stricmp(extension, "rchit") == 0) ||
+			(stricmp(extension, "rint") == 0) ||
+			(stricmp(extension, "rahit") == 0) ||
+			(stricmp(extension, "rcall") == 0))
+		{
+			*pOutStage = &pDesc->mComp;
+			*pStage = SHADER_STAGE_COMP;
+		}
+		else
+		{
+			return false;
+		}
+
+		return true;
+	}
+	#else
+	bool find_shader_stage(const char* extension, BinaryShaderCreateDesc* pBinaryDesc, BinaryShaderStageDesc** pOutStage, ShaderStage* pStage)
+	{
+		if (stricmp(extension, "vert") == 0)
+		{
+			*pOutStage = &pBinaryDesc->vert;
+			*pStage = SG_SHADER_STAGE_VERT;
+		}
+		else if (stricmp(extension, "frag") == 0)
+		{
+			*pOutStage = &pBinaryDesc->frag;
+			*pStage = SG_SHADER_STAGE_FRAG;
+		}
+	#ifndef SG_GRAPHIC_API_METAL
+		else if (stricmp(extension, "tesc") == 0)
+		{
+			*pOutStage = &pBinaryDesc->hull;
+			*pStage = SG_SHADER_STAGE_HULL;
+		}
+		else if (stricmp(extension, "tese") == 0)
+		{
+			*pOutStage = &pBinaryDesc->domain;
+			*pStage = SG_SHADER_STAGE_DOMN;
+		}
+		else if (stricmp(extension, "geom") == 0)
+		{
+			*pOutStage = &pBinaryDesc->geom;
+			*pStage = SG_SHADER_STAGE_GEOM;
+		}
+	#endif
+		else if (stricmp(extension, "comp") == 0)
+		{
+			*pOutStage = &pBinaryDesc->comp;
+			*pStage = SG_SHADER_STAGE_COMP;
+		}
+		else if ((stricmp(extension, "rgen") == 0) ||
+			(stricmp(extension, "rmiss") == 0) ||
+			(stricmp(extension, "rchit") == 0) ||
+			(stricmp(extension, "rint") == 0) ||
+			(stricmp(extension, "rahit") == 0) ||
+			(stricmp(extension, "rcall") == 0))
+		{
+			*pOutStage = &pBinaryDesc->comp;
+	#ifndef SG_GRAPHIC_API_METAL
+			* pStage = SG_SHADER_STAGE_RAYTRACING;
+	#else
+			* pStage = SG_SHADER_STAGE_COMP;
+	#endif
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
 	#endif
 
-	static eastl::string sgfs_read_from_stream_stl_line(FileStream* stream)
+#ifndef TARGET_IOS
+	typedef struct ShaderStageLoadTask
 	{
-		eastl::string result;
+		Renderer*                  pRenderer;
+		/// index of the shader in the add_shaders call
+		uint32_t                   shaderIndex;
+		ShaderTarget               target;
+		ShaderStage                stage;
+		/// all the stages of the shader the stage belongs to
+		ShaderStage                allStages;
+		const ShaderStageLoadDesc* pLoadDesc;
+		eastl::vector<ShaderMacro> macros;
+		ShaderIncludeCache*        pIncludeCache;
+		BinaryShaderStageDesc*     pOut;
+		/// index of an earlier task of the batch loading the same file with the same macros, its bytecode is copied instead
+		/// of compiling (and writing the same binary file) twice, UINT32_MAX if there is none
+		uint32_t                   sourceTask;
+		bool                       result;
+		/// the binary was missing or out of date and the stage got compiled
+		bool                       compiled;
+		/// seconds the stage took to load or compile
+		float                      loadTime;
+		/// bytecode sizes of a compiled stage
+		ShaderStageSizeStats       sizes;
+		/// compile errors of the stage
+		eastl::string              errors;
+	} ShaderStageLoadTask;
+
+	static bool util_is_same_shader_stage(const ShaderStageLoadTask* pTask, const ShaderStageLoadTask* pOther)
+	{
+		if (pTask->target != pOther->target || pTask->macros.size() != pOther->macros.size() || strcmp(pTask->pLoadDesc->fileName, pOther->pLoadDesc->fileName) != 0)
+			return false;
 
-		while (!sgfs_is_stream_at_end(stream))
+		const char* entryPoint = pTask->pLoadDesc->entryPointName ? pTask->pLoadDesc->entryPointName : "";
+		const char* otherEntryPoint = pOther->pLoadDesc->entryPointName ? pOther->pLoadDesc->entryPointName : "";
+		if (strcmp(entryPoint, otherEntryPoint) != 0)
+			return false;
+
+		for (size_t i = 0; i < pTask->macros.size(); ++i)
 		{
-			char nextChar = 0;
-			sgfs_read_from_stream(stream, &nextChar, sizeof(nextChar));
-			if (nextChar == 0 || nextChar == '\n')
-			{
-				break;
-			}
-			if (nextChar == '\r')
-			{
-				char newLine = 0;
-				sgfs_read_from_stream(stream, &newLine, sizeof(newLine));
-				if (newLine == '\n')
-				{
-					break;
-				}
-				else
-				{
-					// We're not looking at a "\r\n" sequence, so add the '\r' to the buffer.
-					sgfs_seek_stream(stream, SG_SBO_CURRENT_POSITION, -1);
-				}
-			}
-			result.push_back(nextChar);
+			if (strcmp(pTask->macros[i].definition, pOther->macros[i].definition) != 0 || strcmp(pTask->macros[i].value, pOther->macros[i].value) != 0)
+				return false;
 		}
-		return result;
+		return true;
 	}
 
-	// function to generate the timestamp of this shader source file considering all include file timestamp
-	#if !defined(NX64)
-	static bool process_source_file(const char* pAppName, FileStream* original, const char* filePath, FileStream* file, time_t& outTimeStamp, eastl::string& outCode)
+	static void load_shader_stage_task(uintptr_t index, void* pUserData)
 	{
-		// If the source if a non-packaged file, store the timestamp
-		if (file)
-		{
-			time_t fileTimeStamp = sgfs_get_last_modified_time(SG_RD_SHADER_SOURCES, filePath);
+		ShaderStageLoadTask* pTask = (ShaderStageLoadTask*)pUserData + index;
+		if (UINT32_MAX != pTask->sourceTask)
+			return;
 
-			if (fileTimeStamp > outTimeStamp)
-				outTimeStamp = fileTimeStamp;
-		}
-		else
-		{
-			return true; // The source file is missing, but we may still be able to use the shader binary.
-		}
+		Timer timer;
+		timer.Reset();
+		tpShaderErrors = &pTask->errors;
+		pTask->result = load_shader_stage_byte_code(pTask->pRenderer, pTask->target, pTask->stage, pTask->allStages, *pTask->pLoadDesc,
+			(uint32_t)pTask->macros.size(), pTask->macros.data(), pTask->pIncludeCache, pTask->pOut, &pTask->compiled, &pTask->sizes);
+		tpShaderErrors = nullptr;
+		timer.Tick();
+		pTask->loadTime = timer.GetTotalTime();
+	}
 
-		const eastl::string pIncludeDirective = "#include";
-		while (!sgfs_is_stream_at_end(file))
-		{
-			eastl::string line = sgfs_read_from_stream_stl_line(file);
+	/// Load the bytecode of every stage of the batch into binaryDescs, shaders with a stage that failed are marked in validShaders
+	static void util_load_shader_batch(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, eastl::vector<BinaryShaderCreateDesc>& binaryDescs,
+		eastl::vector<bool>& validShaders, eastl::vector<ShaderStageLoadTask>& loadTasks)
+	{
+		binaryDescs.resize(shaderCount);
+		validShaders.assign(shaderCount, true);
+		loadTasks.reserve(shaderCount * 2);
 
-			size_t filePos = line.find(pIncludeDirective, 0);
-			const size_t  commentPosCpp = line.find("//", 0);
-			const size_t  commentPosC = line.find("/*", 0);
+		for (uint32_t s = 0; s < shaderCount; ++s)
+		{
+			const ShaderLoadDesc* pDesc = &pDescs[s];
+	#ifndef SG_GRAPHIC_API_D3D11
+			if ((uint32_t)pDesc->target > pRenderer->shaderTarget)
+			{
+				eastl::string error = eastl::string().sprintf("Requested shader target (%u) is higher than the shader target that the renderer supports (%u). Shader wont be compiled",
+					(uint32_t)pDesc->target, (uint32_t)pRenderer->shaderTarget);
+				SG_LOG_ERROR(error.c_str());
+				validShaders[s] = false;
+				continue;
+			}
+	#endif
 
-			// if we have an "#include \"" in our current line
-			const bool bLineHasIncludeDirective = filePos != eastl::string::npos;
-			const bool bLineIsCommentedOut = (commentPosCpp != eastl::string::npos && commentPosCpp < filePos) ||
-				(commentPosC != eastl::string::npos && commentPosC < filePos);
+			ShaderStage stages = SG_SHADER_STAGE_NONE;
+			for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
+			{
+				if (pDesc->stages[i].fileName && strlen(pDesc->stages[i].fileName) != 0)
+				{
+					ShaderStage            stage;
+					BinaryShaderStageDesc* pStage = nullptr;
+					char ext[SG_MAX_FILEPATH] = { 0 };
+					sgfs_get_path_extension(pDesc->stages[i].fileName, ext);
+					if (find_shader_stage(ext, &binaryDescs[s], &pStage, &stage))
+						stages |= stage;
+				}
+			}
 
-			if (bLineHasIncludeDirective && !bLineIsCommentedOut)
+			for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
 			{
-				// get the include file name
-				size_t        currentPos = filePos + pIncludeDirective.length();
-				eastl::string fileName;
-				while (line.at(currentPos++) == ' ')
-					;    // skip empty spaces
-				if (currentPos >= line.size())
-					continue;
-				if (line.at(currentPos - 1) != '\"')
-					continue;
-				else
+				if (pDesc->stages[i].fileName && strlen(pDesc->stages[i].fileName) != 0)
 				{
-					// read char by char until we have the include file name
-					while (line.at(currentPos) != '\"')
+					ShaderStage            stage;
+					BinaryShaderStageDesc* pStage = NULL;
+					char ext[SG_MAX_FILEPATH] = { 0 };
+					sgfs_get_path_extension(pDesc->stages[i].fileName, ext);
+					if (find_shader_stage(ext, &binaryDescs[s], &pStage, &stage))
 					{
-						fileName.push_back(line.at(currentPos));
-						++currentPos;
+						ShaderStageLoadTask task = {};
+						task.pRenderer = pRenderer;
+						task.shaderIndex = s;
+						task.target = pDesc->target;
+						task.stage = stage;
+						task.allStages = stages;
+						task.pLoadDesc = &pDesc->stages[i];
+						task.pOut = pStage;
+						task.sourceTask = UINT32_MAX;
+
+						const uint32_t macroCount = pDesc->stages[i].macroCount + pRenderer->builtinShaderDefinesCount;
+						task.macros.resize(macroCount);
+						for (uint32_t macro = 0; macro < pRenderer->builtinShaderDefinesCount; ++macro)
+							task.macros[macro] = pRenderer->pBuiltinShaderDefines[macro];
+						for (uint32_t macro = 0; macro < pDesc->stages[i].macroCount; ++macro)
+							task.macros[pRenderer->builtinShaderDefinesCount + macro] = pDesc->stages[i].pMacros[macro];
+
+						for (uint32_t t = 0; t < (uint32_t)loadTasks.size(); ++t)
+						{
+							if (UINT32_MAX == loadTasks[t].sourceTask && util_is_same_shader_stage(&task, &loadTasks[t]))
+							{
+								task.sourceTask = t;
+								break;
+							}
+						}
+						loadTasks.push_back(task);
 					}
 				}
+			}
+		}
 
-				// get the include file path
-				//TODO: remove Comments
-				if (fileName.at(0) == '<')    // disregard bracketsauthop
-					continue;
+		// every stage of every shader is loaded (and compiled if needed) at once, the calling thread helps out
+		ShaderIncludeCache includeCache = {};
+		util_init_shader_include_cache(&includeCache, pRenderer->name);
+		for (ShaderStageLoadTask& task : loadTasks)
+			task.pIncludeCache = &includeCache;
 
-				// open the include file
-				FileStream fHandle = {};
-				char includePath[SG_MAX_FILEPATH] = {};
-				{
-					char parentPath[SG_MAX_FILEPATH] = {};
-					sgfs_get_parent_path(filePath, parentPath);
-					sgfs_append_path_component(parentPath, fileName.c_str(), includePath);
-				}
-				if (!sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, includePath, SG_FM_READ_BINARY, &fHandle))
-				{
-					SG_LOG_ERROR("Cannot open #include file: %s", includePath);
-					continue;
-				}
+		ThreadSystem* pThreadSystem = pResourceLoader ? pResourceLoader->pShaderThreadSystem : nullptr;
+		if (!pThreadSystem || loadTasks.size() == 1)
+		{
+			for (size_t i = 0; i < loadTasks.size(); ++i)
+				load_shader_stage_task(i, loadTasks.data());
+		}
+		else if (!loadTasks.empty())
+		{
+			add_thread_system_range_task(pThreadSystem, load_shader_stage_task, loadTasks.data(), loadTasks.size());
+			while (assist_thread_system(pThreadSystem))
+				;
+			wait_thread_system_idle(pThreadSystem);
+		}
+		util_exit_shader_include_cache(&includeCache);
 
-				// add the include file into the current code recursively
-				if (!process_source_file(pAppName, original, includePath, &fHandle, outTimeStamp, outCode))
+		for (ShaderStageLoadTask& task : loadTasks)
+		{
+			if (UINT32_MAX != task.sourceTask)
+			{
+				const ShaderStageLoadTask& source = loadTasks[task.sourceTask];
+				task.result = source.result;
+				task.errors = source.errors;
+				if (task.result)
 				{
-					sgfs_close_stream(&fHandle);
-					return false;
+					const uint32_t size = source.pOut->byteCodeSize + source.pOut->reflectionSize;
+					task.pOut->byteCodeSize = source.pOut->byteCodeSize;
+					task.pOut->pByteCode = sg_malloc(size);
+					memcpy(task.pOut->pByteCode, source.pOut->pByteCode, size);
+					task.pOut->pReflection = source.pOut->reflectionSize ? (uint8_t*)task.pOut->pByteCode + task.pOut->byteCodeSize : nullptr;
+					task.pOut->reflectionSize = source.pOut->reflectionSize;
 				}
-
-				sgfs_close_stream(&fHandle);
 			}
 
-	#if defined(TARGET_IOS) || defined(ANDROID)
-			// iOS doesn't have support for resolving user header includes in shader code
-			// when compiling with shader source using Metal runtime.
-			// https://developer.apple.com/library/archive/documentation/3DDrawing/Conceptual/MTLBestPracticesGuide/FunctionsandLibraries.html
-			//
-			// Here we write out the contents of the header include into the original source
-			// where its included from -- we're expanding the headers as the pre-processor
-			// would do.
-			//
-			//const bool bAreWeProcessingAnIncludedHeader = file != original;
-			if (!bLineHasIncludeDirective)
-			{
-				outCode += line + "\n";
-			}
-	#else
-			// simply write out the current line if we are not in a header file
-			const bool bAreWeProcessingTheShaderSource = file == original;
-			if (bAreWeProcessingTheShaderSource)
+			if (!task.result)
 			{
-				outCode += line + "\n";
+				validShaders[task.shaderIndex] = false;
+				continue;
 			}
+
+			binaryDescs[task.shaderIndex].stages |= task.stage;
+	#if !defined(SG_GRAPHIC_API_METAL) && !defined(ORBIS) && !defined(PROSPERO)
+			if (task.pLoadDesc->entryPointName)
+				task.pOut->pEntryPoint = task.pLoadDesc->entryPointName;
+			else
+				task.pOut->pEntryPoint = "main";
 	#endif
 		}
-		return true;
 	}
+
+	static void util_free_shader_batch(eastl::vector<ShaderStageLoadTask>& loadTasks)
+	{
+	#if !defined(PROSPERO)
+		// the stages of failed shaders are freed as well, every stage that loaded owns its bytecode
+		for (ShaderStageLoadTask& task : loadTasks)
+		{
+			if (task.result)
+				sg_free(task.pOut->pByteCode);
+		}
 	#endif
+	}
 
-	// loads the bytecode from file if the binary shader file is newer than the source
-	bool check_for_byte_code(Renderer* pRenderer, const char* binaryShaderPath, time_t sourceTimeStamp, BinaryShaderStageDesc* pOut)
+	/// add_shaders, with the errors of every shader appended to pErrors if it is not null
+	static void util_add_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders, eastl::string* pErrors)
 	{
-		// if source code is loaded from a package, its timestamp will be zero. Else check that binary is not older
-		// than source, to make sure we are using the latest bytecode
-		time_t dstTimeStamp = sgfs_get_last_modified_time(SG_RD_SHADER_BINARIES, binaryShaderPath);
-		if (!sourceTimeStamp || (dstTimeStamp < sourceTimeStamp))
-			return false;
+		eastl::vector<BinaryShaderCreateDesc> binaryDescs;
+		eastl::vector<bool> validShaders;
+		eastl::vector<ShaderStageLoadTask> loadTasks;
+		util_load_shader_batch(pRenderer, shaderCount, pDescs, binaryDescs, validShaders, loadTasks);
 
-		FileStream fh = {};
-		if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, binaryShaderPath, SG_FM_READ_BINARY, &fh))
+		if (pErrors)
 		{
-			SG_LOG_ERROR("'%s' is not a valid shader bytecode file", binaryShaderPath);
-			return false;
+			for (const ShaderStageLoadTask& task : loadTasks)
+				pErrors[task.shaderIndex] += task.errors;
 		}
 
-		if (!sgfs_get_stream_file_size(&fh))
+		for (uint32_t s = 0; s < shaderCount; ++s)
 		{
-			sgfs_close_stream(&fh);
-			return false;
-		}
+			BinaryShaderCreateDesc& binaryDesc = binaryDescs[s];
+	#if defined(SG_GRAPHIC_API_METAL)
+			char* pSources[SG_SHADER_STAGE_COUNT] = {};
+			for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT && validShaders[s]; ++i)
+			{
+				const ShaderStageLoadDesc& stageDesc = pDescs[s].stages[i];
+				ShaderStage            stage;
+				BinaryShaderStageDesc* pStage = NULL;
+				char ext[SG_MAX_FILEPATH] = { 0 };
+				if (!stageDesc.fileName || strlen(stageDesc.fileName) == 0)
+					continue;
+				sgfs_get_path_extension(stageDesc.fileName, ext);
+				if (!find_shader_stage(ext, &binaryDesc, &pStage, &stage))
+					continue;
+
+				if (stageDesc.pEntryPointName)
+					pStage->pEntryPoint = stageDesc.pEntryPointName;
+				else
+					pStage->pEntryPoint = "stageMain";
+
+				char metalFileName[FS_MAX_PATH] = { 0 };
+				fsAppendPathExtension(stageDesc.fileName, "metal", metalFileName);
+
+				FileStream fh = {};
+				fsOpenStreamFromPath(RD_SHADER_SOURCES, metalFileName, FM_READ_BINARY, &fh);
+				size_t metalFileSize = fsGetStreamFileSize(&fh);
+				pSources[i] = (char*)tf_malloc(metalFileSize + 1);
+				pStage->pSource = pSources[i];
+				pStage->mSourceSize = (uint32_t)metalFileSize;
+				fsReadFromStream(&fh, pSources[i], metalFileSize);
+				pSources[i][metalFileSize] = 0; // Ensure the shader text is null-terminated
+				fsCloseStream(&fh);
+			}
+	#endif
 
 	#if defined(PROSPERO)
-		extern void prospero_loadByteCode(Renderer*, FileStream*, BinaryShaderStageDesc*);
-		prospero_loadByteCode(pRenderer, &fh, pOut);
-	#else
-		ssize_t size = sgfs_get_stream_file_size(&fh);
-		pOut->byteCodeSize = (uint32_t)size;
-		//pOut->pByteCode = sg_memalign(256, size);
-		pOut->pByteCode = sg_malloc(size);
-		ASSERT(pOut->pByteCode);
+			binaryDesc.mOwnByteCode = true;
+	#endif
 
-		sgfs_read_from_stream(&fh, (void*)pOut->pByteCode, size);
+			// like a single add_shader, a shader with a stage that failed is not created
+			if (validShaders[s])
+				add_shader_binary(pRenderer, &binaryDesc, &ppShaders[s]);
+	#if defined(SG_GRAPHIC_API_METAL)
+			for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
+			{
+				if (pSources[i])
+				{
+					sg_free(pSources[i]);
+				}
+			}
 	#endif
-		sgfs_close_stream(&fh);
+		}
 
-		return true;
+		util_free_shader_batch(loadTasks);
 	}
 
-	// saves bytecode to a file
-	bool save_byte_code(const char* binaryShaderPath, char* byteCode, uint32_t byteCodeSize)
+	void add_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders)
 	{
-		if (!byteCodeSize)
-			return false;
-
-		FileStream fh = {};
-		if (!sgfs_open_stream_from_path(SG_RD_SHADER_BINARIES, binaryShaderPath, SG_FM_WRITE_BINARY, &fh))
-			return false;
-
-		sgfs_write_to_stream(&fh, byteCode, byteCodeSize);
-		sgfs_close_stream(&fh);
-		return true;
+		util_add_shaders(pRenderer, shaderCount, pDescs, ppShaders, nullptr);
 	}
 
-	bool load_shader_stage_byte_code(
-		Renderer* pRenderer, ShaderTarget target, ShaderStage stage, ShaderStage allStages, const ShaderStageLoadDesc& loadDesc, uint32_t macroCount,
-		ShaderMacro* pMacros, BinaryShaderStageDesc* pOut)
+	void add_shader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
 	{
-		UNREF_PARAM(loadDesc.flags);
-
-		eastl::string code;
-	#if !defined(NX64)
-		time_t timeStamp = 0;
-	#endif
-
-	#if !defined(SG_GRAPHIC_API_METAL) && !defined(NX64)
-		FileStream sourceFileStream = {};
-		bool sourceExists = sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, loadDesc.fileName, SG_FM_READ_BINARY, &sourceFileStream);
-		ASSERT(sourceExists);
+		add_shaders(pRenderer, 1, pDesc, ppShader);
+	}
 
-		if (!process_source_file(pRenderer->name, &sourceFileStream, loadDesc.fileName, &sourceFileStream, timeStamp, code))
+	bool compile_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, ShaderCompileStats* pStats)
+	{
+		Timer timer;
+		timer.Reset();
+
+		eastl::vector<BinaryShaderCreateDesc> binaryDescs;
+		eastl::vector<bool> validShaders;
+		eastl::vector<ShaderStageLoadTask> loadTasks;
+		util_load_shader_batch(pRenderer, shaderCount, pDescs, binaryDescs, validShaders, loadTasks);
+
+		timer.Tick();
+		ShaderCompileStats stats = {};
+		stats.batchTime = timer.GetTotalTime();
+		for (const ShaderStageLoadTask& task : loadTasks)
 		{
-			sgfs_close_stream(&sourceFileStream);
-			return false;
+			if (!task.result)
+				++stats.failedStageCount;
+			else if (UINT32_MAX != task.sourceTask)
+				++stats.sharedStageCount;
+			else if (task.compiled)
+				++stats.compiledStageCount;
+			else
+				++stats.cachedStageCount;
+
+			if (task.compiled)
+			{
+				stats.compileTime += task.loadTime;
+				stats.compiledByteCodeSize += task.sizes.compiledByteCodeSize;
+				stats.compiledInstructionCount += task.sizes.compiledInstructionCount;
+				stats.savedByteCodeSize += task.sizes.savedByteCodeSize;
+				stats.savedInstructionCount += task.sizes.savedInstructionCount;
+			}
 		}
-	#elif defined(NX64)
-		eastl::string shaderDefines;
-		for (uint32_t i = 0; i < macroCount; ++i)
+		for (uint32_t s = 0; s < shaderCount; ++s)
 		{
-			shaderDefines += (eastl::string(pMacros[i].definition) + pMacros[i].value);
+			if (!validShaders[s])
+				++stats.failedShaderCount;
 		}
 
-		uint32_t hash = 0;
-		MurmurHash3_x86_32(shaderDefines.c_str(), shaderDefines.size(), 0, &hash);
+		util_free_shader_batch(loadTasks);
+		if (pStats)
+			*pStats = stats;
+		return 0 == stats.failedShaderCount;
+	}
 
-		char hashStringBuffer[14];
-		sprintf(&hashStringBuffer[0], "%zu.%s", (size_t)hash, "spv");
+	// MARK: - Shader Hot Reload
 
-		char nxShaderPath[FS_MAX_PATH] = {};
-		fsAppendPathExtension(loadDesc.pFileName, hashStringBuffer, nxShaderPath);
-		FileStream sourceFileStream = {};
-		bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, nxShaderPath, FM_READ_BINARY, &sourceFileStream);
-		ASSERT(sourceExists);
+	typedef struct ShaderReloadFile
+	{
+		eastl::string path;
+		time_t        modifiedTime;
+	} ShaderReloadFile;
 
-		if (sourceExists)
-		{
-			pOut->mByteCodeSize = (uint32_t)fsGetStreamFileSize(&sourceFileStream);
-			pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
-			fsReadFromStream(&sourceFileStream, pOut->pByteCode, pOut->mByteCodeSize);
+	typedef struct WatchedShader
+	{
+		Shader**                        ppShader;
+		ShaderLoadDesc                  desc;
+		/// the strings and macros the desc points to
+		eastl::string                   fileNames[SG_SHADER_STAGE_COUNT];
+		eastl::string                   entryPoints[SG_SHADER_STAGE_COUNT];
+		eastl::vector<eastl::string>    macroStrings[SG_SHADER_STAGE_COUNT];
+		eastl::vector<ShaderMacro>      macros[SG_SHADER_STAGE_COUNT];
+		/// the stage sources and everything they include
+		eastl::vector<ShaderReloadFile> files;
+		/// a file changed since the last reload started
+		bool                            changed;
+		/// compiled by the reload in flight, null if it failed
+		Shader*                         pNewShader;
+		/// errors of the last reload, empty if it compiled
+		eastl::string                   errors;
+	} WatchedShader;
+
+	typedef struct WatchedRootSignature
+	{
+		RootSignature**                 ppRootSignature;
+		RootSignatureCreateDesc         desc;
+		/// the shaders of the desc, with the watched entry of each one or null if it is not watched
+		eastl::vector<Shader*>          shaders;
+		eastl::vector<WatchedShader*>   watchedShaders;
+		eastl::vector<eastl::string>    staticSamplerNames;
+		eastl::vector<const char*>      staticSamplerNamePointers;
+		eastl::vector<Sampler*>         staticSamplers;
+		RootSignature*                  pNewRootSignature;
+	} WatchedRootSignature;
+
+	typedef struct WatchedPipeline
+	{
+		Pipeline**            ppPipeline;
+		PipelineCreateDesc    desc;
+		/// the states the graphics desc points to
+		VertexLayout          vertexLayout;
+		BlendStateDesc        blendState;
+		DepthStateDesc        depthState;
+		RasterizerStateDesc   rasterizerState;
+		TinyImageFormat       colorFormats[SG_MAX_RENDER_TARGET_ATTACHMENTS];
+		eastl::string         name;
+		/// null if the shader or the root signature of the pipeline is not watched
+		WatchedShader*        pWatchedShader;
+		WatchedRootSignature* pWatchedRootSignature;
+		Pipeline*             pNewPipeline;
+	} WatchedPipeline;
+
+	/// An object the reload replaced, the GPU may still use it until freeUpdate
+	typedef struct RetiredShaderObject
+	{
+		Shader*        pShader;
+		RootSignature* pRootSignature;
+		Pipeline*      pPipeline;
+		uint64_t       freeUpdate;
+	} RetiredShaderObject;
+
+	typedef struct ShaderReloadService
+	{
+		Renderer*                            pRenderer;
+		ShaderReloadDesc                     desc;
+		eastl::vector<WatchedShader*>        shaders;
+		eastl::vector<WatchedRootSignature*> rootSignatures;
+		eastl::vector<WatchedPipeline*>      pipelines;
+		eastl::vector<RetiredShaderObject>   retiredObjects;
+		uint64_t                             updateCount;
+		Timer                                pollTimer;
+		float                                lastPollTime;
+		/// the reload thread owns the watched objects while it runs, the main thread only polls again once it is done
+		ThreadDesc                           threadDesc;
+		ThreadHandle                         thread;
+		bool                                 reloading;
+		sg_atomic32_t                        reloadDone;
+		eastl::string                        errors;
+	} ShaderReloadService;
+
+	static ShaderReloadService* pShaderReload = nullptr;
+
+	static void util_replace_manifest_object(const Shader* pOldShader, Shader* pNewShader, const RootSignature* pOldRootSignature, RootSignature* pNewRootSignature);
+
+	static Shader** util_get_pipeline_shader(PipelineCreateDesc* pDesc)
+	{
+		return SG_PIPELINE_TYPE_COMPUTE == pDesc->type ? &pDesc->computeDesc.pShaderProgram : &pDesc->graphicsDesc.pShaderProgram;
+	}
+
+	static RootSignature** util_get_pipeline_root_signature(PipelineCreateDesc* pDesc)
+	{
+		return SG_PIPELINE_TYPE_COMPUTE == pDesc->type ? &pDesc->computeDesc.pRootSignature : &pDesc->graphicsDesc.pRootSignature;
+	}
 
-			LOGF(LogLevel::eINFO, "Shader loaded: '%s' with macro string '%s'", nxShaderPath, shaderDefines.c_str());
-			fsCloseStream(&sourceFileStream);
-			return true;
-		}
-		else
+	/// Collect the stage sources of the shader and everything they include, a file keeps the time it had when it was seen before
+	static void util_collect_shader_files(Renderer* pRenderer, WatchedShader* pShader)
+	{
+		// scanning the stages like includes puts every file they reach into the cache
+		ShaderIncludeCache includeCache = {};
+		util_init_shader_include_cache(&includeCache, pRenderer->name);
+		eastl::vector<eastl::string> paths;
+		for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
 		{
-			LOGF(LogLevel::eERROR, "Failed to load shader: '%s' with macro string '%s'", nxShaderPath, shaderDefines.c_str());
-			return false;
+			if (!pShader->fileNames[i].empty())
+			{
+				paths.push_back(pShader->fileNames[i]);
+				util_get_shader_include(&includeCache, pShader->fileNames[i].c_str());
+			}
 		}
-
-	#else
-		char metalShaderPath[FS_MAX_PATH] = {};
-		fsAppendPathExtension(loadDesc.pFileName, "metal", metalShaderPath);
-		FileStream sourceFileStream = {};
-		bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, metalShaderPath, FM_READ_BINARY, &sourceFileStream);
-		ASSERT(sourceExists);
-		if (!process_source_file(pRenderer->pName, &sourceFileStream, metalShaderPath, &sourceFileStream, timeStamp, code))
+		for (eastl::pair<const eastl::string, ShaderInclude*>& include : includeCache.includes)
 		{
-			fsCloseStream(&sourceFileStream);
-			return false;
+			if (eastl::find(paths.begin(), paths.end(), include.first) == paths.end())
+				paths.push_back(include.first);
 		}
-	#endif
+		util_exit_shader_include_cache(&includeCache);
 
-	#ifndef NX64
-		eastl::string shaderDefines;
-		// apply user specified macros
-		for (uint32_t i = 0; i < macroCount; ++i)
+		eastl::vector<ShaderReloadFile> files;
+		for (const eastl::string& path : paths)
 		{
-			shaderDefines += (eastl::string(pMacros[i].definition) + pMacros[i].value);
+			ShaderReloadFile file = { path, 0 };
+			file.modifiedTime = sgfs_get_last_modified_time(SG_RD_SHADER_SOURCES, path.c_str());
+			for (const ShaderReloadFile& oldFile : pShader->files)
+			{
+				if (oldFile.path == path)
+					file.modifiedTime = oldFile.modifiedTime;
+			}
+			files.push_back(file);
 		}
-	#ifdef _DEBUG
-		shaderDefines += "_DEBUG";
-	#else
-		shaderDefines += "NDEBUG";
-	#endif
+		pShader->files.swap(files);
+	}
 
-		eastl::string rendererApi;
-		switch (pRenderer->api)
+	/// Returns true if a file of the shader changed since the last poll
+	static bool util_poll_shader_files(WatchedShader* pShader)
+	{
+		bool changed = false;
+		for (ShaderReloadFile& file : pShader->files)
 		{
-			case SG_RENDERER_API_D3D12:
-			//case SG_RENDERER_API_XBOX_D3D12: rendererApi = "D3D12"; break;
-			//case SG_RENDERER_API_D3D11: rendererApi = "D3D11"; break;
-			case SG_RENDERER_API_VULKAN: rendererApi = "Vulkan"; break;
-			//case SG_RENDERER_API_METAL: rendererApi = "Metal"; break;
-			case SG_RENDERER_API_GLES: rendererApi = "GLES"; break;
-			default: break;
+			const time_t modifiedTime = sgfs_get_last_modified_time(SG_RD_SHADER_SOURCES, file.path.c_str());
+			if (modifiedTime != file.modifiedTime)
+			{
+				file.modifiedTime = modifiedTime;
+				changed = true;
+			}
 		}
-		char extension[SG_MAX_FILEPATH] = { 0 };
-		sgfs_get_path_extension(loadDesc.fileName, extension);
+		return changed;
+	}
 
-		char fileName[SG_MAX_FILEPATH] = { 0 };
-		sgfs_get_path_file_name(loadDesc.fileName, fileName);
+	static void util_retire_shader_object(ShaderReloadService* pService, Shader* pShader, RootSignature* pRootSignature, Pipeline* pPipeline)
+	{
+		RetiredShaderObject retired = { pShader, pRootSignature, pPipeline, pService->updateCount + pService->desc.framesInFlight };
+		pService->retiredObjects.push_back(retired);
+	}
 
-		eastl::string appName(pRenderer->name);
-	#ifdef __linux__
-		appName.make_lower();
-		appName = appName != pRenderer->pName ? appName : appName + "_";
-	#endif
-		eastl::string binaryShaderComponent = fileName +
-			eastl::string().sprintf("_%zu", eastl::string_hash<eastl::string>()(shaderDefines)) + extension +
-			eastl::string().sprintf("%u", target) +
-	#ifdef SG_GRAPHIC_API_D3D11
-			eastl::string().sprintf("%u", pRenderer->mFeatureLevel) +
-	#endif
-			".bin";
+	static void util_remove_shader_object(Renderer* pRenderer, const RetiredShaderObject& retired)
+	{
+		if (retired.pPipeline)
+			remove_pipeline(pRenderer, retired.pPipeline);
+		if (retired.pRootSignature)
+			remove_root_signature(pRenderer, retired.pRootSignature);
+		if (retired.pShader)
+			remove_shader(pRenderer, retired.pShader);
+	}
 
-		SG_LOG_DEBUG("binary shader component: %s", binaryShaderComponent.c_str());
+	/// Runs on the reload thread: recompile the changed shaders, then the root signatures and the pipelines made from them
+	static void util_reload_shaders(void* pUserData)
+	{
+		ShaderReloadService* pService = (ShaderReloadService*)pUserData;
+		Renderer* pRenderer = pService->pRenderer;
 
-		// shader source is newer than binary
-		if (!check_for_byte_code(pRenderer, binaryShaderComponent.c_str(), timeStamp, pOut))
+		eastl::vector<WatchedShader*> changedShaders;
+		eastl::vector<ShaderLoadDesc> loadDescs;
+		for (WatchedShader* pShader : pService->shaders)
 		{
-			if (!sourceExists)
+			if (pShader->changed)
 			{
-				SG_LOG_ERROR("No source shader or precompiled binary present for file %s", fileName);
-				return false;
+				pShader->changed = false;
+				changedShaders.push_back(pShader);
+				loadDescs.push_back(pShader->desc);
 			}
-	#if defined(ORBIS)
-			orbis_compileShader(pRenderer,
-				stage, allStages,
-				loadDesc.pFileName,
-				binaryShaderComponent.c_str(),
-				macroCount, pMacros,
-				pOut,
-				loadDesc.pEntryPointName);
-	#elif defined(PROSPERO)
-			prospero_compileShader(pRenderer,
-				stage, allStages,
-				loadDesc.pFileName,
-				binaryShaderComponent.c_str(),
-				macroCount, pMacros,
-				pOut,
-				loadDesc.pEntryPointName);
-	#else
-			if (pRenderer->api == SG_RENDERER_API_VULKAN || pRenderer->api == SG_RENDERER_API_GLES)
+		}
+
+		eastl::vector<Shader*> newShaders(changedShaders.size(), nullptr);
+		eastl::vector<eastl::string> errors(changedShaders.size());
+		util_add_shaders(pRenderer, (uint32_t)loadDescs.size(), loadDescs.data(), newShaders.data(), errors.data());
+		for (size_t i = 0; i < changedShaders.size(); ++i)
+		{
+			WatchedShader* pShader = changedShaders[i];
+			pShader->pNewShader = newShaders[i];
+			pShader->errors = newShaders[i] ? "" : errors[i];
+			if (!newShaders[i] && pShader->errors.empty())
+				pShader->errors.sprintf("Failed to reload shader %s\n", pShader->desc.stages[0].fileName);
+			// an include may have been added or removed
+			util_collect_shader_files(pRenderer, pShader);
+		}
+
+		eastl::vector<bool> rebuiltRootSignatures(pService->rootSignatures.size(), false);
+		for (size_t r = 0; r < pService->rootSignatures.size(); ++r)
+		{
+			WatchedRootSignature* pRootSignature = pService->rootSignatures[r];
+			bool changed = false;
+			eastl::vector<Shader*> shaders(pRootSignature->shaders);
+			for (size_t i = 0; i < shaders.size(); ++i)
 			{
-#if defined(SG_GRAPHIC_API_VULKAN)
-		#if defined(__ANDROID__)
-					vk_compileShader(pRenderer, stage, (uint32_t)code.size(), code.c_str(), binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
-					if (!save_byte_code(binaryShaderComponent.c_str(), (char*)(pOut->pByteCode), pOut->byteCodeSize))
-					{
-						LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", loadDesc.pFileName);
-					}
-		#else
-				vk_compile_shader(pRenderer, target, stage, loadDesc.fileName, binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
-		#endif
-#elif defined(SG_GRAPHIC_API_METAL)
-				mtl_compileShader(pRenderer, metalShaderPath, binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
-#elif defined(SG_GRAPHIC_API_GLES)
-				gl_compileShader(pRenderer, target, stage, loadDesc.pFileName, (uint32_t)code.size(), code.c_str(), binaryShaderComponent.c_str(), macroCount, pMacros, pOut, loadDesc.entryPointName);
-#endif
+				WatchedShader* pWatched = pRootSignature->watchedShaders[i];
+				if (pWatched)
+				{
+					shaders[i] = pWatched->pNewShader ? pWatched->pNewShader : *pWatched->ppShader;
+					changed = changed || pWatched->pNewShader;
+				}
 			}
-			else
+			if (!changed)
+				continue;
+
+			RootSignatureCreateDesc desc = pRootSignature->desc;
+			desc.ppShaders = shaders.data();
+			pRootSignature->pNewRootSignature = nullptr;
+			add_root_signature(pRenderer, &desc, &pRootSignature->pNewRootSignature);
+			rebuiltRootSignatures[r] = true;
+		}
+
+		// a root signature that fails to build keeps the old one, and so do the shaders it is made of, as if they failed to compile.
+		// Other root signatures rebuilt with such a shader are dropped as well, until the old and new objects left are consistent
+		eastl::vector<WatchedShader*> droppedShaders;
+		for (bool dropped = true; dropped;)
+		{
+			dropped = false;
+			for (size_t r = 0; r < pService->rootSignatures.size(); ++r)
 			{
-	#if defined(SG_RENDERER_API_D3D12) || defined(SG_RENDERER_API_D3D11)
-				compileShader(
-					pRenderer, target, stage, loadDesc.pFileName, (uint32_t)code.size(), code.c_str(),
-					loadDesc.flags & SHADER_STAGE_LOAD_FLAG_ENABLE_PS_PRIMITIVEID,
-					macroCount, pMacros,
-					pOut, loadDesc.pEntryPointName);
+				WatchedRootSignature* pRootSignature = pService->rootSignatures[r];
+				if (!rebuiltRootSignatures[r])
+					continue;
+
+				bool failed = !pRootSignature->pNewRootSignature;
+				for (WatchedShader* pWatched : pRootSignature->watchedShaders)
+					failed = failed || (pWatched && eastl::find(droppedShaders.begin(), droppedShaders.end(), pWatched) != droppedShaders.end());
+				if (!failed)
+					continue;
 
-				if (!save_byte_code(binaryShaderComponent.c_str(), (char*)(pOut->pByteCode), pOut->mByteCodeSize))
+				if (pRootSignature->pNewRootSignature)
 				{
-					LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", loadDesc.pFileName);
+					remove_root_signature(pRenderer, pRootSignature->pNewRootSignature);
+					pRootSignature->pNewRootSignature = nullptr;
 				}
-	#endif
-			}
+				rebuiltRootSignatures[r] = false;
 
-			if (!pOut->pByteCode)
-			{
-				SG_LOG_ERROR("Error while generating bytecode for shader %s", loadDesc.fileName);
-				sgfs_close_stream(&sourceFileStream);
-				ASSERT(false);
-				return false;
+				for (WatchedShader* pWatched : pRootSignature->watchedShaders)
+				{
+					if (!pWatched || !pWatched->pNewShader)
+						continue;
+					remove_shader(pRenderer, pWatched->pNewShader);
+					pWatched->pNewShader = nullptr;
+					pWatched->errors.sprintf("Failed to create the root signature of shader %s\n", pWatched->desc.stages[0].fileName);
+					droppedShaders.push_back(pWatched);
+					dropped = true;
+				}
 			}
-	#endif
 		}
-	#else
-	#endif
 
-		sgfs_close_stream(&sourceFileStream);
-		return true;
+		for (WatchedPipeline* pPipeline : pService->pipelines)
+		{
+			PipelineCreateDesc desc = pPipeline->desc;
+			WatchedShader* pWatchedShader = pPipeline->pWatchedShader;
+			WatchedRootSignature* pWatchedRootSignature = pPipeline->pWatchedRootSignature;
+			const bool shaderChanged = pWatchedShader && pWatchedShader->pNewShader;
+			const bool rootSignatureChanged = pWatchedRootSignature && pWatchedRootSignature->pNewRootSignature;
+			if (!shaderChanged && !rootSignatureChanged)
+				continue;
+
+			if (pWatchedShader)
+				*util_get_pipeline_shader(&desc) = shaderChanged ? pWatchedShader->pNewShader : *pWatchedShader->ppShader;
+			if (pWatchedRootSignature)
+				*util_get_pipeline_root_signature(&desc) = rootSignatureChanged ? pWatchedRootSignature->pNewRootSignature : *pWatchedRootSignature->ppRootSignature;
+			add_pipeline(pRenderer, &desc, &pPipeline->pNewPipeline);
+		}
+
+		sg_atomic32_store_release(&pService->reloadDone, 1);
 	}
 
-	#ifdef TARGET_IOS
-	bool find_shader_stage(const char* fileName, ShaderDesc* pDesc, ShaderStageDesc** pOutStage, ShaderStage* pStage)
+	/// Wait for the reload thread, the results stay for the next update to swap in
+	static void util_join_shader_reload(ShaderReloadService* pService)
 	{
-		char extension[FS_MAX_PATH] = { 0 };
-		fsGetPathExtension(fileName, extension);
-		if (stricmp(extension, "vert") == 0)
-		{
-			*pOutStage = &pDesc->mVert;
-			*pStage = SHADER_STAGE_VERT;
-		}
-		else if (stricmp(extension, "frag") == 0)
+		if (pService->thread)
 		{
-			*pOutStage = &pDesc->mFrag;
-			*pStage = SHADER_STAGE_FRAG;
+			destroy_thread(pService->thread);
+			pService->thread = nullptr;
 		}
-		else if (stricmp(extension, "comp") == 0)
+	}
+
+	/// Swap the objects of the finished reload into the watched pointers, at a frame boundary
+	static void util_finish_shader_reload(ShaderReloadService* pService, ShaderReloadStatus* pStatus)
+	{
+		util_join_shader_reload(pService);
+		pService->reloading = false;
+		sg_atomic32_store_release(&pService->reloadDone, 0);
+
+		for (WatchedShader* pShader : pService->shaders)
 		{
-			*pOutStage = &pDesc->mComp;
-			*pStage = SHADER_STAGE_COMP;
+			if (pShader->pNewShader)
+			{
+				util_retire_shader_object(pService, *pShader->ppShader, nullptr, nullptr);
+				util_replace_manifest_object(*pShader->ppShader, pShader->pNewShader, nullptr, nullptr);
+				*pShader->ppShader = pShader->pNewShader;
+				pShader->pNewShader = nullptr;
+				++pStatus->reloadedShaderCount;
+			}
 		}
-		else if ((stricmp(extension, "rgen") == 0) ||
-			(stricmp(extension, "rmiss") == 0) ||
-			(stricmp(extension, "rchit") == 0) ||
-			(stricmp(extension, "rint") == 0) ||
-			(stricmp(extension, "rahit") == 0) ||
-			(stricmp(extension, "rcall") == 0))
+		for (WatchedRootSignature* pRootSignature : pService->rootSignatures)
 		{
-			*pOutStage = &pDesc->mComp;
-			*pStage = SHADER_STAGE_COMP;
+			if (pRootSignature->pNewRootSignature)
+			{
+				util_retire_shader_object(pService, nullptr, *pRootSignature->ppRootSignature, nullptr);
+				util_replace_manifest_object(nullptr, nullptr, *pRootSignature->ppRootSignature, pRootSignature->pNewRootSignature);
+				*pRootSignature->ppRootSignature = pRootSignature->pNewRootSignature;
+				pRootSignature->pNewRootSignature = nullptr;
+				pStatus->rootSignaturesChanged = true;
+			}
 		}
-		else
+		for (WatchedPipeline* pPipeline : pService->pipelines)
 		{
-			return false;
+			if (pPipeline->pNewPipeline)
+			{
+				util_retire_shader_object(pService, nullptr, nullptr, *pPipeline->ppPipeline);
+				*pPipeline->ppPipeline = pPipeline->pNewPipeline;
+				pPipeline->pNewPipeline = nullptr;
+			}
 		}
 
-		return true;
+		pService->errors.clear();
+		for (WatchedShader* pShader : pService->shaders)
+			pService->errors += pShader->errors;
+
+		if (pStatus->reloadedShaderCount)
+			SG_LOG_INFO("Reloaded %u shaders", pStatus->reloadedShaderCount);
 	}
-	#else
-	bool find_shader_stage(const char* extension, BinaryShaderCreateDesc* pBinaryDesc, BinaryShaderStageDesc** pOutStage, ShaderStage* pStage)
+
+	void init_shader_reload(Renderer* pRenderer, const ShaderReloadDesc* pDesc)
 	{
-		if (stricmp(extension, "vert") == 0)
+		ASSERT(!pShaderReload);
+		pShaderReload = sg_new(ShaderReloadService);
+		pShaderReload->pRenderer = pRenderer;
+		pShaderReload->desc = *pDesc;
+		pShaderReload->updateCount = 0;
+		pShaderReload->pollTimer.Reset();
+		pShaderReload->lastPollTime = 0.0f;
+		pShaderReload->thread = nullptr;
+		pShaderReload->reloading = false;
+		pShaderReload->reloadDone = 0;
+	}
+
+	void exit_shader_reload()
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
+
+		util_join_shader_reload(pService);
+		for (WatchedShader* pShader : pService->shaders)
 		{
-			*pOutStage = &pBinaryDesc->vert;
-			*pStage = SG_SHADER_STAGE_VERT;
+			if (pShader->pNewShader)
+				remove_shader(pService->pRenderer, pShader->pNewShader);
+			sg_delete(pShader);
 		}
-		else if (stricmp(extension, "frag") == 0)
+		for (WatchedRootSignature* pRootSignature : pService->rootSignatures)
 		{
-			*pOutStage = &pBinaryDesc->frag;
-			*pStage = SG_SHADER_STAGE_FRAG;
+			if (pRootSignature->pNewRootSignature)
+				remove_root_signature(pService->pRenderer, pRootSignature->pNewRootSignature);
+			sg_delete(pRootSignature);
 		}
-	#ifndef SG_GRAPHIC_API_METAL
-		else if (stricmp(extension, "tesc") == 0)
+		for (WatchedPipeline* pPipeline : pService->pipelines)
 		{
-			*pOutStage = &pBinaryDesc->hull;
-			*pStage = SG_SHADER_STAGE_HULL;
+			if (pPipeline->pNewPipeline)
+				remove_pipeline(pService->pRenderer, pPipeline->pNewPipeline);
+			sg_delete(pPipeline);
 		}
-		else if (stricmp(extension, "tese") == 0)
+		for (const RetiredShaderObject& retired : pService->retiredObjects)
+			util_remove_shader_object(pService->pRenderer, retired);
+
+		sg_delete(pService);
+		pShaderReload = nullptr;
+	}
+
+	void watch_shader(const ShaderLoadDesc* pDesc, Shader** ppShader)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
+
+		ASSERT(pDesc && ppShader);
+		// nothing to reload if the object failed to create
+		if (!*ppShader)
+			return;
+		util_join_shader_reload(pService);
+
+		WatchedShader* pShader = sg_new(WatchedShader);
+		pShader->ppShader = ppShader;
+		pShader->desc = *pDesc;
+		for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
 		{
-			*pOutStage = &pBinaryDesc->domain;
-			*pStage = SG_SHADER_STAGE_DOMN;
+			const ShaderStageLoadDesc& stage = pDesc->stages[i];
+			ShaderStageLoadDesc& stageCopy = pShader->desc.stages[i];
+			if (stage.fileName)
+			{
+				pShader->fileNames[i] = stage.fileName;
+				stageCopy.fileName = pShader->fileNames[i].c_str();
+			}
+			if (stage.entryPointName)
+			{
+				pShader->entryPoints[i] = stage.entryPointName;
+				stageCopy.entryPointName = pShader->entryPoints[i].c_str();
+			}
+
+			// sized once, the macros point into the strings
+			pShader->macroStrings[i].resize(stage.macroCount * 2);
+			pShader->macros[i].resize(stage.macroCount);
+			for (uint32_t m = 0; m < stage.macroCount; ++m)
+			{
+				pShader->macroStrings[i][m * 2] = stage.pMacros[m].definition;
+				pShader->macroStrings[i][m * 2 + 1] = stage.pMacros[m].value;
+				pShader->macros[i][m].definition = pShader->macroStrings[i][m * 2].c_str();
+				pShader->macros[i][m].value = pShader->macroStrings[i][m * 2 + 1].c_str();
+			}
+			stageCopy.pMacros = pShader->macros[i].data();
 		}
-		else if (stricmp(extension, "geom") == 0)
+		pShader->changed = false;
+		pShader->pNewShader = nullptr;
+		util_collect_shader_files(pService->pRenderer, pShader);
+		pService->shaders.push_back(pShader);
+	}
+
+	static WatchedShader* util_find_watched_shader(ShaderReloadService* pService, const Shader* pShader)
+	{
+		for (WatchedShader* pWatched : pService->shaders)
 		{
-			*pOutStage = &pBinaryDesc->geom;
-			*pStage = SG_SHADER_STAGE_GEOM;
+			if (*pWatched->ppShader == pShader)
+				return pWatched;
 		}
-	#endif
-		else if (stricmp(extension, "comp") == 0)
+		return nullptr;
+	}
+
+	void watch_root_signature(const RootSignatureCreateDesc* pDesc, RootSignature** ppRootSignature)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
+
+		ASSERT(pDesc && ppRootSignature);
+		// nothing to reload if the object failed to create
+		if (!*ppRootSignature)
+			return;
+		util_join_shader_reload(pService);
+
+		WatchedRootSignature* pRootSignature = sg_new(WatchedRootSignature);
+		pRootSignature->ppRootSignature = ppRootSignature;
+		pRootSignature->desc = *pDesc;
+		pRootSignature->shaders.assign(pDesc->ppShaders, pDesc->ppShaders + pDesc->shaderCount);
+		for (Shader* pShader : pRootSignature->shaders)
+			pRootSignature->watchedShaders.push_back(util_find_watched_shader(pService, pShader));
+
+		pRootSignature->staticSamplerNames.resize(pDesc->staticSamplerCount);
+		for (uint32_t i = 0; i < pDesc->staticSamplerCount; ++i)
 		{
-			*pOutStage = &pBinaryDesc->comp;
-			*pStage = SG_SHADER_STAGE_COMP;
+			pRootSignature->staticSamplerNames[i] = pDesc->ppStaticSamplerNames[i];
+			pRootSignature->staticSamplerNamePointers.push_back(pRootSignature->staticSamplerNames[i].c_str());
+			pRootSignature->staticSamplers.push_back(pDesc->ppStaticSamplers[i]);
 		}
-		else if ((stricmp(extension, "rgen") == 0) ||
-			(stricmp(extension, "rmiss") == 0) ||
-			(stricmp(extension, "rchit") == 0) ||
-			(stricmp(extension, "rint") == 0) ||
-			(stricmp(extension, "rahit") == 0) ||
-			(stricmp(extension, "rcall") == 0))
+		pRootSignature->desc.ppStaticSamplerNames = pRootSignature->staticSamplerNamePointers.data();
+		pRootSignature->desc.ppStaticSamplers = pRootSignature->staticSamplers.data();
+		pRootSignature->desc.ppShaders = nullptr;
+		pRootSignature->pNewRootSignature = nullptr;
+		pService->rootSignatures.push_back(pRootSignature);
+	}
+
+	void watch_pipeline(const PipelineCreateDesc* pDesc, Pipeline** ppPipeline)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
+
+		ASSERT(pDesc && ppPipeline);
+		// nothing to reload if the object failed to create
+		if (!*ppPipeline)
+			return;
+		if (SG_PIPELINE_TYPE_RAYTRACING == pDesc->type)
 		{
-			*pOutStage = &pBinaryDesc->comp;
-	#ifndef SG_GRAPHIC_API_METAL
-			* pStage = SG_SHADER_STAGE_RAYTRACING;
-	#else
-			* pStage = SG_SHADER_STAGE_COMP;
-	#endif
+			SG_LOG_WARNING("Raytracing pipelines are not reloaded");
+			return;
+		}
+		util_join_shader_reload(pService);
+
+		WatchedPipeline* pPipeline = sg_new(WatchedPipeline);
+		pPipeline->ppPipeline = ppPipeline;
+		pPipeline->desc = *pDesc;
+		if (SG_PIPELINE_TYPE_GRAPHICS == pDesc->type)
+		{
+			const GraphicsPipelineDesc& graphicsDesc = pDesc->graphicsDesc;
+			GraphicsPipelineDesc& graphicsCopy = pPipeline->desc.graphicsDesc;
+			if (graphicsDesc.pVertexLayout)
+			{
+				pPipeline->vertexLayout = *graphicsDesc.pVertexLayout;
+				graphicsCopy.pVertexLayout = &pPipeline->vertexLayout;
+			}
+			if (graphicsDesc.pBlendState)
+			{
+				pPipeline->blendState = *graphicsDesc.pBlendState;
+				graphicsCopy.pBlendState = &pPipeline->blendState;
+			}
+			if (graphicsDesc.pDepthState)
+			{
+				pPipeline->depthState = *graphicsDesc.pDepthState;
+				graphicsCopy.pDepthState = &pPipeline->depthState;
+			}
+			if (graphicsDesc.pRasterizerState)
+			{
+				pPipeline->rasterizerState = *graphicsDesc.pRasterizerState;
+				graphicsCopy.pRasterizerState = &pPipeline->rasterizerState;
+			}
+			ASSERT(graphicsDesc.renderTargetCount <= SG_MAX_RENDER_TARGET_ATTACHMENTS);
+			for (uint32_t i = 0; i < graphicsDesc.renderTargetCount; ++i)
+				pPipeline->colorFormats[i] = graphicsDesc.pColorFormats[i];
+			graphicsCopy.pColorFormats = pPipeline->colorFormats;
 		}
-		else
+		if (pDesc->name)
 		{
-			return false;
+			pPipeline->name = pDesc->name;
+			pPipeline->desc.name = pPipeline->name.c_str();
 		}
-		return true;
-	}
-	#endif
 
-	void add_shader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
-	{
-	#ifndef SG_GRAPHIC_API_D3D11
-		if ((uint32_t)pDesc->target > pRenderer->shaderTarget)
+		pPipeline->pWatchedShader = util_find_watched_shader(pService, *util_get_pipeline_shader(&pPipeline->desc));
+		pPipeline->pWatchedRootSignature = nullptr;
+		for (WatchedRootSignature* pRootSignature : pService->rootSignatures)
 		{
-			eastl::string error = eastl::string().sprintf("Requested shader target (%u) is higher than the shader target that the renderer supports (%u). Shader wont be compiled",
-				(uint32_t)pDesc->target, (uint32_t)pRenderer->shaderTarget);
-			SG_LOG_ERROR(error.c_str());
-			return;
+			if (*pRootSignature->ppRootSignature == *util_get_pipeline_root_signature(&pPipeline->desc))
+				pPipeline->pWatchedRootSignature = pRootSignature;
 		}
-	#endif
+		pPipeline->pNewPipeline = nullptr;
+		pService->pipelines.push_back(pPipeline);
+	}
 
-	#ifndef TARGET_IOS
-		BinaryShaderCreateDesc binaryDesc = {};
-	#if defined(SG_GRAPHIC_API_METAL)
-		char* pSources[SG_SHADER_STAGE_COUNT] = {};
-	#endif
+	void unwatch_shader(Shader** ppShader)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
 
-		ShaderStage stages = SG_SHADER_STAGE_NONE;
-		for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
+		util_join_shader_reload(pService);
+		for (size_t i = 0; i < pService->shaders.size(); ++i)
 		{
-			if (pDesc->stages[i].fileName && strlen(pDesc->stages[i].fileName) != 0)
+			WatchedShader* pShader = pService->shaders[i];
+			if (pShader->ppShader != ppShader)
+				continue;
+
+			// the root signatures and pipelines keep the shader they were made from
+			for (WatchedRootSignature* pRootSignature : pService->rootSignatures)
 			{
-				ShaderStage            stage;
-				BinaryShaderStageDesc* pStage = nullptr;
-				char ext[SG_MAX_FILEPATH] = { 0 };
-				sgfs_get_path_extension(pDesc->stages[i].fileName, ext);
-				if (find_shader_stage(ext, &binaryDesc, &pStage, &stage))
-					stages |= stage;
+				for (size_t s = 0; s < pRootSignature->watchedShaders.size(); ++s)
+				{
+					if (pRootSignature->watchedShaders[s] == pShader)
+					{
+						pRootSignature->shaders[s] = *pShader->ppShader;
+						pRootSignature->watchedShaders[s] = nullptr;
+					}
+				}
+			}
+			for (WatchedPipeline* pPipeline : pService->pipelines)
+			{
+				if (pPipeline->pWatchedShader == pShader)
+				{
+					*util_get_pipeline_shader(&pPipeline->desc) = *pShader->ppShader;
+					pPipeline->pWatchedShader = nullptr;
+				}
 			}
+
+			// the objects made from a pending shader do not need it anymore
+			if (pShader->pNewShader)
+				remove_shader(pService->pRenderer, pShader->pNewShader);
+			sg_delete(pShader);
+			pService->shaders.erase(pService->shaders.begin() + i);
+			return;
 		}
+	}
 
-		for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
+	void unwatch_root_signature(RootSignature** ppRootSignature)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
+
+		util_join_shader_reload(pService);
+		for (size_t i = 0; i < pService->rootSignatures.size(); ++i)
 		{
-			if (pDesc->stages[i].fileName && strlen(pDesc->stages[i].fileName) != 0)
-			{
-				const char* fileName = pDesc->stages[i].fileName;
+			WatchedRootSignature* pRootSignature = pService->rootSignatures[i];
+			if (pRootSignature->ppRootSignature != ppRootSignature)
+				continue;
 
-				ShaderStage            stage;
-				BinaryShaderStageDesc* pStage = NULL;
-				char ext[SG_MAX_FILEPATH] = { 0 };
-				sgfs_get_path_extension(fileName, ext);
-				if (find_shader_stage(ext, &binaryDesc, &pStage, &stage))
+			for (WatchedPipeline* pPipeline : pService->pipelines)
+			{
+				if (pPipeline->pWatchedRootSignature == pRootSignature)
 				{
-					const uint32_t macroCount = pDesc->stages[i].macroCount + pRenderer->builtinShaderDefinesCount;
+					// a pending pipeline may be made from the pending root signature, it goes with it
+					if (pRootSignature->pNewRootSignature && pPipeline->pNewPipeline)
+					{
+						remove_pipeline(pService->pRenderer, pPipeline->pNewPipeline);
+						pPipeline->pNewPipeline = nullptr;
+					}
+					*util_get_pipeline_root_signature(&pPipeline->desc) = *pRootSignature->ppRootSignature;
+					pPipeline->pWatchedRootSignature = nullptr;
+				}
+			}
 
-					eastl::vector<ShaderMacro> macros(macroCount);
-					for (uint32_t macro = 0; macro < pRenderer->builtinShaderDefinesCount; ++macro)
-						macros[macro] = pRenderer->pBuiltinShaderDefines[macro];
-					for (uint32_t macro = 0; macro < pDesc->stages[i].macroCount; ++macro)
-						macros[pRenderer->builtinShaderDefinesCount + macro] = pDesc->stages[i].pMacros[macro];
+			if (pRootSignature->pNewRootSignature)
+				remove_root_signature(pService->pRenderer, pRootSignature->pNewRootSignature);
+			sg_delete(pRootSignature);
+			pService->rootSignatures.erase(pService->rootSignatures.begin() + i);
+			return;
+		}
+	}
 
-					if (!load_shader_stage_byte_code(pRenderer, pDesc->target, stage, stages, pDesc->stages[i], macroCount, macros.data(),
-						pStage))
-						return;
+	void unwatch_pipeline(Pipeline** ppPipeline)
+	{
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+			return;
 
-					binaryDesc.stages |= stage;
-	#if defined(SG_GRAPHIC_API_METAL)
-					if (pDesc->stages[i].pEntryPointName)
-						pStage->pEntryPoint = pDesc->stages[i].pEntryPointName;
-					else
-						pStage->pEntryPoint = "stageMain";
+		util_join_shader_reload(pService);
+		for (size_t i = 0; i < pService->pipelines.size(); ++i)
+		{
+			WatchedPipeline* pPipeline = pService->pipelines[i];
+			if (pPipeline->ppPipeline != ppPipeline)
+				continue;
+
+			if (pPipeline->pNewPipeline)
+				remove_pipeline(pService->pRenderer, pPipeline->pNewPipeline);
+			sg_delete(pPipeline);
+			pService->pipelines.erase(pService->pipelines.begin() + i);
+			return;
+		}
+	}
 
-					char metalFileName[FS_MAX_PATH] = { 0 };
-					fsAppendPathExtension(fileName, "metal", metalFileName);
+	void update_shader_reload(ShaderReloadStatus* pStatus)
+	{
+		ShaderReloadStatus status = {};
+		status.pErrors = "";
+		ShaderReloadService* pService = pShaderReload;
+		if (!pService)
+		{
+			if (pStatus)
+				*pStatus = status;
+			return;
+		}
 
-					FileStream fh = {};
-					fsOpenStreamFromPath(RD_SHADER_SOURCES, metalFileName, FM_READ_BINARY, &fh);
-					size_t metalFileSize = fsGetStreamFileSize(&fh);
-					pSources[i] = (char*)tf_malloc(metalFileSize + 1);
-					pStage->pSource = pSources[i];
-					pStage->mSourceSize = (uint32_t)metalFileSize;
-					fsReadFromStream(&fh, pSources[i], metalFileSize);
-					pSources[i][metalFileSize] = 0; // Ensure the shader text is null-terminated
-					fsCloseStream(&fh);
-	#elif !defined(ORBIS) && !defined(PROSPERO)
-					if (pDesc->stages[i].entryPointName)
-						pStage->pEntryPoint = pDesc->stages[i].entryPointName;
-					else
-						pStage->pEntryPoint = "main";
-	#endif
-				}
+		// free what the GPU is done with
+		++pService->updateCount;
+		for (size_t i = 0; i < pService->retiredObjects.size();)
+		{
+			if (pService->retiredObjects[i].freeUpdate <= pService->updateCount)
+			{
+				util_remove_shader_object(pService->pRenderer, pService->retiredObjects[i]);
+				pService->retiredObjects.erase(pService->retiredObjects.begin() + i);
+			}
+			else
+			{
+				++i;
 			}
 		}
 
-	#if defined(PROSPERO)
-		binaryDesc.mOwnByteCode = true;
-	#endif
+		if (pService->reloading && sg_atomic32_load_acquire(&pService->reloadDone))
+			util_finish_shader_reload(pService, &status);
 
-		add_shader_binary(pRenderer, &binaryDesc, ppShader);
-	#if defined(SG_GRAPHIC_API_METAL)
-		for (uint32_t i = 0; i < SG_SHADER_STAGE_COUNT; ++i)
+		if (!pService->reloading)
 		{
-			if (pSources[i])
+			pService->pollTimer.Tick();
+			const float time = pService->pollTimer.GetTotalTime();
+			if (time - pService->lastPollTime >= pService->desc.pollInterval)
 			{
-				sg_free(pSources[i]);
+				pService->lastPollTime = time;
+
+				bool changed = false;
+				for (WatchedShader* pShader : pService->shaders)
+				{
+					if (util_poll_shader_files(pShader))
+					{
+						pShader->changed = true;
+						changed = true;
+					}
+				}
+
+				if (changed)
+				{
+					pService->reloading = true;
+					pService->threadDesc.pFunc = util_reload_shaders;
+					pService->threadDesc.pData = pService;
+					pService->thread = create_thread(&pService->threadDesc);
+				}
 			}
 		}
-	#endif
-	#if !defined(PROSPERO)
-		if (binaryDesc.stages & SG_SHADER_STAGE_VERT)
-			sg_free(binaryDesc.vert.pByteCode);
-		if (binaryDesc.stages & SG_SHADER_STAGE_FRAG)
-			sg_free(binaryDesc.frag.pByteCode);
-		if (binaryDesc.stages & SG_SHADER_STAGE_COMP)
-			sg_free(binaryDesc.comp.pByteCode);
-	#if !defined(SG_GRAPHIC_API_METAL)
-		if (binaryDesc.stages & SG_SHADER_STAGE_TESC)
-			sg_free(binaryDesc.hull.pByteCode);
-		if (binaryDesc.stages & SG_SHADER_STAGE_TESE)
-			sg_free(binaryDesc.domain.pByteCode);
-		if (binaryDesc.stages & SG_SHADER_STAGE_GEOM)
-			sg_free(binaryDesc.geom.pByteCode);
-		if (binaryDesc.stages & SG_SHADER_STAGE_RAYTRACING)
-			sg_free(binaryDesc.comp.pByteCode);
-	#endif
-	#endif
-	#else
-		// Binary shaders are not supported on iOS.
+
+		status.reloading = pService->reloading;
+		status.pErrors = pService->errors.c_str();
+		if (pStatus)
+			*pStatus = status;
+	}
+#else
+	void add_shader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
+	{
+		if ((uint32_t)pDesc->target > pRenderer->shaderTarget)
+		{
+			eastl::string error = eastl::string().sprintf("Requested shader target (%u) is higher than the shader target that the renderer supports (%u). Shader wont be compiled",
+				(uint32_t)pDesc->target, (uint32_t)pRenderer->shaderTarget);
+			SG_LOG_ERROR(error.c_str());
+			return;
+		}
+
 		ShaderDesc desc = {};
 		eastl::string codes[SG_SHADER_STAGE_COUNT] = {};
 		ShaderMacro* pMacros[SG_SHADER_STAGE_COUNT] = {};
@@ -3160,8 +7842,8 @@ namespace SG
 					ASSERT(sourceExists);
 
 					pStage->pName = pDesc->stages[i].pFileName;
-					time_t timestamp = 0;
-					process_source_file(pRenderer->pName, &fh, metalFileName, &fh, timestamp, codes[i]);
+					eastl::vector<Hash128> includeHashes;
+					process_source_file(pRenderer->pName, &fh, metalFileName, &fh, nullptr, includeHashes, codes[i]);
 					pStage->pCode = codes[i].c_str();
 					if (pDesc->stages[i].pEntryPointName)
 						pStage->pEntryPoint = pDesc->stages[i].pEntryPointName;
@@ -3185,9 +7867,44 @@ namespace SG
 		}
 
 		add_shader(pRenderer, &desc, ppShader);
-	#endif
 	}
 
+	void add_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders)
+	{
+		for (uint32_t i = 0; i < shaderCount; ++i)
+			add_shader(pRenderer, &pDescs[i], &ppShaders[i]);
+	}
+
+	bool compile_shaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, ShaderCompileStats* pStats)
+	{
+		// the shaders are compiled from source when they are created
+		UNREF_PARAM(pRenderer);
+		UNREF_PARAM(shaderCount);
+		UNREF_PARAM(pDescs);
+		if (pStats)
+			*pStats = {};
+		return true;
+	}
+
+	// the shaders are compiled from source when they are created, there is nothing to reload
+	void init_shader_reload(Renderer* pRenderer, const ShaderReloadDesc* pDesc) { UNREF_PARAM(pRenderer); UNREF_PARAM(pDesc); }
+	void exit_shader_reload() {}
+	void watch_shader(const ShaderLoadDesc* pDesc, Shader** ppShader) { UNREF_PARAM(pDesc); UNREF_PARAM(ppShader); }
+	void watch_root_signature(const RootSignatureCreateDesc* pDesc, RootSignature** ppRootSignature) { UNREF_PARAM(pDesc); UNREF_PARAM(ppRootSignature); }
+	void watch_pipeline(const PipelineCreateDesc* pDesc, Pipeline** ppPipeline) { UNREF_PARAM(pDesc); UNREF_PARAM(ppPipeline); }
+	void unwatch_shader(Shader** ppShader) { UNREF_PARAM(ppShader); }
+	void unwatch_root_signature(RootSignature** ppRootSignature) { UNREF_PARAM(ppRootSignature); }
+	void unwatch_pipeline(Pipeline** ppPipeline) { UNREF_PARAM(ppPipeline); }
+	void update_shader_reload(ShaderReloadStatus* pStatus)
+	{
+		if (pStatus)
+		{
+			*pStatus = {};
+			pStatus->pErrors = "";
+		}
+	}
+#endif
+
 	// pipeline cache save, load
 	void add_pipeline_cache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache)
 	{
@@ -3243,4 +7960,417 @@ namespace SG
 	#endif
 	}
 
+
+	// MARK: - Pipeline Manifest
+
+	#define SG_PIPELINE_MANIFEST_MAGIC   0x4d505053 // "SPPM"
+	#define SG_PIPELINE_MANIFEST_VERSION 1
+	#define SG_PIPELINE_MANIFEST_NAME_LENGTH 64
+
+	/// A pipeline description as written to the file, the states the description points to are stored inline.
+	/// Records are zeroed before they are filled, so equal descriptions have equal bytes
+	typedef struct PipelineManifestRecord
+	{
+		PipelineType        type;
+		char                shaderName[SG_PIPELINE_MANIFEST_NAME_LENGTH];
+		char                rootSignatureName[SG_PIPELINE_MANIFEST_NAME_LENGTH];
+		char                name[SG_PIPELINE_MANIFEST_NAME_LENGTH];
+		/// Which of the states below the description had, a missing one is the default state
+		bool                hasVertexLayout;
+		bool                hasBlendState;
+		bool                hasDepthState;
+		bool                hasRasterizerState;
+		VertexLayout        vertexLayout;
+		BlendStateDesc      blendState;
+		DepthStateDesc      depthState;
+		RasterizerStateDesc rasterizerState;
+		TinyImageFormat     colorFormats[SG_MAX_RENDER_TARGET_ATTACHMENTS];
+		uint32_t            renderTargetCount;
+		SampleCount         sampleCount;
+		uint32_t            sampleQuality;
+		TinyImageFormat     depthStencilFormat;
+		PrimitiveTopology   primitiveTopo;
+		bool                supportIndirectCommandBuffer;
+	} PipelineManifestRecord;
+
+	typedef struct PipelineManifestHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		/// sizeof(PipelineManifestRecord) of the build that wrote the file
+		uint32_t recordSize;
+		uint32_t recordCount;
+	} PipelineManifestHeader;
+
+	typedef struct PipelineManifestEntry
+	{
+		PipelineManifestRecord record;
+		/// Created by a replay or in this session already, a replay skips it
+		bool                   created;
+	} PipelineManifestEntry;
+
+	/// Pipeline created by a replay task, the task owns a copy of the record since recording may grow the entries meanwhile
+	typedef struct PipelineReplayTask
+	{
+		Renderer*              pRenderer;
+		PipelineManifestRecord record;
+		PipelineCreateDesc     desc;
+		Pipeline*              pPipeline;
+	} PipelineReplayTask;
+
+	struct PipelineManifestKeyHasher
+	{
+		size_t operator()(const Hash128& key) const { return (size_t)key.value[0]; }
+	};
+
+	typedef struct PipelineManifest
+	{
+		Renderer*                                                           pRenderer;
+		eastl::string                                                       fileName;
+		Mutex                                                               mutex;
+		eastl::vector<PipelineManifestEntry>                                entries;
+		eastl::unordered_map<Hash128, uint32_t, PipelineManifestKeyHasher>  entryIndices;
+		eastl::unordered_map<eastl::string, Shader*>                        shaders;
+		eastl::unordered_map<const Shader*, eastl::string>                  shaderNames;
+		eastl::unordered_map<eastl::string, RootSignature*>                 rootSignatures;
+		eastl::unordered_map<const RootSignature*, eastl::string>           rootSignatureNames;
+		/// The replayed pipelines, the manifest holds a reference on each of them
+		eastl::vector<Pipeline*>                                            pipelines;
+	} PipelineManifest;
+
+	static PipelineManifest* pPipelineManifest = nullptr;
+
+	/// Add the record unless an equal one is in the manifest already
+	static void util_add_manifest_entry(PipelineManifest* pManifest, const PipelineManifestRecord& record, bool created)
+	{
+		const Hash128 key = hash_128(&record, sizeof(record));
+		auto it = pManifest->entryIndices.find(key);
+		if (it != pManifest->entryIndices.end())
+		{
+			pManifest->entries[it->second].created |= created;
+			return;
+		}
+
+		PipelineManifestEntry entry = {};
+		entry.record = record;
+		entry.created = created;
+		pManifest->entryIndices.insert(eastl::make_pair(key, (uint32_t)pManifest->entries.size()));
+		pManifest->entries.push_back(entry);
+	}
+
+	/// Callback of the pipeline state cache, runs on any thread creating a pipeline
+	static void util_record_pipeline(const PipelineCreateDesc* pDesc, void* pUserData)
+	{
+		PipelineManifest* pManifest = (PipelineManifest*)pUserData;
+		if (SG_PIPELINE_TYPE_GRAPHICS != pDesc->type && SG_PIPELINE_TYPE_COMPUTE != pDesc->type)
+			return;
+
+		const bool compute = SG_PIPELINE_TYPE_COMPUTE == pDesc->type;
+		const Shader* pShader = compute ? pDesc->computeDesc.pShaderProgram : pDesc->graphicsDesc.pShaderProgram;
+		const RootSignature* pRootSignature = compute ? pDesc->computeDesc.pRootSignature : pDesc->graphicsDesc.pRootSignature;
+
+		MutexLock lock(pManifest->mutex);
+		auto shaderIt = pManifest->shaderNames.find(pShader);
+		auto rootSignatureIt = pManifest->rootSignatureNames.find(pRootSignature);
+		if (shaderIt == pManifest->shaderNames.end() || rootSignatureIt == pManifest->rootSignatureNames.end())
+			return;
+
+		PipelineManifestRecord record;
+		memset(&record, 0, sizeof(record));
+		record.type = pDesc->type;
+		strncpy(record.shaderName, shaderIt->second.c_str(), SG_PIPELINE_MANIFEST_NAME_LENGTH - 1);
+		strncpy(record.rootSignatureName, rootSignatureIt->second.c_str(), SG_PIPELINE_MANIFEST_NAME_LENGTH - 1);
+		if (pDesc->name)
+			strncpy(record.name, pDesc->name, SG_PIPELINE_MANIFEST_NAME_LENGTH - 1);
+
+		if (!compute)
+		{
+			const GraphicsPipelineDesc* pGraphics = &pDesc->graphicsDesc;
+			record.hasVertexLayout = pGraphics->pVertexLayout != nullptr;
+			record.hasBlendState = pGraphics->pBlendState != nullptr;
+			record.hasDepthState = pGraphics->pDepthState != nullptr;
+			record.hasRasterizerState = pGraphics->pRasterizerState != nullptr;
+			if (record.hasVertexLayout)
+				record.vertexLayout = *pGraphics->pVertexLayout;
+			if (record.hasBlendState)
+				record.blendState = *pGraphics->pBlendState;
+			if (record.hasDepthState)
+				record.depthState = *pGraphics->pDepthState;
+			if (record.hasRasterizerState)
+				record.rasterizerState = *pGraphics->pRasterizerState;
+			ASSERT(pGraphics->renderTargetCount <= SG_MAX_RENDER_TARGET_ATTACHMENTS);
+			record.renderTargetCount = pGraphics->renderTargetCount;
+			if (record.renderTargetCount)
+				memcpy(record.colorFormats, pGraphics->pColorFormats, record.renderTargetCount * sizeof(TinyImageFormat));
+			record.sampleCount = pGraphics->sampleCount;
+			record.sampleQuality = pGraphics->sampleQuality;
+			record.depthStencilFormat = pGraphics->depthStencilFormat;
+			record.primitiveTopo = pGraphics->primitiveTopo;
+			record.supportIndirectCommandBuffer = pGraphics->supportIndirectCommandBuffer;
+		}
+
+		util_add_manifest_entry(pManifest, record, true);
+	}
+
+	/// Point the description of the task to the states of its record
+	static void util_fill_replay_desc(PipelineReplayTask* pTask, Shader* pShader, RootSignature* pRootSignature, PipelineCache* pCache)
+	{
+		PipelineManifestRecord* pRecord = &pTask->record;
+		PipelineCreateDesc* pDesc = &pTask->desc;
+		*pDesc = {};
+		pDesc->type = pRecord->type;
+		pDesc->pCache = pCache;
+		pDesc->name = pRecord->name[0] ? pRecord->name : nullptr;
+		if (SG_PIPELINE_TYPE_COMPUTE == pRecord->type)
+		{
+			pDesc->computeDesc.pShaderProgram = pShader;
+			pDesc->computeDesc.pRootSignature = pRootSignature;
+			return;
+		}
+
+		GraphicsPipelineDesc* pGraphics = &pDesc->graphicsDesc;
+		pGraphics->pShaderProgram = pShader;
+		pGraphics->pRootSignature = pRootSignature;
+		pGraphics->pVertexLayout = pRecord->hasVertexLayout ? &pRecord->vertexLayout : nullptr;
+		pGraphics->pBlendState = pRecord->hasBlendState ? &pRecord->blendState : nullptr;
+		pGraphics->pDepthState = pRecord->hasDepthState ? &pRecord->depthState : nullptr;
+		pGraphics->pRasterizerState = pRecord->hasRasterizerState ? &pRecord->rasterizerState : nullptr;
+		pGraphics->pColorFormats = pRecord->colorFormats;
+		pGraphics->renderTargetCount = pRecord->renderTargetCount;
+		pGraphics->sampleCount = pRecord->sampleCount;
+		pGraphics->sampleQuality = pRecord->sampleQuality;
+		pGraphics->depthStencilFormat = pRecord->depthStencilFormat;
+		pGraphics->primitiveTopo = pRecord->primitiveTopo;
+		pGraphics->supportIndirectCommandBuffer = pRecord->supportIndirectCommandBuffer;
+	}
+
+	/// Keep the name of a watched object when the shader hot reload swaps in a new one
+	static void util_replace_manifest_object(const Shader* pOldShader, Shader* pNewShader, const RootSignature* pOldRootSignature, RootSignature* pNewRootSignature)
+	{
+		PipelineManifest* pManifest = pPipelineManifest;
+		if (!pManifest)
+			return;
+
+		MutexLock lock(pManifest->mutex);
+		auto shaderIt = pManifest->shaderNames.find(pOldShader);
+		if (pOldShader && shaderIt != pManifest->shaderNames.end())
+		{
+			const eastl::string name = shaderIt->second;
+			pManifest->shaderNames.erase(shaderIt);
+			pManifest->shaderNames[pNewShader] = name;
+			pManifest->shaders[name] = pNewShader;
+		}
+		auto rootSignatureIt = pManifest->rootSignatureNames.find(pOldRootSignature);
+		if (pOldRootSignature && rootSignatureIt != pManifest->rootSignatureNames.end())
+		{
+			const eastl::string name = rootSignatureIt->second;
+			pManifest->rootSignatureNames.erase(rootSignatureIt);
+			pManifest->rootSignatureNames[pNewRootSignature] = name;
+			pManifest->rootSignatures[name] = pNewRootSignature;
+		}
+	}
+
+	void init_pipeline_manifest(Renderer* pRenderer, const char* fileName)
+	{
+		ASSERT(pRenderer);
+		ASSERT(fileName);
+		ASSERT(!pPipelineManifest);
+
+		PipelineManifest* pManifest = sg_new(PipelineManifest);
+		pManifest->pRenderer = pRenderer;
+		pManifest->fileName = fileName;
+		pManifest->mutex.Init();
+
+		FileStream stream = {};
+		if (sgfs_open_stream_from_path(SG_RD_PIPELINE_CACHE, fileName, SG_FM_READ_BINARY, &stream))
+		{
+			PipelineManifestHeader header = {};
+			sgfs_read_from_stream(&stream, &header, sizeof(header));
+			const ssize_t expectedSize = (ssize_t)(sizeof(header) + (size_t)header.recordCount * sizeof(PipelineManifestRecord));
+			if (SG_PIPELINE_MANIFEST_MAGIC != header.magic || SG_PIPELINE_MANIFEST_VERSION != header.version ||
+				sizeof(PipelineManifestRecord) != header.recordSize || sgfs_get_stream_file_size(&stream) != expectedSize)
+			{
+				SG_LOG_WARNING("Pipeline manifest %s was written by another build, it is recorded again", fileName);
+			}
+			else
+			{
+				eastl::vector<PipelineManifestRecord> records(header.recordCount);
+				sgfs_read_from_stream(&stream, records.data(), records.size() * sizeof(PipelineManifestRecord));
+				pManifest->entries.reserve(records.size());
+				for (const PipelineManifestRecord& record : records)
+					util_add_manifest_entry(pManifest, record, false);
+			}
+			sgfs_close_stream(&stream);
+		}
+
+		pPipelineManifest = pManifest;
+		set_pipeline_created_callback(pRenderer, util_record_pipeline, pManifest);
+	}
+
+	void exit_pipeline_manifest()
+	{
+		PipelineManifest* pManifest = pPipelineManifest;
+		if (!pManifest)
+			return;
+
+		set_pipeline_created_callback(pManifest->pRenderer, nullptr, nullptr);
+
+		FileStream stream = {};
+		if (sgfs_open_stream_from_path(SG_RD_PIPELINE_CACHE, pManifest->fileName.c_str(), SG_FM_WRITE_BINARY, &stream))
+		{
+			PipelineManifestHeader header = {};
+			header.magic = SG_PIPELINE_MANIFEST_MAGIC;
+			header.version = SG_PIPELINE_MANIFEST_VERSION;
+			header.recordSize = sizeof(PipelineManifestRecord);
+			header.recordCount = (uint32_t)pManifest->entries.size();
+			sgfs_write_to_stream(&stream, &header, sizeof(header));
+			for (const PipelineManifestEntry& entry : pManifest->entries)
+				sgfs_write_to_stream(&stream, &entry.record, sizeof(entry.record));
+			sgfs_close_stream(&stream);
+		}
+		else
+		{
+			SG_LOG_ERROR("Failed to save pipeline manifest %s", pManifest->fileName.c_str());
+		}
+
+		for (Pipeline* pPipeline : pManifest->pipelines)
+			remove_pipeline(pManifest->pRenderer, pPipeline);
+
+		pManifest->mutex.Destroy();
+		sg_delete(pManifest);
+		pPipelineManifest = nullptr;
+	}
+
+	void register_pipeline_manifest_shader(const char* name, Shader* pShader)
+	{
+		PipelineManifest* pManifest = pPipelineManifest;
+		if (!pManifest)
+			return;
+		ASSERT(name);
+		if (strlen(name) >= SG_PIPELINE_MANIFEST_NAME_LENGTH)
+		{
+			SG_LOG_ERROR("Pipeline manifest name %s is longer than %u characters", name, SG_PIPELINE_MANIFEST_NAME_LENGTH - 1);
+			return;
+		}
+
+		MutexLock lock(pManifest->mutex);
+		auto it = pManifest->shaders.find(name);
+		if (it != pManifest->shaders.end())
+		{
+			pManifest->shaderNames.erase(it->second);
+			pManifest->shaders.erase(it);
+		}
+		if (pShader)
+		{
+			pManifest->shaders[name] = pShader;
+			pManifest->shaderNames[pShader] = name;
+		}
+	}
+
+	void register_pipeline_manifest_root_signature(const char* name, RootSignature* pRootSignature)
+	{
+		PipelineManifest* pManifest = pPipelineManifest;
+		if (!pManifest)
+			return;
+		ASSERT(name);
+		if (strlen(name) >= SG_PIPELINE_MANIFEST_NAME_LENGTH)
+		{
+			SG_LOG_ERROR("Pipeline manifest name %s is longer than %u characters", name, SG_PIPELINE_MANIFEST_NAME_LENGTH - 1);
+			return;
+		}
+
+		MutexLock lock(pManifest->mutex);
+		auto it = pManifest->rootSignatures.find(name);
+		if (it != pManifest->rootSignatures.end())
+		{
+			pManifest->rootSignatureNames.erase(it->second);
+			pManifest->rootSignatures.erase(it);
+		}
+		if (pRootSignature)
+		{
+			pManifest->rootSignatures[name] = pRootSignature;
+			pManifest->rootSignatureNames[pRootSignature] = name;
+		}
+	}
+
+	void replay_pipeline_manifest(PipelineCache* pCache, PipelineManifestStats* pStats)
+	{
+		PipelineManifest* pManifest = pPipelineManifest;
+		PipelineManifestStats stats = {};
+		if (!pManifest)
+		{
+			if (pStats)
+				*pStats = stats;
+			return;
+		}
+
+		Timer timer;
+		timer.Reset();
+
+		// take the entries that can be created now, the records are copied out of the lock's reach
+		eastl::vector<PipelineReplayTask> tasks;
+		eastl::vector<uint32_t> taskEntries;
+		{
+			MutexLock lock(pManifest->mutex);
+			for (uint32_t i = 0; i < (uint32_t)pManifest->entries.size(); ++i)
+			{
+				const PipelineManifestEntry& entry = pManifest->entries[i];
+				if (entry.created)
+					continue;
+				auto shaderIt = pManifest->shaders.find(entry.record.shaderName);
+				auto rootSignatureIt = pManifest->rootSignatures.find(entry.record.rootSignatureName);
+				if (shaderIt == pManifest->shaders.end() || rootSignatureIt == pManifest->rootSignatures.end())
+				{
+					++stats.skippedCount;
+					continue;
+				}
+
+				PipelineReplayTask task = {};
+				task.pRenderer = pManifest->pRenderer;
+				task.record = entry.record;
+				tasks.push_back(task);
+				taskEntries.push_back(i);
+			}
+			// the desc points into the task, fill it once the tasks do not move anymore
+			for (size_t t = 0; t < tasks.size(); ++t)
+			{
+				PipelineReplayTask& task = tasks[t];
+				util_fill_replay_desc(&task, pManifest->shaders[task.record.shaderName], pManifest->rootSignatures[task.record.rootSignatureName], pCache);
+			}
+		}
+
+		// the workers of the pipeline state cache create them, equal descriptions share one creation
+		for (PipelineReplayTask& task : tasks)
+			add_pipeline_async(task.pRenderer, &task.desc, nullptr, &task.pPipeline);
+		// wait for these pipelines only: add_pipeline joins the creation in flight, helping the workers, and hands out
+		// the shared pipeline the manifest keeps, the async handle is given back
+		for (PipelineReplayTask& task : tasks)
+		{
+			Pipeline* pAsyncPipeline = task.pPipeline;
+			task.pPipeline = nullptr;
+			add_pipeline(task.pRenderer, &task.desc, &task.pPipeline);
+			if (pAsyncPipeline)
+				remove_pipeline(task.pRenderer, pAsyncPipeline);
+		}
+
+		{
+			MutexLock lock(pManifest->mutex);
+			for (size_t t = 0; t < tasks.size(); ++t)
+			{
+				if (!tasks[t].pPipeline)
+					continue;
+				pManifest->entries[taskEntries[t]].created = true;
+				pManifest->pipelines.push_back(tasks[t].pPipeline);
+				++stats.replayedCount;
+			}
+			stats.recordCount = (uint32_t)pManifest->entries.size();
+		}
+
+		timer.Tick();
+		stats.replayTime = timer.GetTotalTime();
+		SG_LOG_INFO("Replayed %u pipelines of the manifest in %.2fs, %u wait for their shaders", stats.replayedCount, stats.replayTime, stats.skippedCount);
+		if (pStats)
+			*pStats = stats;
+	}
+
 }
\ No newline at end of file
@@ -40,6 +40,21 @@ project "RendererVulkan"
 		"_CRT_NONSTDC_NO_DEPRECATE"
 	}
 
+	-- the transcoder and the zstd decoder it ships with are compiled straight into the renderer
+	if BasisUniversalDir then
+		includedirs { BasisUniversalDir }
+		files
+		{
+			BasisUniversalDir .. "/transcoder/basisu_transcoder.cpp",
+			BasisUniversalDir .. "/zstd/zstddeclib.c"
+		}
+		defines
+		{
+			"SG_ENABLE_BASIS_UNIVERSAL",
+			"BASISD_SUPPORT_KTX2_ZSTD=1"
+		}
+	end
+
 	filter "system:windows"
 		systemversion "latest"
 		defines 
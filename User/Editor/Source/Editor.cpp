@@ -355,6 +355,11 @@ public:
 		// begin command buffer
 		begin_cmd(cmd);
 
+		// wait on the GPU for what the loader uploaded on the transfer queue
+		Semaphore* pUploadSemaphore = nullptr;
+		uint64_t uploadValue = 0;
+		cmd_acquire_loaded_resources(cmd, &pUploadSemaphore, &uploadValue);
+
 		RenderTargetBarrier renderTargetBarriers;
 
 		LoadActionsDesc loadAction = {};
@@ -415,13 +420,17 @@ public:
 
 		end_cmd(cmd);
 
+		Semaphore* waitSemaphores[] = { mImageAcquiredSemaphore, pUploadSemaphore };
+		uint64_t waitValues[] = { 0, uploadValue };
+
 		QueueSubmitDesc submitDesc = {};
 		submitDesc.cmdCount = 1;
 		submitDesc.signalSemaphoreCount = 1;
-		submitDesc.waitSemaphoreCount = 1;
+		submitDesc.waitSemaphoreCount = pUploadSemaphore ? 2 : 1;
 		submitDesc.ppCmds = &cmd;
 		submitDesc.ppSignalSemaphores = &renderCompleteSemaphore;
-		submitDesc.ppWaitSemaphores = &mImageAcquiredSemaphore;
+		submitDesc.ppWaitSemaphores = waitSemaphores;
+		submitDesc.pWaitValues = waitValues;
 		submitDesc.pSignalFence = renderCompleteFence;
 		queue_submit(mGraphicQueue, &submitDesc);
 
@@ -661,7 +670,7 @@ private:
 		rootSignatureCreate.shaderCount = COUNT_OF(submitShaders);
 		add_root_signature(mRenderer, &rootSignatureCreate, &mPbrRootSignature);
 
-		BufferLoadDesc uboCreate;
+		BufferLoadDesc uboCreate = {};
 		uboCreate.desc.descriptors = SG_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		uboCreate.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 		uboCreate.desc.name = "UniformBuffer";
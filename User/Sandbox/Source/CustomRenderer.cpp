@@ -237,6 +237,9 @@ public:
 		materialWidget.AddItem(&gSliderMat);
 		materialWidget.AddItem(&gSliderSmoo);
 		mSecondGui->AddWidget(materialWidget);
+
+		// the errors of the last shader reload, empty while the shaders compile
+		mShaderErrorWidget = mSecondGui->AddWidget(ColorLabelWidget("", { 1.0f, 0.2f, 0.2f, 1.0f }));
 		
 		//mSecondGui->AddWidget(SeparatorWidget());
 		//mSecondGui->AddWidget(SliderFloatWidget("SkyboxX", &gSkyboxRotateX, 0.0f, 360.0f));
@@ -307,17 +310,6 @@ public:
 
 	virtual bool OnLoad() override
 	{
-		DescriptorSetCreateDesc descriptorSetCreate = { mSkyboxRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_NONE, 1 };
-		add_descriptor_set(mRenderer, &descriptorSetCreate, &mSkyboxTexDescSet);
-		descriptorSetCreate = { mPbrRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_NONE, 2 };
-		add_descriptor_set(mRenderer, &descriptorSetCreate, &mModelTexDescSet);
-		descriptorSetCreate = { mPbrRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT * 2 };
-		add_descriptor_set(mRenderer, &descriptorSetCreate, &mModelUboDescSet);
-		descriptorSetCreate = { mLightProxyRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT * 3 };
-		add_descriptor_set(mRenderer, &descriptorSetCreate, &mLightProxyGeomUboDescSet);
-		descriptorSetCreate = { mSkyboxRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT };
-		add_descriptor_set(mRenderer, &descriptorSetCreate, &mSkyboxUboDescSet);
-
 		if (!CreateSwapChain())
 			return false;
 
@@ -338,50 +330,7 @@ public:
 		if (!CreateLightpassPipeline())
 			return false;
 
-		DescriptorData updateData[2] = {};
-		updateData[0].name = "skyboxCubeMap";
-		updateData[0].ppTextures = &mSkyboxCubeMap;
-		update_descriptor_set(mRenderer, 0, mSkyboxTexDescSet, 1, updateData); // update the cubemap
-
-		DescriptorData modelUpdateData[2] = {};
-		modelUpdateData[0].name = "samplerIrradiance";
-		modelUpdateData[0].ppTextures = &mIrradianceCubeMap->pTexture;
-		modelUpdateData[1].name = "samplerPrefilter";
-		modelUpdateData[1].ppTextures = &mPrefilterCubeMap->pTexture;
-		update_descriptor_set(mRenderer, 0, mModelTexDescSet, 2, modelUpdateData); // update the cubemap
-
-		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
-		{
-			DescriptorData bufferUpdate[1] = {};
-			bufferUpdate[0].name = "camera";
-			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
-			update_descriptor_set(mRenderer, i, mSkyboxUboDescSet, 1, bufferUpdate);
-		}
-
-		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
-		{
-			DescriptorData bufferUpdate[4] = {};
-			bufferUpdate[0].name = "camera";
-			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
-			bufferUpdate[1].name = "ubo";
-			bufferUpdate[1].ppBuffers = &mRoomUniformBuffer[i];
-			bufferUpdate[2].name = "light";
-			bufferUpdate[2].ppBuffers = mLightUniformBuffer[i];
-			bufferUpdate[2].count = 2;
-			bufferUpdate[3].name = "mat";
-			bufferUpdate[3].ppBuffers = &mMaterialUniformBuffer[i];
-			update_descriptor_set(mRenderer, i, mModelUboDescSet, 4, bufferUpdate);
-		}
-
-		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
-		{
-			DescriptorData bufferUpdate[2] = {};
-			bufferUpdate[0].name = "camera";
-			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
-			bufferUpdate[1].name = "lightUbo";
-			bufferUpdate[1].ppBuffers = &mCubeUniformBuffer[i];
-			update_descriptor_set(mRenderer, i, mLightProxyGeomUboDescSet, 2, bufferUpdate);
-		}
+		AddDescriptorSets();
 
 		return true;
 	}
@@ -394,20 +343,33 @@ public:
 
 		remove_render_target(mRenderer, mDepthBuffer);
 
+		unwatch_pipeline(&mSkyboxPipeline);
+		unwatch_pipeline(&mLightProxyGeomPipeline);
+		unwatch_pipeline(&mPbrPipeline);
 		remove_pipeline(mRenderer, mSkyboxPipeline);
 		remove_pipeline(mRenderer, mLightProxyGeomPipeline);
 		remove_pipeline(mRenderer, mPbrPipeline);
 		remove_swapchain(mRenderer, mSwapChain);
 
-		remove_descriptor_set(mRenderer, mSkyboxTexDescSet);
-		remove_descriptor_set(mRenderer, mModelUboDescSet);
-		remove_descriptor_set(mRenderer, mLightProxyGeomUboDescSet);
+		RemoveDescriptorSets();
 
 		return true;
 	}
 
 	virtual bool OnUpdate(float deltaTime) override
 	{
+		ShaderReloadStatus reloadStatus = {};
+		update_shader_reload(&reloadStatus);
+		if (reloadStatus.rootSignaturesChanged)
+		{
+			// the descriptor sets were made for the layouts of the old root signatures
+			wait_queue_idle(mGraphicQueue);
+			RemoveDescriptorSets();
+			AddDescriptorSets();
+		}
+		if (mShaderErrorWidget->mLabel != reloadStatus.pErrors)
+			mShaderErrorWidget->mLabel = reloadStatus.pErrors;
+
 		update_input_system(mSettings.width, mSettings.height);
 
 		gCamera->SetCameraLens(glm::radians(45.0f), (float)mSettings.width / mSettings.height, 0.001f, 1000.0f);
@@ -479,6 +441,11 @@ public:
 		// begin command buffer
 		begin_cmd(cmd);
 
+		// wait on the GPU for what the loader uploaded on the transfer queue
+		Semaphore* pUploadSemaphore = nullptr;
+		uint64_t uploadValue = 0;
+		cmd_acquire_loaded_resources(cmd, &pUploadSemaphore, &uploadValue);
+
 		RenderTargetBarrier renderTargetBarriers;
 
 		LoadActionsDesc loadAction = {};
@@ -571,13 +538,17 @@ public:
 
 		end_cmd(cmd);
 
+		Semaphore* waitSemaphores[] = { mImageAcquiredSemaphore, pUploadSemaphore };
+		uint64_t waitValues[] = { 0, uploadValue };
+
 		QueueSubmitDesc submitDesc = {};
 		submitDesc.cmdCount = 1;
 		submitDesc.signalSemaphoreCount = 1;
-		submitDesc.waitSemaphoreCount = 1;
+		submitDesc.waitSemaphoreCount = pUploadSemaphore ? 2 : 1;
 		submitDesc.ppCmds = &cmd;
 		submitDesc.ppSignalSemaphores = &renderCompleteSemaphore;
-		submitDesc.ppWaitSemaphores = &mImageAcquiredSemaphore;
+		submitDesc.ppWaitSemaphores = waitSemaphores;
+		submitDesc.pWaitValues = waitValues;
 		submitDesc.pSignalFence = renderCompleteFence;
 		queue_submit(mGraphicQueue, &submitDesc);
 
@@ -691,6 +662,7 @@ private:
 
 		graphicPipe.pBlendState = &blendStateDesc;
 		add_pipeline(mRenderer, &pipelineCreate, &mPbrPipeline);
+		watch_pipeline(&pipelineCreate, &mPbrPipeline);
 
 		return mPbrPipeline != nullptr;
 	}
@@ -758,6 +730,7 @@ private:
 
 		graphicPipe.pBlendState = &blendStateDesc;
 		add_pipeline(mRenderer, &pipelineCreate, &mLightProxyGeomPipeline);
+		watch_pipeline(&pipelineCreate, &mLightProxyGeomPipeline);
 
 		return mLightProxyGeomPipeline != nullptr;
 	}
@@ -825,6 +798,7 @@ private:
 
 		graphicPipe.pBlendState = &blendStateDesc;
 		add_pipeline(mRenderer, &pipelineCreate, &mSkyboxPipeline);
+		watch_pipeline(&pipelineCreate, &mSkyboxPipeline);
 
 		return mSkyboxPipeline != nullptr;
 	}
@@ -1093,6 +1067,12 @@ private:
 
 		init_resource_loader_interface(mRenderer);
 
+		// recompile the shaders when their sources change while the sandbox runs
+		ShaderReloadDesc shaderReloadDesc = { 0.5f, IMAGE_COUNT };
+		init_shader_reload(mRenderer, &shaderReloadDesc);
+		// create the pipelines of the last run while loading instead of on their first use
+		init_pipeline_manifest(mRenderer, "Sandbox.pipelines");
+
 		TextureLoadDesc textureCreate = {};
 		textureCreate.fileName = "logo";
 		textureCreate.ppTexture = &mLogoTex;
@@ -1141,14 +1121,20 @@ private:
 		loadBasicShader.stages[0] = { "pbr.vert", nullptr, 0, "main" };
 		loadBasicShader.stages[1] = { "pbr.frag", nullptr, 0, "main" };
 		add_shader(mRenderer, &loadBasicShader, &mPbrShader);
+		watch_shader(&loadBasicShader, &mPbrShader);
+		register_pipeline_manifest_shader("Pbr", mPbrShader);
 
 		loadBasicShader.stages[0] = { "LightProxy/lightGeo.vert", nullptr, 0, "main" };
 		loadBasicShader.stages[1] = { "LightProxy/lightGeo.frag", nullptr, 0, "main" };
 		add_shader(mRenderer, &loadBasicShader, &mLightShader);
+		watch_shader(&loadBasicShader, &mLightShader);
+		register_pipeline_manifest_shader("Light", mLightShader);
 
 		loadBasicShader.stages[0] = { "skybox.vert", nullptr, 0, "main" };
 		loadBasicShader.stages[1] = { "skybox.frag", nullptr, 0, "main" };
 		add_shader(mRenderer, &loadBasicShader, &mSkyboxShader);
+		watch_shader(&loadBasicShader, &mSkyboxShader);
+		register_pipeline_manifest_shader("Skybox", mSkyboxShader);
 
 		SamplerCreateDesc samplerCreate = {};
 		samplerCreate.addressU = SG_ADDRESS_MODE_CLAMP_TO_EDGE;
@@ -1168,6 +1154,8 @@ private:
 		rootSignatureCreate.ppShaders = submitSkyboxShader;
 		rootSignatureCreate.shaderCount = COUNT_OF(submitSkyboxShader);
 		add_root_signature(mRenderer, &rootSignatureCreate, &mSkyboxRootSignature);
+		watch_root_signature(&rootSignatureCreate, &mSkyboxRootSignature);
+		register_pipeline_manifest_root_signature("Skybox", mSkyboxRootSignature);
 
 		Shader* submitShaders[] = { mPbrShader };
 		const char* modelStaticSamplers[] = { "samplerIrradiance", "samplerPrefilter" };
@@ -1179,13 +1167,27 @@ private:
 		rootSignatureCreate.ppShaders = submitShaders;
 		rootSignatureCreate.shaderCount = COUNT_OF(submitShaders);
 		add_root_signature(mRenderer, &rootSignatureCreate, &mPbrRootSignature);
+		watch_root_signature(&rootSignatureCreate, &mPbrRootSignature);
+		register_pipeline_manifest_root_signature("Pbr", mPbrRootSignature);
 
 		submitShaders[0] = { mLightShader };
 		rootSignatureCreate.ppShaders = submitShaders;
 		rootSignatureCreate.shaderCount = COUNT_OF(submitShaders);
 		add_root_signature(mRenderer, &rootSignatureCreate, &mLightProxyRootSignature);
-
-		BufferLoadDesc uboCreate;
+		watch_root_signature(&rootSignatureCreate, &mLightProxyRootSignature);
+		register_pipeline_manifest_root_signature("LightProxy", mLightProxyRootSignature);
+		replay_pipeline_manifest(nullptr, nullptr);
+
+		// all the per frame uniform buffers are ranges of one persistently mapped buffer
+		BufferPoolDesc uboPoolDesc = {};
+		uboPoolDesc.blockSize = 64 * 1024;
+		uboPoolDesc.descriptors = SG_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboPoolDesc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+		uboPoolDesc.name = "UniformBufferPool";
+		add_buffer_pool(&uboPoolDesc, &mUniformBufferPool);
+
+		BufferLoadDesc uboCreate = {};
+		uboCreate.pPool = mUniformBufferPool;
 		uboCreate.desc.descriptors = SG_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		uboCreate.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
 		uboCreate.desc.name = "RoomUniformBuffer";
@@ -1251,6 +1253,74 @@ private:
 		return true;
 	}
 
+	void AddDescriptorSets()
+	{
+		DescriptorSetCreateDesc descriptorSetCreate = { mSkyboxRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_NONE, 1 };
+		add_descriptor_set(mRenderer, &descriptorSetCreate, &mSkyboxTexDescSet);
+		descriptorSetCreate = { mPbrRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_NONE, 2 };
+		add_descriptor_set(mRenderer, &descriptorSetCreate, &mModelTexDescSet);
+		descriptorSetCreate = { mPbrRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT * 2 };
+		add_descriptor_set(mRenderer, &descriptorSetCreate, &mModelUboDescSet);
+		descriptorSetCreate = { mLightProxyRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT * 3 };
+		add_descriptor_set(mRenderer, &descriptorSetCreate, &mLightProxyGeomUboDescSet);
+		descriptorSetCreate = { mSkyboxRootSignature, SG_DESCRIPTOR_UPDATE_FREQ_PER_FRAME, IMAGE_COUNT };
+		add_descriptor_set(mRenderer, &descriptorSetCreate, &mSkyboxUboDescSet);
+
+		DescriptorData updateData[2] = {};
+		updateData[0].name = "skyboxCubeMap";
+		updateData[0].ppTextures = &mSkyboxCubeMap;
+		update_descriptor_set(mRenderer, 0, mSkyboxTexDescSet, 1, updateData); // update the cubemap
+
+		DescriptorData modelUpdateData[2] = {};
+		modelUpdateData[0].name = "samplerIrradiance";
+		modelUpdateData[0].ppTextures = &mIrradianceCubeMap->pTexture;
+		modelUpdateData[1].name = "samplerPrefilter";
+		modelUpdateData[1].ppTextures = &mPrefilterCubeMap->pTexture;
+		update_descriptor_set(mRenderer, 0, mModelTexDescSet, 2, modelUpdateData); // update the cubemap
+
+		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
+		{
+			DescriptorData bufferUpdate[1] = {};
+			bufferUpdate[0].name = "camera";
+			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
+			update_descriptor_set(mRenderer, i, mSkyboxUboDescSet, 1, bufferUpdate);
+		}
+
+		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
+		{
+			DescriptorData bufferUpdate[4] = {};
+			bufferUpdate[0].name = "camera";
+			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
+			bufferUpdate[1].name = "ubo";
+			bufferUpdate[1].ppBuffers = &mRoomUniformBuffer[i];
+			bufferUpdate[2].name = "light";
+			bufferUpdate[2].ppBuffers = mLightUniformBuffer[i];
+			bufferUpdate[2].count = 2;
+			bufferUpdate[3].name = "mat";
+			bufferUpdate[3].ppBuffers = &mMaterialUniformBuffer[i];
+			update_descriptor_set(mRenderer, i, mModelUboDescSet, 4, bufferUpdate);
+		}
+
+		for (uint32_t i = 0; i < IMAGE_COUNT; i++)
+		{
+			DescriptorData bufferUpdate[2] = {};
+			bufferUpdate[0].name = "camera";
+			bufferUpdate[0].ppBuffers = &mCameraUniformBuffer[i];
+			bufferUpdate[1].name = "lightUbo";
+			bufferUpdate[1].ppBuffers = &mCubeUniformBuffer[i];
+			update_descriptor_set(mRenderer, i, mLightProxyGeomUboDescSet, 2, bufferUpdate);
+		}
+	}
+
+	void RemoveDescriptorSets()
+	{
+		remove_descriptor_set(mRenderer, mSkyboxTexDescSet);
+		remove_descriptor_set(mRenderer, mModelTexDescSet);
+		remove_descriptor_set(mRenderer, mModelUboDescSet);
+		remove_descriptor_set(mRenderer, mLightProxyGeomUboDescSet);
+		remove_descriptor_set(mRenderer, mSkyboxUboDescSet);
+	}
+
 	void RemoveRenderResource()
 	{
 		remove_resource(mSkyboxCubeMap);
@@ -1268,6 +1338,10 @@ private:
 			remove_resource(mLightUniformBuffer[i][0]);
 			remove_resource(mLightUniformBuffer[i][1]);
 		}
+		remove_buffer_pool(mUniformBufferPool);
+
+		exit_pipeline_manifest();
+		exit_shader_reload();
 
 		remove_sampler(mRenderer, mSampler);
 		remove_shader(mRenderer, mPbrShader);
@@ -1814,6 +1888,7 @@ private:
 
 	Buffer* mCameraUniformBuffer[IMAGE_COUNT] = { nullptr, nullptr };
 	Buffer* mMaterialUniformBuffer[IMAGE_COUNT] = { nullptr, nullptr };
+	BufferPool* mUniformBufferPool = nullptr;
 	Buffer* mRoomUniformBuffer[IMAGE_COUNT] = { nullptr, nullptr };
 	Buffer* mCubeUniformBuffer[IMAGE_COUNT] = { nullptr, nullptr };
 	Buffer* mLightUniformBuffer[IMAGE_COUNT][2] = { nullptr, nullptr, nullptr, nullptr };
@@ -1828,6 +1903,7 @@ private:
 	UIMiddleware  mUiMiddleware;
 	GuiComponent* mMainGui = nullptr;
 	GuiComponent* mSecondGui = nullptr;
+	IWidget*      mShaderErrorWidget = nullptr;
 };
 
 SG_DEFINE_APPLICATION_MAIN(CustomRenderer)
\ No newline at end of file
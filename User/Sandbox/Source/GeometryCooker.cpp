@@ -0,0 +1,82 @@
+
+#include "Seagull.h"
+
+using namespace SG;
+
+/// Cooks the gltf files given on the command line into .sgmesh files next to them,
+/// with the vertex layout (position, texcoord, normal) the sandbox renderer loads its geometries with
+class GeometryCookerApp : public IApp
+{
+	virtual bool OnInit() override
+	{
+		VertexLayout vertexLayout = {};
+		vertexLayout.attribCount = 3;
+
+		vertexLayout.attribs[0].semantic = SG_SEMANTIC_POSITION;
+		vertexLayout.attribs[0].format = TinyImageFormat_R32G32B32_SFLOAT;
+		vertexLayout.attribs[0].binding = 0;
+		vertexLayout.attribs[0].location = 0;
+		vertexLayout.attribs[0].offset = 0;
+
+		vertexLayout.attribs[1].semantic = SG_SEMANTIC_TEXCOORD0;
+		vertexLayout.attribs[1].format = TinyImageFormat_R32G32_SFLOAT;
+		vertexLayout.attribs[1].binding = 0;
+		vertexLayout.attribs[1].location = 1;
+		vertexLayout.attribs[1].offset = 3 * sizeof(float);
+
+		vertexLayout.attribs[2].semantic = SG_SEMANTIC_NORMAL;
+		vertexLayout.attribs[2].format = TinyImageFormat_R32G32B32_SFLOAT;
+		vertexLayout.attribs[2].binding = 0;
+		vertexLayout.attribs[2].location = 2;
+		vertexLayout.attribs[2].offset = 5 * sizeof(float);
+
+		if (IApp::argc < 2)
+			SG_LOG_INFO("Usage: %s <mesh.gltf> [mesh.gltf ...], paths are relative to the mesh directory", IApp::argv[0]);
+
+		uint32_t cookedCount = 0;
+		for (int i = 1; i < IApp::argc; ++i)
+		{
+			GeometryLoadDesc geoDesc = {};
+			geoDesc.fileName = IApp::argv[i];
+			geoDesc.pVertexLayout = &vertexLayout;
+			geoDesc.flags = SG_GEOMETRY_LOAD_FLAG_OPTIMIZE_ALL | SG_GEOMETRY_LOAD_FLAG_GENERATE_MESHLETS | SG_GEOMETRY_LOAD_FLAG_OPTIMIZATION_REPORT;
+			if (cook_geometry(&geoDesc, nullptr))
+				++cookedCount;
+		}
+		SG_LOG_INFO("Cooked %u of %d geometries", cookedCount, IApp::argc - 1);
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "GeometryCookerApp";
+	}
+};
+
+//SG_DEFINE_APPLICATION_MAIN(GeometryCookerApp);
@@ -0,0 +1,129 @@
+
+#include "Seagull.h"
+
+#include "Memory/RangeAllocator.h"
+
+using namespace SG;
+
+/// Sizes on and off the subclass boundaries, the good fit search rounds the ones off them up to the next subclass
+static const uint64_t gSizes[] = { 1, 7, 8, 9, 17, 100, 1000, 12345, 65536, 65537 };
+
+static uint32_t gFailCount = 0;
+
+static void check(bool condition, const char* pWhat, uint64_t size)
+{
+	if (!condition)
+	{
+		SG_LOG_ERROR("RangeAllocator: %s failed for size %llu", pWhat, (unsigned long long)size);
+		++gFailCount;
+	}
+}
+
+/// A block of exactly the requested size takes it once and refuses anything more
+static void test_exact_fit(uint64_t size)
+{
+	RangeAllocator* pAllocator = nullptr;
+	add_range_allocator(size, 1, &pAllocator);
+
+	RangeAllocation allocation = {};
+	check(allocate_range(pAllocator, size, &allocation), "exact fit", size);
+	check(allocation.offset == 0 && allocation.size == size, "exact fit range", size);
+	RangeAllocation overflow = {};
+	check(!allocate_range(pAllocator, 1, &overflow), "full block", size);
+
+	free_range(pAllocator, &allocation);
+	check(get_range_allocator_free_size(pAllocator) == size, "free size", size);
+	check(get_range_allocator_largest_free_range(pAllocator) == size, "largest free range", size);
+
+	remove_range_allocator(pAllocator);
+}
+
+/// A hole of exactly the requested size between two allocations is found again
+static void test_exact_hole(uint64_t size)
+{
+	RangeAllocator* pAllocator = nullptr;
+	add_range_allocator(size * 3, 1, &pAllocator);
+
+	RangeAllocation allocations[3] = {};
+	for (RangeAllocation& allocation : allocations)
+		check(allocate_range(pAllocator, size, &allocation), "fill", size);
+	free_range(pAllocator, &allocations[1]);
+
+	RangeAllocation hole = {};
+	check(allocate_range(pAllocator, size, &hole), "exact hole", size);
+	check(hole.offset == allocations[1].offset, "exact hole offset", size);
+
+	free_range(pAllocator, &hole);
+	free_range(pAllocator, &allocations[0]);
+	free_range(pAllocator, &allocations[2]);
+	// the freed ranges merge back into the whole block
+	check(get_range_allocator_largest_free_range(pAllocator) == size * 3, "merge", size);
+
+	remove_range_allocator(pAllocator);
+}
+
+/// A request larger than the block, or than its granularity rounded size, fails instead of overlapping
+static void test_oversized(uint64_t size)
+{
+	RangeAllocator* pAllocator = nullptr;
+	add_range_allocator(size, 1, &pAllocator);
+
+	RangeAllocation allocation = {};
+	check(!allocate_range(pAllocator, size + 1, &allocation), "oversized", size);
+	check(!allocate_range(pAllocator, size * 1024, &allocation), "far oversized", size);
+	check(get_range_allocator_free_size(pAllocator) == size, "oversized free size", size);
+
+	remove_range_allocator(pAllocator);
+}
+
+class RangeAllocatorTestApp : public IApp
+{
+	virtual bool OnInit() override
+	{
+		for (uint64_t size : gSizes)
+		{
+			test_exact_fit(size);
+			test_exact_hole(size);
+			test_oversized(size);
+		}
+
+		if (gFailCount)
+			SG_LOG_ERROR("RangeAllocator: %u checks failed", gFailCount);
+		else
+			SG_LOG_INFO("RangeAllocator: all checks passed");
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "RangeAllocatorTestApp";
+	}
+};
+
+//SG_DEFINE_APPLICATION_MAIN(RangeAllocatorTestApp);
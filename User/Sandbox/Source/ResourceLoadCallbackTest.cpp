@@ -0,0 +1,119 @@
+
+#include "Seagull.h"
+
+#include "Core/Atomic.h"
+
+using namespace SG;
+
+/// A worker load callback of one load waits on a later load. The later load is decoded by the workers the loader thread
+/// waits for, so the callback must not run on them or neither of them ever finishes.
+static const uint32_t gTimeoutMs = 10000;
+
+static SyncToken gTextureToken = 0;
+static sg_atomic32_t gCallbackDone = 0;
+
+static void wait_for_texture_callback(void* pUserData)
+{
+	UNREF_PARAM(pUserData);
+	wait_for_token(&gTextureToken);
+	sg_atomic32_store_release(&gCallbackDone, 1);
+}
+
+class ResourceLoadCallbackTestApp : public IApp
+{
+	virtual bool OnInit() override
+	{
+		RendererCreateDesc rendererCreate = {};
+		init_renderer("Seagull Resource Load Callback Test", &rendererCreate, &mRenderer);
+		if (!mRenderer)
+		{
+			SG_LOG_ERROR("Failed to initialize renderer!");
+			mSettings.quit = true;
+			return true;
+		}
+		init_resource_loader_interface(mRenderer);
+
+		uint32_t data[256] = {};
+		SyncToken bufferToken = 0;
+		BufferLoadDesc bufferCreate = {};
+		bufferCreate.desc.descriptors = SG_DESCRIPTOR_TYPE_VERTEX_BUFFER;
+		bufferCreate.desc.memoryUsage = SG_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+		bufferCreate.desc.size = sizeof(data);
+		bufferCreate.pData = data;
+		bufferCreate.ppBuffer = &mBuffer;
+		add_resource(&bufferCreate, &bufferToken);
+
+		TextureLoadDesc textureCreate = {};
+		textureCreate.fileName = "logo";
+		textureCreate.ppTexture = &mTexture;
+		add_resource(&textureCreate, &gTextureToken);
+
+		add_resource_load_callback(&bufferToken, wait_for_texture_callback, nullptr, SG_LOAD_CALLBACK_DISPATCH_WORKER);
+
+		Timer timer;
+		timer.Reset();
+		uint32_t waitedMs = 0;
+		while (!sg_atomic32_load_acquire(&gCallbackDone) && waitedMs < gTimeoutMs)
+		{
+			// single threaded loaders run the callback here
+			dispatch_resource_load_callbacks();
+			Thread::sleep(1);
+			++waitedMs;
+		}
+		timer.Tick();
+
+		if (sg_atomic32_load_acquire(&gCallbackDone))
+		{
+			SG_LOG_INFO("Callback waiting on a later load returned after %.3fs", timer.GetTotalTime());
+			wait_for_all_resource_loads();
+			remove_resource(mBuffer);
+			remove_resource(mTexture);
+			exit_resource_loader_interface(mRenderer);
+			remove_renderer(mRenderer);
+		}
+		else
+		{
+			// the loader is stuck, tearing it down would hang as well
+			SG_LOG_ERROR("Callback waiting on a later load did not return within %ums, the loader deadlocked", gTimeoutMs);
+		}
+		mRenderer = nullptr;
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "ResourceLoadCallbackTestApp";
+	}
+
+	Renderer* mRenderer = nullptr;
+	Buffer*   mBuffer = nullptr;
+	Texture*  mTexture = nullptr;
+};
+
+//SG_DEFINE_APPLICATION_MAIN(ResourceLoadCallbackTestApp);
@@ -0,0 +1,257 @@
+
+#include "Seagull.h"
+
+using namespace SG;
+
+/// Compiles every variant of the shaders listed in the permutation manifests given on the command line into the shader binary
+/// directory, so add_shader finds all of them up to date and never compiles or reflects on the user's machine.
+/// A manifest is a text file in the shader source directory:
+///     # comment
+///     shader pbr.vert pbr.frag          starts a shader with its stage files
+///     target 6_0                        optional shader target of the shader, 5_1 by default
+///     axis USE_IBL 0 1                  a macro and the values it takes, every combination of the axes is a variant
+///     axis SHADOW_QUALITY 0 1 2
+/// The builtin macros of the renderer depend on the GPU, the binaries are valid for GPUs with the same features as the one compiling
+class ShaderPrecompilerApp : public IApp
+{
+	struct ShaderAxis
+	{
+		eastl::string              macro;
+		eastl::vector<eastl::string> values;
+	};
+
+	struct ShaderPermutations
+	{
+		eastl::vector<eastl::string> stageFiles;
+		eastl::vector<ShaderAxis>    axes;
+		ShaderTarget                 target;
+	};
+
+	static eastl::vector<eastl::string> SplitLine(const eastl::string& line)
+	{
+		eastl::vector<eastl::string> tokens;
+		size_t start = line.find_first_not_of(" \t\r");
+		while (start != eastl::string::npos)
+		{
+			size_t end = line.find_first_of(" \t\r", start);
+			tokens.push_back(line.substr(start, end == eastl::string::npos ? eastl::string::npos : end - start));
+			start = end == eastl::string::npos ? end : line.find_first_not_of(" \t\r", end);
+		}
+		return tokens;
+	}
+
+	static bool ReadManifest(const char* fileName, eastl::vector<ShaderPermutations>& shaders)
+	{
+		static const char* targetNames[] = { "5_1", "6_0", "6_1", "6_2", "6_3" };
+		static const ShaderTarget targets[] = { SG_SHADER_TARGET_5_1, SG_SHADER_TARGET_6_0, SG_SHADER_TARGET_6_1, SG_SHADER_TARGET_6_2, SG_SHADER_TARGET_6_3 };
+
+		FileStream fh = {};
+		if (!sgfs_open_stream_from_path(SG_RD_SHADER_SOURCES, fileName, SG_FM_READ_BINARY, &fh))
+		{
+			SG_LOG_ERROR("Failed to open shader permutation manifest %s", fileName);
+			return false;
+		}
+		eastl::string manifest;
+		manifest.resize((size_t)sgfs_get_stream_file_size(&fh));
+		sgfs_read_from_stream(&fh, &manifest[0], manifest.size());
+		sgfs_close_stream(&fh);
+
+		bool result = true;
+		uint32_t lineNumber = 0;
+		size_t lineStart = 0;
+		while (lineStart < manifest.size())
+		{
+			size_t lineEnd = manifest.find('\n', lineStart);
+			if (lineEnd == eastl::string::npos)
+				lineEnd = manifest.size();
+			eastl::vector<eastl::string> tokens = SplitLine(manifest.substr(lineStart, lineEnd - lineStart));
+			lineStart = lineEnd + 1;
+			++lineNumber;
+			if (tokens.empty() || tokens[0][0] == '#')
+				continue;
+
+			if (tokens[0] == "shader" && tokens.size() > 1 && tokens.size() <= SG_SHADER_STAGE_COUNT + 1)
+			{
+				ShaderPermutations shader = {};
+				shader.stageFiles.assign(tokens.begin() + 1, tokens.end());
+				shader.target = SG_SHADER_TARGET_5_1;
+				shaders.push_back(shader);
+				continue;
+			}
+
+			if (shaders.empty())
+			{
+				SG_LOG_ERROR("%s(%u): '%s' before the first shader", fileName, lineNumber, tokens[0].c_str());
+				result = false;
+				continue;
+			}
+
+			if (tokens[0] == "axis" && tokens.size() > 2)
+			{
+				ShaderAxis axis;
+				axis.macro = tokens[1];
+				axis.values.assign(tokens.begin() + 2, tokens.end());
+				shaders.back().axes.push_back(axis);
+			}
+			else if (tokens[0] == "target" && tokens.size() == 2)
+			{
+				bool found = false;
+				for (uint32_t i = 0; i < sizeof(targets) / sizeof(targets[0]); ++i)
+				{
+					if (tokens[1] == targetNames[i])
+					{
+						shaders.back().target = targets[i];
+						found = true;
+					}
+				}
+				if (!found)
+				{
+					SG_LOG_ERROR("%s(%u): unknown shader target %s", fileName, lineNumber, tokens[1].c_str());
+					result = false;
+				}
+			}
+			else
+			{
+				SG_LOG_ERROR("%s(%u): cannot parse '%s'", fileName, lineNumber, tokens[0].c_str());
+				result = false;
+			}
+		}
+		return result;
+	}
+
+	virtual bool OnInit() override
+	{
+		if (IApp::argc < 2)
+		{
+			SG_LOG_INFO("Usage: %s <manifest> [...], paths are relative to the shader source directory", IApp::argv[0]);
+			mSettings.quit = true;
+			return true;
+		}
+
+		eastl::vector<ShaderPermutations> shaders;
+		for (int i = 1; i < IApp::argc; ++i)
+		{
+			if (!ReadManifest(IApp::argv[i], shaders))
+			{
+				mSettings.quit = true;
+				return true;
+			}
+		}
+
+		// one ShaderLoadDesc per combination of the axis values, the stages of a variant share its macros
+		size_t variantCount = 0;
+		size_t macroCount = 0;
+		for (const ShaderPermutations& shader : shaders)
+		{
+			size_t shaderVariants = 1;
+			for (const ShaderAxis& axis : shader.axes)
+				shaderVariants *= axis.values.size();
+			variantCount += shaderVariants;
+			macroCount += shaderVariants * shader.axes.size();
+		}
+
+		// the macros of all the variants live in one array, reserved up front so the pointers into it stay valid
+		eastl::vector<ShaderLoadDesc> loadDescs;
+		eastl::vector<ShaderMacro> macros;
+		loadDescs.reserve(variantCount);
+		macros.reserve(macroCount);
+		for (const ShaderPermutations& shader : shaders)
+		{
+			eastl::vector<uint32_t> valueIndices(shader.axes.size(), 0);
+			for (;;)
+			{
+				ShaderMacro* pMacros = macros.data() + macros.size();
+				for (size_t a = 0; a < shader.axes.size(); ++a)
+					macros.push_back({ shader.axes[a].macro.c_str(), shader.axes[a].values[valueIndices[a]].c_str() });
+
+				ShaderLoadDesc loadDesc = {};
+				loadDesc.target = shader.target;
+				for (size_t i = 0; i < shader.stageFiles.size(); ++i)
+				{
+					loadDesc.stages[i].fileName = shader.stageFiles[i].c_str();
+					loadDesc.stages[i].pMacros = pMacros;
+					loadDesc.stages[i].macroCount = (uint32_t)shader.axes.size();
+					loadDesc.stages[i].entryPointName = "main";
+				}
+				loadDescs.push_back(loadDesc);
+
+				// next combination, the first axis changes fastest
+				size_t a = 0;
+				for (; a < shader.axes.size(); ++a)
+				{
+					if (++valueIndices[a] < shader.axes[a].values.size())
+						break;
+					valueIndices[a] = 0;
+				}
+				if (a == shader.axes.size())
+					break;
+			}
+		}
+
+		RendererCreateDesc rendererCreate = {};
+		rendererCreate.shaderTarget = SG_SHADER_TARGET_6_3;
+		init_renderer("Seagull Shader Precompiler", &rendererCreate, &mRenderer);
+		if (!mRenderer)
+		{
+			SG_LOG_ERROR("Failed to initialize renderer!");
+			mSettings.quit = true;
+			return true;
+		}
+		init_resource_loader_interface(mRenderer);
+
+		ShaderCompileStats stats = {};
+		compile_shaders(mRenderer, (uint32_t)loadDescs.size(), loadDescs.data(), &stats);
+
+		SG_LOG_INFO("%u shaders, %u variants: %u stages compiled, %u up to date, %u shared between variants, %u failed",
+			(uint32_t)shaders.size(), (uint32_t)loadDescs.size(), stats.compiledStageCount, stats.cachedStageCount, stats.sharedStageCount, stats.failedStageCount);
+		SG_LOG_INFO("Precompiling took %.2fs, %.2fs of compiling spread over the workers", stats.batchTime, stats.compileTime);
+		if (stats.compiledStageCount)
+		{
+			SG_LOG_INFO("Compiled bytecode: %llu -> %llu bytes, %llu -> %llu instructions once optimized and stripped",
+				(unsigned long long)stats.compiledByteCodeSize, (unsigned long long)stats.savedByteCodeSize,
+				(unsigned long long)stats.compiledInstructionCount, (unsigned long long)stats.savedInstructionCount);
+		}
+		if (stats.failedShaderCount)
+			SG_LOG_ERROR("%u variants failed to compile", stats.failedShaderCount);
+
+		exit_resource_loader_interface(mRenderer);
+		remove_renderer(mRenderer);
+		mRenderer = nullptr;
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "ShaderPrecompilerApp";
+	}
+
+	Renderer* mRenderer = nullptr;
+};
+
+//SG_DEFINE_APPLICATION_MAIN(ShaderPrecompilerApp);
@@ -0,0 +1,93 @@
+
+#include "Seagull.h"
+
+using namespace SG;
+
+/// Block compresses the uncompressed DDS textures given on the command line into <name>_<format>.dds files next to them.
+/// Options apply to the textures after them: -bc1, -bc3, -bc4, -bc5, -bc7 (default), -fast, -normal, -high (default) and -srgb
+class TextureCookerApp : public IApp
+{
+	virtual bool OnInit() override
+	{
+		if (IApp::argc < 2)
+			SG_LOG_INFO("Usage: %s [-bc1|-bc3|-bc4|-bc5|-bc7] [-fast|-normal|-high] [-srgb] <texture.dds> [...], paths are relative to the texture directory", IApp::argv[0]);
+
+		static const char* formatOptions[SG_BLOCK_COMPRESSION_COUNT] = { "-bc1", "-bc3", "-bc4", "-bc5", "-bc7" };
+		static const char* qualityOptions[] = { "-fast", "-normal", "-high" };
+
+		TextureCookDesc cookDesc = {};
+		cookDesc.format = SG_BLOCK_COMPRESSION_BC7;
+		cookDesc.quality = SG_BLOCK_COMPRESSION_QUALITY_HIGH;
+
+		uint32_t textureCount = 0;
+		uint32_t cookedCount = 0;
+		for (int i = 1; i < IApp::argc; ++i)
+		{
+			const char* arg = IApp::argv[i];
+			bool option = false;
+			for (uint32_t f = 0; f < SG_BLOCK_COMPRESSION_COUNT; ++f)
+			{
+				if (strcmp(arg, formatOptions[f]) == 0)
+				{
+					cookDesc.format = (BlockCompressionFormat)f;
+					option = true;
+				}
+			}
+			for (uint32_t q = 0; q < 3; ++q)
+			{
+				if (strcmp(arg, qualityOptions[q]) == 0)
+				{
+					cookDesc.quality = (BlockCompressionQuality)q;
+					option = true;
+				}
+			}
+			if (strcmp(arg, "-srgb") == 0)
+			{
+				cookDesc.srgb = true;
+				option = true;
+			}
+			if (option)
+				continue;
+
+			++textureCount;
+			cookDesc.fileName = arg;
+			if (cook_texture(&cookDesc, nullptr))
+				++cookedCount;
+		}
+		SG_LOG_INFO("Cooked %u of %u textures", cookedCount, textureCount);
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "TextureCookerApp";
+	}
+};
+
+//SG_DEFINE_APPLICATION_MAIN(TextureCookerApp);
@@ -0,0 +1,119 @@
+
+#include "Seagull.h"
+
+#include "Math/VertexPacking.h"
+
+using namespace SG;
+
+typedef void (*PackFunc)(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst);
+
+/// a million vertices of [ POSITION | NORMAL | TEXCOORD ]
+static const uint32_t gVertexCount = 1024 * 1024;
+static const uint32_t gSrcStride = sizeof(float) * 8;
+static const uint32_t gIterations = 8;
+
+static void pack_normals(uint32_t count, uint32_t components, uint32_t srcStride, uint32_t dstStride, const uint8_t* src, uint8_t* dst)
+{
+	pack_float3_direction_to_oct16(count, srcStride, dstStride, src, dst);
+}
+
+class VertexPackingBenchmarkApp : public IApp
+{
+	virtual bool OnInit() override
+	{
+		mSrc = (float*)sg_malloc(gVertexCount * gSrcStride);
+		mDst = (uint8_t*)sg_malloc(gVertexCount * sizeof(uint32_t) * 4);
+		mReference = (uint8_t*)sg_malloc(gVertexCount * sizeof(uint32_t) * 4);
+
+		uint32_t seed = 1;
+		for (uint32_t i = 0; i < gVertexCount * 8; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			mSrc[i] = (float)(seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+		}
+
+		struct { const char* name; PackFunc func; uint32_t components; uint32_t srcOffset; uint32_t dstStride; } benchmarks[] =
+		{
+			{ "texcoord float2 -> half2",   pack_float_to_half,    2, sizeof(float) * 6, sizeof(uint16_t) * 2 },
+			{ "position float3 -> half4",   pack_float_to_half,    3, 0,                 sizeof(uint16_t) * 4 },
+			{ "normal float3 -> oct16",     pack_normals,          3, sizeof(float) * 3, sizeof(uint32_t) },
+			{ "color float4 -> unorm8",     pack_float_to_unorm8,  4, sizeof(float) * 3, sizeof(uint8_t) * 4 },
+			{ "tangent float4 -> snorm16",  pack_float_to_snorm16, 4, sizeof(float) * 3, sizeof(int16_t) * 4 },
+		};
+
+		const VertexPackingISA bestISA = get_vertex_packing_isa();
+		for (auto& benchmark : benchmarks)
+		{
+			const uint8_t* src = (const uint8_t*)mSrc + benchmark.srcOffset;
+			const size_t dstSize = (size_t)gVertexCount * benchmark.dstStride;
+
+			set_vertex_packing_isa(SG_VERTEX_PACKING_ISA_SCALAR);
+			benchmark.func(gVertexCount, benchmark.components, gSrcStride, benchmark.dstStride, src, mReference);
+
+			float scalarTime = 0.0f;
+			for (uint32_t isa = 0; isa < SG_VERTEX_PACKING_ISA_COUNT; ++isa)
+			{
+				if (!set_vertex_packing_isa((VertexPackingISA)isa))
+					continue;
+
+				Timer t;
+				t.Reset();
+				for (uint32_t i = 0; i < gIterations; ++i)
+					benchmark.func(gVertexCount, benchmark.components, gSrcStride, benchmark.dstStride, src, mDst);
+				t.Tick();
+
+				const float time = t.GetTotalTime() / gIterations;
+				if (SG_VERTEX_PACKING_ISA_SCALAR == isa)
+					scalarTime = time;
+
+				const bool exact = memcmp(mDst, mReference, dstSize) == 0;
+				SG_LOG_INFO("%-26s %-7s %8.3fms %6.1f Mverts/s (x%.2f) %s", benchmark.name, get_vertex_packing_isa_name((VertexPackingISA)isa),
+					time * 1000.0f, gVertexCount / time / 1000000.0f, scalarTime / time, exact ? "bit-exact" : "MISMATCH");
+				ASSERT(exact);
+			}
+		}
+		set_vertex_packing_isa(bestISA);
+
+		sg_free(mReference);
+		sg_free(mDst);
+		sg_free(mSrc);
+
+		mSettings.quit = true;
+		return true;
+	}
+
+	virtual void OnExit() override
+	{
+	}
+
+	virtual bool OnLoad() override
+	{
+		return true;
+	}
+
+	virtual bool OnUnload() override
+	{
+		return true;
+	}
+
+	virtual bool OnUpdate(float deltaTime) override
+	{
+		return true;
+	}
+
+	virtual bool OnDraw() override
+	{
+		return true;
+	}
+
+	virtual const char* GetName() override
+	{
+		return "VertexPackingBenchmarkApp";
+	}
+private:
+	float*   mSrc = nullptr;
+	uint8_t* mDst = nullptr;
+	uint8_t* mReference = nullptr;
+};
+
+//SG_DEFINE_APPLICATION_MAIN(VertexPackingBenchmarkApp);
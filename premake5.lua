@@ -8,6 +8,16 @@ workspace "Seagull"
 		"Release-Vulkan"
     }
 
+newoption
+{
+    trigger     = "basisu",
+    value       = "path",
+    description = "Path to a basis_universal checkout, enables Basis Universal and zstd supercompressed KTX2 textures"
+}
+
+-- resolved here so that the path given on the command line is relative to the workspace root
+BasisUniversalDir = _OPTIONS["basisu"] and path.getabsolute(_OPTIONS["basisu"]) or nil
+
 -- Debug-windows-x64
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 IncludeDir = { }